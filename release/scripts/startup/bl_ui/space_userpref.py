@@ -628,6 +628,20 @@ class USERPREF_PT_system_video_sequencer(SystemPanel, CenterAlignMixIn, Panel):
         col.prop(system, "sequencer_disk_cache_compression", text="Compression")
 
 
+class USERPREF_PT_system_image_decode_cache(SystemPanel, CenterAlignMixIn, Panel):
+    bl_label = "Image Decode Cache"
+
+    def draw_centered(self, context, layout):
+        prefs = context.preferences
+        system = prefs.system
+
+        layout.prop(system, "use_image_decode_cache")
+        col = layout.column()
+        col.active = system.use_image_decode_cache
+        col.prop(system, "image_decode_cache_dir", text="Directory")
+        col.prop(system, "image_decode_cache_size_limit", text="Cache Limit")
+
+
 # -----------------------------------------------------------------------------
 # Viewport Panels
 
@@ -2188,6 +2202,7 @@ classes = (
     USERPREF_PT_system_cycles_devices,
     USERPREF_PT_system_memory,
     USERPREF_PT_system_video_sequencer,
+    USERPREF_PT_system_image_decode_cache,
     USERPREF_PT_system_sound,
 
     USERPREF_MT_interface_theme_presets,
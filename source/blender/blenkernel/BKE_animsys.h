@@ -251,6 +251,9 @@ void BKE_animsys_eval_driver(struct Depsgraph *depsgraph,
                              struct FCurve *fcu_orig);
 
 void BKE_animsys_update_driver_array(struct ID *id);
+void BKE_animsys_free_action_eval_cache(struct AnimData *adt);
+bool BKE_animsys_action_eval_changed_channels(
+    struct ID *id, struct AnimData *adt, float ctime, bool *r_changed, int num_channels);
 
 /* ************************************* */
 
@@ -259,6 +259,7 @@ float bvhtree_sphereray_tri_intersection(const BVHTreeRay *ray,
 bool bvhcache_has_tree(const struct BVHCache *bvh_cache, const BVHTree *tree);
 struct BVHCache *bvhcache_init(void);
 void bvhcache_free(struct BVHCache *bvh_cache);
+void bvhcache_free_ex(struct BVHCache *bvh_cache, struct Mesh *mesh);
 
 #ifdef __cplusplus
 }
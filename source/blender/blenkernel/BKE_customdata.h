@@ -73,6 +73,13 @@ typedef enum eCDAllocType {
   CD_REFERENCE = 3,
   /** Do a full copy of all layers, only allowed if source has same number of elements. */
   CD_DUPLICATE = 4,
+  /**
+   * Share data of the source layers using reference counting, without copying it. The data is
+   * freed when the last layer using it is freed. Code which modifies such layer is to call
+   * #CustomData_duplicate_referenced_layer() first, which only copies the data when it is
+   * actually used by other layers.
+   */
+  CD_SHARE = 5,
 } eCDAllocType;
 
 #define CD_TYPE_AS_MASK(_type) (CustomDataMask)((CustomDataMask)1 << (CustomDataMask)(_type))
@@ -31,10 +31,13 @@
 extern "C" {
 #endif
 
+struct BVHTree;
 struct CustomData;
 struct CustomData_MeshMasks;
 struct Depsgraph;
 struct KeyBlock;
+struct MeshElemMap;
+struct MeshLoopSplitTopology;
 struct MLoop;
 struct MLoopTri;
 struct MVertTri;
@@ -52,6 +55,21 @@ bool BKE_mesh_runtime_clear_edit_data(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_geometry(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_cache(struct Mesh *mesh);
 
+void BKE_mesh_runtime_topology_cache_share(struct Mesh *mesh_dst, struct Mesh *mesh_src);
+void BKE_mesh_runtime_topology_cache_release(struct Mesh *mesh);
+const struct MeshElemMap *BKE_mesh_runtime_vert_loop_map_ensure(struct Mesh *mesh);
+struct MeshLoopSplitTopology *BKE_mesh_runtime_loop_split_topology_acquire(struct Mesh *mesh,
+                                                                           bool *r_do_store);
+void BKE_mesh_runtime_loop_split_topology_store(struct Mesh *mesh,
+                                                struct MeshLoopSplitTopology *topology);
+struct BVHTree *BKE_mesh_runtime_bvh_tree_take(struct Mesh *mesh,
+                                              int bvh_cache_type,
+                                              int *r_refit_count);
+bool BKE_mesh_runtime_bvh_tree_store(struct Mesh *mesh,
+                                     int bvh_cache_type,
+                                     struct BVHTree *tree,
+                                     int refit_count);
+
 void BKE_mesh_runtime_verttri_from_looptri(struct MVertTri *r_verttri,
                                            const struct MLoop *mloop,
                                            const struct MLoopTri *looptri,
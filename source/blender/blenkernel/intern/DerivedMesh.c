@@ -553,6 +553,26 @@ static void mesh_set_only_copy(Mesh *mesh, const CustomData_MeshMasks *mask)
 #endif
 }
 
+/**
+ * Create the deform mesh of a stack which only has deform modifiers. Its coordinates are the
+ * same as the final mesh, so the vertices (with their already computed normals) are shared with
+ * it instead of being copied and deformed a second time. Other layers reference the input mesh.
+ */
+static Mesh *mesh_create_deform_from_final(Mesh *mesh_input, Mesh *mesh_final)
+{
+  Mesh *mesh_deform = BKE_mesh_copy_for_eval(mesh_input, true);
+
+  CustomData_free_layers(&mesh_deform->vdata, CD_MVERT, mesh_deform->totvert);
+  CustomData_merge(
+      &mesh_final->vdata, &mesh_deform->vdata, CD_MASK_MVERT, CD_SHARE, mesh_deform->totvert);
+  BKE_mesh_update_customdata_pointers(mesh_deform, false);
+
+  mesh_deform->runtime.cd_dirty_vert &= ~CD_MASK_NORMAL;
+  mesh_deform->runtime.cd_dirty_vert |= (mesh_final->runtime.cd_dirty_vert & CD_MASK_NORMAL);
+
+  return mesh_deform;
+}
+
 void DM_add_vert_layer(DerivedMesh *dm, int type, eCDAllocType alloctype, void *layer)
 {
   CustomData_add_layer(&dm->vertData, type, alloctype, layer, dm->numVertData);
@@ -803,15 +823,19 @@ static void mesh_calc_modifier_final_normals(const Mesh *mesh_input,
     if (!CustomData_has_layer(&mesh_final->pdata, CD_NORMAL)) {
       float(*polynors)[3] = CustomData_add_layer(
           &mesh_final->pdata, CD_NORMAL, CD_CALLOC, NULL, mesh_final->totpoly);
-      BKE_mesh_calc_normals_poly(mesh_final->mvert,
-                                 NULL,
-                                 mesh_final->totvert,
-                                 mesh_final->mloop,
-                                 mesh_final->mpoly,
-                                 mesh_final->totloop,
-                                 mesh_final->totpoly,
-                                 polynors,
-                                 false);
+      /* Vertex normals are written as well, the vertices may be shared with the input mesh. */
+      mesh_final->mvert = CustomData_duplicate_referenced_layer(
+          &mesh_final->vdata, CD_MVERT, mesh_final->totvert);
+      BKE_mesh_calc_normals_poly_ex(mesh_final->mvert,
+                                    NULL,
+                                    mesh_final->totvert,
+                                    mesh_final->mloop,
+                                    mesh_final->mpoly,
+                                    mesh_final->totloop,
+                                    mesh_final->totpoly,
+                                    polynors,
+                                    false,
+                                    BKE_mesh_runtime_vert_loop_map_ensure(mesh_final));
     }
   }
 
@@ -901,6 +925,8 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
   float(*deformed_verts)[3] = NULL;
   int num_deformed_verts = mesh_input->totvert;
   bool isPrevDeform = false;
+  /* The whole stack only deforms, so the deform mesh is created from the final one. */
+  bool deform_from_final = false;
 
   /* Mesh with constructive modifiers but no deformation applied. Tracked
    * along with final mesh if undeformed / orco coordinates are requested
@@ -1003,10 +1029,15 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
      * places that wish to use the original mesh but with deformed
      * coordinates (like vertex paint). */
     if (r_deform) {
-      mesh_deform = BKE_mesh_copy_for_eval(mesh_input, true);
+      if (md == NULL && deformed_verts) {
+        deform_from_final = true;
+      }
+      else {
+        mesh_deform = BKE_mesh_copy_for_eval(mesh_input, true);
 
-      if (deformed_verts) {
-        BKE_mesh_vert_coords_apply(mesh_deform, deformed_verts);
+        if (deformed_verts) {
+          BKE_mesh_vert_coords_apply(mesh_deform, deformed_verts);
+        }
       }
     }
   }
@@ -1361,6 +1392,15 @@ static void mesh_calc_modifiers(struct Depsgraph *depsgraph,
     mesh_calc_finalize(mesh_input, mesh_final);
   }
 
+  if (deform_from_final) {
+    BLI_assert(is_own_mesh);
+    mesh_deform = mesh_create_deform_from_final(mesh_input, mesh_final);
+
+    if (final_datamask.vmask & CD_MASK_ORCO) {
+      add_orco_mesh(ob, NULL, mesh_deform, NULL, CD_ORCO);
+    }
+  }
+
   /* Return final mesh */
   *r_final = mesh_final;
   if (r_deform) {
@@ -1424,15 +1464,19 @@ static void editbmesh_calc_modifier_final_normals(Mesh *mesh_final,
     if (!CustomData_has_layer(&mesh_final->pdata, CD_NORMAL)) {
       float(*polynors)[3] = CustomData_add_layer(
           &mesh_final->pdata, CD_NORMAL, CD_CALLOC, NULL, mesh_final->totpoly);
-      BKE_mesh_calc_normals_poly(mesh_final->mvert,
-                                 NULL,
-                                 mesh_final->totvert,
-                                 mesh_final->mloop,
-                                 mesh_final->mpoly,
-                                 mesh_final->totloop,
-                                 mesh_final->totpoly,
-                                 polynors,
-                                 false);
+      /* Vertex normals are written as well, the vertices may be shared with the input mesh. */
+      mesh_final->mvert = CustomData_duplicate_referenced_layer(
+          &mesh_final->vdata, CD_MVERT, mesh_final->totvert);
+      BKE_mesh_calc_normals_poly_ex(mesh_final->mvert,
+                                    NULL,
+                                    mesh_final->totvert,
+                                    mesh_final->mloop,
+                                    mesh_final->mpoly,
+                                    mesh_final->totloop,
+                                    mesh_final->totpoly,
+                                    polynors,
+                                    false,
+                                    BKE_mesh_runtime_vert_loop_map_ensure(mesh_final));
     }
   }
 
@@ -261,6 +261,9 @@ void BKE_animdata_free(ID *id, const bool do_id_user)
       /* free driver array cache */
       MEM_SAFE_FREE(adt->driver_array);
 
+      /* free compiled action cache */
+      BKE_animsys_free_action_eval_cache(adt);
+
       /* free overrides */
       /* TODO... */
 
@@ -347,6 +350,7 @@ AnimData *BKE_animdata_copy(Main *bmain, AnimData *adt, const int flag)
   /* duplicate drivers (F-Curves) */
   BKE_fcurves_copy(&dadt->drivers, &adt->drivers);
   dadt->driver_array = NULL;
+  dadt->action_eval_cache = NULL;
 
   /* don't copy overrides */
   BLI_listbase_clear(&dadt->overrides);
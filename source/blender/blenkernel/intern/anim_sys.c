@@ -36,6 +36,7 @@
 #include "BLI_math_rotation.h"
 #include "BLI_math_vector.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -702,6 +703,220 @@ void animsys_evaluate_action(PointerRNA *ptr,
   animsys_evaluate_action_ex(ptr, act, ctime, flush_to_original);
 }
 
+/* ----------------------------------------- */
+
+/* Active action compiled for evaluation of an evaluated (copy-on-write) ID.
+ *
+ * Resolving RNA paths of all F-Curves on every frame is a big part of playback time for scenes
+ * with many animated characters. The evaluated ID keeps the same memory until it is copied
+ * again from the original, which resets the cache (same as the driver array), so the resolved
+ * properties can be kept across frames. The action itself is copied in-place when it is tagged
+ * for update, which is detected using its copy-on-write recalc flag. */
+
+/* Below this number of channels the values are computed without threading. */
+#define ACTION_EVAL_CACHE_THREADING_THRESHOLD 256
+
+typedef struct ActionEvalChannel {
+  FCurve *fcu;
+  PathResolvedRNA anim_rna;
+  /* Keyframe segment of the previous evaluation, see #evaluate_fcurve_segment_cached(). */
+  int segment;
+  bool is_resolved;
+  /* Value written to the property by the previous evaluation, see
+   * #BKE_animsys_action_eval_changed_channels(). */
+  bool is_written;
+  float written_value;
+  float value;
+} ActionEvalChannel;
+
+typedef struct ActionEvalCache {
+  bAction *action;
+  int num_channels;
+  ActionEvalChannel *channels;
+} ActionEvalCache;
+
+void BKE_animsys_free_action_eval_cache(AnimData *adt)
+{
+  ActionEvalCache *cache = adt->action_eval_cache;
+  if (cache == NULL) {
+    return;
+  }
+  MEM_SAFE_FREE(cache->channels);
+  MEM_freeN(cache);
+  adt->action_eval_cache = NULL;
+}
+
+/* Pointers into ID-blocks which store their elements in CustomData layers (vertices and such)
+ * change during evaluation, so paths are resolved on every frame for them. */
+static bool animsys_action_eval_cache_supported(ID *id)
+{
+  return DEG_is_evaluated_id(id) && !ELEM(GS(id->name), ID_ME, ID_HA, ID_PT);
+}
+
+static bool animsys_action_eval_cache_is_valid(const ActionEvalCache *cache, bAction *act)
+{
+  /* Frame changes tag the animation of the action as well, only a copy of the action from the
+   * original one invalidates the cache. */
+  if (cache->action != act || (act->id.recalc & ID_RECALC_COPY_ON_WRITE)) {
+    return false;
+  }
+  /* Cheap sanity check of the F-Curves, in case the action was modified in a way which does not
+   * tag it for an update. */
+  int index = 0;
+  LISTBASE_FOREACH (FCurve *, fcu, &act->curves) {
+    if (index == cache->num_channels || cache->channels[index].fcu != fcu) {
+      return false;
+    }
+    index++;
+  }
+  return index == cache->num_channels;
+}
+
+static ActionEvalCache *animsys_action_eval_cache_ensure(PointerRNA *ptr,
+                                                         AnimData *adt,
+                                                         bAction *act)
+{
+  ActionEvalCache *cache = adt->action_eval_cache;
+  if (cache != NULL && animsys_action_eval_cache_is_valid(cache, act)) {
+    return cache;
+  }
+  BKE_animsys_free_action_eval_cache(adt);
+
+  cache = MEM_callocN(sizeof(*cache), __func__);
+  cache->action = act;
+  cache->num_channels = BLI_listbase_count(&act->curves);
+  cache->channels = MEM_calloc_arrayN(cache->num_channels, sizeof(*cache->channels), __func__);
+  ActionEvalChannel *channel = cache->channels;
+  LISTBASE_FOREACH (FCurve *, fcu, &act->curves) {
+    channel->fcu = fcu;
+    channel->is_resolved = BKE_animsys_store_rna_setting(
+        ptr, fcu->rna_path, fcu->array_index, &channel->anim_rna);
+    channel++;
+  }
+  adt->action_eval_cache = cache;
+  return cache;
+}
+
+static bool animsys_action_eval_channel_is_active(const ActionEvalChannel *channel)
+{
+  const FCurve *fcu = channel->fcu;
+  if (!channel->is_resolved) {
+    return false;
+  }
+  /* Same checks as animsys_evaluate_fcurves(), muting does not invalidate the cache. */
+  if ((fcu->grp != NULL) && (fcu->grp->flag & AGRP_MUTED)) {
+    return false;
+  }
+  if ((fcu->flag & (FCURVE_MUTED | FCURVE_DISABLED))) {
+    return false;
+  }
+  return !BKE_fcurve_is_empty(channel->fcu);
+}
+
+typedef struct ActionEvalCacheData {
+  ActionEvalCache *cache;
+  float ctime;
+} ActionEvalCacheData;
+
+static void animsys_action_eval_cache_calc_cb(void *__restrict userdata,
+                                              const int index,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  ActionEvalCacheData *data = userdata;
+  ActionEvalChannel *channel = &data->cache->channels[index];
+  if (!animsys_action_eval_channel_is_active(channel)) {
+    return;
+  }
+  FCurve *fcu = channel->fcu;
+  channel->value = evaluate_fcurve_segment_cached(fcu, data->ctime, &channel->segment);
+  fcu->curval = channel->value; /* debug display only, not thread safe! */
+}
+
+/* Same as animsys_evaluate_action_ex(), using the compiled action of the animation data.
+ * Values are calculated for all channels first (in parallel for big actions), and then written
+ * in the order of the F-Curves. */
+static void animsys_evaluate_action_cached(PointerRNA *ptr,
+                                           AnimData *adt,
+                                           float ctime,
+                                           const bool flush_to_original)
+{
+  bAction *act = adt->action;
+
+  action_idcode_patch_check(ptr->owner_id, act);
+
+  ActionEvalCache *cache = animsys_action_eval_cache_ensure(ptr, adt, act);
+
+  ActionEvalCacheData data = {
+      .cache = cache,
+      .ctime = ctime,
+  };
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (cache->num_channels > ACTION_EVAL_CACHE_THREADING_THRESHOLD);
+  BLI_task_parallel_range(
+      0, cache->num_channels, &data, animsys_action_eval_cache_calc_cb, &settings);
+
+  for (int i = 0; i < cache->num_channels; i++) {
+    ActionEvalChannel *channel = &cache->channels[i];
+    if (!animsys_action_eval_channel_is_active(channel)) {
+      continue;
+    }
+    /* Properties of the evaluated ID itself keep their value until it is copied again, which
+     * resets the cache. Not writing unchanged values keeps values set by drivers of properties
+     * which are not re-evaluated when the animation did not change. */
+    if (!(channel->is_written && channel->anim_rna.ptr.owner_id == ptr->owner_id &&
+          channel->written_value == channel->value)) {
+      BKE_animsys_write_rna_setting(&channel->anim_rna, channel->value);
+      channel->written_value = channel->value;
+      channel->is_written = true;
+    }
+    if (flush_to_original) {
+      FCurve *fcu = channel->fcu;
+      animsys_write_orig_anim_rna(ptr, fcu->rna_path, fcu->array_index, channel->value);
+    }
+  }
+}
+
+/* Check which F-Curves of the active action will write a different value when the evaluated ID
+ * is evaluated at the given time, without writing anything. Used by the dependency graph to
+ * only flush frame changes to animated properties which change.
+ *
+ * Returns false when this can not be determined (no compiled action, NLA, overrides), in which
+ * case all properties are to be considered changed. */
+bool BKE_animsys_action_eval_changed_channels(
+    ID *id, AnimData *adt, float ctime, bool *r_changed, int num_channels)
+{
+  if (adt == NULL || adt->action == NULL || !animsys_action_eval_cache_supported(id)) {
+    return false;
+  }
+  if ((adt->nla_tracks.first) && !(adt->flag & ADT_NLA_EVAL_OFF)) {
+    return false;
+  }
+  if (!BLI_listbase_is_empty(&adt->overrides)) {
+    return false;
+  }
+  ActionEvalCache *cache = adt->action_eval_cache;
+  if (cache == NULL || cache->num_channels != num_channels ||
+      !animsys_action_eval_cache_is_valid(cache, adt->action)) {
+    return false;
+  }
+  for (int i = 0; i < num_channels; i++) {
+    ActionEvalChannel *channel = &cache->channels[i];
+    if (!animsys_action_eval_channel_is_active(channel)) {
+      r_changed[i] = false;
+    }
+    else if (!channel->is_written || channel->anim_rna.ptr.owner_id != id) {
+      r_changed[i] = true;
+    }
+    else {
+      int segment = channel->segment;
+      const float value = evaluate_fcurve_segment_cached(channel->fcu, ctime, &segment);
+      r_changed[i] = (value != channel->written_value);
+    }
+  }
+  return true;
+}
+
 /* ***************************************** */
 /* NLA System - Evaluation */
 
@@ -2527,7 +2742,12 @@ void BKE_animsys_evaluate_animdata(
     }
     /* evaluate Active Action only */
     else if (adt->action) {
-      animsys_evaluate_action_ex(&id_ptr, adt->action, ctime, flush_to_original);
+      if (animsys_action_eval_cache_supported(id)) {
+        animsys_evaluate_action_cached(&id_ptr, adt, ctime, flush_to_original);
+      }
+      else {
+        animsys_evaluate_action_ex(&id_ptr, adt->action, ctime, flush_to_original);
+      }
     }
   }
 
@@ -75,6 +75,10 @@
 
 #include "CLG_log.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static CLG_LogRef LOG = {"bke.armature"};
 
 /*************************** Prototypes ***************************/
@@ -1331,12 +1335,15 @@ void BKE_pchan_bbone_deform_segment_index(const bPoseChannel *pchan,
   *r_blend_next = blend;
 }
 
-/* Add the effect of one bone or B-Bone segment to the accumulated result. */
+/* Add the effect of one bone or B-Bone segment to the accumulated result.
+ *
+ * \note co_accum must have room for 4 floats, the SSE path accumulates a full column which
+ * leaves an unused value in the 4th component. */
 static void pchan_deform_accumulate(const DualQuat *deform_dq,
                                     const float deform_mat[4][4],
                                     const float co_in[3],
                                     float weight,
-                                    float co_accum[3],
+                                    float co_accum[4],
                                     DualQuat *dq_accum,
                                     float mat_accum[3][3])
 {
@@ -1350,11 +1357,24 @@ static void pchan_deform_accumulate(const DualQuat *deform_dq,
     add_weighted_dq_dq(dq_accum, deform_dq, weight);
   }
   else {
+#ifdef __SSE2__
+    /* Same operation order as mul_v3_m4v3() followed by madd_v3_v3fl(), so the result
+     * matches the scalar code exactly. */
+    const __m128 co = _mm_set_ps(0.0f, co_in[2], co_in[1], co_in[0]);
+    __m128 tmp = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(deform_mat[0]), _mm_set1_ps(co_in[0])),
+                            _mm_mul_ps(_mm_loadu_ps(deform_mat[1]), _mm_set1_ps(co_in[1])));
+    tmp = _mm_add_ps(tmp, _mm_mul_ps(_mm_loadu_ps(deform_mat[2]), _mm_set1_ps(co_in[2])));
+    tmp = _mm_add_ps(tmp, _mm_loadu_ps(deform_mat[3]));
+    tmp = _mm_sub_ps(tmp, co);
+    _mm_storeu_ps(co_accum,
+                  _mm_add_ps(_mm_loadu_ps(co_accum), _mm_mul_ps(tmp, _mm_set1_ps(weight))));
+#else
     float tmp[3];
     mul_v3_m4v3(tmp, deform_mat, co_in);
 
     sub_v3_v3(tmp, co_in);
     madd_v3_v3fl(co_accum, tmp, weight);
+#endif
 
     if (mat_accum) {
       float tmpmat[3][3];
@@ -1368,7 +1388,7 @@ static void pchan_deform_accumulate(const DualQuat *deform_dq,
 static void b_bone_deform(const bPoseChannel *pchan,
                           const float co[3],
                           float weight,
-                          float vec[3],
+                          float vec[4],
                           DualQuat *dq,
                           float defmat[3][3])
 {
@@ -1447,7 +1467,7 @@ float distfactor_to_bone(
 }
 
 static float dist_bone_deform(
-    bPoseChannel *pchan, float vec[3], DualQuat *dq, float mat[3][3], const float co[3])
+    bPoseChannel *pchan, float vec[4], DualQuat *dq, float mat[3][3], const float co[3])
 {
   Bone *bone = pchan->bone;
   float fac, contrib = 0.0;
@@ -1478,7 +1498,7 @@ static float dist_bone_deform(
 
 static void pchan_bone_deform(bPoseChannel *pchan,
                               float weight,
-                              float vec[3],
+                              float vec[4],
                               DualQuat *dq,
                               float mat[3][3],
                               const float co[3],
@@ -1543,7 +1563,7 @@ static void armature_vert_task(void *__restrict userdata,
   DualQuat sumdq, *dq = NULL;
   bPoseChannel *pchan;
   float *co, dco[3];
-  float sumvec[3], summat[3][3];
+  float sumvec[4], summat[3][3];
   float *vec = NULL, (*smat)[3] = NULL;
   float contrib = 0.0f;
   float armature_weight = 1.0f; /* default to 1 if no overall def group */
@@ -1554,7 +1574,7 @@ static void armature_vert_task(void *__restrict userdata,
     dq = &sumdq;
   }
   else {
-    sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
+    zero_v4(sumvec);
     vec = sumvec;
 
     if (defMats) {
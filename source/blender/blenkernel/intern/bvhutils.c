@@ -47,19 +47,22 @@
 
 typedef struct BVHCacheItem {
   bool is_filled;
+  /** Number of times the tree has been refitted since it was built, see #BVHCACHE_REFIT_MAX. */
+  int refit_count;
   BVHTree *tree;
+  /** Held while the tree is built, trees of other types can be built and read meanwhile. */
+  ThreadMutex mutex;
 } BVHCacheItem;
 
 typedef struct BVHCache {
   BVHCacheItem items[BVHTREE_MAX_ITEM];
-  ThreadMutex mutex;
 } BVHCache;
 
 /**
  * Queries a bvhcache for the cache bvhtree of the request type
  *
- * When the `r_locked` is filled and the tree could not be found the caches mutex will be
- * locked. This mutex can be unlocked by calling `bvhcache_unlock`.
+ * When the `r_locked` is filled and the tree could not be found the mutex of the requested type
+ * will be locked. This mutex can be unlocked by calling `bvhcache_unlock`.
  *
  * When `r_locked` is used the `mesh_eval_mutex` must contain the `Mesh_Runtime.eval_mutex`.
  */
@@ -92,10 +95,10 @@ static bool bvhcache_find(BVHCache **bvh_cache_p,
     return true;
   }
   if (do_lock) {
-    BLI_mutex_lock(&bvh_cache->mutex);
+    BLI_mutex_lock(&bvh_cache->items[type].mutex);
     bool in_cache = bvhcache_find(bvh_cache_p, type, r_tree, NULL, NULL);
     if (in_cache) {
-      BLI_mutex_unlock(&bvh_cache->mutex);
+      BLI_mutex_unlock(&bvh_cache->items[type].mutex);
       return in_cache;
     }
     *r_locked = true;
@@ -103,10 +106,10 @@ static bool bvhcache_find(BVHCache **bvh_cache_p,
   return false;
 }
 
-static void bvhcache_unlock(BVHCache *bvh_cache, bool lock_started)
+static void bvhcache_unlock(BVHCache *bvh_cache, BVHCacheType type, bool lock_started)
 {
   if (lock_started) {
-    BLI_mutex_unlock(&bvh_cache->mutex);
+    BLI_mutex_unlock(&bvh_cache->items[type].mutex);
   }
 }
 
@@ -127,7 +130,9 @@ bool bvhcache_has_tree(const BVHCache *bvh_cache, const BVHTree *tree)
 BVHCache *bvhcache_init(void)
 {
   BVHCache *cache = MEM_callocN(sizeof(BVHCache), __func__);
-  BLI_mutex_init(&cache->mutex);
+  for (BVHCacheType i = 0; i < BVHTREE_MAX_ITEM; i++) {
+    BLI_mutex_init(&cache->items[i].mutex);
+  }
   return cache;
 }
 /**
@@ -146,17 +151,45 @@ static void bvhcache_insert(BVHCache *bvh_cache, BVHTree *tree, BVHCacheType typ
   item->is_filled = true;
 }
 
+/**
+ * Trees of evaluated meshes which can be refitted to the positions of the next evaluated mesh
+ * with the same topology, see #BKE_mesh_runtime_bvh_tree_store.
+ */
+static bool bvhcache_type_is_refittable(BVHCacheType type)
+{
+  return ELEM(type,
+              BVHTREE_FROM_VERTS,
+              BVHTREE_FROM_EDGES,
+              BVHTREE_FROM_LOOPTRI,
+              BVHTREE_FROM_LOOPTRI_NO_HIDDEN,
+              BVHTREE_FROM_LOOSEVERTS,
+              BVHTREE_FROM_LOOSEEDGES);
+}
+
 /**
  * frees a bvhcache
  */
 void bvhcache_free(BVHCache *bvh_cache)
+{
+  bvhcache_free_ex(bvh_cache, NULL);
+}
+
+/**
+ * Frees a bvhcache, handing the trees built for \a mesh over to its topology cache,
+ * so that the next evaluated mesh of the same topology refits them instead of building new ones.
+ */
+void bvhcache_free_ex(BVHCache *bvh_cache, Mesh *mesh)
 {
   for (BVHCacheType index = 0; index < BVHTREE_MAX_ITEM; index++) {
     BVHCacheItem *item = &bvh_cache->items[index];
+    if (mesh != NULL && item->tree != NULL && bvhcache_type_is_refittable(index) &&
+        BKE_mesh_runtime_bvh_tree_store(mesh, (int)index, item->tree, item->refit_count)) {
+      item->tree = NULL;
+    }
     BLI_bvhtree_free(item->tree);
     item->tree = NULL;
+    BLI_mutex_end(&item->mutex);
   }
-  BLI_mutex_end(&bvh_cache->mutex);
   MEM_freeN(bvh_cache);
 }
 
@@ -531,6 +564,72 @@ static void mesh_edges_spherecast(void *userdata,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Tree Refit
+ *
+ * Cached trees of deformed meshes are refitted to the new positions instead of being rebuilt,
+ * see #BKE_mesh_runtime_bvh_tree_take.
+ * \{ */
+
+/* Refitting keeps the hierarchy built for the positions the tree was first built with,
+ * its quality degrades as the mesh deforms, so trees are rebuilt after this many refits. */
+#define BVHCACHE_REFIT_MAX 32
+
+/**
+ * Return \a tree_refit when it can be refitted to \a leaf_num elements with the given settings,
+ * otherwise free it and return NULL.
+ *
+ * \note The axis of recycled trees isn't checked, they are all built by
+ * #BKE_bvhtree_from_mesh_get which always uses the same one.
+ */
+static BVHTree *bvhtree_refit_check(BVHTree *tree_refit,
+                                    int leaf_num,
+                                    float epsilon,
+                                    int tree_type)
+{
+  if (tree_refit != NULL) {
+    if ((BLI_bvhtree_get_len(tree_refit) == leaf_num) &&
+        (BLI_bvhtree_get_tree_type(tree_refit) == tree_type) &&
+        /* Matches the clamping of #BLI_bvhtree_new. */
+        (BLI_bvhtree_get_epsilon(tree_refit) == max_ff(FLT_EPSILON, epsilon))) {
+      return tree_refit;
+    }
+    BLI_bvhtree_free(tree_refit);
+  }
+  return NULL;
+}
+
+/**
+ * Insert the leaf of element \a index, or when refitting, update the bounds of the next leaf
+ * (leaves are refitted in the order they have been inserted).
+ */
+BLI_INLINE void bvhtree_leaf_add(BVHTree *tree,
+                                 const bool is_refit,
+                                 int *leaf_index,
+                                 int index,
+                                 const float co[3],
+                                 int numpoints)
+{
+  if (is_refit) {
+    BLI_bvhtree_update_node(tree, (*leaf_index)++, co, NULL, numpoints);
+  }
+  else {
+    BLI_bvhtree_insert(tree, index, co, numpoints);
+  }
+}
+
+static void bvhtree_leaves_finish(BVHTree *tree, const bool is_refit, const int balance_flag)
+{
+  if (is_refit) {
+    BLI_bvhtree_update_tree(tree);
+  }
+  else {
+    BLI_bvhtree_balance_ex(tree, balance_flag);
+  }
+}
+
+/** \} */
+
 /*
  * BVH builders
  */
@@ -572,13 +671,18 @@ static BVHTree *bvhtree_from_editmesh_verts_create_tree(float epsilon,
   return tree;
 }
 
+/**
+ * \param tree_refit: Optional tree to refit instead of building a new one,
+ * with one leaf per active element (see #bvhtree_refit_check).
+ */
 static BVHTree *bvhtree_from_mesh_verts_create_tree(float epsilon,
                                                     int tree_type,
                                                     int axis,
                                                     const MVert *vert,
                                                     const int verts_num,
                                                     const BLI_bitmap *verts_mask,
-                                                    int verts_num_active)
+                                                    int verts_num_active,
+                                                    BVHTree *tree_refit)
 {
   BVHTree *tree = NULL;
 
@@ -590,17 +694,19 @@ static BVHTree *bvhtree_from_mesh_verts_create_tree(float epsilon,
   }
 
   if (verts_num_active) {
-    tree = BLI_bvhtree_new(verts_num_active, epsilon, tree_type, axis);
+    const bool is_refit = tree_refit != NULL;
+    tree = is_refit ? tree_refit : BLI_bvhtree_new(verts_num_active, epsilon, tree_type, axis);
 
     if (tree) {
+      int leaf_index = 0;
       for (int i = 0; i < verts_num; i++) {
         if (verts_mask && !BLI_BITMAP_TEST_BOOL(verts_mask, i)) {
           continue;
         }
-        BLI_bvhtree_insert(tree, i, vert[i].co, 1);
+        bvhtree_leaf_add(tree, is_refit, &leaf_index, i, vert[i].co, 1);
       }
       BLI_assert(BLI_bvhtree_get_len(tree) == verts_num_active);
-      BLI_bvhtree_balance(tree);
+      bvhtree_leaves_finish(tree, is_refit, 0);
     }
   }
 
@@ -655,7 +761,7 @@ BVHTree *bvhtree_from_editmesh_verts_ex(BVHTreeFromEditMesh *data,
       bvhcache_insert(*bvh_cache_p, tree, bvh_cache_type);
       data->cached = true;
     }
-    bvhcache_unlock(*bvh_cache_p, lock_started);
+    bvhcache_unlock(*bvh_cache_p, bvh_cache_type, lock_started);
   }
   else {
     tree = bvhtree_from_editmesh_verts_create_tree(
@@ -710,14 +816,14 @@ BVHTree *bvhtree_from_mesh_verts_ex(BVHTreeFromMesh *data,
 
   if (in_cache == false) {
     tree = bvhtree_from_mesh_verts_create_tree(
-        epsilon, tree_type, axis, vert, verts_num, verts_mask, verts_num_active);
+        epsilon, tree_type, axis, vert, verts_num, verts_mask, verts_num_active, NULL);
 
     if (bvh_cache_p) {
       /* Save on cache for later use */
       /* printf("BVHTree built and saved on cache\n"); */
       BVHCache *bvh_cache = *bvh_cache_p;
       bvhcache_insert(bvh_cache, tree, bvh_cache_type);
-      bvhcache_unlock(bvh_cache, lock_started);
+      bvhcache_unlock(bvh_cache, bvh_cache_type, lock_started);
       in_cache = true;
     }
   }
@@ -774,6 +880,10 @@ static BVHTree *bvhtree_from_editmesh_edges_create_tree(float epsilon,
   return tree;
 }
 
+/**
+ * \param tree_refit: Optional tree to refit instead of building a new one,
+ * with one leaf per active element (see #bvhtree_refit_check).
+ */
 static BVHTree *bvhtree_from_mesh_edges_create_tree(const MVert *vert,
                                                     const MEdge *edge,
                                                     const int edge_num,
@@ -781,7 +891,8 @@ static BVHTree *bvhtree_from_mesh_edges_create_tree(const MVert *vert,
                                                     int edges_num_active,
                                                     float epsilon,
                                                     int tree_type,
-                                                    int axis)
+                                                    int axis,
+                                                    BVHTree *tree_refit)
 {
   BVHTree *tree = NULL;
 
@@ -794,8 +905,10 @@ static BVHTree *bvhtree_from_mesh_edges_create_tree(const MVert *vert,
 
   if (edges_num_active) {
     /* Create a bvh-tree of the given target */
-    tree = BLI_bvhtree_new(edges_num_active, epsilon, tree_type, axis);
+    const bool is_refit = tree_refit != NULL;
+    tree = is_refit ? tree_refit : BLI_bvhtree_new(edges_num_active, epsilon, tree_type, axis);
     if (tree) {
+      int leaf_index = 0;
       for (int i = 0; i < edge_num; i++) {
         if (edges_mask && !BLI_BITMAP_TEST_BOOL(edges_mask, i)) {
           continue;
@@ -804,9 +917,9 @@ static BVHTree *bvhtree_from_mesh_edges_create_tree(const MVert *vert,
         copy_v3_v3(co[0], vert[edge[i].v1].co);
         copy_v3_v3(co[1], vert[edge[i].v2].co);
 
-        BLI_bvhtree_insert(tree, i, co[0], 2);
+        bvhtree_leaf_add(tree, is_refit, &leaf_index, i, co[0], 2);
       }
-      BLI_bvhtree_balance(tree);
+      bvhtree_leaves_finish(tree, is_refit, 0);
     }
   }
 
@@ -864,7 +977,7 @@ BVHTree *bvhtree_from_editmesh_edges_ex(BVHTreeFromEditMesh *data,
       bvhcache_insert(bvh_cache, tree, bvh_cache_type);
       data->cached = true;
     }
-    bvhcache_unlock(bvh_cache, lock_started);
+    bvhcache_unlock(bvh_cache, bvh_cache_type, lock_started);
   }
   else {
     tree = bvhtree_from_editmesh_edges_create_tree(
@@ -922,14 +1035,14 @@ BVHTree *bvhtree_from_mesh_edges_ex(BVHTreeFromMesh *data,
 
   if (in_cache == false) {
     tree = bvhtree_from_mesh_edges_create_tree(
-        vert, edge, edges_num, edges_mask, edges_num_active, epsilon, tree_type, axis);
+        vert, edge, edges_num, edges_mask, edges_num_active, epsilon, tree_type, axis, NULL);
 
     if (bvh_cache_p) {
       BVHCache *bvh_cache = *bvh_cache_p;
       /* Save on cache for later use */
       /* printf("BVHTree built and saved on cache\n"); */
       bvhcache_insert(bvh_cache, tree, bvh_cache_type);
-      bvhcache_unlock(bvh_cache, lock_started);
+      bvhcache_unlock(bvh_cache, bvh_cache_type, lock_started);
       in_cache = true;
     }
   }
@@ -989,7 +1102,8 @@ static BVHTree *bvhtree_from_mesh_faces_create_tree(float epsilon,
         }
       }
       BLI_assert(BLI_bvhtree_get_len(tree) == faces_num_active);
-      BLI_bvhtree_balance(tree);
+      /* Cached trees are queried far more often than they are built. */
+      BLI_bvhtree_balance_ex(tree, BVH_BALANCE_SAH);
     }
   }
 
@@ -1058,7 +1172,7 @@ BVHTree *bvhtree_from_mesh_faces_ex(BVHTreeFromMesh *data,
       /* printf("BVHTree built and saved on cache\n"); */
       BVHCache *bvh_cache = *bvh_cache_p;
       bvhcache_insert(bvh_cache, tree, bvh_cache_type);
-      bvhcache_unlock(bvh_cache, lock_started);
+      bvhcache_unlock(bvh_cache, bvh_cache_type, lock_started);
       in_cache = true;
     }
   }
@@ -1126,6 +1240,10 @@ static BVHTree *bvhtree_from_editmesh_looptri_create_tree(float epsilon,
   return tree;
 }
 
+/**
+ * \param tree_refit: Optional tree to refit instead of building a new one,
+ * with one leaf per active element (see #bvhtree_refit_check).
+ */
 static BVHTree *bvhtree_from_mesh_looptri_create_tree(float epsilon,
                                                       int tree_type,
                                                       int axis,
@@ -1134,7 +1252,8 @@ static BVHTree *bvhtree_from_mesh_looptri_create_tree(float epsilon,
                                                       const MLoopTri *looptri,
                                                       const int looptri_num,
                                                       const BLI_bitmap *looptri_mask,
-                                                      int looptri_num_active)
+                                                      int looptri_num_active,
+                                                      BVHTree *tree_refit)
 {
   BVHTree *tree = NULL;
 
@@ -1148,8 +1267,10 @@ static BVHTree *bvhtree_from_mesh_looptri_create_tree(float epsilon,
   if (looptri_num_active) {
     /* Create a bvh-tree of the given target */
     /* printf("%s: building BVH, total=%d\n", __func__, numFaces); */
-    tree = BLI_bvhtree_new(looptri_num_active, epsilon, tree_type, axis);
+    const bool is_refit = tree_refit != NULL;
+    tree = is_refit ? tree_refit : BLI_bvhtree_new(looptri_num_active, epsilon, tree_type, axis);
     if (tree) {
+      int leaf_index = 0;
       if (vert && looptri) {
         for (int i = 0; i < looptri_num; i++) {
           float co[3][3];
@@ -1161,11 +1282,12 @@ static BVHTree *bvhtree_from_mesh_looptri_create_tree(float epsilon,
           copy_v3_v3(co[1], vert[mloop[looptri[i].tri[1]].v].co);
           copy_v3_v3(co[2], vert[mloop[looptri[i].tri[2]].v].co);
 
-          BLI_bvhtree_insert(tree, i, co[0], 3);
+          bvhtree_leaf_add(tree, is_refit, &leaf_index, i, co[0], 3);
         }
       }
       BLI_assert(BLI_bvhtree_get_len(tree) == looptri_num_active);
-      BLI_bvhtree_balance(tree);
+      /* Cached trees are queried far more often than they are built. */
+      bvhtree_leaves_finish(tree, is_refit, BVH_BALANCE_SAH);
     }
   }
 
@@ -1230,7 +1352,7 @@ BVHTree *bvhtree_from_editmesh_looptri_ex(BVHTreeFromEditMesh *data,
       /* printf("BVHTree built and saved on cache\n"); */
       bvhcache_insert(bvh_cache, tree, bvh_cache_type);
     }
-    bvhcache_unlock(bvh_cache, lock_started);
+    bvhcache_unlock(bvh_cache, bvh_cache_type, lock_started);
   }
   else {
     tree = bvhtree_from_editmesh_looptri_create_tree(
@@ -1293,12 +1415,13 @@ BVHTree *bvhtree_from_mesh_looptri_ex(BVHTreeFromMesh *data,
                                                  looptri,
                                                  looptri_num,
                                                  looptri_mask,
-                                                 looptri_num_active);
+                                                 looptri_num_active,
+                                                 NULL);
 
     if (bvh_cache_p) {
       BVHCache *bvh_cache = *bvh_cache_p;
       bvhcache_insert(bvh_cache, tree, bvh_cache_type);
-      bvhcache_unlock(bvh_cache, lock_started);
+      bvhcache_unlock(bvh_cache, bvh_cache_type, lock_started);
       in_cache = true;
     }
   }
@@ -1396,8 +1519,139 @@ static BLI_bitmap *looptri_no_hidden_map_get(const MPoly *mpoly,
   return looptri_mask;
 }
 
+/**
+ * Build the tree of the request type for \a mesh.
+ *
+ * \param tree_refit: Optional tree of the same type built for a mesh with the same topology,
+ * which is refitted to the positions of \a mesh when it matches, or freed otherwise.
+ * \param r_is_refit: Set when \a tree_refit has been refitted and returned.
+ */
+static BVHTree *bvhtree_from_mesh_create_tree(Mesh *mesh,
+                                              const BVHCacheType bvh_cache_type,
+                                              const int tree_type,
+                                              BVHTree *tree_refit,
+                                              bool *r_is_refit)
+{
+  BVHTree *tree = NULL;
+
+  switch (bvh_cache_type) {
+    case BVHTREE_FROM_VERTS:
+    case BVHTREE_FROM_LOOSEVERTS: {
+      BLI_bitmap *loose_verts_mask = NULL;
+      int loose_vert_len = -1;
+      int verts_len = mesh->totvert;
+
+      if (bvh_cache_type == BVHTREE_FROM_LOOSEVERTS) {
+        loose_verts_mask = loose_verts_map_get(
+            mesh->medge, mesh->totedge, mesh->mvert, verts_len, &loose_vert_len);
+      }
+
+      tree_refit = bvhtree_refit_check(
+          tree_refit, loose_verts_mask ? loose_vert_len : verts_len, 0.0f, tree_type);
+      tree = bvhtree_from_mesh_verts_create_tree(0.0f,
+                                                 tree_type,
+                                                 6,
+                                                 mesh->mvert,
+                                                 verts_len,
+                                                 loose_verts_mask,
+                                                 loose_vert_len,
+                                                 tree_refit);
+
+      if (loose_verts_mask != NULL) {
+        MEM_freeN(loose_verts_mask);
+      }
+      break;
+    }
+
+    case BVHTREE_FROM_EDGES:
+    case BVHTREE_FROM_LOOSEEDGES: {
+      BLI_bitmap *loose_edges_mask = NULL;
+      int loose_edges_len = -1;
+      int edges_len = mesh->totedge;
+
+      if (bvh_cache_type == BVHTREE_FROM_LOOSEEDGES) {
+        loose_edges_mask = loose_edges_map_get(mesh->medge, edges_len, &loose_edges_len);
+      }
+
+      tree_refit = bvhtree_refit_check(
+          tree_refit, loose_edges_mask ? loose_edges_len : edges_len, 0.0f, tree_type);
+      tree = bvhtree_from_mesh_edges_create_tree(mesh->mvert,
+                                                 mesh->medge,
+                                                 edges_len,
+                                                 loose_edges_mask,
+                                                 loose_edges_len,
+                                                 0.0f,
+                                                 tree_type,
+                                                 6,
+                                                 tree_refit);
+
+      if (loose_edges_mask != NULL) {
+        MEM_freeN(loose_edges_mask);
+      }
+      break;
+    }
+
+    case BVHTREE_FROM_FACES: {
+      int num_faces = mesh->totface;
+      BLI_assert(!(num_faces == 0 && mesh->totpoly != 0));
+
+      /* Tessellated faces aren't part of the topology cache, their trees aren't refitted. */
+      BLI_assert(tree_refit == NULL);
+      tree = bvhtree_from_mesh_faces_create_tree(
+          0.0f, tree_type, 6, mesh->mvert, mesh->mface, num_faces, NULL, -1);
+      break;
+    }
+
+    case BVHTREE_FROM_LOOPTRI:
+    case BVHTREE_FROM_LOOPTRI_NO_HIDDEN: {
+      const MLoopTri *mlooptri = BKE_mesh_runtime_looptri_ensure(mesh);
+      int looptri_len = BKE_mesh_runtime_looptri_len(mesh);
+
+      int looptri_mask_active_len = -1;
+      BLI_bitmap *looptri_mask = NULL;
+      if (bvh_cache_type == BVHTREE_FROM_LOOPTRI_NO_HIDDEN) {
+        looptri_mask = looptri_no_hidden_map_get(
+            mesh->mpoly, looptri_len, &looptri_mask_active_len);
+      }
+
+      tree_refit = bvhtree_refit_check(
+          tree_refit, looptri_mask ? looptri_mask_active_len : looptri_len, 0.0f, tree_type);
+      tree = bvhtree_from_mesh_looptri_create_tree(0.0f,
+                                                   tree_type,
+                                                   6,
+                                                   mesh->mvert,
+                                                   mesh->mloop,
+                                                   mlooptri,
+                                                   looptri_len,
+                                                   looptri_mask,
+                                                   looptri_mask_active_len,
+                                                   tree_refit);
+
+      if (looptri_mask != NULL) {
+        MEM_freeN(looptri_mask);
+      }
+      break;
+    }
+    case BVHTREE_FROM_EM_VERTS:
+    case BVHTREE_FROM_EM_EDGES:
+    case BVHTREE_FROM_EM_LOOPTRI:
+    case BVHTREE_MAX_ITEM:
+      BLI_assert(false);
+      break;
+  }
+
+  *r_is_refit = (tree_refit != NULL);
+  BLI_assert(!*r_is_refit || tree == tree_refit);
+  return tree;
+}
+
 /**
  * Builds or queries a bvhcache for the cache bvhtree of the request type.
+ *
+ * Only trees of the requested type are locked while building,
+ * so other trees of the mesh can be built and used at the same time.
+ * Trees of deformed meshes are refitted from the trees of the previous evaluation
+ * of the same topology when possible (see #bvhcache_free_ex).
  */
 BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
                                    struct Mesh *mesh,
@@ -1408,152 +1662,60 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
   BVHCache **bvh_cache_p = (BVHCache **)&mesh->runtime.bvh_cache;
   ThreadMutex *mesh_eval_mutex = (ThreadMutex *)mesh->runtime.eval_mutex;
 
-  bool is_cached = bvhcache_find(bvh_cache_p, bvh_cache_type, &tree, NULL, NULL);
+  bool lock_started = false;
+  bool is_cached = bvhcache_find(
+      bvh_cache_p, bvh_cache_type, &tree, &lock_started, mesh_eval_mutex);
+
+  if (is_cached == false) {
+    BVHTree *tree_refit = NULL;
+    int refit_count = 0;
+    if (bvhcache_type_is_refittable(bvh_cache_type)) {
+      tree_refit = BKE_mesh_runtime_bvh_tree_take(mesh, (int)bvh_cache_type, &refit_count);
+      if (tree_refit != NULL && refit_count >= BVHCACHE_REFIT_MAX) {
+        BLI_bvhtree_free(tree_refit);
+        tree_refit = NULL;
+      }
+    }
 
-  if (is_cached && tree == NULL) {
-    memset(data, 0, sizeof(*data));
+    bool is_refit;
+    tree = bvhtree_from_mesh_create_tree(mesh, bvh_cache_type, tree_type, tree_refit, &is_refit);
+
+    BVHCache *bvh_cache = *bvh_cache_p;
+    bvhcache_insert(bvh_cache, tree, bvh_cache_type);
+    bvh_cache->items[bvh_cache_type].refit_count = is_refit ? refit_count + 1 : 0;
+    bvhcache_unlock(bvh_cache, bvh_cache_type, lock_started);
+  }
+
+  memset(data, 0, sizeof(*data));
+  if (tree == NULL) {
     return tree;
   }
 
+  /* Setup BVHTreeFromMesh */
   switch (bvh_cache_type) {
     case BVHTREE_FROM_VERTS:
     case BVHTREE_FROM_LOOSEVERTS:
-      if (is_cached == false) {
-        BLI_bitmap *loose_verts_mask = NULL;
-        int loose_vert_len = -1;
-        int verts_len = mesh->totvert;
-
-        if (bvh_cache_type == BVHTREE_FROM_LOOSEVERTS) {
-          loose_verts_mask = loose_verts_map_get(
-              mesh->medge, mesh->totedge, mesh->mvert, verts_len, &loose_vert_len);
-        }
-
-        /* TODO: a global mutex lock held during the expensive operation of
-         * building the BVH tree is really bad for performance. */
-        tree = bvhtree_from_mesh_verts_ex(data,
-                                          mesh->mvert,
-                                          verts_len,
-                                          false,
-                                          loose_verts_mask,
-                                          loose_vert_len,
-                                          0.0f,
-                                          tree_type,
-                                          6,
-                                          bvh_cache_type,
-                                          bvh_cache_p,
-                                          mesh_eval_mutex);
-
-        if (loose_verts_mask != NULL) {
-          MEM_freeN(loose_verts_mask);
-        }
-      }
-      else {
-        /* Setup BVHTreeFromMesh */
-        bvhtree_from_mesh_verts_setup_data(data, tree, true, mesh->mvert, false);
-      }
+      bvhtree_from_mesh_verts_setup_data(data, tree, true, mesh->mvert, false);
       break;
 
     case BVHTREE_FROM_EDGES:
     case BVHTREE_FROM_LOOSEEDGES:
-      if (is_cached == false) {
-        BLI_bitmap *loose_edges_mask = NULL;
-        int loose_edges_len = -1;
-        int edges_len = mesh->totedge;
-
-        if (bvh_cache_type == BVHTREE_FROM_LOOSEEDGES) {
-          loose_edges_mask = loose_edges_map_get(mesh->medge, edges_len, &loose_edges_len);
-        }
-
-        tree = bvhtree_from_mesh_edges_ex(data,
-                                          mesh->mvert,
-                                          false,
-                                          mesh->medge,
-                                          edges_len,
-                                          false,
-                                          loose_edges_mask,
-                                          loose_edges_len,
-                                          0.0,
-                                          tree_type,
-                                          6,
-                                          bvh_cache_type,
-                                          bvh_cache_p,
-                                          mesh_eval_mutex);
-
-        if (loose_edges_mask != NULL) {
-          MEM_freeN(loose_edges_mask);
-        }
-      }
-      else {
-        /* Setup BVHTreeFromMesh */
-        bvhtree_from_mesh_edges_setup_data(
-            data, tree, true, mesh->mvert, false, mesh->medge, false);
-      }
+      bvhtree_from_mesh_edges_setup_data(
+          data, tree, true, mesh->mvert, false, mesh->medge, false);
       break;
 
     case BVHTREE_FROM_FACES:
-      if (is_cached == false) {
-        int num_faces = mesh->totface;
-        BLI_assert(!(num_faces == 0 && mesh->totpoly != 0));
-
-        tree = bvhtree_from_mesh_faces_ex(data,
-                                          mesh->mvert,
-                                          false,
-                                          mesh->mface,
-                                          num_faces,
-                                          false,
-                                          NULL,
-                                          -1,
-                                          0.0,
-                                          tree_type,
-                                          6,
-                                          bvh_cache_type,
-                                          bvh_cache_p,
-                                          mesh_eval_mutex);
-      }
-      else {
-        /* Setup BVHTreeFromMesh */
-        bvhtree_from_mesh_faces_setup_data(
-            data, tree, true, mesh->mvert, false, mesh->mface, false);
-      }
+      bvhtree_from_mesh_faces_setup_data(
+          data, tree, true, mesh->mvert, false, mesh->mface, false);
       break;
 
     case BVHTREE_FROM_LOOPTRI:
-    case BVHTREE_FROM_LOOPTRI_NO_HIDDEN:
-      if (is_cached == false) {
-        const MLoopTri *mlooptri = BKE_mesh_runtime_looptri_ensure(mesh);
-        int looptri_len = BKE_mesh_runtime_looptri_len(mesh);
-
-        int looptri_mask_active_len = -1;
-        BLI_bitmap *looptri_mask = NULL;
-        if (bvh_cache_type == BVHTREE_FROM_LOOPTRI_NO_HIDDEN) {
-          looptri_mask = looptri_no_hidden_map_get(
-              mesh->mpoly, looptri_len, &looptri_mask_active_len);
-        }
-
-        tree = bvhtree_from_mesh_looptri_ex(data,
-                                            mesh->mvert,
-                                            false,
-                                            mesh->mloop,
-                                            false,
-                                            mlooptri,
-                                            looptri_len,
-                                            false,
-                                            looptri_mask,
-                                            looptri_mask_active_len,
-                                            0.0,
-                                            tree_type,
-                                            6,
-                                            bvh_cache_type,
-                                            bvh_cache_p,
-                                            mesh_eval_mutex);
-      }
-      else {
-        /* Setup BVHTreeFromMesh */
-        const MLoopTri *mlooptri = BKE_mesh_runtime_looptri_ensure(mesh);
-        bvhtree_from_mesh_looptri_setup_data(
-            data, tree, true, mesh->mvert, false, mesh->mloop, false, mlooptri, false);
-      }
+    case BVHTREE_FROM_LOOPTRI_NO_HIDDEN: {
+      const MLoopTri *mlooptri = BKE_mesh_runtime_looptri_ensure(mesh);
+      bvhtree_from_mesh_looptri_setup_data(
+          data, tree, true, mesh->mvert, false, mesh->mloop, false, mlooptri, false);
       break;
+    }
     case BVHTREE_FROM_EM_VERTS:
     case BVHTREE_FROM_EM_EDGES:
     case BVHTREE_FROM_EM_LOOPTRI:
@@ -1562,20 +1724,13 @@ BVHTree *BKE_bvhtree_from_mesh_get(struct BVHTreeFromMesh *data,
       break;
   }
 
-  if (data->tree != NULL) {
 #ifdef DEBUG
-    if (BLI_bvhtree_get_tree_type(data->tree) != tree_type) {
-      printf("tree_type %d obtained instead of %d\n",
-             BLI_bvhtree_get_tree_type(data->tree),
-             tree_type);
-    }
-#endif
-    BLI_assert(data->cached);
-  }
-  else {
-    free_bvhtree_from_mesh(data);
-    memset(data, 0, sizeof(*data));
+  if (BLI_bvhtree_get_tree_type(data->tree) != tree_type) {
+    printf("tree_type %d obtained instead of %d\n",
+           BLI_bvhtree_get_tree_type(data->tree),
+           tree_type);
   }
+#endif
 
   return tree;
 }
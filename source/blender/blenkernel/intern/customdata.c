@@ -56,17 +56,28 @@
 
 #include "CLG_log.h"
 
+#include "atomic_ops.h"
+
 /* only for customdata_data_transfer_interp_normal_normals */
 #include "data_transfer_intern.h"
 
 /* number of layers to add when growing a CustomData object */
 #define CUSTOMDATA_GROW 5
 
+/* Alignment of layer arrays allocated here, so that packed layers (e.g. #CD_PROP_FLOAT3)
+ * can be processed with aligned SIMD loads, and threads don't share their first cache line. */
+#define CUSTOMDATA_LAYER_ALIGNMENT 64
+
 /* ensure typemap size is ok */
 BLI_STATIC_ASSERT(ARRAY_SIZE(((CustomData *)NULL)->typemap) == CD_NUMTYPES, "size mismatch");
 
 static CLG_LogRef LOG = {"bke.customdata"};
 
+/* Reference count of layer data which is shared by multiple layers, see #CD_SHARE. */
+typedef struct CustomDataSharingInfo {
+  int users;
+} CustomDataSharingInfo;
+
 /** Update mask_dst with layers defined in mask_src (equivalent to a bitwise OR). */
 void CustomData_MeshMasks_update(CustomData_MeshMasks *mask_dst,
                                  const CustomData_MeshMasks *mask_src)
@@ -1465,6 +1476,79 @@ static int layerMaxNum_propcol(void)
   return MAX_MCOL;
 }
 
+static void layerInterp_propfloat3(
+    const void **sources, const float *weights, const float *sub_weights, int count, void *dest)
+{
+  float result[3] = {0.0f, 0.0f, 0.0f};
+  const float *sub_weight = sub_weights;
+  for (int i = 0; i < count; i++) {
+    float weight = weights ? weights[i] : 1.0f;
+    const float *src = sources[i];
+    if (sub_weights) {
+      madd_v3_v3fl(result, src, (*sub_weight) * weight);
+      sub_weight++;
+    }
+    else {
+      madd_v3_v3fl(result, src, weight);
+    }
+  }
+  copy_v3_v3((float *)dest, result);
+}
+
+static void layerMultiply_propfloat3(void *data, float fac)
+{
+  mul_v3_fl((float *)data, fac);
+}
+
+static void layerAdd_propfloat3(void *data1, const void *data2)
+{
+  add_v3_v3((float *)data1, (const float *)data2);
+}
+
+static void layerInterp_propfloat2(
+    const void **sources, const float *weights, const float *sub_weights, int count, void *dest)
+{
+  float result[2] = {0.0f, 0.0f};
+  const float *sub_weight = sub_weights;
+  for (int i = 0; i < count; i++) {
+    float weight = weights ? weights[i] : 1.0f;
+    const float *src = sources[i];
+    if (sub_weights) {
+      madd_v2_v2fl(result, src, (*sub_weight) * weight);
+      sub_weight++;
+    }
+    else {
+      madd_v2_v2fl(result, src, weight);
+    }
+  }
+  copy_v2_v2((float *)dest, result);
+}
+
+static void layerMultiply_propfloat2(void *data, float fac)
+{
+  mul_v2_fl((float *)data, fac);
+}
+
+static void layerAdd_propfloat2(void *data1, const void *data2)
+{
+  add_v2_v2((float *)data1, (const float *)data2);
+}
+
+static void layerInterp_propbool(const void **sources,
+                                 const float *weights,
+                                 const float *UNUSED(sub_weights),
+                                 int count,
+                                 void *dest)
+{
+  bool result = false;
+  for (int i = 0; i < count; i++) {
+    const float weight = weights ? weights[i] : 1.0f;
+    const bool src = *(const bool *)sources[i];
+    result |= src && (weight > 0.0f);
+  }
+  *(bool *)dest = result;
+}
+
 static const LayerTypeInfo LAYERTYPEINFO[CD_NUMTYPES] = {
     /* 0: CD_MVERT */
     {sizeof(MVert), "MVert", 1, NULL, NULL, NULL, NULL, NULL, NULL},
@@ -1800,7 +1884,47 @@ static const LayerTypeInfo LAYERTYPEINFO[CD_NUMTYPES] = {
      NULL,
      NULL,
      NULL,
-     layerMaxNum_propcol}};
+     layerMaxNum_propcol},
+    /* 48: CD_PROP_FLOAT3 */
+    {sizeof(float[3]),
+     "vec3f",
+     1,
+     N_("Float3"),
+     NULL,
+     NULL,
+     layerInterp_propfloat3,
+     NULL,
+     NULL,
+     NULL,
+     NULL,
+     layerMultiply_propfloat3,
+     NULL,
+     layerAdd_propfloat3},
+    /* 49: CD_PROP_FLOAT2 */
+    {sizeof(float[2]),
+     "vec2f",
+     1,
+     N_("Float2"),
+     NULL,
+     NULL,
+     layerInterp_propfloat2,
+     NULL,
+     NULL,
+     NULL,
+     NULL,
+     layerMultiply_propfloat2,
+     NULL,
+     layerAdd_propfloat2},
+    /* 50: CD_PROP_BOOL */
+    {sizeof(bool),
+     "",
+     0,
+     N_("Boolean"),
+     NULL,
+     NULL,
+     layerInterp_propbool,
+     NULL,
+     NULL}};
 
 static const char *LAYERTYPENAMES[CD_NUMTYPES] = {
     /*   0-4 */ "CDMVert",
@@ -1853,6 +1977,9 @@ static const char *LAYERTYPENAMES[CD_NUMTYPES] = {
     "CDHairMapping",
     "CDPoint",
     "CDPropCol",
+    /* 48-50 */ "CDPropFloat3",
+    "CDPropFloat2",
+    "CDPropBool",
 };
 
 const CustomData_MeshMasks CD_MASK_BAREMESH = {
@@ -2035,6 +2162,108 @@ static bool customdata_typemap_is_valid(const CustomData *data)
 }
 #endif
 
+/**
+ * Allocate the data of a layer with \a totelem elements,
+ * aligned to #CUSTOMDATA_LAYER_ALIGNMENT (alignment is kept by #MEM_dupallocN/#MEM_reallocN).
+ */
+static void *customData_layer_data_alloc(const LayerTypeInfo *typeInfo,
+                                         const int totelem,
+                                         const bool do_clear,
+                                         const char *name)
+{
+  const size_t size = (size_t)totelem * (size_t)typeInfo->size;
+  void *data = MEM_mallocN_aligned(size, CUSTOMDATA_LAYER_ALIGNMENT, name);
+  if (do_clear && data != NULL) {
+    memset(data, 0, size);
+  }
+  return data;
+}
+
+/* Layers added with #CD_SHARE point to the same data as the source layer. The data is freed by
+ * the last layer using it, and is copied on first write (see
+ * #CustomData_duplicate_referenced_layer), so sharing is invisible to code which only reads. */
+
+static void customData_layer_share(const CustomDataLayer *src, CustomDataLayer *dst)
+{
+  CustomDataSharingInfo *sharing_info = src->sharing_info;
+
+  if (sharing_info == NULL) {
+    /* Source layer is only modified to store runtime data, which is safe to do from multiple
+     * threads as long as the info is created atomically. */
+    CustomDataSharingInfo *new_sharing_info = MEM_mallocN(sizeof(*new_sharing_info), __func__);
+    new_sharing_info->users = 1;
+    sharing_info = atomic_cas_ptr(
+        (void **)&((CustomDataLayer *)src)->sharing_info, NULL, new_sharing_info);
+    if (sharing_info == NULL) {
+      sharing_info = new_sharing_info;
+    }
+    else {
+      MEM_freeN(new_sharing_info);
+    }
+  }
+
+  atomic_add_and_fetch_int32(&sharing_info->users, 1);
+  dst->data = src->data;
+  dst->sharing_info = sharing_info;
+}
+
+/**
+ * Stop sharing the layer data, without freeing it.
+ *
+ * \return true when the layer was the last user of the data, which is then to be freed.
+ */
+static bool customData_layer_unshare(CustomDataLayer *layer)
+{
+  CustomDataSharingInfo *sharing_info = layer->sharing_info;
+
+  if (sharing_info == NULL) {
+    return true;
+  }
+
+  layer->sharing_info = NULL;
+  if (atomic_sub_and_fetch_int32(&sharing_info->users, 1) == 0) {
+    MEM_freeN(sharing_info);
+    return true;
+  }
+  return false;
+}
+
+/* Make sure the layer is the only owner of its data, copying it if it is used by other layers. */
+static void customData_layer_ensure_owned(CustomDataLayer *layer,
+                                          int totelem,
+                                          const LayerTypeInfo *typeInfo)
+{
+  CustomDataSharingInfo *sharing_info = layer->sharing_info;
+  void *data = layer->data;
+
+  if (sharing_info == NULL) {
+    return;
+  }
+
+  if (atomic_add_and_fetch_int32(&sharing_info->users, 0) == 1) {
+    /* Other users are gone already, nothing to copy. */
+    layer->sharing_info = NULL;
+    MEM_freeN(sharing_info);
+    return;
+  }
+
+  layer->data = customData_layer_data_alloc(typeInfo, totelem, false, "CD unshare layer");
+  if (typeInfo->copy) {
+    typeInfo->copy(data, layer->data, totelem);
+  }
+  else {
+    memcpy(layer->data, data, (size_t)totelem * (size_t)typeInfo->size);
+  }
+
+  if (customData_layer_unshare(layer)) {
+    /* All other users released the data while it was being copied. */
+    if (typeInfo->free) {
+      typeInfo->free(data, totelem, typeInfo->size);
+    }
+    MEM_freeN(data);
+  }
+}
+
 bool CustomData_merge(const struct CustomData *source,
                       struct CustomData *dest,
                       CustomDataMask mask,
@@ -2086,6 +2315,7 @@ bool CustomData_merge(const struct CustomData *source,
       case CD_ASSIGN:
       case CD_REFERENCE:
       case CD_DUPLICATE:
+      case CD_SHARE:
         data = layer->data;
         break;
       default:
@@ -2097,8 +2327,21 @@ bool CustomData_merge(const struct CustomData *source,
       newlayer = customData_add_layer__internal(
           dest, type, CD_REFERENCE, data, totelem, layer->name);
     }
+    else if (alloctype == CD_SHARE) {
+      /* Referenced layers are not owned by the source, so they can not be shared. */
+      const bool can_share = (data != NULL) && !(flag & CD_FLAG_NOFREE);
+      newlayer = customData_add_layer__internal(
+          dest, type, can_share ? CD_ASSIGN : CD_DUPLICATE, data, totelem, layer->name);
+      if (can_share && newlayer && newlayer->data == data) {
+        customData_layer_share(layer, newlayer);
+      }
+    }
     else {
       newlayer = customData_add_layer__internal(dest, type, alloctype, data, totelem, layer->name);
+      if ((alloctype == CD_ASSIGN) && newlayer && newlayer->data == data) {
+        /* Ownership of the data is moved, and so is its reference count. */
+        newlayer->sharing_info = layer->sharing_info;
+      }
     }
 
     if (newlayer) {
@@ -2128,6 +2371,10 @@ void CustomData_realloc(CustomData *data, int totelem)
       continue;
     }
     typeInfo = layerType_getInfo(layer->type);
+    if (layer->sharing_info) {
+      customData_layer_ensure_owned(
+          layer, (int)(MEM_allocN_len(layer->data) / typeInfo->size), typeInfo);
+    }
     layer->data = MEM_reallocN(layer->data, (size_t)totelem * typeInfo->size);
   }
 }
@@ -2152,6 +2399,11 @@ static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
   const LayerTypeInfo *typeInfo;
 
   if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
+    if (!customData_layer_unshare(layer)) {
+      /* Data is still used by other layers. */
+      return;
+    }
+
     typeInfo = layerType_getInfo(layer->type);
 
     if (typeInfo->free) {
@@ -2501,12 +2753,10 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
     newlayerdata = layerdata;
   }
   else if (totelem > 0 && typeInfo->size > 0) {
-    if (alloctype == CD_DUPLICATE && layerdata) {
-      newlayerdata = MEM_malloc_arrayN((size_t)totelem, typeInfo->size, layerType_getName(type));
-    }
-    else {
-      newlayerdata = MEM_calloc_arrayN((size_t)totelem, typeInfo->size, layerType_getName(type));
-    }
+    newlayerdata = customData_layer_data_alloc(typeInfo,
+                                               totelem,
+                                               !(alloctype == CD_DUPLICATE && layerdata),
+                                               layerType_getName(type));
 
     if (!newlayerdata) {
       return NULL;
@@ -2549,6 +2799,7 @@ static CustomDataLayer *customData_add_layer__internal(CustomData *data,
   data->layers[index].type = type;
   data->layers[index].flag = flag;
   data->layers[index].data = newlayerdata;
+  data->layers[index].sharing_info = NULL;
 
   /* Set default name if none exists. Note we only call DATA_()  once
    * we know there is a default name, to avoid overhead of locale lookups
@@ -2741,18 +2992,21 @@ static void *customData_duplicate_referenced_layer_index(CustomData *data,
      */
     const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
 
+    void *dst_data = customData_layer_data_alloc(
+        typeInfo, totelem, false, "CD duplicate ref layer");
     if (typeInfo->copy) {
-      void *dst_data = MEM_malloc_arrayN(
-          (size_t)totelem, typeInfo->size, "CD duplicate ref layer");
       typeInfo->copy(layer->data, dst_data, totelem);
-      layer->data = dst_data;
     }
     else {
-      layer->data = MEM_dupallocN(layer->data);
+      memcpy(dst_data, layer->data, (size_t)totelem * (size_t)typeInfo->size);
     }
+    layer->data = dst_data;
 
     layer->flag &= ~CD_FLAG_NOFREE;
   }
+  else if (layer->sharing_info) {
+    customData_layer_ensure_owned(layer, totelem, layerType_getInfo(layer->type));
+  }
 
   return layer->data;
 }
@@ -2806,7 +3060,7 @@ bool CustomData_is_referenced_layer(struct CustomData *data, int type)
 
   layer = &data->layers[layer_index];
 
-  return (layer->flag & CD_FLAG_NOFREE) != 0;
+  return (layer->flag & CD_FLAG_NOFREE) != 0 || layer->sharing_info != NULL;
 }
 
 void CustomData_free_temporary(CustomData *data, int totelem)
@@ -3240,6 +3494,8 @@ void *CustomData_set_layer(const CustomData *data, int type, void *ptr)
     return NULL;
   }
 
+  /* The caller takes care of the previous data, it is not shared with this layer anymore. */
+  customData_layer_unshare(&data->layers[layer_index]);
   data->layers[layer_index].data = ptr;
 
   return ptr;
@@ -3253,6 +3509,8 @@ void *CustomData_set_layer_n(const struct CustomData *data, int type, int n, voi
     return NULL;
   }
 
+  /* The caller takes care of the previous data, it is not shared with this layer anymore. */
+  customData_layer_unshare(&data->layers[layer_index]);
   data->layers[layer_index].data = ptr;
 
   return ptr;
@@ -3869,7 +4127,7 @@ bool CustomData_has_referenced(const struct CustomData *data)
 {
   int i;
   for (i = 0; i < data->totlayer; i++) {
-    if (data->layers[i].flag & CD_FLAG_NOFREE) {
+    if ((data->layers[i].flag & CD_FLAG_NOFREE) || data->layers[i].sharing_info) {
       return true;
     }
   }
@@ -4289,7 +4547,13 @@ int CustomData_layertype_layers_max(const int type)
 
 static bool CustomData_is_property_layer(int type)
 {
-  if ((type == CD_PROP_FLT) || (type == CD_PROP_INT) || (type == CD_PROP_STR)) {
+  if (ELEM(type,
+           CD_PROP_FLT,
+           CD_PROP_INT,
+           CD_PROP_STR,
+           CD_PROP_FLOAT3,
+           CD_PROP_FLOAT2,
+           CD_PROP_BOOL)) {
     return true;
   }
   return false;
@@ -4407,7 +4671,12 @@ bool CustomData_verify_versions(struct CustomData *data, int index)
     /* 0 structnum is used in writing code to tag layer types that should not be written. */
     else if (typeInfo->structnum == 0 &&
              /* XXX Not sure why those three are exception, maybe that should be fixed? */
-             !ELEM(layer->type, CD_PAINT_MASK, CD_FACEMAP, CD_MTEXPOLY, CD_SCULPT_FACE_SETS)) {
+             !ELEM(layer->type,
+                   CD_PAINT_MASK,
+                   CD_FACEMAP,
+                   CD_MTEXPOLY,
+                   CD_SCULPT_FACE_SETS,
+                   CD_PROP_BOOL)) {
       keeplayer = false;
       CLOG_WARN(&LOG, ".blend file read: removing a data layer that should not have been written");
     }
@@ -1498,18 +1498,13 @@ static float fcurve_eval_keyframes_extrapolate(
   return endpoint_bezt->vec[1][1] - (fac * dx);
 }
 
-static float fcurve_eval_keyframes_interpolate(FCurve *fcu, BezTriple *bezts, float evaltime)
+static float fcurve_eval_keyframes_interpolate(FCurve *fcu,
+                                               BezTriple *bezts,
+                                               float evaltime,
+                                               int *segment_cache)
 {
   const float eps = 1.e-8f;
-  BezTriple *bezt, *prevbezt;
-  unsigned int a;
-
-  /* evaltime occurs somewhere in the middle of the curve */
-  bool exact = false;
-
-  /* Use binary search to find appropriate keyframes...
-   *
-   * The threshold here has the following constraints:
+  /* The threshold here has the following constraints:
    * - 0.001 is too coarse:
    *   We get artifacts with 2cm driver movements at 1BU = 1m (see T40332)
    *
@@ -1517,7 +1512,28 @@ static float fcurve_eval_keyframes_interpolate(FCurve *fcu, BezTriple *bezts, fl
    *   Weird errors, like selecting the wrong keyframe range (see T39207), occur.
    *   This lower bound was established in b888a32eee8147b028464336ad2404d8155c64dd.
    */
-  a = binarysearch_bezt_index_ex(bezts, evaltime, fcu->totvert, 0.0001, &exact);
+  const float threshold = 0.0001f;
+  BezTriple *bezt, *prevbezt;
+  unsigned int a;
+
+  /* evaltime occurs somewhere in the middle of the curve */
+  bool exact = false;
+
+  /* During playback evaltime mostly stays within the segment of the previous evaluation, so check
+   * it before falling back to the search. The segment is only reused when the binary search would
+   * find it as well, i.e. when evaltime is not within the threshold of either keyframe. */
+  const int cached = (segment_cache != NULL) ? *segment_cache : 0;
+  if (cached > 0 && cached < fcu->totvert && evaltime - bezts[cached - 1].vec[1][0] > threshold &&
+      bezts[cached].vec[1][0] - evaltime > threshold) {
+    a = (unsigned int)cached;
+  }
+  else {
+    /* Use binary search to find appropriate keyframes... */
+    a = binarysearch_bezt_index_ex(bezts, evaltime, fcu->totvert, threshold, &exact);
+    if (segment_cache != NULL) {
+      *segment_cache = (int)a;
+    }
+  }
   bezt = bezts + a;
 
   if (exact) {
@@ -1759,8 +1775,12 @@ static float fcurve_eval_keyframes_interpolate(FCurve *fcu, BezTriple *bezts, fl
   return 0.0f;
 }
 
-/* Calculate F-Curve value for 'evaltime' using BezTriple keyframes */
-static float fcurve_eval_keyframes(FCurve *fcu, BezTriple *bezts, float evaltime)
+/* Calculate F-Curve value for 'evaltime' using BezTriple keyframes.
+ * segment_cache is optional, see #evaluate_fcurve_segment_cached(). */
+static float fcurve_eval_keyframes(FCurve *fcu,
+                                   BezTriple *bezts,
+                                   float evaltime,
+                                   int *segment_cache)
 {
   if (evaltime <= bezts->vec[1][0]) {
     return fcurve_eval_keyframes_extrapolate(fcu, bezts, evaltime, 0, +1);
@@ -1771,7 +1791,7 @@ static float fcurve_eval_keyframes(FCurve *fcu, BezTriple *bezts, float evaltime
     return fcurve_eval_keyframes_extrapolate(fcu, bezts, evaltime, fcu->totvert - 1, -1);
   }
 
-  return fcurve_eval_keyframes_interpolate(fcu, bezts, evaltime);
+  return fcurve_eval_keyframes_interpolate(fcu, bezts, evaltime, segment_cache);
 }
 
 /* Calculate F-Curve value for 'evaltime' using FPoint samples */
@@ -1817,7 +1837,7 @@ static float fcurve_eval_samples(FCurve *fcu, FPoint *fpts, float evaltime)
 /* Evaluate and return the value of the given F-Curve at the specified frame ("evaltime")
  * Note: this is also used for drivers
  */
-static float evaluate_fcurve_ex(FCurve *fcu, float evaltime, float cvalue)
+static float evaluate_fcurve_ex(FCurve *fcu, float evaltime, float cvalue, int *segment_cache)
 {
   float devaltime;
 
@@ -1834,7 +1854,7 @@ static float evaluate_fcurve_ex(FCurve *fcu, float evaltime, float cvalue)
    *   F-Curve modifier on the stack requested the curve to be evaluated at
    */
   if (fcu->bezt) {
-    cvalue = fcurve_eval_keyframes(fcu, fcu->bezt, devaltime);
+    cvalue = fcurve_eval_keyframes(fcu, fcu->bezt, devaltime, segment_cache);
   }
   else if (fcu->fpt) {
     cvalue = fcurve_eval_samples(fcu, fcu->fpt, devaltime);
@@ -1858,7 +1878,20 @@ float evaluate_fcurve(FCurve *fcu, float evaltime)
 {
   BLI_assert(fcu->driver == NULL);
 
-  return evaluate_fcurve_ex(fcu, evaltime, 0.0);
+  return evaluate_fcurve_ex(fcu, evaltime, 0.0, NULL);
+}
+
+/**
+ * Same as #evaluate_fcurve(), but remembers the keyframe segment evaltime was found in, so that
+ * evaluating the curve at nearby times (as happens during playback) skips the keyframe search.
+ *
+ * \param segment_cache: Per user storage of the segment, initialize to 0.
+ */
+float evaluate_fcurve_segment_cached(FCurve *fcu, float evaltime, int *segment_cache)
+{
+  BLI_assert(fcu->driver == NULL);
+
+  return evaluate_fcurve_ex(fcu, evaltime, 0.0, segment_cache);
 }
 
 float evaluate_fcurve_only_curve(FCurve *fcu, float evaltime)
@@ -1866,7 +1899,7 @@ float evaluate_fcurve_only_curve(FCurve *fcu, float evaltime)
   /* Can be used to evaluate the (keyframed) fcurve only.
    * Also works for driver-fcurves when the driver itself is not relevant.
    * E.g. when inserting a keyframe in a driver fcurve. */
-  return evaluate_fcurve_ex(fcu, evaltime, 0.0);
+  return evaluate_fcurve_ex(fcu, evaltime, 0.0, NULL);
 }
 
 float evaluate_fcurve_driver(PathResolvedRNA *anim_rna,
@@ -1913,7 +1946,7 @@ float evaluate_fcurve_driver(PathResolvedRNA *anim_rna,
     }
   }
 
-  return evaluate_fcurve_ex(fcu, evaltime, cvalue);
+  return evaluate_fcurve_ex(fcu, evaltime, cvalue, NULL);
 }
 
 /* Checks if the curve has valid keys, drivers or modifiers that produce an actual curve. */
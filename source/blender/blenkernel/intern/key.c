@@ -30,6 +30,8 @@
 #include "BLI_blenlib.h"
 #include "BLI_math_vector.h"
 #include "BLI_string_utils.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
 #include "BLT_translation.h"
@@ -56,8 +58,12 @@
 #include "BKE_mesh.h"
 #include "BKE_scene.h"
 
+#include "DEG_depsgraph_query.h"
+
 #include "RNA_access.h"
 
+static void key_eval_cache_free(Key *key);
+
 static void shapekey_copy_data(Main *UNUSED(bmain),
                                ID *id_dst,
                                const ID *id_src,
@@ -77,6 +83,8 @@ static void shapekey_copy_data(Main *UNUSED(bmain),
       key_dst->refkey = kb_dst;
     }
   }
+
+  key_dst->eval_cache = NULL;
 }
 
 static void shapekey_free_data(ID *id)
@@ -84,6 +92,8 @@ static void shapekey_free_data(ID *id)
   Key *key = (Key *)id;
   KeyBlock *kb;
 
+  key_eval_cache_free(key);
+
   while ((kb = BLI_pophead(&key->block))) {
     if (kb->data) {
       MEM_freeN(kb->data);
@@ -140,6 +150,8 @@ void BKE_key_free_nolib(Key *key)
 {
   KeyBlock *kb;
 
+  key_eval_cache_free(key);
+
   while ((kb = BLI_pophead(&key->block))) {
     if (kb->data) {
       MEM_freeN(kb->data);
@@ -216,6 +228,7 @@ Key *BKE_key_copy_nolib(Key *key)
   keyn = MEM_dupallocN(key);
 
   keyn->adt = NULL;
+  keyn->eval_cache = NULL;
 
   BLI_duplicatelist(&keyn->block, &key->block);
 
@@ -794,6 +807,250 @@ static void cp_cu_key(Curve *cu,
   }
 }
 
+/* -------------------------------------------------------------------- */
+/* Relative blending of mesh and lattice coordinates.
+ *
+ * Corrective shapes often only move a small part of the vertices. For evaluated (copy-on-write)
+ * keys the offsets of such blocks are stored sparsely, as element indices with the offset from
+ * their reference block, so evaluation only visits the moved elements. The cache lives as long as
+ * the evaluated key, which is copied again from the original on any change.
+ *
+ * Elements are blended in ranges in parallel, each range applying all blocks in order, so the
+ * result is the same as when blending one block after another. */
+
+/* Store offsets sparsely when at most this fraction of the elements differ from the reference. */
+#define KEY_SPARSE_MAX_FACTOR 0.5f
+/* Number of elements blended by a single task. */
+#define KEY_RELATIVE_RANGE_SIZE 4096
+
+typedef struct KeyBlockSparseOffsets {
+  /* Data the offsets were calculated from, to notice blocks being reordered or reallocated.
+   * The data itself only changes by copying the evaluated key again, which frees the cache. */
+  const void *data, *refdata;
+  int totelem;
+  /* Sorted indices of the elements which differ from the reference, NULL when the block is
+   * stored densely. */
+  int *indices;
+  /* Reference minus block coordinates, for every index. */
+  float (*offsets)[3];
+  int indices_len;
+} KeyBlockSparseOffsets;
+
+typedef struct KeyEvalCache {
+  int totkey;
+  KeyBlockSparseOffsets *blocks;
+} KeyEvalCache;
+
+/* Protects creation of #KeyEvalCache, objects sharing the same key are evaluated in parallel. */
+static ThreadMutex key_eval_cache_lock = BLI_MUTEX_INITIALIZER;
+
+static void key_sparse_offsets_free(KeyBlockSparseOffsets *sparse)
+{
+  MEM_SAFE_FREE(sparse->indices);
+  MEM_SAFE_FREE(sparse->offsets);
+  sparse->indices_len = 0;
+}
+
+static void key_eval_cache_free(Key *key)
+{
+  KeyEvalCache *cache = key->eval_cache;
+  if (cache == NULL) {
+    return;
+  }
+  for (int i = 0; i < cache->totkey; i++) {
+    key_sparse_offsets_free(&cache->blocks[i]);
+  }
+  MEM_freeN(cache->blocks);
+  MEM_freeN(cache);
+  key->eval_cache = NULL;
+}
+
+static void key_sparse_offsets_calc(KeyBlockSparseOffsets *sparse,
+                                    const float (*from)[3],
+                                    const float (*reffrom)[3],
+                                    const int totelem)
+{
+  const int max_len = (int)(totelem * KEY_SPARSE_MAX_FACTOR);
+  int len = 0;
+
+  key_sparse_offsets_free(sparse);
+  sparse->data = from;
+  sparse->refdata = reffrom;
+  sparse->totelem = totelem;
+
+  for (int i = 0; i < totelem; i++) {
+    if (!equals_v3v3(from[i], reffrom[i]) && ++len > max_len) {
+      /* Dense storage is faster to evaluate. */
+      return;
+    }
+  }
+
+  sparse->indices = MEM_malloc_arrayN(max_ii(len, 1), sizeof(*sparse->indices), __func__);
+  sparse->offsets = MEM_malloc_arrayN(max_ii(len, 1), sizeof(*sparse->offsets), __func__);
+  sparse->indices_len = len;
+  for (int i = 0, j = 0; i < totelem; i++) {
+    if (!equals_v3v3(from[i], reffrom[i])) {
+      sparse->indices[j] = i;
+      sub_v3_v3v3(sparse->offsets[j], reffrom[i], from[i]);
+      j++;
+    }
+  }
+}
+
+/* Get sparse offsets of the block at given index, NULL when the block is to be blended densely. */
+static const KeyBlockSparseOffsets *key_sparse_offsets_ensure(Key *key,
+                                                              const int keyblock_index,
+                                                              const float (*from)[3],
+                                                              const float (*reffrom)[3],
+                                                              const int totelem)
+{
+  BLI_mutex_lock(&key_eval_cache_lock);
+
+  KeyEvalCache *cache = key->eval_cache;
+  if (cache == NULL || cache->totkey != key->totkey) {
+    key_eval_cache_free(key);
+    cache = MEM_callocN(sizeof(*cache), __func__);
+    cache->totkey = key->totkey;
+    cache->blocks = MEM_calloc_arrayN(key->totkey, sizeof(*cache->blocks), __func__);
+    key->eval_cache = cache;
+  }
+
+  KeyBlockSparseOffsets *sparse = &cache->blocks[keyblock_index];
+  if (sparse->data != from || sparse->refdata != reffrom || sparse->totelem != totelem) {
+    key_sparse_offsets_calc(sparse, from, reffrom, totelem);
+  }
+
+  BLI_mutex_unlock(&key_eval_cache_lock);
+
+  return sparse->indices ? sparse : NULL;
+}
+
+typedef struct KeyRelativeBlock {
+  const float (*from)[3];
+  const float (*reffrom)[3];
+  const float *weights;
+  float influence;
+  const KeyBlockSparseOffsets *sparse;
+  char *freefrom;
+} KeyRelativeBlock;
+
+typedef struct KeyRelativeData {
+  float (*out)[3];
+  const KeyRelativeBlock *blocks;
+  int blocks_len;
+  int start, end;
+} KeyRelativeData;
+
+static void key_evaluate_relative_coords_range(void *__restrict userdata,
+                                               const int range_index,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KeyRelativeData *data = userdata;
+  const int range_start = data->start + range_index * KEY_RELATIVE_RANGE_SIZE;
+  const int range_end = min_ii(range_start + KEY_RELATIVE_RANGE_SIZE, data->end);
+  float(*out)[3] = data->out;
+
+  for (int i = 0; i < data->blocks_len; i++) {
+    const KeyRelativeBlock *block = &data->blocks[i];
+    const float *weights = block->weights;
+    const float influence = block->influence;
+    const KeyBlockSparseOffsets *sparse = block->sparse;
+
+    /* Same arithmetic as rel_flerp(), to get bit-identical results with the dense path. */
+    if (sparse) {
+      /* Find the first element of the range. */
+      int lo = 0, hi = sparse->indices_len;
+      while (lo < hi) {
+        const int mid = lo + (hi - lo) / 2;
+        if (sparse->indices[mid] < range_start) {
+          lo = mid + 1;
+        }
+        else {
+          hi = mid;
+        }
+      }
+      for (int j = lo; j < sparse->indices_len && sparse->indices[j] < range_end; j++) {
+        const int b = sparse->indices[j];
+        const float weight = weights ? (weights[b] * influence) : influence;
+        for (int a = 0; a < 3; a++) {
+          out[b][a] -= weight * sparse->offsets[j][a];
+        }
+      }
+    }
+    else {
+      for (int b = range_start; b < range_end; b++) {
+        const float weight = weights ? (weights[b] * influence) : influence;
+        for (int a = 0; a < 3; a++) {
+          out[b][a] -= weight * (block->reffrom[b][a] - block->from[b][a]);
+        }
+      }
+    }
+  }
+}
+
+/* Fast path of key_evaluate_relative() for keys of meshes and lattices, after the basis is
+ * copied to the output. */
+static void key_evaluate_relative_coords(const int start,
+                                         const int end,
+                                         const int tot,
+                                         char *basispoin,
+                                         Key *key,
+                                         KeyBlock *actkb,
+                                         float **per_keyblock_weights)
+{
+  KeyRelativeBlock *blocks = MEM_malloc_arrayN(max_ii(key->totkey, 1), sizeof(*blocks), __func__);
+  const bool use_sparse = DEG_is_evaluated_id(&key->id);
+  int blocks_len = 0;
+  KeyBlock *kb;
+  int keyblock_index;
+
+  for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
+    /* Same checks as key_evaluate_relative(). */
+    if (kb == key->refkey || (kb->flag & KEYBLOCK_MUTE) || kb->curval == 0.0f ||
+        kb->totelem != tot) {
+      continue;
+    }
+    KeyBlock *refb = BLI_findlink(&key->block, kb->relative);
+    if (refb == NULL) {
+      continue;
+    }
+
+    KeyRelativeBlock *block = &blocks[blocks_len++];
+    block->from = (const float(*)[3])key_block_get_data(key, actkb, kb, &block->freefrom);
+    /* For meshes, use the original values instead of the bmesh values to
+     * maintain a constant offset. */
+    block->reffrom = refb->data;
+    block->weights = per_keyblock_weights ? per_keyblock_weights[keyblock_index] : NULL;
+    block->influence = kb->curval;
+    block->sparse = NULL;
+    /* Edit-mode data of the active block is temporary. */
+    if (use_sparse && block->freefrom == NULL && refb->totelem == tot) {
+      block->sparse = key_sparse_offsets_ensure(
+          key, keyblock_index, block->from, block->reffrom, tot);
+    }
+  }
+
+  KeyRelativeData data = {
+      .out = (float(*)[3])basispoin,
+      .blocks = blocks,
+      .blocks_len = blocks_len,
+      .start = start,
+      .end = end,
+  };
+  const int ranges_len = (end - start + KEY_RELATIVE_RANGE_SIZE - 1) / KEY_RELATIVE_RANGE_SIZE;
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (ranges_len > 1);
+  BLI_task_parallel_range(0, ranges_len, &data, key_evaluate_relative_coords_range, &settings);
+
+  for (int i = 0; i < blocks_len; i++) {
+    if (blocks[i].freefrom) {
+      MEM_freeN(blocks[i].freefrom);
+    }
+  }
+  MEM_freeN(blocks);
+}
+
 static void key_evaluate_relative(const int start,
                                   int end,
                                   const int tot,
@@ -832,6 +1089,11 @@ static void key_evaluate_relative(const int start,
 
   /* step 2: do it */
 
+  if (ELEM(GS(key->from->name), ID_ME, ID_LT)) {
+    key_evaluate_relative_coords(start, end, tot, basispoin, key, actkb, per_keyblock_weights);
+    return;
+  }
+
   for (kb = key->block.first, keyblock_index = 0; kb; kb = kb->next, keyblock_index++) {
     if (kb != key->refkey) {
       float icuval = kb->curval;
@@ -49,6 +49,8 @@
 #include "BKE_editmesh_cache.h"
 #include "BKE_global.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
+#include "BKE_mesh_runtime.h"
 #include "BKE_multires.h"
 #include "BKE_report.h"
 
@@ -217,6 +219,7 @@ typedef struct MeshCalcNormalsData {
   float (*pnors)[3];
   float (*lnors_weighted)[3];
   float (*vnors)[3];
+  const MeshElemMap *vert_loop_map;
 } MeshCalcNormalsData;
 
 static void mesh_calc_normals_poly_cb(void *__restrict userdata,
@@ -293,21 +296,44 @@ static void mesh_calc_normals_poly_prepare_cb(void *__restrict userdata,
   }
 }
 
+BLI_INLINE void mesh_calc_normals_vert_finalize(MVert *mv, float no[3])
+{
+  if (UNLIKELY(normalize_v3(no) == 0.0f)) {
+    /* following Mesh convention; we use vertex coordinate itself for normal in this case */
+    normalize_v3_v3(no, mv->co);
+  }
+
+  normal_float_to_short_v3(mv->no, no);
+}
+
 static void mesh_calc_normals_poly_finalize_cb(void *__restrict userdata,
                                                const int vidx,
                                                const TaskParallelTLS *__restrict UNUSED(tls))
 {
   MeshCalcNormalsData *data = userdata;
 
-  MVert *mv = &data->mverts[vidx];
-  float *no = data->vnors[vidx];
+  mesh_calc_normals_vert_finalize(&data->mverts[vidx], data->vnors[vidx]);
+}
 
-  if (UNLIKELY(normalize_v3(no) == 0.0f)) {
-    /* following Mesh convention; we use vertex coordinate itself for normal in this case */
-    normalize_v3_v3(no, mv->co);
+/* Gather variant of the accumulation + finalize steps, each vertex only reads its own loops,
+ * so it can run in parallel without any write conflicts. */
+static void mesh_calc_normals_poly_gather_cb(void *__restrict userdata,
+                                             const int vidx,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  MeshCalcNormalsData *data = userdata;
+  const MeshElemMap *vert_loops = &data->vert_loop_map[vidx];
+  const float(*lnors_weighted)[3] = (const float(*)[3])data->lnors_weighted;
+
+  float no_temp[3];
+  float *no = data->vnors ? data->vnors[vidx] : no_temp;
+
+  zero_v3(no);
+  for (int i = 0; i < vert_loops->count; i++) {
+    add_v3_v3(no, lnors_weighted[vert_loops->indices[i]]);
   }
 
-  normal_float_to_short_v3(mv->no, no);
+  mesh_calc_normals_vert_finalize(&data->mverts[vidx], no);
 }
 
 void BKE_mesh_calc_normals_poly(MVert *mverts,
@@ -319,6 +345,34 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
                                 int numPolys,
                                 float (*r_polynors)[3],
                                 const bool only_face_normals)
+{
+  BKE_mesh_calc_normals_poly_ex(mverts,
+                                r_vertnors,
+                                numVerts,
+                                mloop,
+                                mpolys,
+                                numLoops,
+                                numPolys,
+                                r_polynors,
+                                only_face_normals,
+                                NULL);
+}
+
+/**
+ * \param vert_loop_map: Optional vertex to loop map (see #BKE_mesh_runtime_vert_loop_map_ensure),
+ * when given, vertex normals are gathered from their loops in parallel
+ * instead of being accumulated serially.
+ */
+void BKE_mesh_calc_normals_poly_ex(MVert *mverts,
+                                   float (*r_vertnors)[3],
+                                   int numVerts,
+                                   const MLoop *mloop,
+                                   const MPoly *mpolys,
+                                   int numLoops,
+                                   int numPolys,
+                                   float (*r_polynors)[3],
+                                   const bool only_face_normals,
+                                   const MeshElemMap *vert_loop_map)
 {
   float(*pnors)[3] = r_polynors;
 
@@ -346,6 +400,24 @@ void BKE_mesh_calc_normals_poly(MVert *mverts,
       (size_t)numLoops, sizeof(*lnors_weighted), __func__);
   bool free_vnors = false;
 
+  if (vert_loop_map != NULL) {
+    MeshCalcNormalsData data = {
+        .mpolys = mpolys,
+        .mloop = mloop,
+        .mverts = mverts,
+        .pnors = pnors,
+        .lnors_weighted = lnors_weighted,
+        .vnors = vnors,
+        .vert_loop_map = vert_loop_map,
+    };
+
+    BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_prepare_cb, &settings);
+    BLI_task_parallel_range(0, numVerts, &data, mesh_calc_normals_poly_gather_cb, &settings);
+
+    MEM_freeN(lnors_weighted);
+    return;
+  }
+
   /* first go through and calculate normals for all the polys */
   if (vnors == NULL) {
     vnors = MEM_calloc_arrayN((size_t)numVerts, sizeof(*vnors), __func__);
@@ -422,16 +494,23 @@ void BKE_mesh_ensure_normals_for_display(Mesh *mesh)
       poly_nors = MEM_malloc_arrayN((size_t)mesh->totpoly, sizeof(*poly_nors), __func__);
     }
 
+    if (do_vert_normals) {
+      /* Vertices may be shared with the original mesh, don't write normals into them. */
+      mesh->mvert = CustomData_duplicate_referenced_layer(&mesh->vdata, CD_MVERT, mesh->totvert);
+    }
+
     /* calculate poly/vert normals */
-    BKE_mesh_calc_normals_poly(mesh->mvert,
-                               NULL,
-                               mesh->totvert,
-                               mesh->mloop,
-                               mesh->mpoly,
-                               mesh->totloop,
-                               mesh->totpoly,
-                               poly_nors,
-                               !do_vert_normals);
+    BKE_mesh_calc_normals_poly_ex(mesh->mvert,
+                                  NULL,
+                                  mesh->totvert,
+                                  mesh->mloop,
+                                  mesh->mpoly,
+                                  mesh->totloop,
+                                  mesh->totpoly,
+                                  poly_nors,
+                                  !do_vert_normals,
+                                  do_vert_normals ? BKE_mesh_runtime_vert_loop_map_ensure(mesh) :
+                                                    NULL);
 
     if (do_add_poly_nors_cddata) {
       CustomData_add_layer(&mesh->pdata, CD_NORMAL, CD_ASSIGN, poly_nors, mesh->totpoly);
@@ -449,15 +528,18 @@ void BKE_mesh_calc_normals(Mesh *mesh)
 #ifdef DEBUG_TIME
   TIMEIT_START_AVERAGED(BKE_mesh_calc_normals);
 #endif
-  BKE_mesh_calc_normals_poly(mesh->mvert,
-                             NULL,
-                             mesh->totvert,
-                             mesh->mloop,
-                             mesh->mpoly,
-                             mesh->totloop,
-                             mesh->totpoly,
-                             NULL,
-                             false);
+  /* Vertices may be shared with the original mesh, don't write normals into them. */
+  mesh->mvert = CustomData_duplicate_referenced_layer(&mesh->vdata, CD_MVERT, mesh->totvert);
+  BKE_mesh_calc_normals_poly_ex(mesh->mvert,
+                                NULL,
+                                mesh->totvert,
+                                mesh->mloop,
+                                mesh->mpoly,
+                                mesh->totloop,
+                                mesh->totpoly,
+                                NULL,
+                                false,
+                                BKE_mesh_runtime_vert_loop_map_ensure(mesh));
 #ifdef DEBUG_TIME
   TIMEIT_END_AVERAGED(BKE_mesh_calc_normals);
 #endif
@@ -819,6 +901,35 @@ typedef struct LoopSplitTaskDataCommon {
   int numPolys;
 } LoopSplitTaskDataCommon;
 
+/** A single loop or smooth fan found by #loop_split_generator. */
+typedef struct LoopSplitTopologyTask {
+  int ml_curr_index;
+  int ml_prev_index;
+  int mp_index;
+  /** False when both edges of the loop are sharp. */
+  bool is_fan;
+} LoopSplitTopologyTask;
+
+/**
+ * Smooth fans of a mesh, they only depend on its topology (and on its sharp edges),
+ * cached in the mesh runtime so that deformed meshes only have to compute the normals.
+ */
+typedef struct MeshLoopSplitTopology {
+  unsigned int users;
+
+  bool check_angle;
+  float split_angle;
+
+  int (*edge_to_loops)[2];
+  /** Same as edge_to_loops without angle threshold, to check for edges changing sharpness.
+   * Only set when check_angle is. */
+  int (*edge_to_loops_no_angle)[2];
+  int *loop_to_poly;
+
+  LoopSplitTopologyTask *tasks;
+  int tasks_len;
+} MeshLoopSplitTopology;
+
 #define INDEX_UNSET INT_MIN
 #define INDEX_INVALID -1
 /* See comment about edge_to_loops below. */
@@ -1424,7 +1535,12 @@ static bool loop_split_generator_check_cyclic_smooth_fan(const MLoop *mloops,
   }
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
+/**
+ * \param r_topology: When given, smooth fans are only recorded into it, not computed.
+ */
+static void loop_split_generator(TaskPool *pool,
+                                 LoopSplitTaskDataCommon *common_data,
+                                 MeshLoopSplitTopology *r_topology)
 {
   MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
   float(*loopnors)[3] = common_data->loopnors;
@@ -1457,7 +1573,7 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
   TIMEIT_START_AVERAGED(loop_split_generator);
 #endif
 
-  if (!pool) {
+  if (!pool && !r_topology) {
     if (lnors_spacearr) {
       edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
     }
@@ -1513,6 +1629,13 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
                                                                                      mp_index))) {
         //              printf("SKIPPING!\n");
       }
+      else if (r_topology) {
+        LoopSplitTopologyTask *task = &r_topology->tasks[r_topology->tasks_len++];
+        task->ml_curr_index = ml_curr_index;
+        task->ml_prev_index = ml_prev_index;
+        task->mp_index = mp_index;
+        task->is_fan = !(IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev));
+      }
       else {
         LoopSplitTaskData *data, data_local;
 
@@ -1601,13 +1724,248 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 #endif
 }
 
+void BKE_mesh_loop_split_topology_user_add(MeshLoopSplitTopology *topology)
+{
+  atomic_add_and_fetch_uint32(&topology->users, 1);
+}
+
+void BKE_mesh_loop_split_topology_release(MeshLoopSplitTopology *topology)
+{
+  if (atomic_sub_and_fetch_uint32(&topology->users, 1) != 0) {
+    return;
+  }
+  MEM_freeN(topology->edge_to_loops);
+  MEM_SAFE_FREE(topology->edge_to_loops_no_angle);
+  MEM_freeN(topology->loop_to_poly);
+  MEM_freeN(topology->tasks);
+  MEM_freeN(topology);
+}
+
+static MeshLoopSplitTopology *loop_split_topology_create(LoopSplitTaskDataCommon *common_data,
+                                                         const bool check_angle,
+                                                         const float split_angle)
+{
+  MeshLoopSplitTopology *topology = MEM_callocN(sizeof(*topology), __func__);
+  const size_t numEdges = (size_t)common_data->numEdges;
+  const size_t numLoops = (size_t)common_data->numLoops;
+
+  topology->users = 1;
+  topology->check_angle = check_angle;
+  topology->split_angle = split_angle;
+  topology->edge_to_loops = MEM_calloc_arrayN(numEdges, sizeof(*topology->edge_to_loops), __func__);
+  topology->loop_to_poly = MEM_malloc_arrayN(numLoops, sizeof(*topology->loop_to_poly), __func__);
+  /* There is at most one task per loop, shrunk once they are all known. */
+  topology->tasks = MEM_malloc_arrayN(numLoops, sizeof(*topology->tasks), __func__);
+
+  /* Loop normals are initialized in parallel when computing them from the topology. */
+  LoopSplitTaskDataCommon topology_data = *common_data;
+  topology_data.lnors_spacearr = NULL;
+  topology_data.loopnors = NULL;
+  topology_data.clnors_data = NULL;
+  topology_data.loop_to_poly = topology->loop_to_poly;
+
+  if (check_angle) {
+    topology->edge_to_loops_no_angle = MEM_calloc_arrayN(
+        numEdges, sizeof(*topology->edge_to_loops_no_angle), __func__);
+    topology_data.edge_to_loops = topology->edge_to_loops_no_angle;
+    mesh_edges_sharp_tag(&topology_data, false, split_angle, false);
+  }
+
+  topology_data.edge_to_loops = topology->edge_to_loops;
+  mesh_edges_sharp_tag(&topology_data, check_angle, split_angle, false);
+
+  loop_split_generator(NULL, &topology_data, topology);
+
+  if (topology->tasks_len != 0) {
+    topology->tasks = MEM_reallocN(topology->tasks,
+                                   sizeof(*topology->tasks) * (size_t)topology->tasks_len);
+  }
+
+  return topology;
+}
+
+typedef struct LoopSplitTopologyValidateData {
+  const MeshLoopSplitTopology *topology;
+  const float (*polynors)[3];
+  float split_angle_cos;
+  bool is_valid;
+} LoopSplitTopologyValidateData;
+
+static void loop_split_topology_validate_cb(void *__restrict userdata,
+                                            const int me_index,
+                                            const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LoopSplitTopologyValidateData *data = userdata;
+  const MeshLoopSplitTopology *topology = data->topology;
+  const int *e2l = topology->edge_to_loops_no_angle[me_index];
+
+  if (IS_EDGE_SHARP(e2l)) {
+    /* Sharp whatever the angle is. */
+    return;
+  }
+
+  const float(*polynors)[3] = data->polynors;
+  const bool is_angle_sharp = dot_v3v3(polynors[topology->loop_to_poly[e2l[0]]],
+                                       polynors[topology->loop_to_poly[e2l[1]]]) <
+                              data->split_angle_cos;
+  if (is_angle_sharp != IS_EDGE_SHARP(topology->edge_to_loops[me_index])) {
+    data->is_valid = false;
+  }
+}
+
+/**
+ * Check whether the cached smooth fans still match the sharp edges of the mesh,
+ * only the angle threshold depends on the vertex positions.
+ */
+static bool loop_split_topology_is_valid(const MeshLoopSplitTopology *topology,
+                                         const float (*polynors)[3],
+                                         const int numEdges,
+                                         const bool check_angle,
+                                         const float split_angle)
+{
+  if (topology->check_angle != check_angle) {
+    return false;
+  }
+  if (!check_angle) {
+    return true;
+  }
+  if (topology->split_angle != split_angle) {
+    return false;
+  }
+
+  LoopSplitTopologyValidateData data = {
+      .topology = topology,
+      .polynors = polynors,
+      .split_angle_cos = cosf(split_angle),
+      .is_valid = true,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 4096;
+  BLI_task_parallel_range(0, numEdges, &data, loop_split_topology_validate_cb, &settings);
+
+  return data.is_valid;
+}
+
+typedef struct LoopSplitTopologyUserData {
+  LoopSplitTaskDataCommon *common_data;
+  const MeshLoopSplitTopology *topology;
+  MLoopNorSpace *lnor_spaces;
+} LoopSplitTopologyUserData;
+
+typedef struct LoopSplitTopologyTLS {
+  BLI_Stack *edge_vectors;
+} LoopSplitTopologyTLS;
+
+static void loop_split_topology_init_loopnors_cb(void *__restrict userdata,
+                                                 const int ml_index,
+                                                 const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  LoopSplitTaskDataCommon *common_data = userdata;
+
+  /* Same as in #mesh_edges_sharp_tag, loop normals default to their vertex normal. */
+  normal_short_to_float_v3(common_data->loopnors[ml_index],
+                           common_data->mverts[common_data->mloops[ml_index].v].no);
+}
+
+static void loop_split_topology_task_cb(void *__restrict userdata,
+                                        const int task_index,
+                                        const TaskParallelTLS *__restrict tls)
+{
+  LoopSplitTopologyUserData *data = userdata;
+  LoopSplitTopologyTLS *tls_data = tls->userdata_chunk;
+  LoopSplitTaskDataCommon *common_data = data->common_data;
+  const LoopSplitTopologyTask *task = &data->topology->tasks[task_index];
+  const MLoop *mloops = common_data->mloops;
+
+  LoopSplitTaskData task_data = {NULL};
+  task_data.ml_curr = &mloops[task->ml_curr_index];
+  task_data.ml_prev = &mloops[task->ml_prev_index];
+  task_data.ml_curr_index = task->ml_curr_index;
+  task_data.ml_prev_index = task->ml_prev_index;
+  task_data.mp_index = task->mp_index;
+  if (task->is_fan) {
+    task_data.e2l_prev = common_data->edge_to_loops[task_data.ml_prev->e];
+    if (common_data->lnors_spacearr && tls_data->edge_vectors == NULL) {
+      tls_data->edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+    }
+  }
+  else {
+    task_data.lnor = &common_data->loopnors[task->ml_curr_index];
+  }
+  if (common_data->lnors_spacearr) {
+    task_data.lnor_space = &data->lnor_spaces[task_index];
+  }
+
+  loop_split_worker_do(common_data, &task_data, tls_data->edge_vectors);
+}
+
+static void loop_split_topology_task_free(const void *__restrict UNUSED(userdata),
+                                          void *__restrict tls_v)
+{
+  LoopSplitTopologyTLS *tls_data = tls_v;
+  if (tls_data->edge_vectors != NULL) {
+    BLI_stack_free(tls_data->edge_vectors);
+    tls_data->edge_vectors = NULL;
+  }
+}
+
+/**
+ * Compute the loop normals (and lnor spaces) from the cached smooth fans,
+ * all loops and fans are independent so this is fully threaded.
+ */
+static void loop_split_from_topology(LoopSplitTaskDataCommon *common_data,
+                                     const MeshLoopSplitTopology *topology,
+                                     int *r_loop_to_poly)
+{
+  MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
+
+  common_data->edge_to_loops = topology->edge_to_loops;
+  common_data->loop_to_poly = topology->loop_to_poly;
+
+  if (r_loop_to_poly) {
+    memcpy(r_loop_to_poly,
+           topology->loop_to_poly,
+           sizeof(*r_loop_to_poly) * (size_t)common_data->numLoops);
+  }
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 1024;
+
+  BLI_task_parallel_range(
+      0, common_data->numLoops, common_data, loop_split_topology_init_loopnors_cb, &settings);
+
+  LoopSplitTopologyUserData data = {
+      .common_data = common_data,
+      .topology = topology,
+  };
+  if (lnors_spacearr) {
+    /* Spaces are only ever referenced by pointer, allocate them all at once. */
+    data.lnor_spaces = BLI_memarena_calloc(lnors_spacearr->mem,
+                                           sizeof(*data.lnor_spaces) *
+                                               (size_t)max_ii(topology->tasks_len, 1));
+    lnors_spacearr->num_spaces += topology->tasks_len;
+  }
+
+  LoopSplitTopologyTLS tls = {NULL};
+  settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
+  settings.userdata_chunk = &tls;
+  settings.userdata_chunk_size = sizeof(tls);
+  settings.func_free = loop_split_topology_task_free;
+
+  BLI_task_parallel_range(
+      0, topology->tasks_len, &data, loop_split_topology_task_cb, &settings);
+}
+
 /**
  * Compute split normals, i.e. vertex normals associated with each poly (hence 'loop normals').
  * Useful to materialize sharp edges (or non-smooth faces) without actually modifying the geometry
  * (splitting edges).
  */
 void BKE_mesh_normals_loop_split(const MVert *mverts,
-                                 const int UNUSED(numVerts),
+                                 const int numVerts,
                                  MEdge *medges,
                                  const int numEdges,
                                  MLoop *mloops,
@@ -1621,6 +1979,46 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
                                  MLoopNorSpaceArray *r_lnors_spacearr,
                                  short (*clnors_data)[2],
                                  int *r_loop_to_poly)
+{
+  BKE_mesh_normals_loop_split_ex(mverts,
+                                 numVerts,
+                                 medges,
+                                 numEdges,
+                                 mloops,
+                                 r_loopnors,
+                                 numLoops,
+                                 mpolys,
+                                 polynors,
+                                 numPolys,
+                                 use_split_normals,
+                                 split_angle,
+                                 r_lnors_spacearr,
+                                 clnors_data,
+                                 r_loop_to_poly,
+                                 NULL);
+}
+
+/**
+ * \param mesh_cache: Optional mesh owning the given arrays,
+ * its smooth fans are cached in its runtime topology cache and reused by later calls,
+ * so that only normals need to be computed when the mesh is deformed.
+ */
+void BKE_mesh_normals_loop_split_ex(const MVert *mverts,
+                                    const int UNUSED(numVerts),
+                                    MEdge *medges,
+                                    const int numEdges,
+                                    MLoop *mloops,
+                                    float (*r_loopnors)[3],
+                                    const int numLoops,
+                                    MPoly *mpolys,
+                                    const float (*polynors)[3],
+                                    const int numPolys,
+                                    const bool use_split_normals,
+                                    const float split_angle,
+                                    MLoopNorSpaceArray *r_lnors_spacearr,
+                                    short (*clnors_data)[2],
+                                    int *r_loop_to_poly,
+                                    Mesh *mesh_cache)
 {
   /* For now this is not supported.
    * If we do not use split normals, we do not generate anything fancy! */
@@ -1657,27 +2055,6 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
     return;
   }
 
-  /**
-   * Mapping edge -> loops.
-   * If that edge is used by more than two loops (polys),
-   * it is always sharp (and tagged as such, see below).
-   * We also use the second loop index as a kind of flag:
-   *
-   * - smooth edge: > 0.
-   * - sharp edge: < 0 (INDEX_INVALID || INDEX_UNSET).
-   * - unset: INDEX_UNSET.
-   *
-   * Note that currently we only have two values for second loop of sharp edges.
-   * However, if needed, we can store the negated value of loop index instead of INDEX_INVALID
-   * to retrieve the real value later in code).
-   * Note also that lose edges always have both values set to 0! */
-  int(*edge_to_loops)[2] = MEM_calloc_arrayN((size_t)numEdges, sizeof(*edge_to_loops), __func__);
-
-  /* Simple mapping from a loop to its polygon index. */
-  int *loop_to_poly = r_loop_to_poly ?
-                          r_loop_to_poly :
-                          MEM_malloc_arrayN((size_t)numLoops, sizeof(*loop_to_poly), __func__);
-
   /* When using custom loop normals, disable the angle feature! */
   const bool check_angle = (split_angle < (float)M_PI) && (clnors_data == NULL);
 
@@ -1704,34 +2081,78 @@ void BKE_mesh_normals_loop_split(const MVert *mverts,
       .medges = medges,
       .mloops = mloops,
       .mpolys = mpolys,
-      .edge_to_loops = edge_to_loops,
-      .loop_to_poly = loop_to_poly,
       .polynors = polynors,
       .numEdges = numEdges,
       .numLoops = numLoops,
       .numPolys = numPolys,
   };
 
-  /* This first loop check which edges are actually smooth, and compute edge vectors. */
-  mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
+  MeshLoopSplitTopology *topology = NULL;
+  if (mesh_cache != NULL) {
+    bool do_store;
+    topology = BKE_mesh_runtime_loop_split_topology_acquire(mesh_cache, &do_store);
+    if (topology != NULL &&
+        !loop_split_topology_is_valid(topology, polynors, numEdges, check_angle, split_angle)) {
+      BKE_mesh_loop_split_topology_release(topology);
+      topology = NULL;
+    }
+    if (topology == NULL && do_store) {
+      topology = loop_split_topology_create(&common_data, check_angle, split_angle);
+      BKE_mesh_runtime_loop_split_topology_store(mesh_cache, topology);
+    }
+  }
 
-  if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-    /* Not enough loops to be worth the whole threading overhead... */
-    loop_split_generator(NULL, &common_data);
+  if (topology != NULL) {
+    loop_split_from_topology(&common_data, topology, r_loop_to_poly);
+    BKE_mesh_loop_split_topology_release(topology);
   }
   else {
-    TaskPool *task_pool = BLI_task_pool_create(&common_data, TASK_PRIORITY_HIGH);
+    /**
+     * Mapping edge -> loops.
+     * If that edge is used by more than two loops (polys),
+     * it is always sharp (and tagged as such, see below).
+     * We also use the second loop index as a kind of flag:
+     *
+     * - smooth edge: > 0.
+     * - sharp edge: < 0 (INDEX_INVALID || INDEX_UNSET).
+     * - unset: INDEX_UNSET.
+     *
+     * Note that currently we only have two values for second loop of sharp edges.
+     * However, if needed, we can store the negated value of loop index instead of INDEX_INVALID
+     * to retrieve the real value later in code).
+     * Note also that lose edges always have both values set to 0! */
+    int(*edge_to_loops)[2] = MEM_calloc_arrayN(
+        (size_t)numEdges, sizeof(*edge_to_loops), __func__);
+
+    /* Simple mapping from a loop to its polygon index. */
+    int *loop_to_poly = r_loop_to_poly ?
+                            r_loop_to_poly :
+                            MEM_malloc_arrayN((size_t)numLoops, sizeof(*loop_to_poly), __func__);
+
+    common_data.edge_to_loops = edge_to_loops;
+    common_data.loop_to_poly = loop_to_poly;
+
+    /* This first loop check which edges are actually smooth, and compute edge vectors. */
+    mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
+
+    if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
+      /* Not enough loops to be worth the whole threading overhead... */
+      loop_split_generator(NULL, &common_data, NULL);
+    }
+    else {
+      TaskPool *task_pool = BLI_task_pool_create(&common_data, TASK_PRIORITY_HIGH);
 
-    loop_split_generator(task_pool, &common_data);
+      loop_split_generator(task_pool, &common_data, NULL);
 
-    BLI_task_pool_work_and_wait(task_pool);
+      BLI_task_pool_work_and_wait(task_pool);
 
-    BLI_task_pool_free(task_pool);
-  }
+      BLI_task_pool_free(task_pool);
+    }
 
-  MEM_freeN(edge_to_loops);
-  if (!r_loop_to_poly) {
-    MEM_freeN(loop_to_poly);
+    MEM_freeN(edge_to_loops);
+    if (!r_loop_to_poly) {
+      MEM_freeN(loop_to_poly);
+    }
   }
 
   if (r_lnors_spacearr) {
@@ -3234,62 +3655,47 @@ int BKE_mesh_tessface_calc_ex(CustomData *fdata,
 #undef ML_TO_MF_QUAD
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Loop Tessellation
+ *
+ * Fill in #MLoopTri data-structure.
+ * \{ */
+
+/** Only tessellate in parallel for meshes with more loops than this. */
+#define MESH_FACE_TESSELLATE_THREADED_LIMIT 4096
+
 /**
- * Calculate tessellation into #MLoopTri which exist only for this purpose.
+ * Tessellate a single polygon, \a mlt points to its first triangle.
+ *
+ * \param pf_arena_p: Memory arena for n-gons, allocated when needed.
  */
-void BKE_mesh_recalc_looptri(const MLoop *mloop,
-                             const MPoly *mpoly,
-                             const MVert *mvert,
-                             int totloop,
-                             int totpoly,
-                             MLoopTri *mlooptri)
+static void mesh_calc_tessellation_for_face(const MLoop *mloop,
+                                            const MPoly *mpoly,
+                                            const MVert *mvert,
+                                            const unsigned int poly_index,
+                                            MLoopTri *mlt,
+                                            MemArena **pf_arena_p)
 {
-  /* use this to avoid locking pthread for _every_ polygon
-   * and calling the fill function */
-
-#define USE_TESSFACE_SPEEDUP
+  const unsigned int mp_loopstart = (unsigned int)mpoly[poly_index].loopstart;
+  const unsigned int mp_totloop = (unsigned int)mpoly[poly_index].totloop;
 
-  const MPoly *mp;
-  const MLoop *ml;
-  MLoopTri *mlt;
-  MemArena *arena = NULL;
-  int poly_index, mlooptri_index;
-  unsigned int j;
-
-  mlooptri_index = 0;
-  mp = mpoly;
-  for (poly_index = 0; poly_index < totpoly; poly_index++, mp++) {
-    const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
-    const unsigned int mp_totloop = (unsigned int)mp->totloop;
-    unsigned int l1, l2, l3;
-    if (mp_totloop < 3) {
-      /* do nothing */
-    }
-
-#ifdef USE_TESSFACE_SPEEDUP
-
-#  define ML_TO_MLT(i1, i2, i3) \
-    { \
-      mlt = &mlooptri[mlooptri_index]; \
-      l1 = mp_loopstart + i1; \
-      l2 = mp_loopstart + i2; \
-      l3 = mp_loopstart + i3; \
-      ARRAY_SET_ITEMS(mlt->tri, l1, l2, l3); \
-      mlt->poly = (unsigned int)poly_index; \
-    } \
-    ((void)0)
+#define ML_TO_MLT(i1, i2, i3) \
+  { \
+    ARRAY_SET_ITEMS(mlt->tri, mp_loopstart + i1, mp_loopstart + i2, mp_loopstart + i3); \
+    mlt->poly = poly_index; \
+  } \
+  ((void)0)
 
-    else if (mp_totloop == 3) {
+  switch (mp_totloop) {
+    case 3: {
       ML_TO_MLT(0, 1, 2);
-      mlooptri_index++;
+      break;
     }
-    else if (mp_totloop == 4) {
+    case 4: {
       ML_TO_MLT(0, 1, 2);
-      MLoopTri *mlt_a = mlt;
-      mlooptri_index++;
+      MLoopTri *mlt_a = mlt++;
       ML_TO_MLT(0, 2, 3);
       MLoopTri *mlt_b = mlt;
-      mlooptri_index++;
 
       if (UNLIKELY(is_quad_flip_v3_first_third_fast(mvert[mloop[mlt_a->tri[0]].v].co,
                                                     mvert[mloop[mlt_a->tri[1]].v].co,
@@ -3299,9 +3705,15 @@ void BKE_mesh_recalc_looptri(const MLoop *mloop,
         mlt_a->tri[2] = mlt_b->tri[2];
         mlt_b->tri[0] = mlt_a->tri[1];
       }
+      break;
     }
-#endif /* USE_TESSFACE_SPEEDUP */
-    else {
+    default: {
+      if (mp_totloop < 3) {
+        /* Invalid polygon, no triangles. */
+        break;
+      }
+
+      const MLoop *ml;
       const float *co_curr, *co_prev;
 
       float normal[3];
@@ -3311,13 +3723,15 @@ void BKE_mesh_recalc_looptri(const MLoop *mloop,
       unsigned int(*tris)[3];
 
       const unsigned int totfilltri = mp_totloop - 2;
+      unsigned int j;
 
-      if (UNLIKELY(arena == NULL)) {
-        arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+      MemArena *pf_arena = *pf_arena_p;
+      if (UNLIKELY(pf_arena == NULL)) {
+        pf_arena = *pf_arena_p = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
       }
 
-      tris = BLI_memarena_alloc(arena, sizeof(*tris) * (size_t)totfilltri);
-      projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * (size_t)mp_totloop);
+      tris = BLI_memarena_alloc(pf_arena, sizeof(*tris) * (size_t)totfilltri);
+      projverts = BLI_memarena_alloc(pf_arena, sizeof(*projverts) * (size_t)mp_totloop);
 
       zero_v3(normal);
 
@@ -3341,41 +3755,138 @@ void BKE_mesh_recalc_looptri(const MLoop *mloop,
         mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
       }
 
-      BLI_polyfill_calc_arena(projverts, mp_totloop, 1, tris, arena);
+      BLI_polyfill_calc_arena(projverts, mp_totloop, 1, tris, pf_arena);
 
       /* apply fill */
-      for (j = 0; j < totfilltri; j++) {
-        unsigned int *tri = tris[j];
-
-        mlt = &mlooptri[mlooptri_index];
-
-        /* set loop indices, transformed to vert indices later */
-        l1 = mp_loopstart + tri[0];
-        l2 = mp_loopstart + tri[1];
-        l3 = mp_loopstart + tri[2];
+      for (j = 0; j < totfilltri; j++, mlt++) {
+        const unsigned int *tri = tris[j];
+        ML_TO_MLT(tri[0], tri[1], tri[2]);
+      }
 
-        ARRAY_SET_ITEMS(mlt->tri, l1, l2, l3);
-        mlt->poly = (unsigned int)poly_index;
+      BLI_memarena_clear(pf_arena);
+      break;
+    }
+  }
 
-        mlooptri_index++;
-      }
+#undef ML_TO_MLT
+}
 
-      BLI_memarena_clear(arena);
+static void mesh_recalc_looptri__single_threaded(const MLoop *mloop,
+                                                 const MPoly *mpoly,
+                                                 const MVert *mvert,
+                                                 int totloop,
+                                                 int totpoly,
+                                                 MLoopTri *mlooptri)
+{
+  MemArena *pf_arena = NULL;
+  const MPoly *mp = mpoly;
+  unsigned int tri_index = 0;
+
+  for (unsigned int poly_index = 0; poly_index < (unsigned int)totpoly; poly_index++, mp++) {
+    mesh_calc_tessellation_for_face(
+        mloop, mpoly, mvert, poly_index, &mlooptri[tri_index], &pf_arena);
+    if (LIKELY(mp->totloop >= 3)) {
+      tri_index += (unsigned int)(mp->totloop - 2);
     }
   }
 
-  if (arena) {
-    BLI_memarena_free(arena);
-    arena = NULL;
+  if (pf_arena) {
+    BLI_memarena_free(pf_arena);
+    pf_arena = NULL;
   }
 
-  BLI_assert(mlooptri_index == poly_to_tri_count(totpoly, totloop));
+  BLI_assert(tri_index == (unsigned int)poly_to_tri_count(totpoly, totloop));
   UNUSED_VARS_NDEBUG(totloop);
+}
 
-#undef USE_TESSFACE_SPEEDUP
-#undef ML_TO_MLT
+typedef struct TessellationUserData {
+  const MLoop *mloop;
+  const MPoly *mpoly;
+  const MVert *mvert;
+
+  /** Output array. */
+  MLoopTri *mlooptri;
+} TessellationUserData;
+
+typedef struct TessellationUserTLS {
+  MemArena *pf_arena;
+} TessellationUserTLS;
+
+static void mesh_calc_tessellation_for_face_fn(void *__restrict userdata,
+                                               const int index,
+                                               const TaskParallelTLS *__restrict tls)
+{
+  const TessellationUserData *data = userdata;
+  TessellationUserTLS *tls_data = tls->userdata_chunk;
+  /* The triangles of all previous polygons, always stored in order. */
+  const int tri_index = poly_to_tri_count(index, data->mpoly[index].loopstart);
+  mesh_calc_tessellation_for_face(data->mloop,
+                                  data->mpoly,
+                                  data->mvert,
+                                  (unsigned int)index,
+                                  &data->mlooptri[tri_index],
+                                  &tls_data->pf_arena);
+}
+
+static void mesh_calc_tessellation_for_face_free_fn(const void *__restrict UNUSED(userdata),
+                                                    void *__restrict tls_v)
+{
+  TessellationUserTLS *tls_data = tls_v;
+  if (tls_data->pf_arena) {
+    BLI_memarena_free(tls_data->pf_arena);
+  }
+}
+
+static void mesh_recalc_looptri__multi_threaded(const MLoop *mloop,
+                                                const MPoly *mpoly,
+                                                const MVert *mvert,
+                                                int UNUSED(totloop),
+                                                int totpoly,
+                                                MLoopTri *mlooptri)
+{
+  TessellationUserTLS tls_data_dummy = {NULL};
+
+  TessellationUserData data = {
+      .mloop = mloop,
+      .mpoly = mpoly,
+      .mvert = mvert,
+      .mlooptri = mlooptri,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+
+  settings.userdata_chunk = &tls_data_dummy;
+  settings.userdata_chunk_size = sizeof(tls_data_dummy);
+
+  settings.func_free = mesh_calc_tessellation_for_face_free_fn;
+
+  BLI_task_parallel_range(0, totpoly, &data, mesh_calc_tessellation_for_face_fn, &settings);
 }
 
+/**
+ * Calculate tessellation into #MLoopTri which exist only for this purpose.
+ *
+ * \note Polygons must be stored in the same order as their loops, since the first triangle
+ * of each polygon is calculated from its loop-start (see #poly_to_tri_count).
+ */
+void BKE_mesh_recalc_looptri(const MLoop *mloop,
+                             const MPoly *mpoly,
+                             const MVert *mvert,
+                             int totloop,
+                             int totpoly,
+                             MLoopTri *mlooptri)
+{
+  if (totloop < MESH_FACE_TESSELLATE_THREADED_LIMIT) {
+    mesh_recalc_looptri__single_threaded(mloop, mpoly, mvert, totloop, totpoly, mlooptri);
+  }
+  else {
+    mesh_recalc_looptri__multi_threaded(mloop, mpoly, mvert, totloop, totpoly, mlooptri);
+  }
+}
+
+/** \} */
+
 static void bm_corners_to_loops_ex(ID *id,
                                    CustomData *fdata,
                                    CustomData *ldata,
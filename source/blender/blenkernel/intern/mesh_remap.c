@@ -112,6 +112,89 @@ static bool mesh_remap_bvhtree_query_raycast(BVHTreeFromMesh *treedata,
   }
 }
 
+/* Same as #mesh_remap_bvhtree_query_nearest for all given coordinates at once (in parallel),
+ * results are checked with #mesh_remap_bvhtree_nearest_is_valid. */
+static BVHTreeNearest *mesh_remap_bvhtree_query_nearest_batch(BVHTreeFromMesh *treedata,
+                                                              const float (*cos)[3],
+                                                              const int numcos,
+                                                              const float max_dist_sq)
+{
+  BVHTreeNearest *nearests = MEM_mallocN(sizeof(*nearests) * (size_t)numcos, __func__);
+  BLI_bvhtree_find_nearest_batch(
+      treedata->tree, cos, numcos, max_dist_sq, nearests, treedata->nearest_callback, treedata, 0);
+  return nearests;
+}
+
+static bool mesh_remap_bvhtree_nearest_is_valid(const BVHTreeNearest *nearest,
+                                                const float max_dist_sq,
+                                                float *r_hit_dist)
+{
+  if ((nearest->index != -1) && (nearest->dist_sq <= max_dist_sq)) {
+    *r_hit_dist = sqrtf(nearest->dist_sq);
+    return true;
+  }
+  return false;
+}
+
+/* Same as #mesh_remap_bvhtree_query_raycast for all given rays at once (in parallel),
+ * results are checked with #mesh_remap_bvhtree_rayhit_is_valid. */
+static BVHTreeRayHit *mesh_remap_bvhtree_query_raycast_batch(BVHTreeFromMesh *treedata,
+                                                             const float (*cos)[3],
+                                                             const float (*nos)[3],
+                                                             const int numcos,
+                                                             const float radius,
+                                                             const float max_dist)
+{
+  BVHTreeRayHit *rayhits = MEM_mallocN(sizeof(*rayhits) * (size_t)numcos, __func__);
+  BVHTreeRayHit *rayhits_inv = MEM_mallocN(sizeof(*rayhits_inv) * (size_t)numcos, __func__);
+  float(*inv_nos)[3] = MEM_mallocN(sizeof(*inv_nos) * (size_t)numcos, __func__);
+
+  for (int i = 0; i < numcos; i++) {
+    negate_v3_v3(inv_nos[i], nos[i]);
+  }
+  BLI_bvhtree_ray_cast_batch(treedata->tree,
+                             cos,
+                             nos,
+                             numcos,
+                             radius,
+                             max_dist,
+                             rayhits,
+                             treedata->raycast_callback,
+                             treedata,
+                             BVH_RAYCAST_DEFAULT);
+  /* Also cast in the other direction! */
+  BLI_bvhtree_ray_cast_batch(treedata->tree,
+                             cos,
+                             (const float(*)[3])inv_nos,
+                             numcos,
+                             radius,
+                             max_dist,
+                             rayhits_inv,
+                             treedata->raycast_callback,
+                             treedata,
+                             BVH_RAYCAST_DEFAULT);
+  for (int i = 0; i < numcos; i++) {
+    if (rayhits_inv[i].dist < rayhits[i].dist) {
+      rayhits[i] = rayhits_inv[i];
+    }
+  }
+
+  MEM_freeN(rayhits_inv);
+  MEM_freeN(inv_nos);
+  return rayhits;
+}
+
+static bool mesh_remap_bvhtree_rayhit_is_valid(const BVHTreeRayHit *rayhit,
+                                               const float max_dist,
+                                               float *r_hit_dist)
+{
+  if ((rayhit->index != -1) && (rayhit->dist <= max_dist)) {
+    *r_hit_dist = rayhit->dist;
+    return true;
+  }
+  return false;
+}
+
 /** \} */
 
 /**
@@ -519,51 +602,47 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
   }
   else {
     BVHTreeFromMesh treedata = {NULL};
-    BVHTreeNearest nearest = {0};
-    BVHTreeRayHit rayhit = {0};
     float hit_dist;
-    float tmp_co[3], tmp_no[3];
+
+    /* Convert the vertices to tree coordinates, if needed. */
+    float(*cos_dst)[3] = MEM_mallocN(sizeof(*cos_dst) * (size_t)numverts_dst, __func__);
+    for (i = 0; i < numverts_dst; i++) {
+      copy_v3_v3(cos_dst[i], verts_dst[i].co);
+      if (space_transform) {
+        BLI_space_transform_apply(space_transform, cos_dst[i]);
+      }
+    }
 
     if (mode == MREMAP_MODE_VERT_NEAREST) {
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_VERTS, 2);
-      nearest.index = -1;
+      BVHTreeNearest *nearests = mesh_remap_bvhtree_query_nearest_batch(
+          &treedata, (const float(*)[3])cos_dst, numverts_dst, max_dist_sq);
 
       for (i = 0; i < numverts_dst; i++) {
-        copy_v3_v3(tmp_co, verts_dst[i].co);
-
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &nearest.index, &full_weight);
+        if (mesh_remap_bvhtree_nearest_is_valid(&nearests[i], max_dist_sq, &hit_dist)) {
+          mesh_remap_item_define(r_map, i, hit_dist, 0, 1, &nearests[i].index, &full_weight);
         }
         else {
           /* No source for this dest vertex! */
           BKE_mesh_remap_item_define_invalid(r_map, i);
         }
       }
+
+      MEM_freeN(nearests);
     }
     else if (ELEM(mode, MREMAP_MODE_VERT_EDGE_NEAREST, MREMAP_MODE_VERT_EDGEINTERP_NEAREST)) {
       MEdge *edges_src = me_src->medge;
       float(*vcos_src)[3] = BKE_mesh_vert_coords_alloc(me_src, NULL);
 
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_EDGES, 2);
-      nearest.index = -1;
+      BVHTreeNearest *nearests = mesh_remap_bvhtree_query_nearest_batch(
+          &treedata, (const float(*)[3])cos_dst, numverts_dst, max_dist_sq);
 
       for (i = 0; i < numverts_dst; i++) {
-        copy_v3_v3(tmp_co, verts_dst[i].co);
+        const float *tmp_co = cos_dst[i];
 
-        /* Convert the vertex to tree coordinates, if needed. */
-        if (space_transform) {
-          BLI_space_transform_apply(space_transform, tmp_co);
-        }
-
-        if (mesh_remap_bvhtree_query_nearest(
-                &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-          MEdge *me = &edges_src[nearest.index];
+        if (mesh_remap_bvhtree_nearest_is_valid(&nearests[i], max_dist_sq, &hit_dist)) {
+          MEdge *me = &edges_src[nearests[i].index];
           const float *v1cos = vcos_src[me->v1];
           const float *v2cos = vcos_src[me->v2];
 
@@ -594,6 +673,7 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
         }
       }
 
+      MEM_freeN(nearests);
       MEM_freeN(vcos_src);
     }
     else if (ELEM(mode,
@@ -612,24 +692,30 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
       BKE_bvhtree_from_mesh_get(&treedata, me_src, BVHTREE_FROM_LOOPTRI, 2);
 
       if (mode == MREMAP_MODE_VERT_POLYINTERP_VNORPROJ) {
+        float(*nos_dst)[3] = MEM_mallocN(sizeof(*nos_dst) * (size_t)numverts_dst, __func__);
         for (i = 0; i < numverts_dst; i++) {
-          copy_v3_v3(tmp_co, verts_dst[i].co);
-          normal_short_to_float_v3(tmp_no, verts_dst[i].no);
-
-          /* Convert the vertex to tree coordinates, if needed. */
+          normal_short_to_float_v3(nos_dst[i], verts_dst[i].no);
           if (space_transform) {
-            BLI_space_transform_apply(space_transform, tmp_co);
-            BLI_space_transform_apply_normal(space_transform, tmp_no);
+            BLI_space_transform_apply_normal(space_transform, nos_dst[i]);
           }
+        }
+        BVHTreeRayHit *rayhits = mesh_remap_bvhtree_query_raycast_batch(&treedata,
+                                                                        (const float(*)[3])cos_dst,
+                                                                        (const float(*)[3])nos_dst,
+                                                                        numverts_dst,
+                                                                        ray_radius,
+                                                                        max_dist);
 
-          if (mesh_remap_bvhtree_query_raycast(
-                  &treedata, &rayhit, tmp_co, tmp_no, ray_radius, max_dist, &hit_dist)) {
-            const MLoopTri *lt = &treedata.looptri[rayhit.index];
+        for (i = 0; i < numverts_dst; i++) {
+          const BVHTreeRayHit *rayhit = &rayhits[i];
+
+          if (mesh_remap_bvhtree_rayhit_is_valid(rayhit, max_dist, &hit_dist)) {
+            const MLoopTri *lt = &treedata.looptri[rayhit->index];
             MPoly *mp_src = &polys_src[lt->poly];
             const int sources_num = mesh_remap_interp_poly_data_get(mp_src,
                                                                     loops_src,
                                                                     (const float(*)[3])vcos_src,
-                                                                    rayhit.co,
+                                                                    rayhit->co,
                                                                     &tmp_buff_size,
                                                                     &vcos,
                                                                     false,
@@ -645,21 +731,19 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
             BKE_mesh_remap_item_define_invalid(r_map, i);
           }
         }
+
+        MEM_freeN(rayhits);
+        MEM_freeN(nos_dst);
       }
       else {
-        nearest.index = -1;
+        BVHTreeNearest *nearests = mesh_remap_bvhtree_query_nearest_batch(
+            &treedata, (const float(*)[3])cos_dst, numverts_dst, max_dist_sq);
 
         for (i = 0; i < numverts_dst; i++) {
-          copy_v3_v3(tmp_co, verts_dst[i].co);
+          const BVHTreeNearest *nearest = &nearests[i];
 
-          /* Convert the vertex to tree coordinates, if needed. */
-          if (space_transform) {
-            BLI_space_transform_apply(space_transform, tmp_co);
-          }
-
-          if (mesh_remap_bvhtree_query_nearest(
-                  &treedata, &nearest, tmp_co, max_dist_sq, &hit_dist)) {
-            const MLoopTri *lt = &treedata.looptri[nearest.index];
+          if (mesh_remap_bvhtree_nearest_is_valid(nearest, max_dist_sq, &hit_dist)) {
+            const MLoopTri *lt = &treedata.looptri[nearest->index];
             MPoly *mp = &polys_src[lt->poly];
 
             if (mode == MREMAP_MODE_VERT_POLY_NEAREST) {
@@ -667,7 +751,7 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
               mesh_remap_interp_poly_data_get(mp,
                                               loops_src,
                                               (const float(*)[3])vcos_src,
-                                              nearest.co,
+                                              nearest->co,
                                               &tmp_buff_size,
                                               &vcos,
                                               false,
@@ -682,7 +766,7 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
               const int sources_num = mesh_remap_interp_poly_data_get(mp,
                                                                       loops_src,
                                                                       (const float(*)[3])vcos_src,
-                                                                      nearest.co,
+                                                                      nearest->co,
                                                                       &tmp_buff_size,
                                                                       &vcos,
                                                                       false,
@@ -699,6 +783,8 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
             BKE_mesh_remap_item_define_invalid(r_map, i);
           }
         }
+
+        MEM_freeN(nearests);
       }
 
       MEM_freeN(vcos_src);
@@ -712,6 +798,7 @@ void BKE_mesh_remap_calc_verts_from_mesh(const int mode,
     }
 
     free_bvhtree_from_mesh(&treedata);
+    MEM_freeN(cos_dst);
   }
 }
 
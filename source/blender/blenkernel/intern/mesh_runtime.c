@@ -35,6 +35,7 @@
 #include "BKE_bvhutils.h"
 #include "BKE_lib_id.h"
 #include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
 #include "BKE_mesh_runtime.h"
 #include "BKE_shrinkwrap.h"
 #include "BKE_subdiv_ccg.h"
@@ -70,6 +71,7 @@ void BKE_mesh_runtime_reset_on_copy(Mesh *mesh, const int UNUSED(flag))
   memset(&runtime->looptris, 0, sizeof(runtime->looptris));
   runtime->bvh_cache = NULL;
   runtime->shrinkwrap_data = NULL;
+  runtime->topology_cache = NULL;
 
   mesh->runtime.eval_mutex = MEM_mallocN(sizeof(ThreadMutex), "mesh runtime eval_mutex");
   BLI_mutex_init(mesh->runtime.eval_mutex);
@@ -229,7 +231,8 @@ bool BKE_mesh_runtime_clear_edit_data(Mesh *mesh)
 void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
 {
   if (mesh->runtime.bvh_cache) {
-    bvhcache_free(mesh->runtime.bvh_cache);
+    /* Before releasing the topology cache, which keeps the trees for the next evaluation. */
+    bvhcache_free_ex(mesh->runtime.bvh_cache, mesh);
     mesh->runtime.bvh_cache = NULL;
   }
   MEM_SAFE_FREE(mesh->runtime.looptris.array);
@@ -239,6 +242,275 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
     mesh->runtime.subdiv_ccg = NULL;
   }
   BKE_shrinkwrap_discard_boundary_data(mesh);
+  BKE_mesh_runtime_topology_cache_release(mesh);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Mesh Topology Cache
+ *
+ * Data which only depends on the connectivity of a mesh (loops and polygons),
+ * shared between a copy-on-write mesh and the evaluated meshes referencing its topology,
+ * so it survives re-evaluation of deformed meshes from one frame to the next.
+ *
+ * Mappings are only built once they have been requested more than once,
+ * meshes evaluated a single time never pay for them.
+ * \{ */
+
+typedef struct MeshTopologyCache {
+  unsigned int users;
+  /** Number of #BKE_mesh_runtime_vert_loop_map_ensure requests. */
+  unsigned int vert_loop_map_requests;
+  /** Number of #BKE_mesh_runtime_loop_split_topology_acquire requests. */
+  unsigned int loop_split_topology_requests;
+
+  /** Topology the cache was created for, used to detect meshes that no longer match it. */
+  const MEdge *medge;
+  const MLoop *mloop;
+  const MPoly *mpoly;
+  int totvert, totedge, totloop, totpoly;
+
+  ThreadMutex mutex;
+
+  MeshElemMap *vert_loop_map;
+  int *vert_loop_map_mem;
+
+  /** Smooth fans of split normals, defined in 'mesh_evaluate.c', protected by the mutex. */
+  struct MeshLoopSplitTopology *loop_split_topology;
+
+  /**
+   * BVH trees of freed evaluated meshes, for the next evaluated mesh to refit them,
+   * indexed by #BVHCacheType and protected by the mutex.
+   */
+  BVHTree *bvh_trees[BVHTREE_MAX_ITEM];
+  int bvh_tree_refit_counts[BVHTREE_MAX_ITEM];
+} MeshTopologyCache;
+
+static MeshTopologyCache *mesh_topology_cache_create(const Mesh *mesh)
+{
+  MeshTopologyCache *cache = MEM_callocN(sizeof(*cache), __func__);
+  cache->users = 1;
+  cache->medge = mesh->medge;
+  cache->mloop = mesh->mloop;
+  cache->mpoly = mesh->mpoly;
+  cache->totvert = mesh->totvert;
+  cache->totedge = mesh->totedge;
+  cache->totloop = mesh->totloop;
+  cache->totpoly = mesh->totpoly;
+  BLI_mutex_init(&cache->mutex);
+  return cache;
+}
+
+static void mesh_topology_cache_free(MeshTopologyCache *cache)
+{
+  MEM_SAFE_FREE(cache->vert_loop_map);
+  MEM_SAFE_FREE(cache->vert_loop_map_mem);
+  if (cache->loop_split_topology != NULL) {
+    BKE_mesh_loop_split_topology_release(cache->loop_split_topology);
+  }
+  for (int i = 0; i < BVHTREE_MAX_ITEM; i++) {
+    if (cache->bvh_trees[i] != NULL) {
+      BLI_bvhtree_free(cache->bvh_trees[i]);
+    }
+  }
+  BLI_mutex_end(&cache->mutex);
+  MEM_freeN(cache);
+}
+
+static bool mesh_topology_cache_matches(const MeshTopologyCache *cache, const Mesh *mesh)
+{
+  return (cache->medge == mesh->medge) && (cache->mloop == mesh->mloop) &&
+         (cache->mpoly == mesh->mpoly) && (cache->totvert == mesh->totvert) &&
+         (cache->totedge == mesh->totedge) && (cache->totloop == mesh->totloop) &&
+         (cache->totpoly == mesh->totpoly);
+}
+
+/**
+ * Let \a mesh_dst use the topology cache of \a mesh_src,
+ * creating it first when \a mesh_src is a copy-on-write mesh (which persists across frames).
+ *
+ * \note Only valid when \a mesh_dst references the loops and polygons of \a mesh_src.
+ */
+void BKE_mesh_runtime_topology_cache_share(Mesh *mesh_dst, Mesh *mesh_src)
+{
+  BLI_assert(mesh_dst->runtime.topology_cache == NULL);
+
+  MeshTopologyCache *cache = mesh_src->runtime.topology_cache;
+  if (cache == NULL) {
+    if ((mesh_src->id.tag & LIB_TAG_COPIED_ON_WRITE) == 0 || mesh_src->totpoly == 0) {
+      return;
+    }
+    /* Several objects using the same mesh may be evaluated at once. */
+    MeshTopologyCache *cache_new = mesh_topology_cache_create(mesh_src);
+    cache = atomic_cas_ptr((void **)&mesh_src->runtime.topology_cache, NULL, cache_new);
+    if (cache == NULL) {
+      cache = cache_new;
+    }
+    else {
+      mesh_topology_cache_free(cache_new);
+    }
+  }
+
+  if (!mesh_topology_cache_matches(cache, mesh_dst)) {
+    return;
+  }
+
+  atomic_add_and_fetch_uint32(&cache->users, 1);
+  mesh_dst->runtime.topology_cache = cache;
+}
+
+void BKE_mesh_runtime_topology_cache_release(Mesh *mesh)
+{
+  MeshTopologyCache *cache = mesh->runtime.topology_cache;
+  if (cache == NULL) {
+    return;
+  }
+  mesh->runtime.topology_cache = NULL;
+  if (atomic_sub_and_fetch_uint32(&cache->users, 1) == 0) {
+    mesh_topology_cache_free(cache);
+  }
+}
+
+/**
+ * Return the vertex to loop map of the mesh topology (see #BKE_mesh_vert_loop_map_create),
+ * or NULL when the mesh has no (matching) topology cache or the map is not worth building yet.
+ */
+const MeshElemMap *BKE_mesh_runtime_vert_loop_map_ensure(Mesh *mesh)
+{
+  MeshTopologyCache *cache = mesh->runtime.topology_cache;
+  if (cache == NULL || !mesh_topology_cache_matches(cache, mesh)) {
+    return NULL;
+  }
+
+  MeshElemMap *map = cache->vert_loop_map;
+  if (map != NULL) {
+    return map;
+  }
+  if (atomic_add_and_fetch_uint32(&cache->vert_loop_map_requests, 1) < 2) {
+    return NULL;
+  }
+
+  BLI_mutex_lock(&cache->mutex);
+  if (cache->vert_loop_map == NULL) {
+    int *map_mem;
+    BKE_mesh_vert_loop_map_create(&map,
+                                  &map_mem,
+                                  mesh->mpoly,
+                                  mesh->mloop,
+                                  mesh->totvert,
+                                  mesh->totpoly,
+                                  mesh->totloop);
+    cache->vert_loop_map_mem = map_mem;
+    atomic_cas_ptr((void **)&cache->vert_loop_map, NULL, map);
+  }
+  map = cache->vert_loop_map;
+  BLI_mutex_unlock(&cache->mutex);
+
+  return map;
+}
+
+/**
+ * Get a new user of the cached smooth fans of the mesh (see #BKE_mesh_normals_loop_split_ex),
+ * to be released with #BKE_mesh_loop_split_topology_release.
+ *
+ * \param r_do_store: Set when the caller should store the smooth fans it computes,
+ * either because the cached ones are outdated, or because they have been requested repeatedly.
+ */
+struct MeshLoopSplitTopology *BKE_mesh_runtime_loop_split_topology_acquire(Mesh *mesh,
+                                                                           bool *r_do_store)
+{
+  MeshTopologyCache *cache = mesh->runtime.topology_cache;
+  *r_do_store = false;
+  if (cache == NULL || !mesh_topology_cache_matches(cache, mesh)) {
+    return NULL;
+  }
+
+  BLI_mutex_lock(&cache->mutex);
+  struct MeshLoopSplitTopology *topology = cache->loop_split_topology;
+  if (topology != NULL) {
+    BKE_mesh_loop_split_topology_user_add(topology);
+    *r_do_store = true;
+  }
+  else {
+    *r_do_store = (++cache->loop_split_topology_requests >= 2);
+  }
+  BLI_mutex_unlock(&cache->mutex);
+
+  return topology;
+}
+
+/**
+ * Replace the cached smooth fans of the mesh, the cache gets its own user of \a topology.
+ */
+void BKE_mesh_runtime_loop_split_topology_store(Mesh *mesh, struct MeshLoopSplitTopology *topology)
+{
+  MeshTopologyCache *cache = mesh->runtime.topology_cache;
+  if (cache == NULL || !mesh_topology_cache_matches(cache, mesh)) {
+    return;
+  }
+
+  BKE_mesh_loop_split_topology_user_add(topology);
+
+  BLI_mutex_lock(&cache->mutex);
+  struct MeshLoopSplitTopology *topology_old = cache->loop_split_topology;
+  cache->loop_split_topology = topology;
+  BLI_mutex_unlock(&cache->mutex);
+
+  if (topology_old != NULL) {
+    BKE_mesh_loop_split_topology_release(topology_old);
+  }
+}
+
+/**
+ * Take the BVH tree of type \a bvh_cache_type kept by #BKE_mesh_runtime_bvh_tree_store,
+ * to be refitted to the positions of \a mesh, the caller owns the returned tree.
+ *
+ * \param r_refit_count: The number of times the tree has been refitted since it was built.
+ */
+BVHTree *BKE_mesh_runtime_bvh_tree_take(Mesh *mesh, int bvh_cache_type, int *r_refit_count)
+{
+  MeshTopologyCache *cache = mesh->runtime.topology_cache;
+  *r_refit_count = 0;
+  if (cache == NULL || !mesh_topology_cache_matches(cache, mesh)) {
+    return NULL;
+  }
+
+  BLI_mutex_lock(&cache->mutex);
+  BVHTree *tree = cache->bvh_trees[bvh_cache_type];
+  cache->bvh_trees[bvh_cache_type] = NULL;
+  *r_refit_count = cache->bvh_tree_refit_counts[bvh_cache_type];
+  BLI_mutex_unlock(&cache->mutex);
+
+  return tree;
+}
+
+/**
+ * Keep the BVH tree of type \a bvh_cache_type built for \a mesh (which is being freed)
+ * for the next evaluated mesh with the same topology.
+ *
+ * \return true when the topology cache took ownership of \a tree.
+ */
+bool BKE_mesh_runtime_bvh_tree_store(Mesh *mesh,
+                                     int bvh_cache_type,
+                                     BVHTree *tree,
+                                     int refit_count)
+{
+  MeshTopologyCache *cache = mesh->runtime.topology_cache;
+  if (cache == NULL || !mesh_topology_cache_matches(cache, mesh)) {
+    return false;
+  }
+
+  bool is_stored = false;
+  BLI_mutex_lock(&cache->mutex);
+  if (cache->bvh_trees[bvh_cache_type] == NULL) {
+    cache->bvh_trees[bvh_cache_type] = tree;
+    cache->bvh_tree_refit_counts[bvh_cache_type] = refit_count;
+    is_stored = true;
+  }
+  BLI_mutex_unlock(&cache->mutex);
+
+  return is_stored;
 }
 
 /** \} */
@@ -4547,8 +4547,8 @@ bool BKE_object_modifier_use_time(Object *ob, ModifierData *md)
     return true;
   }
 
-  /* Check whether modifier is animated. */
-  /* TODO: this should be handled as part of build_animdata() -- Aligorith */
+  /* Keyframed modifier properties are handled by the relations from the animation to the
+   * modifier, which only flush frame changes when the animated value changes. */
   if (ob->adt) {
     AnimData *adt = ob->adt;
     FCurve *fcu;
@@ -4556,15 +4556,6 @@ bool BKE_object_modifier_use_time(Object *ob, ModifierData *md)
     char pattern[MAX_NAME + 16];
     BLI_snprintf(pattern, sizeof(pattern), "modifiers[\"%s\"]", md->name);
 
-    /* action - check for F-Curves with paths containing 'modifiers[' */
-    if (adt->action) {
-      for (fcu = (FCurve *)adt->action->curves.first; fcu != NULL; fcu = (FCurve *)fcu->next) {
-        if (fcu->rna_path && strstr(fcu->rna_path, pattern)) {
-          return true;
-        }
-      }
-    }
-
     /* This here allows modifier properties to get driven and still update properly
      *
      * Workaround to get [#26764] (e.g. subsurf levels not updating when animated/driven)
@@ -4576,9 +4567,6 @@ bool BKE_object_modifier_use_time(Object *ob, ModifierData *md)
         return true;
       }
     }
-
-    /* XXX: also, should check NLA strips, though for now assume that nobody uses
-     * that and we can omit that for performance reasons... */
   }
 
   return false;
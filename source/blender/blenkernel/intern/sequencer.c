@@ -1999,7 +1999,7 @@ static void seq_proxy_build_frame(const SeqRenderData *context,
     ibuf = IMB_dupImBuf(ibuf_tmp);
     IMB_metadata_copy(ibuf, ibuf_tmp);
     IMB_freeImBuf(ibuf_tmp);
-    IMB_scalefastImBuf(ibuf, (short)rectx, (short)recty);
+    IMB_scaleImBuf(ibuf, (short)rectx, (short)recty);
   }
   else {
     ibuf = ibuf_tmp;
@@ -2714,7 +2714,8 @@ static ImBuf *input_preprocess(const SeqRenderData *context,
       double f = BKE_sequencer_rendersize_to_scale_factor(context->preview_render_size);
 
       if (f != 1.0) {
-        IMB_scalefastImBuf(ibuf, ibuf->x * f, ibuf->y * f);
+        /* Proxies are only ever scaled down to the preview size. */
+        IMB_scale_filter_ImBuf(ibuf, ibuf->x * f, ibuf->y * f, IMB_SCALE_FILTER_BOX);
       }
     }
 
@@ -2812,7 +2813,9 @@ static ImBuf *input_preprocess(const SeqRenderData *context,
       IMB_scaleImBuf(ibuf, (short)context->rectx, (short)context->recty);
     }
     else {
-      IMB_scalefastImBuf(ibuf, (short)context->rectx, (short)context->recty);
+      /* Bilinear widens to a tent filter when scaling down, cheap enough for playback. */
+      IMB_scale_filter_ImBuf(
+          ibuf, (short)context->rectx, (short)context->recty, IMB_SCALE_FILTER_BILINEAR);
     }
   }
 
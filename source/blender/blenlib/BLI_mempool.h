@@ -94,6 +94,27 @@ BLI_mempool_iter *BLI_mempool_iter_threadsafe_create(BLI_mempool *pool,
     ATTR_NONNULL();
 void BLI_mempool_iter_threadsafe_free(BLI_mempool_iter *iter_arr) ATTR_NONNULL();
 
+/** Thread local allocation, see #BLI_mempool_tls_init. */
+/* private structure */
+typedef struct BLI_mempool_tls {
+  BLI_mempool *pool;
+  struct BLI_mempool_chunk *chunks;
+  struct BLI_mempool_chunk *chunk_tail;
+  struct BLI_freenode *free;
+  struct BLI_freenode *free_tail;
+  /** Elements allocated minus elements freed, may be negative. */
+  int totused;
+} BLI_mempool_tls;
+
+void BLI_mempool_tls_init(BLI_mempool *pool, BLI_mempool_tls *tls) ATTR_NONNULL();
+void *BLI_mempool_tls_alloc(BLI_mempool_tls *tls) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(1);
+void *BLI_mempool_tls_calloc(BLI_mempool_tls *tls) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT
+    ATTR_NONNULL(1);
+void BLI_mempool_tls_free(BLI_mempool_tls *tls, void *addr) ATTR_NONNULL(1, 2);
+void BLI_mempool_tls_join(BLI_mempool_tls *tls_join, BLI_mempool_tls *tls) ATTR_NONNULL();
+void BLI_mempool_tls_finalize(BLI_mempool_tls *tls) ATTR_NONNULL();
+
 #ifdef __cplusplus
 }
 #endif
@@ -72,6 +72,10 @@
 #  define KDOPBVH_THREAD_LEAF_THRESHOLD 1024
 #endif
 
+/* Number of top-most branches #BLI_bvhtree_update_tree joins after updating the sub-trees
+ * below them in parallel. */
+#define KDOPBVH_UPDATE_TOP_BRANCHES 64
+
 /* -------------------------------------------------------------------- */
 /** \name Struct Definitions
  * \{ */
@@ -859,6 +863,344 @@ static void non_recursive_bvh_div_nodes(const BVHTree *tree,
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Binned SAH Build
+ *
+ * Alternative to the implicit tree, used with #BVH_BALANCE_SAH.
+ *
+ * Each branch is split into up to tree_type children by repeatedly splitting the child with
+ * the largest surface in two, at the bin boundary with the lowest surface area heuristic cost.
+ * Like #non_recursive_bvh_div_nodes the tree is built one level at a time,
+ * so all branches of a level are split in parallel.
+ *
+ * Branches are stored breadth first, so children still have an index greater than the parent.
+ * Every branch has at least two children, so a tree needs at most (totleaf - 1) branches.
+ * \{ */
+
+#define KDOPBVH_SAH_BINS 16
+
+typedef struct BVHSAHBin {
+  float bv[6];
+  int count;
+} BVHSAHBin;
+
+static void sah_bv_init(float bv[6])
+{
+  bv[0] = bv[2] = bv[4] = FLT_MAX;
+  bv[1] = bv[3] = bv[5] = -FLT_MAX;
+}
+
+static void sah_bv_add(float bv[6], const float bv_add[6])
+{
+  for (int i = 0; i < 6; i += 2) {
+    bv[i] = min_ff(bv[i], bv_add[i]);
+    bv[i + 1] = max_ff(bv[i + 1], bv_add[i + 1]);
+  }
+}
+
+static float sah_bv_half_area(const float bv[6])
+{
+  const float dx = bv[1] - bv[0];
+  const float dy = bv[3] - bv[2];
+  const float dz = bv[5] - bv[4];
+  return dx * dy + dy * dz + dz * dx;
+}
+
+BLI_INLINE int sah_bin_index(const float *bv, const int axis, const float min, const float scale)
+{
+  /* Twice the centroid, it's only compared against values computed the same way. */
+  const float centroid = bv[2 * axis] + bv[2 * axis + 1];
+  const float bin = (centroid - min) * scale;
+  /* Clamp from below, also catching NaN from infinite bounds which can not be cast to int. */
+  if (!(bin > 0.0f)) {
+    return 0;
+  }
+  return min_ii((int)bin, KDOPBVH_SAH_BINS - 1);
+}
+
+/**
+ * Partition the leafs in range [begin, end) in two, on the x, y or z axis.
+ *
+ * \param r_bv: the x, y and z bounds of both halves.
+ * \return the first leaf of the upper half, there is always at least one leaf in each half.
+ */
+static int sah_split_leafs(BVHNode **leafs_array, const int begin, const int end, float r_bv[2][6])
+{
+  float centroid_min[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+  float centroid_max[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+  float best_cost = FLT_MAX;
+  int best_axis = -1, best_bin = 0;
+  int i, axis;
+
+  for (i = begin; i < end; i++) {
+    const float *bv = leafs_array[i]->bv;
+    for (axis = 0; axis < 3; axis++) {
+      const float centroid = bv[2 * axis] + bv[2 * axis + 1];
+      centroid_min[axis] = min_ff(centroid_min[axis], centroid);
+      centroid_max[axis] = max_ff(centroid_max[axis], centroid);
+    }
+  }
+
+  for (axis = 0; axis < 3; axis++) {
+    const float extent = centroid_max[axis] - centroid_min[axis];
+    /* Infinite bounds give an infinite extent, binning needs a finite one. */
+    if (!(extent > 0.0f) || !isfinite(extent)) {
+      continue;
+    }
+    const float scale = (float)KDOPBVH_SAH_BINS / extent;
+
+    BVHSAHBin bins[KDOPBVH_SAH_BINS];
+    for (i = 0; i < KDOPBVH_SAH_BINS; i++) {
+      sah_bv_init(bins[i].bv);
+      bins[i].count = 0;
+    }
+    for (i = begin; i < end; i++) {
+      const float *bv = leafs_array[i]->bv;
+      BVHSAHBin *bin = &bins[sah_bin_index(bv, axis, centroid_min[axis], scale)];
+      sah_bv_add(bin->bv, bv);
+      bin->count++;
+    }
+
+    /* Sweep from the right to get the bounds of everything above each split. */
+    BVHSAHBin right[KDOPBVH_SAH_BINS - 1];
+    BVHSAHBin accum;
+    sah_bv_init(accum.bv);
+    accum.count = 0;
+    for (i = KDOPBVH_SAH_BINS - 1; i > 0; i--) {
+      if (bins[i].count) {
+        sah_bv_add(accum.bv, bins[i].bv);
+        accum.count += bins[i].count;
+      }
+      right[i - 1] = accum;
+    }
+
+    sah_bv_init(accum.bv);
+    accum.count = 0;
+    for (i = 0; i < KDOPBVH_SAH_BINS - 1; i++) {
+      if (bins[i].count) {
+        sah_bv_add(accum.bv, bins[i].bv);
+        accum.count += bins[i].count;
+      }
+      if (accum.count == 0 || right[i].count == 0) {
+        continue;
+      }
+      const float cost = sah_bv_half_area(accum.bv) * (float)accum.count +
+                         sah_bv_half_area(right[i].bv) * (float)right[i].count;
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = i;
+        memcpy(r_bv[0], accum.bv, sizeof(accum.bv));
+        memcpy(r_bv[1], right[i].bv, sizeof(accum.bv));
+      }
+    }
+  }
+
+  if (best_axis == -1) {
+    /* All centroids are the same (or not finite), any split is as good as another. */
+    const int mid = (begin + end) / 2;
+    sah_bv_init(r_bv[0]);
+    sah_bv_init(r_bv[1]);
+    for (i = begin; i < end; i++) {
+      sah_bv_add(r_bv[i < mid ? 0 : 1], leafs_array[i]->bv);
+    }
+    return mid;
+  }
+
+  {
+    const float min = centroid_min[best_axis];
+    const float scale = (float)KDOPBVH_SAH_BINS /
+                        (centroid_max[best_axis] - centroid_min[best_axis]);
+    int j = end - 1;
+    i = begin;
+    while (true) {
+      while (sah_bin_index(leafs_array[i]->bv, best_axis, min, scale) <= best_bin) {
+        i++;
+      }
+      while (sah_bin_index(leafs_array[j]->bv, best_axis, min, scale) > best_bin) {
+        j--;
+      }
+      if (i > j) {
+        break;
+      }
+      SWAP(BVHNode *, leafs_array[i], leafs_array[j]);
+    }
+  }
+  return i;
+}
+
+typedef struct BVHSAHDivNodesData {
+  const BVHTree *tree;
+  BVHNode **leafs_array;
+
+  /** Branches of the current level and their range in the leafs array. */
+  BVHNode **level_branches;
+  int (*level_ranges)[2];
+  /** Leaf ranges of the children, tree_type ranges for each branch of the level. */
+  int (*level_child_ranges)[2];
+} BVHSAHDivNodesData;
+
+static void sah_bvh_div_nodes_task_cb(void *__restrict userdata,
+                                      const int j,
+                                      const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHSAHDivNodesData *data = userdata;
+  const int tree_type = data->tree->tree_type;
+  BVHNode *parent = data->level_branches[j];
+  int(*child_ranges)[2] = &data->level_child_ranges[j * tree_type];
+  int nth[MAX_TREETYPE + 1];
+  float child_bv[MAX_TREETYPE][6];
+  int k, totnode = 1;
+
+  nth[0] = data->level_ranges[j][0];
+  nth[1] = data->level_ranges[j][1];
+
+  refit_kdop_hull(data->tree, parent, nth[0], nth[1]);
+  parent->main_axis = get_largest_axis(parent->bv) / 2;
+  memcpy(child_bv[0], parent->bv, sizeof(child_bv[0]));
+
+  /* Split the child with the largest surface until the branch is full. */
+  while (totnode < tree_type) {
+    int k_split = -1;
+    float k_split_area = -1.0f;
+
+    for (k = 0; k < totnode; k++) {
+      if (nth[k + 1] - nth[k] > 1) {
+        /* Area is NaN for infinite bounds, those must still be split. */
+        const float area = sah_bv_half_area(child_bv[k]);
+        if (k_split == -1 || area > k_split_area) {
+          k_split = k;
+          k_split_area = area;
+        }
+      }
+    }
+    if (k_split == -1) {
+      break;
+    }
+
+    float split_bv[2][6];
+    const int mid = sah_split_leafs(data->leafs_array, nth[k_split], nth[k_split + 1], split_bv);
+
+    memmove(&nth[k_split + 2], &nth[k_split + 1], sizeof(*nth) * (size_t)(totnode - k_split));
+    memmove(&child_bv[k_split + 2],
+            &child_bv[k_split + 1],
+            sizeof(*child_bv) * (size_t)(totnode - k_split - 1));
+    nth[k_split + 1] = mid;
+    memcpy(child_bv[k_split], split_bv[0], sizeof(*child_bv));
+    memcpy(child_bv[k_split + 1], split_bv[1], sizeof(*child_bv));
+    totnode++;
+  }
+  parent->totnode = (char)totnode;
+
+  /* Order the children along the main axis, walking the tree relies on it. */
+  {
+    const int axis = parent->main_axis;
+    float child_centroid[MAX_TREETYPE];
+    for (k = 0; k < totnode; k++) {
+      const float centroid = child_bv[k][2 * axis] + child_bv[k][2 * axis + 1];
+      int k_insert = k;
+      while (k_insert > 0 && child_centroid[k_insert - 1] > centroid) {
+        child_centroid[k_insert] = child_centroid[k_insert - 1];
+        copy_v2_v2_int(child_ranges[k_insert], child_ranges[k_insert - 1]);
+        k_insert--;
+      }
+      child_centroid[k_insert] = centroid;
+      child_ranges[k_insert][0] = nth[k];
+      child_ranges[k_insert][1] = nth[k + 1];
+    }
+  }
+}
+
+/**
+ * Build a SAH tree on branches_array (root first), returning the number of branches used.
+ */
+static int sah_bvh_div_nodes(const BVHTree *tree,
+                             BVHNode *branches_array,
+                             BVHNode **leafs_array,
+                             int num_leafs)
+{
+  const int tree_type = tree->tree_type;
+  BVHNode *root = &branches_array[0];
+  int num_branches = 1;
+
+  BLI_assert(num_leafs > 1);
+
+  root->parent = NULL;
+
+  /* A level can't hold more branches than half the leafs. */
+  const int level_len_max = num_leafs / 2;
+  BVHNode **level_branches = MEM_mallocN(sizeof(*level_branches) * (size_t)level_len_max,
+                                         __func__);
+  BVHNode **next_branches = MEM_mallocN(sizeof(*next_branches) * (size_t)level_len_max,
+                                        __func__);
+  int(*level_ranges)[2] = MEM_mallocN(sizeof(*level_ranges) * (size_t)level_len_max, __func__);
+  int(*next_ranges)[2] = MEM_mallocN(sizeof(*next_ranges) * (size_t)level_len_max, __func__);
+  int(*level_child_ranges)[2] = MEM_mallocN(
+      sizeof(*level_child_ranges) * (size_t)(level_len_max * tree_type), __func__);
+
+  int level_len = 1;
+  level_branches[0] = root;
+  level_ranges[0][0] = 0;
+  level_ranges[0][1] = num_leafs;
+
+  BVHSAHDivNodesData cb_data = {
+      .tree = tree,
+      .leafs_array = leafs_array,
+      .level_child_ranges = level_child_ranges,
+  };
+
+  while (level_len) {
+    cb_data.level_branches = level_branches;
+    cb_data.level_ranges = level_ranges;
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    settings.use_threading = (num_leafs > KDOPBVH_THREAD_LEAF_THRESHOLD);
+    BLI_task_parallel_range(0, level_len, &cb_data, sah_bvh_div_nodes_task_cb, &settings);
+
+    /* Link the children, allocating the branches of the next level in order. */
+    int next_len = 0;
+    for (int j = 0; j < level_len; j++) {
+      BVHNode *parent = level_branches[j];
+      const int(*child_ranges)[2] = &level_child_ranges[j * tree_type];
+
+      for (int k = 0; k < parent->totnode; k++) {
+        BVHNode *child;
+        if (child_ranges[k][1] - child_ranges[k][0] > 1) {
+          child = &branches_array[num_branches++];
+          next_branches[next_len] = child;
+          copy_v2_v2_int(next_ranges[next_len], child_ranges[k]);
+          next_len++;
+        }
+        else {
+          child = leafs_array[child_ranges[k][0]];
+        }
+        parent->children[k] = child;
+        child->parent = parent;
+      }
+    }
+
+    SWAP(BVHNode **, level_branches, next_branches);
+    {
+      int(*ranges_tmp)[2] = level_ranges;
+      level_ranges = next_ranges;
+      next_ranges = ranges_tmp;
+    }
+    level_len = next_len;
+  }
+
+  MEM_freeN(level_branches);
+  MEM_freeN(next_branches);
+  MEM_freeN(level_ranges);
+  MEM_freeN(next_ranges);
+  MEM_freeN(level_child_ranges);
+
+  BLI_assert(num_branches < num_leafs);
+  return num_branches;
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
@@ -949,21 +1291,65 @@ void BLI_bvhtree_free(BVHTree *tree)
   }
 }
 
+/**
+ * Trees are allocated for the implicit tree,
+ * make room for \a totbranch branches when building a tree which needs more.
+ */
+static void bvhtree_ensure_branch_len(BVHTree *tree, const int totbranch)
+{
+  const int numnodes_prev = (int)(MEM_allocN_len(tree->nodearray) / sizeof(*tree->nodearray));
+  const int numnodes = tree->totleaf + totbranch;
+  int i;
+
+  if (numnodes <= numnodes_prev) {
+    return;
+  }
+
+  tree->nodes = MEM_recallocN(tree->nodes, sizeof(*tree->nodes) * (size_t)numnodes);
+  tree->nodebv = MEM_recallocN(tree->nodebv,
+                               sizeof(*tree->nodebv) * (size_t)tree->axis * (size_t)numnodes);
+  tree->nodechild = MEM_recallocN(
+      tree->nodechild, sizeof(*tree->nodechild) * (size_t)tree->tree_type * (size_t)numnodes);
+  tree->nodearray = MEM_recallocN(tree->nodearray, sizeof(*tree->nodearray) * (size_t)numnodes);
+
+  /* link the dynamic bv and child links */
+  for (i = 0; i < numnodes; i++) {
+    tree->nodearray[i].bv = &tree->nodebv[i * tree->axis];
+    tree->nodearray[i].children = &tree->nodechild[i * tree->tree_type];
+  }
+  for (i = 0; i < tree->totleaf; i++) {
+    tree->nodes[i] = &tree->nodearray[i];
+  }
+}
+
 void BLI_bvhtree_balance(BVHTree *tree)
 {
-  BVHNode **leafs_array = tree->nodes;
+  BLI_bvhtree_balance_ex(tree, 0);
+}
 
+/**
+ * \param flag: #BVH_BALANCE_SAH to build a tree which is faster to query but slower to build.
+ */
+void BLI_bvhtree_balance_ex(BVHTree *tree, const int flag)
+{
   /* This function should only be called once
    * (some big bug goes here if its being called more than once per tree) */
   BLI_assert(tree->totbranch == 0);
 
-  /* Build the implicit tree */
-  non_recursive_bvh_div_nodes(
-      tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+  if ((flag & BVH_BALANCE_SAH) && (tree->totleaf > tree->tree_type)) {
+    bvhtree_ensure_branch_len(tree, tree->totleaf - 1);
+    tree->totbranch = sah_bvh_div_nodes(
+        tree, tree->nodearray + tree->totleaf, tree->nodes, tree->totleaf);
+  }
+  else {
+    /* Build the implicit tree */
+    non_recursive_bvh_div_nodes(
+        tree, tree->nodearray + (tree->totleaf - 1), tree->nodes, tree->totleaf);
+    tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
+  }
 
   /* current code expects the branches to be linked to the nodes array
    * we perform that linkage here */
-  tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
   for (int i = 0; i < tree->totbranch; i++) {
     tree->nodes[tree->totleaf + i] = &tree->nodearray[tree->totleaf + i];
   }
@@ -1032,6 +1418,29 @@ bool BLI_bvhtree_update_node(
   return true;
 }
 
+static void node_join_recursive(BVHTree *tree, BVHNode *node)
+{
+  for (int i = 0; i < node->totnode; i++) {
+    if (node->children[i]->totnode) {
+      node_join_recursive(tree, node->children[i]);
+    }
+  }
+  node_join(tree, node);
+}
+
+typedef struct BVHUpdateTreeData {
+  BVHTree *tree;
+  BVHNode **subtrees;
+} BVHUpdateTreeData;
+
+static void bvhtree_update_tree_task_cb(void *__restrict userdata,
+                                        const int i,
+                                        const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  BVHUpdateTreeData *data = userdata;
+  node_join_recursive(data->tree, data->subtrees[i]);
+}
+
 /* call BLI_bvhtree_update_node() first for every node/point/triangle */
 void BLI_bvhtree_update_tree(BVHTree *tree)
 {
@@ -1042,6 +1451,37 @@ void BLI_bvhtree_update_tree(BVHTree *tree)
   BVHNode **root = tree->nodes + tree->totleaf;
   BVHNode **index = tree->nodes + tree->totleaf + tree->totbranch - 1;
 
+  if ((tree->totleaf > KDOPBVH_THREAD_LEAF_THRESHOLD) &&
+      (tree->totbranch > KDOPBVH_UPDATE_TOP_BRANCHES)) {
+    /* For the same reason the first branches contain all their parents,
+     * the branches they point to past them are independent sub-trees which are updated
+     * in parallel, before joining the first branches. */
+    BVHNode **top_last = root + (KDOPBVH_UPDATE_TOP_BRANCHES - 1);
+    BVHNode **subtrees = BLI_array_alloca(subtrees,
+                                          KDOPBVH_UPDATE_TOP_BRANCHES * tree->tree_type);
+    int subtrees_len = 0;
+
+    for (BVHNode **top = root; top <= top_last; top++) {
+      for (int i = 0; i < (*top)->totnode; i++) {
+        BVHNode *child = (*top)->children[i];
+        if (child->totnode && child > *top_last) {
+          subtrees[subtrees_len++] = child;
+        }
+      }
+    }
+
+    BVHUpdateTreeData data = {
+        .tree = tree,
+        .subtrees = subtrees,
+    };
+
+    TaskParallelSettings settings;
+    BLI_parallel_range_settings_defaults(&settings);
+    BLI_task_parallel_range(0, subtrees_len, &data, bvhtree_update_tree_task_cb, &settings);
+
+    index = top_last;
+  }
+
   for (; index >= root; index--) {
     node_join(tree, *index);
   }
@@ -1416,6 +1856,70 @@ static float calc_nearest_point_squared(const float proj[3], BVHNode *node, floa
   return len_squared_v3v3(proj, nearest);
 }
 
+/* Same as calc_nearest_point_squared() for all children of the node,
+ * four children are tested at once when SSE2 is available. */
+static void calc_nearest_children_squared(const float proj[3],
+                                          const BVHNode *node,
+                                          float r_dist_sq[MAX_TREETYPE])
+{
+#ifdef __SSE2__
+  const __m128 px = _mm_set1_ps(proj[0]);
+  const __m128 py = _mm_set1_ps(proj[1]);
+  const __m128 pz = _mm_set1_ps(proj[2]);
+  const int totnode = node->totnode;
+
+  for (int i = 0; i < totnode; i += 4) {
+    /* Unused lanes repeat the last child. */
+    const float *bv[4];
+    for (int j = 0; j < 4; j++) {
+      bv[j] = node->children[min_ii(i + j, totnode - 1)]->bv;
+    }
+    const __m128 dx = _mm_sub_ps(
+        _mm_min_ps(_mm_max_ps(px, _mm_setr_ps(bv[0][0], bv[1][0], bv[2][0], bv[3][0])),
+                   _mm_setr_ps(bv[0][1], bv[1][1], bv[2][1], bv[3][1])),
+        px);
+    const __m128 dy = _mm_sub_ps(
+        _mm_min_ps(_mm_max_ps(py, _mm_setr_ps(bv[0][2], bv[1][2], bv[2][2], bv[3][2])),
+                   _mm_setr_ps(bv[0][3], bv[1][3], bv[2][3], bv[3][3])),
+        py);
+    const __m128 dz = _mm_sub_ps(
+        _mm_min_ps(_mm_max_ps(pz, _mm_setr_ps(bv[0][4], bv[1][4], bv[2][4], bv[3][4])),
+                   _mm_setr_ps(bv[0][5], bv[1][5], bv[2][5], bv[3][5])),
+        pz);
+    float dist_sq[4];
+    _mm_storeu_ps(dist_sq,
+                  _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                             _mm_mul_ps(dz, dz)));
+    for (int j = 0; j < 4 && i + j < totnode; j++) {
+      r_dist_sq[i + j] = dist_sq[j];
+    }
+  }
+#else
+  float nearest[3];
+  for (int i = 0; i != node->totnode; i++) {
+    r_dist_sq[i] = calc_nearest_point_squared(proj, node->children[i], nearest);
+  }
+#endif
+}
+
+/**
+ * Sort children indices by their distance, so the nearest children are traversed first.
+ * Unlike the split axis this also works for overlapping children.
+ */
+static void children_order_by_dist(const float dist[MAX_TREETYPE],
+                                   const int totnode,
+                                   int r_order[MAX_TREETYPE])
+{
+  for (int i = 0; i < totnode; i++) {
+    int j = i;
+    while (j > 0 && dist[r_order[j - 1]] > dist[i]) {
+      r_order[j] = r_order[j - 1];
+      j--;
+    }
+    r_order[j] = i;
+  }
+}
+
 /* Depth first search method */
 static void dfs_find_nearest_dfs(BVHNearestData *data, BVHNode *node)
 {
@@ -1431,26 +1935,18 @@ static void dfs_find_nearest_dfs(BVHNearestData *data, BVHNode *node)
   else {
     /* Better heuristic to pick the closest node to dive on */
     int i;
-    float nearest[3];
+    float dist_sq[MAX_TREETYPE];
+    int order[MAX_TREETYPE];
 
-    if (data->proj[node->main_axis] <= node->children[0]->bv[node->main_axis * 2 + 1]) {
+    calc_nearest_children_squared(data->proj, node, dist_sq);
+    children_order_by_dist(dist_sq, node->totnode, order);
 
-      for (i = 0; i != node->totnode; i++) {
-        if (calc_nearest_point_squared(data->proj, node->children[i], nearest) >=
-            data->nearest.dist_sq) {
-          continue;
-        }
-        dfs_find_nearest_dfs(data, node->children[i]);
-      }
-    }
-    else {
-      for (i = node->totnode - 1; i >= 0; i--) {
-        if (calc_nearest_point_squared(data->proj, node->children[i], nearest) >=
-            data->nearest.dist_sq) {
-          continue;
-        }
-        dfs_find_nearest_dfs(data, node->children[i]);
+    for (i = 0; i != node->totnode; i++) {
+      const int k = order[i];
+      if (dist_sq[k] >= data->nearest.dist_sq) {
+        break;
       }
+      dfs_find_nearest_dfs(data, node->children[k]);
     }
   }
 }
@@ -1478,13 +1974,13 @@ static void heap_find_nearest_inner(BVHNearestData *data, HeapSimple *heap, BVHN
     }
   }
   else {
-    float nearest[3];
+    float dist_sq[MAX_TREETYPE];
 
-    for (int i = 0; i != node->totnode; i++) {
-      float dist_sq = calc_nearest_point_squared(data->proj, node->children[i], nearest);
+    calc_nearest_children_squared(data->proj, node, dist_sq);
 
-      if (dist_sq < data->nearest.dist_sq) {
-        BLI_heapsimple_insert(heap, dist_sq, node->children[i]);
+    for (int i = 0; i != node->totnode; i++) {
+      if (dist_sq[i] < data->nearest.dist_sq) {
+        BLI_heapsimple_insert(heap, dist_sq[i], node->children[i]);
       }
     }
   }
@@ -1568,6 +2064,88 @@ int BLI_bvhtree_find_nearest(BVHTree *tree,
   return BLI_bvhtree_find_nearest_ex(tree, co, nearest, callback, userdata, 0);
 }
 
+/* Number of consecutive queries of a batch handled by the same thread, the results of coherent
+ * queries are used to limit the search of the next query. */
+#define KDOPBVH_BATCH_CHUNK_SIZE 64
+
+typedef struct BVHNearestBatchData {
+  BVHTree *tree;
+  const float (*co)[3];
+  int co_len;
+  float max_dist_sq;
+  BVHTreeNearest *r_nearest;
+  BVHTree_NearestPointCallback callback;
+  void *userdata;
+  int flag;
+} BVHNearestBatchData;
+
+static void bvhtree_find_nearest_batch_task_cb(void *__restrict userdata,
+                                               const int chunk,
+                                               const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHNearestBatchData *data = userdata;
+  const int start = chunk * KDOPBVH_BATCH_CHUNK_SIZE;
+  const int end = min_ii(start + KDOPBVH_BATCH_CHUNK_SIZE, data->co_len);
+  const BVHTreeNearest *prev = NULL;
+
+  for (int i = start; i < end; i++) {
+    BVHTreeNearest *nearest = &data->r_nearest[i];
+    /* The nearest point of the previous query bounds the distance of this one. */
+    if (prev != NULL && prev->index != -1) {
+      *nearest = *prev;
+      nearest->dist_sq = min_ff(len_squared_v3v3(data->co[i], prev->co), data->max_dist_sq);
+    }
+    else {
+      nearest->index = -1;
+      nearest->dist_sq = data->max_dist_sq;
+    }
+    BLI_bvhtree_find_nearest_ex(
+        data->tree, data->co[i], nearest, data->callback, data->userdata, data->flag);
+    prev = nearest;
+  }
+}
+
+/**
+ * Find the nearest element for each of the given coordinates, in parallel.
+ *
+ * Queries are expected to be coherent (vertices of a mesh for example): the result of a query
+ * limits the search of the next one. Elements at the exact same distance may be found in a
+ * different order than with #BLI_bvhtree_find_nearest_ex.
+ *
+ * \param max_dist_sq: Only elements closer than this are found.
+ * \param r_nearest: Results, index is -1 when nothing is found.
+ * \note The callback must be thread-safe.
+ */
+void BLI_bvhtree_find_nearest_batch(BVHTree *tree,
+                                    const float (*co)[3],
+                                    const int co_len,
+                                    const float max_dist_sq,
+                                    BVHTreeNearest *r_nearest,
+                                    BVHTree_NearestPointCallback callback,
+                                    void *userdata,
+                                    int flag)
+{
+  BVHNearestBatchData data = {
+      .tree = tree,
+      .co = co,
+      .co_len = co_len,
+      .max_dist_sq = max_dist_sq,
+      .r_nearest = r_nearest,
+      .callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (co_len > KDOPBVH_BATCH_CHUNK_SIZE);
+  BLI_task_parallel_range(0,
+                          (int)divide_ceil_u((uint)co_len, KDOPBVH_BATCH_CHUNK_SIZE),
+                          &data,
+                          bvhtree_find_nearest_batch_task_cb,
+                          &settings);
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -1737,18 +2315,77 @@ static float fast_ray_nearest_hit(const BVHRayCastData *data, const BVHNode *nod
   }
 }
 
-static void dfs_raycast(BVHRayCastData *data, BVHNode *node)
+/* ray-bv is really fast.. and simple tests revealed its worth to test it
+ * before calling the ray-primitive functions */
+static float ray_nearest_hit_node(const BVHRayCastData *data, const BVHNode *node)
 {
-  int i;
-
-  /* ray-bv is really fast.. and simple tests revealed its worth to test it
-   * before calling the ray-primitive functions */
   /* XXX: temporary solution for particles until fast_ray_nearest_hit supports ray.radius */
-  float dist = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node) :
-                                            ray_nearest_hit(data, node->bv);
-  if (dist >= data->hit.dist) {
+  return (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node) :
+                                      ray_nearest_hit(data, node->bv);
+}
+
+/* Same as ray_nearest_hit_node() for all children of the node, four children are tested at once
+ * when SSE2 is available. The result does not depend on the hit distance at the time of the test,
+ * as long as children are skipped when they are not closer than the hit. */
+static void ray_nearest_hit_children(const BVHRayCastData *data,
+                                     const BVHNode *node,
+                                     float r_dist[MAX_TREETYPE])
+{
+#ifdef __SSE2__
+  if (data->ray.radius == 0.0f) {
+    const int *index = data->index;
+    const __m128 ox = _mm_set1_ps(data->ray.origin[0]);
+    const __m128 oy = _mm_set1_ps(data->ray.origin[1]);
+    const __m128 oz = _mm_set1_ps(data->ray.origin[2]);
+    const __m128 ix = _mm_set1_ps(data->idot_axis[0]);
+    const __m128 iy = _mm_set1_ps(data->idot_axis[1]);
+    const __m128 iz = _mm_set1_ps(data->idot_axis[2]);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 miss = _mm_set1_ps(FLT_MAX);
+    const int totnode = node->totnode;
+
+    for (int i = 0; i < totnode; i += 4) {
+      /* Unused lanes repeat the last child. */
+      const float *bv[4];
+      for (int j = 0; j < 4; j++) {
+        bv[j] = node->children[min_ii(i + j, totnode - 1)]->bv;
+      }
+#  define BV_LANES(k) _mm_setr_ps(bv[0][k], bv[1][k], bv[2][k], bv[3][k])
+      const __m128 t1x = _mm_mul_ps(_mm_sub_ps(BV_LANES(index[0]), ox), ix);
+      const __m128 t2x = _mm_mul_ps(_mm_sub_ps(BV_LANES(index[1]), ox), ix);
+      const __m128 t1y = _mm_mul_ps(_mm_sub_ps(BV_LANES(index[2]), oy), iy);
+      const __m128 t2y = _mm_mul_ps(_mm_sub_ps(BV_LANES(index[3]), oy), iy);
+      const __m128 t1z = _mm_mul_ps(_mm_sub_ps(BV_LANES(index[4]), oz), iz);
+      const __m128 t2z = _mm_mul_ps(_mm_sub_ps(BV_LANES(index[5]), oz), iz);
+#  undef BV_LANES
+      /* Same tests as fast_ray_nearest_hit(). */
+      __m128 reject = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(t1x, t2y), _mm_cmplt_ps(t2x, t1y)),
+                                _mm_or_ps(_mm_cmpgt_ps(t1x, t2z), _mm_cmplt_ps(t2x, t1z)));
+      reject = _mm_or_ps(reject,
+                         _mm_or_ps(_mm_cmpgt_ps(t1y, t2z), _mm_cmplt_ps(t2y, t1z)));
+      reject = _mm_or_ps(reject,
+                         _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(t2x, zero), _mm_cmplt_ps(t2y, zero)),
+                                   _mm_cmplt_ps(t2z, zero)));
+      const __m128 dist = _mm_max_ps(_mm_max_ps(t1x, t1y), t1z);
+      float dist_arr[4];
+      _mm_storeu_ps(dist_arr,
+                    _mm_or_ps(_mm_and_ps(reject, miss), _mm_andnot_ps(reject, dist)));
+      for (int j = 0; j < 4 && i + j < totnode; j++) {
+        r_dist[i + j] = dist_arr[j];
+      }
+    }
     return;
   }
+#endif
+  for (int i = 0; i != node->totnode; i++) {
+    r_dist[i] = ray_nearest_hit_node(data, node->children[i]);
+  }
+}
+
+/* Traverse a node which was hit at the given distance. */
+static void dfs_raycast(BVHRayCastData *data, BVHNode *node, float dist)
+{
+  int i;
 
   if (node->totnode == 0) {
     if (data->callback) {
@@ -1761,15 +2398,19 @@ static void dfs_raycast(BVHRayCastData *data, BVHNode *node)
     }
   }
   else {
-    /* pick loop direction to dive into the tree (based on ray direction and split axis) */
-    if (data->ray_dot_axis[node->main_axis] > 0.0f) {
-      for (i = 0; i != node->totnode; i++) {
-        dfs_raycast(data, node->children[i]);
+    float child_dist[MAX_TREETYPE];
+    ray_nearest_hit_children(data, node, child_dist);
+
+    /* Dive into the nearest children first. */
+    int order[MAX_TREETYPE];
+    children_order_by_dist(child_dist, node->totnode, order);
+    for (i = 0; i != node->totnode; i++) {
+      const int k = order[i];
+      if (child_dist[k] < data->hit.dist) {
+        dfs_raycast(data, node->children[k], child_dist[k]);
       }
-    }
-    else {
-      for (i = node->totnode - 1; i >= 0; i--) {
-        dfs_raycast(data, node->children[i]);
+      else {
+        break;
       }
     }
   }
@@ -1782,37 +2423,51 @@ static void dfs_raycast_all(BVHRayCastData *data, BVHNode *node)
 {
   int i;
 
-  /* ray-bv is really fast.. and simple tests revealed its worth to test it
-   * before calling the ray-primitive functions */
-  /* XXX: temporary solution for particles until fast_ray_nearest_hit supports ray.radius */
-  float dist = (data->ray.radius == 0.0f) ? fast_ray_nearest_hit(data, node) :
-                                            ray_nearest_hit(data, node->bv);
-  if (dist >= data->hit.dist) {
-    return;
-  }
-
   if (node->totnode == 0) {
     /* no need to check for 'data->callback' (using 'all' only makes sense with a callback). */
-    dist = data->hit.dist;
+    const float dist = data->hit.dist;
     data->callback(data->userdata, node->index, &data->ray, &data->hit);
     data->hit.index = -1;
     data->hit.dist = dist;
   }
   else {
+    float child_dist[MAX_TREETYPE];
+    ray_nearest_hit_children(data, node, child_dist);
+
     /* pick loop direction to dive into the tree (based on ray direction and split axis) */
     if (data->ray_dot_axis[node->main_axis] > 0.0f) {
       for (i = 0; i != node->totnode; i++) {
-        dfs_raycast_all(data, node->children[i]);
+        if (child_dist[i] < data->hit.dist) {
+          dfs_raycast_all(data, node->children[i]);
+        }
       }
     }
     else {
       for (i = node->totnode - 1; i >= 0; i--) {
-        dfs_raycast_all(data, node->children[i]);
+        if (child_dist[i] < data->hit.dist) {
+          dfs_raycast_all(data, node->children[i]);
+        }
       }
     }
   }
 }
 
+static void dfs_raycast_begin(BVHRayCastData *data, BVHNode *root)
+{
+  const float dist = ray_nearest_hit_node(data, root);
+  if (dist < data->hit.dist) {
+    dfs_raycast(data, root, dist);
+  }
+}
+
+static void dfs_raycast_all_begin(BVHRayCastData *data, BVHNode *root)
+{
+  const float dist = ray_nearest_hit_node(data, root);
+  if (dist < data->hit.dist) {
+    dfs_raycast_all(data, root);
+  }
+}
+
 static void bvhtree_ray_cast_data_precalc(BVHRayCastData *data, int flag)
 {
   int i;
@@ -1882,8 +2537,7 @@ int BLI_bvhtree_ray_cast_ex(BVHTree *tree,
   }
 
   if (root) {
-    dfs_raycast(&data, root);
-    //      iterative_raycast(&data, root);
+    dfs_raycast_begin(&data, root);
   }
 
   if (hit) {
@@ -1905,6 +2559,107 @@ int BLI_bvhtree_ray_cast(BVHTree *tree,
       tree, co, dir, radius, hit, callback, userdata, BVH_RAYCAST_DEFAULT);
 }
 
+typedef struct BVHRayCastBatchData {
+  BVHTree *tree;
+  const float (*co)[3];
+  const float (*dir)[3];
+  int rays_len;
+  float radius;
+  float max_dist;
+  BVHTreeRayHit *r_hit;
+  BVHTree_RayCastCallback callback;
+  void *userdata;
+  int flag;
+} BVHRayCastBatchData;
+
+static void bvhtree_ray_cast_batch_task_cb(void *__restrict userdata,
+                                           const int chunk,
+                                           const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const BVHRayCastBatchData *data = userdata;
+  const int start = chunk * KDOPBVH_BATCH_CHUNK_SIZE;
+  const int end = min_ii(start + KDOPBVH_BATCH_CHUNK_SIZE, data->rays_len);
+  int prev_index = -1;
+
+  for (int i = start; i < end; i++) {
+    BVHTreeRayHit *hit = &data->r_hit[i];
+    hit->index = -1;
+    hit->dist = data->max_dist;
+    /* Coherent rays likely hit the same element, testing it first limits the traversal. */
+    if (prev_index != -1 && data->callback) {
+      BVHTreeRay ray;
+#ifdef USE_KDOPBVH_WATERTIGHT
+      struct IsectRayPrecalc isect_precalc;
+      if (data->flag & BVH_RAYCAST_WATERTIGHT) {
+        isect_ray_tri_watertight_v3_precalc(&isect_precalc, data->dir[i]);
+        ray.isect_precalc = &isect_precalc;
+      }
+      else {
+        ray.isect_precalc = NULL;
+      }
+#endif
+      copy_v3_v3(ray.origin, data->co[i]);
+      copy_v3_v3(ray.direction, data->dir[i]);
+      ray.radius = data->radius;
+      data->callback(data->userdata, prev_index, &ray, hit);
+    }
+    BLI_bvhtree_ray_cast_ex(data->tree,
+                            data->co[i],
+                            data->dir[i],
+                            data->radius,
+                            hit,
+                            data->callback,
+                            data->userdata,
+                            data->flag);
+    prev_index = hit->index;
+  }
+}
+
+/**
+ * Cast all the given rays, in parallel.
+ *
+ * Rays are expected to be coherent (from vertices of a mesh for example): with a callback, the
+ * element hit by a ray is tested first for the next ray, which limits its search. Elements at
+ * the exact same distance may be hit in a different order than with #BLI_bvhtree_ray_cast_ex.
+ *
+ * \param max_dist: Only hits closer than this are found.
+ * \param r_hit: Results, index is -1 when nothing is hit.
+ * \note The callback must be thread-safe, and set the hit index to the index it is given.
+ */
+void BLI_bvhtree_ray_cast_batch(BVHTree *tree,
+                                const float (*co)[3],
+                                const float (*dir)[3],
+                                const int rays_len,
+                                float radius,
+                                float max_dist,
+                                BVHTreeRayHit *r_hit,
+                                BVHTree_RayCastCallback callback,
+                                void *userdata,
+                                int flag)
+{
+  BVHRayCastBatchData data = {
+      .tree = tree,
+      .co = co,
+      .dir = dir,
+      .rays_len = rays_len,
+      .radius = radius,
+      .max_dist = max_dist,
+      .r_hit = r_hit,
+      .callback = callback,
+      .userdata = userdata,
+      .flag = flag,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.use_threading = (rays_len > KDOPBVH_BATCH_CHUNK_SIZE);
+  BLI_task_parallel_range(0,
+                          (int)divide_ceil_u((uint)rays_len, KDOPBVH_BATCH_CHUNK_SIZE),
+                          &data,
+                          bvhtree_ray_cast_batch_task_cb,
+                          &settings);
+}
+
 float BLI_bvhtree_bb_raycast(const float bv[6],
                              const float light_start[3],
                              const float light_end[3],
@@ -1971,7 +2726,7 @@ void BLI_bvhtree_ray_cast_all_ex(BVHTree *tree,
   data.hit.dist = hit_dist;
 
   if (root) {
-    dfs_raycast_all(&data, root);
+    dfs_raycast_all_begin(&data, root);
   }
 }
 
@@ -179,11 +179,47 @@ BLI_INLINE uint mempool_maxchunks(const uint totelem, const uint pchunk)
   return (totelem <= pchunk) ? 1 : ((totelem / pchunk) + 1);
 }
 
-static BLI_mempool_chunk *mempool_chunk_alloc(BLI_mempool *pool)
+static BLI_mempool_chunk *mempool_chunk_alloc(const BLI_mempool *pool)
 {
   return MEM_mallocN(sizeof(BLI_mempool_chunk) + (size_t)pool->csize, "BLI_Mempool Chunk");
 }
 
+/**
+ * Link all elements of \a mpchunk into a single free list,
+ * only reads from \a pool so this is safe to call from any thread.
+ *
+ * \return The last element in the chunk (terminating the list).
+ */
+static BLI_freenode *mempool_chunk_free_list_init(const BLI_mempool *pool,
+                                                  BLI_mempool_chunk *mpchunk)
+{
+  const uint esize = pool->esize;
+  BLI_freenode *curnode = CHUNK_DATA(mpchunk);
+  uint j;
+
+  /* loop through the allocated data, building the pointer structures */
+  j = pool->pchunk;
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+    while (j--) {
+      curnode->next = NODE_STEP_NEXT(curnode);
+      curnode->freeword = FREEWORD;
+      curnode = curnode->next;
+    }
+  }
+  else {
+    while (j--) {
+      curnode->next = NODE_STEP_NEXT(curnode);
+      curnode = curnode->next;
+    }
+  }
+
+  /* terminate the list (rewind one) */
+  curnode = NODE_STEP_PREV(curnode);
+  curnode->next = NULL;
+
+  return curnode;
+}
+
 /**
  * Initialize a chunk and add into \a pool->chunks
  *
@@ -197,9 +233,7 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
                                        BLI_mempool_chunk *mpchunk,
                                        BLI_freenode *last_tail)
 {
-  const uint esize = pool->esize;
   BLI_freenode *curnode = CHUNK_DATA(mpchunk);
-  uint j;
 
   /* append */
   if (pool->chunk_tail) {
@@ -217,26 +251,8 @@ static BLI_freenode *mempool_chunk_add(BLI_mempool *pool,
     pool->free = curnode;
   }
 
-  /* loop through the allocated data, building the pointer structures */
-  j = pool->pchunk;
-  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
-    while (j--) {
-      curnode->next = NODE_STEP_NEXT(curnode);
-      curnode->freeword = FREEWORD;
-      curnode = curnode->next;
-    }
-  }
-  else {
-    while (j--) {
-      curnode->next = NODE_STEP_NEXT(curnode);
-      curnode = curnode->next;
-    }
-  }
-
-  /* terminate the list (rewind one)
-   * will be overwritten if 'curnode' gets passed in again as 'last_tail' */
-  curnode = NODE_STEP_PREV(curnode);
-  curnode->next = NULL;
+  /* will be overwritten if 'curnode' gets passed in again as 'last_tail' */
+  curnode = mempool_chunk_free_list_init(pool, mpchunk);
 
 #ifdef USE_TOTALLOC
   pool->totalloc += pool->pchunk;
@@ -451,6 +467,179 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
   }
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Thread Local Allocation
+ *
+ * Allocate and free elements from worker threads without locking.
+ *
+ * Each #BLI_mempool_tls owns the chunks it allocates and keeps its own free list,
+ * the pool its self is only read until #BLI_mempool_tls_finalize is called.
+ * So existing elements may be iterated over (with #BLI_mempool_iter or
+ * #BLI_task_parallel_mempool) while new elements are created,
+ * new elements won't be visited until they have been finalized into the pool.
+ *
+ * Typical use with #BLI_task_parallel_range, where the allocator is part of the user-data chunk:
+ *
+ * \code{.c}
+ * MyChunk chunk = {0};
+ * BLI_mempool_tls_init(pool, &chunk.pool_tls);
+ * settings.userdata_chunk = &chunk;
+ * settings.userdata_chunk_size = sizeof(chunk);
+ * settings.func_reduce = my_reduce; (calls #BLI_mempool_tls_join)
+ * BLI_task_parallel_range(0, len, &data, my_func, &settings);
+ * BLI_mempool_tls_finalize(&chunk.pool_tls);
+ * \endcode
+ *
+ * \note Freeing an element through one allocator while another thread accesses it is
+ * (as with any allocator) the responsibility of the caller.
+ * \{ */
+
+void BLI_mempool_tls_init(BLI_mempool *pool, BLI_mempool_tls *tls)
+{
+  tls->pool = pool;
+  tls->chunks = NULL;
+  tls->chunk_tail = NULL;
+  tls->free = NULL;
+  tls->free_tail = NULL;
+  tls->totused = 0;
+}
+
+void *BLI_mempool_tls_alloc(BLI_mempool_tls *tls)
+{
+  const BLI_mempool *pool = tls->pool;
+  BLI_freenode *free_pop;
+
+  if (UNLIKELY(tls->free == NULL)) {
+    /* Need to allocate a new chunk, owned by this allocator until finalized. */
+    BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
+    tls->free_tail = mempool_chunk_free_list_init(pool, mpchunk);
+    mpchunk->next = NULL;
+    if (tls->chunk_tail) {
+      tls->chunk_tail->next = mpchunk;
+    }
+    else {
+      tls->chunks = mpchunk;
+    }
+    tls->chunk_tail = mpchunk;
+    tls->free = CHUNK_DATA(mpchunk);
+  }
+
+  free_pop = tls->free;
+
+  if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+    free_pop->freeword = USEDWORD;
+  }
+
+  tls->free = free_pop->next;
+  tls->totused++;
+
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_ALLOC(pool, free_pop, pool->esize);
+#endif
+
+  return (void *)free_pop;
+}
+
+void *BLI_mempool_tls_calloc(BLI_mempool_tls *tls)
+{
+  void *retval = BLI_mempool_tls_alloc(tls);
+  memset(retval, 0, (size_t)tls->pool->esize);
+  return retval;
+}
+
+/**
+ * Free an element, which may have been allocated from the pool or any of its thread allocators.
+ * The element is only available to this allocator until it's finalized.
+ *
+ * \note doesn't protect against double frees, take care!
+ */
+void BLI_mempool_tls_free(BLI_mempool_tls *tls, void *addr)
+{
+  BLI_freenode *newhead = addr;
+
+  if (tls->pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+#ifndef NDEBUG
+    /* This will detect double free's. */
+    BLI_assert(newhead->freeword != FREEWORD);
+#endif
+    newhead->freeword = FREEWORD;
+  }
+
+  if (tls->free == NULL) {
+    tls->free_tail = newhead;
+  }
+  newhead->next = tls->free;
+  tls->free = newhead;
+  tls->totused--;
+
+#ifdef WITH_MEM_VALGRIND
+  VALGRIND_MEMPOOL_FREE(tls->pool, addr);
+#endif
+}
+
+/**
+ * Move all chunks and free elements from \a tls into \a tls_join,
+ * leaving \a tls empty. Doesn't access the pool, so it can be used to reduce thread data.
+ */
+void BLI_mempool_tls_join(BLI_mempool_tls *tls_join, BLI_mempool_tls *tls)
+{
+  BLI_assert(tls_join->pool == tls->pool);
+
+  if (tls->chunks) {
+    if (tls_join->chunk_tail) {
+      tls_join->chunk_tail->next = tls->chunks;
+    }
+    else {
+      tls_join->chunks = tls->chunks;
+    }
+    tls_join->chunk_tail = tls->chunk_tail;
+  }
+
+  if (tls->free) {
+    BLI_assert(tls->free_tail->next == NULL);
+    if (tls_join->free == NULL) {
+      tls_join->free_tail = tls->free_tail;
+    }
+    tls->free_tail->next = tls_join->free;
+    tls_join->free = tls->free;
+  }
+
+  tls_join->totused += tls->totused;
+
+  BLI_mempool_tls_init(tls->pool, tls);
+}
+
+/**
+ * Add all chunks and free elements of \a tls to its pool, leaving \a tls empty.
+ * New chunks are appended, so iteration order of existing elements is kept.
+ *
+ * \note Must not run at the same time as any other operation on the pool.
+ */
+void BLI_mempool_tls_finalize(BLI_mempool_tls *tls)
+{
+  BLI_mempool *pool = tls->pool;
+  BLI_mempool_tls tls_pool;
+
+  /* Use the pool's own chunks and free list as the target of a join. */
+  tls_pool.pool = pool;
+  tls_pool.chunks = pool->chunks;
+  tls_pool.chunk_tail = pool->chunk_tail;
+  tls_pool.free = pool->free;
+  /* Not needed, the pool's free list is only ever prepended to. */
+  tls_pool.free_tail = NULL;
+  tls_pool.totused = (int)pool->totused;
+
+  BLI_mempool_tls_join(&tls_pool, tls);
+
+  BLI_assert(tls_pool.totused >= 0);
+  pool->chunks = tls_pool.chunks;
+  pool->chunk_tail = tls_pool.chunk_tail;
+  pool->free = tls_pool.free;
+  pool->totused = (uint)tls_pool.totused;
+}
+
+/** \} */
+
 int BLI_mempool_len(BLI_mempool *pool)
 {
   return (int)pool->totused;
@@ -68,14 +68,24 @@ typedef struct EdgeSet {
   ((void)0)
 #define PERTURB_SHIFT 5
 
+/**
+ * Probe the slots next to the initial one first, these are likely in the same cache line.
+ * After that, continue with perturbed probing so many edges sharing a vertex don't cluster.
+ */
+#define LINEAR_PROBES 4
+
 #define ITER_SLOTS(CONTAINER, EDGE, SLOT, INDEX) \
   uint32_t hash = calc_edge_hash(EDGE); \
   uint32_t mask = (CONTAINER)->slot_mask; \
-  uint32_t perturb = hash; \
+  uint32_t perturb = calc_edge_perturb(EDGE); \
   int32_t *map = (CONTAINER)->map; \
   uint32_t SLOT = mask & hash; \
   int INDEX = map[SLOT]; \
-  for (;; SLOT = mask & ((5 * SLOT) + 1 + perturb), perturb >>= PERTURB_SHIFT, INDEX = map[SLOT])
+  for (uint probe = 1;; \
+       SLOT = mask & ((probe < LINEAR_PROBES) ? SLOT + 1 : ((5 * SLOT) + 1 + perturb)), \
+       perturb >>= (probe < LINEAR_PROBES) ? 0 : PERTURB_SHIFT, \
+       probe++, \
+       INDEX = map[SLOT])
 
 #define SLOT_EMPTY -1
 #define SLOT_DUMMY -2
@@ -88,9 +98,20 @@ typedef struct EdgeSet {
 /** \name Internal Edge API
  * \{ */
 
+/**
+ * Edges sharing their lowest vertex start probing from neighboring slots.
+ * Vertex indices of meshes tend to be coherent, so this keeps lookups of nearby edges
+ * in nearby memory, which is much faster than scattering them for large meshes.
+ */
 BLI_INLINE uint32_t calc_edge_hash(Edge edge)
 {
-  return (edge.v_low << 8) ^ edge.v_high;
+  return (edge.v_low << 2) + (edge.v_high & 3);
+}
+
+/** Well distributed hash, used when the slots near the initial one are taken. */
+BLI_INLINE uint32_t calc_edge_perturb(Edge edge)
+{
+  return (edge.v_low * 0x9E3779B1u) ^ (edge.v_high * 0x85EBCA77u);
 }
 
 BLI_INLINE Edge init_edge(uint v0, uint v1)
@@ -438,13 +459,22 @@ int BLI_edgehash_len(EdgeHash *eh)
 /**
  * Remove all edges from hash.
  */
-void BLI_edgehash_clear_ex(EdgeHash *eh, EdgeHashFreeFP free_value, const uint UNUSED(reserve))
+void BLI_edgehash_clear_ex(EdgeHash *eh, EdgeHashFreeFP free_value, const uint reserve)
 {
-  /* TODO: handle reserve */
   edgehash_free_values(eh, free_value);
   eh->length = 0;
   eh->dummy_count = 0;
-  eh->capacity_exp = CAPACITY_EXP_DEFAULT;
+
+  /* Keep the current capacity, the map must always match the slot mask. */
+  const uint capacity_exp = calc_capacity_exp_for_reserve(reserve);
+  if (capacity_exp > eh->capacity_exp) {
+    eh->capacity_exp = capacity_exp;
+    UPDATE_SLOT_MASK(eh);
+    MEM_freeN(eh->entries);
+    MEM_freeN(eh->map);
+    eh->entries = MEM_calloc_arrayN(sizeof(EdgeHashEntry), ENTRIES_CAPACITY(eh), "eh entries");
+    eh->map = MEM_malloc_arrayN(sizeof(int32_t), MAP_CAPACITY(eh), "eh map");
+  }
   CLEAR_MAP(eh);
 }
 
@@ -22,6 +22,7 @@
 
 #include "BLI_kdtree_impl.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_strict_flags.h"
 #include "BLI_utildefines.h"
 
@@ -30,39 +31,60 @@
 #define BLI_kdtree_nd_(id) _CONCAT(KDTREE_PREFIX_ID, _##id)
 
 typedef struct KDTreeNode_head {
-  uint left, right;
   float co[KD_DIMS];
   int index;
 } KDTreeNode_head;
 
 typedef struct KDTreeNode {
-  uint left, right;
   float co[KD_DIMS];
   int index;
   uint d; /* range is only (0..KD_DIMS - 1) */
 } KDTreeNode;
 
+/**
+ * The tree is implicit: any sub-tree is a contiguous range of nodes with its root in the middle,
+ * nodes before the root are its left sub-tree and nodes after it the right sub-tree.
+ * So no child links are stored and sub-trees are compact in memory.
+ */
+typedef struct KDTreeRange {
+  uint begin, end;
+} KDTreeRange;
+
 struct KDTree {
   KDTreeNode *nodes;
   uint nodes_len;
-  uint root;
 #ifdef DEBUG
   bool is_balanced;        /* ensure we call balance first */
   uint nodes_len_capacity; /* max size of the tree */
 #endif
 };
 
-#define KD_STACK_INIT 100     /* initial size for array (on the stack) */
-#define KD_NEAR_ALLOC_INC 100 /* alloc increment for collecting nearest */
+/* Size of the traversal stack (on the stack), the tree depth is at most 32. */
+#define KD_STACK_SIZE 64
 #define KD_FOUND_ALLOC_INC 50 /* alloc increment for collecting nearest */
+#define KD_SORT_INSERTION_MAX 32 /* sort more range search results than this with qsort */
 
-#define KD_NODE_UNSET ((uint)-1)
+/* Balance the top levels of trees with more nodes than this in parallel. */
+#define KD_THREAD_NODES_THRESHOLD 1024
+/* Number of sub-trees balanced in parallel after the top levels. */
+#define KD_BALANCE_SUBTREES 64
+/* Minimum number of queries per thread for batched queries. */
+#define KD_BATCH_CHUNK_SIZE 64
 
-/**
- * When set we know all values are unbalanced,
- * otherwise clear them when re-balancing: see T62210.
- */
-#define KD_NODE_ROOT_IS_INIT ((uint)-2)
+BLI_INLINE uint kdtree_range_root(const KDTreeRange *range)
+{
+  return range->begin + (range->end - range->begin) / 2;
+}
+
+BLI_INLINE void kdtree_stack_push(KDTreeRange *stack, uint *cur, const uint begin, const uint end)
+{
+  if (begin != end) {
+    BLI_assert(*cur < KD_STACK_SIZE);
+    stack[*cur].begin = begin;
+    stack[*cur].end = end;
+    (*cur)++;
+  }
+}
 
 /* -------------------------------------------------------------------- */
 /** \name Local Math API
@@ -103,7 +125,6 @@ KDTree *BLI_kdtree_nd_(new)(uint nodes_len_capacity)
   tree = MEM_mallocN(sizeof(KDTree), "KDTree");
   tree->nodes = MEM_mallocN(sizeof(KDTreeNode) * nodes_len_capacity, "KDTreeNode");
   tree->nodes_len = 0;
-  tree->root = KD_NODE_ROOT_IS_INIT;
 
 #ifdef DEBUG
   tree->is_balanced = false;
@@ -135,7 +156,6 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
   /* note, array isn't calloc'd,
    * need to initialize all struct members */
 
-  node->left = node->right = KD_NODE_UNSET;
   copy_vn_vn(node->co, co);
   node->index = index;
   node->d = 0;
@@ -145,19 +165,15 @@ void BLI_kdtree_nd_(insert)(KDTree *tree, int index, const float co[KD_DIMS])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const uint ofs)
+/**
+ * Partition the nodes so the median on \a axis is in the middle,
+ * with smaller or equal values before it and greater or equal values after it.
+ */
+static void kdtree_balance_partition(KDTreeNode *nodes, const uint nodes_len, const uint axis)
 {
-  KDTreeNode *node;
   float co;
   uint left, right, median, i, j;
 
-  if (nodes_len <= 0) {
-    return KD_NODE_UNSET;
-  }
-  else if (nodes_len == 1) {
-    return 0 + ofs;
-  }
-
   /* quicksort style sorting around median */
   left = 0;
   right = nodes_len - 1;
@@ -190,44 +206,110 @@ static uint kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis, const u
     }
   }
 
-  /* set node and sort subnodes */
-  node = &nodes[median];
-  node->d = axis;
-  axis = (axis + 1) % KD_DIMS;
-  node->left = kdtree_balance(nodes, median, axis, ofs);
-  node->right = kdtree_balance(
-      nodes + median + 1, (nodes_len - (median + 1)), axis, (median + 1) + ofs);
+  nodes[median].d = axis;
+}
+
+static void kdtree_balance(KDTreeNode *nodes, uint nodes_len, uint axis)
+{
+  while (nodes_len > 0) {
+    const uint median = nodes_len / 2;
 
-  return median + ofs;
+    kdtree_balance_partition(nodes, nodes_len, axis);
+    axis = (axis + 1) % KD_DIMS;
+
+    /* sort subnodes, looping on the right side */
+    kdtree_balance(nodes, median, axis);
+    nodes += median + 1;
+    nodes_len -= median + 1;
+  }
 }
 
-void BLI_kdtree_nd_(balance)(KDTree *tree)
+typedef struct KDTreeBalanceData {
+  KDTreeNode *nodes;
+  const KDTreeRange *ranges;
+  uint axis;
+} KDTreeBalanceData;
+
+static void kdtree_balance_partition_task_cb(void *__restrict userdata,
+                                             const int i,
+                                             const TaskParallelTLS *__restrict UNUSED(tls))
 {
-  if (tree->root != KD_NODE_ROOT_IS_INIT) {
-    for (uint i = 0; i < tree->nodes_len; i++) {
-      tree->nodes[i].left = KD_NODE_UNSET;
-      tree->nodes[i].right = KD_NODE_UNSET;
+  const KDTreeBalanceData *data = userdata;
+  const KDTreeRange *range = &data->ranges[i];
+  kdtree_balance_partition(data->nodes + range->begin, range->end - range->begin, data->axis);
+}
+
+static void kdtree_balance_task_cb(void *__restrict userdata,
+                                   const int i,
+                                   const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBalanceData *data = userdata;
+  const KDTreeRange *range = &data->ranges[i];
+  kdtree_balance(data->nodes + range->begin, range->end - range->begin, data->axis);
+}
+
+/**
+ * Balance the top levels one level at a time, partitioning the sub-trees of a level in parallel,
+ * then balance the sub-trees below in parallel.
+ * Gives exactly the same tree as #kdtree_balance.
+ */
+static void kdtree_balance_parallel(KDTreeNode *nodes, const uint nodes_len)
+{
+  KDTreeRange ranges_buf[2][KD_BALANCE_SUBTREES * 2];
+  KDTreeRange *ranges = ranges_buf[0], *ranges_next = ranges_buf[1];
+  uint ranges_len = 1;
+
+  KDTreeBalanceData data = {
+      .nodes = nodes,
+      .axis = 0,
+  };
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+
+  ranges[0].begin = 0;
+  ranges[0].end = nodes_len;
+
+  while (ranges_len && ranges_len < KD_BALANCE_SUBTREES) {
+    data.ranges = ranges;
+    BLI_task_parallel_range(
+        0, (int)ranges_len, &data, kdtree_balance_partition_task_cb, &settings);
+
+    uint ranges_next_len = 0;
+    for (uint i = 0; i < ranges_len; i++) {
+      const uint root = kdtree_range_root(&ranges[i]);
+      if (ranges[i].begin != root) {
+        ranges_next[ranges_next_len].begin = ranges[i].begin;
+        ranges_next[ranges_next_len].end = root;
+        ranges_next_len++;
+      }
+      if (root + 1 != ranges[i].end) {
+        ranges_next[ranges_next_len].begin = root + 1;
+        ranges_next[ranges_next_len].end = ranges[i].end;
+        ranges_next_len++;
+      }
     }
+    SWAP(KDTreeRange *, ranges, ranges_next);
+    ranges_len = ranges_next_len;
+    data.axis = (data.axis + 1) % KD_DIMS;
   }
 
-  tree->root = kdtree_balance(tree->nodes, tree->nodes_len, 0, 0);
-
-#ifdef DEBUG
-  tree->is_balanced = true;
-#endif
+  data.ranges = ranges;
+  BLI_task_parallel_range(0, (int)ranges_len, &data, kdtree_balance_task_cb, &settings);
 }
 
-static uint *realloc_nodes(uint *stack, uint *stack_len_capacity, const bool is_alloc)
+void BLI_kdtree_nd_(balance)(KDTree *tree)
 {
-  uint *stack_new = MEM_mallocN((*stack_len_capacity + KD_NEAR_ALLOC_INC) * sizeof(uint),
-                                "KDTree.treestack");
-  memcpy(stack_new, stack, *stack_len_capacity * sizeof(uint));
-  // memset(stack_new + *stack_len_capacity, 0, sizeof(uint) * KD_NEAR_ALLOC_INC);
-  if (is_alloc) {
-    MEM_freeN(stack);
+  if (tree->nodes_len > KD_THREAD_NODES_THRESHOLD) {
+    kdtree_balance_parallel(tree->nodes, tree->nodes_len);
   }
-  *stack_len_capacity += KD_NEAR_ALLOC_INC;
-  return stack_new;
+  else {
+    kdtree_balance(tree->nodes, tree->nodes_len, 0);
+  }
+
+#ifdef DEBUG
+  tree->is_balanced = true;
+#endif
 }
 
 /**
@@ -239,44 +321,36 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
 {
   const KDTreeNode *nodes = tree->nodes;
   const KDTreeNode *root, *min_node;
-  uint *stack, stack_default[KD_STACK_INIT];
+  KDTreeRange stack[KD_STACK_SIZE];
   float min_dist, cur_dist;
-  uint stack_len_capacity, cur = 0;
+  uint cur = 0;
 
 #ifdef DEBUG
   BLI_assert(tree->is_balanced == true);
 #endif
 
-  if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
+  if (UNLIKELY(tree->nodes_len == 0)) {
     return -1;
   }
 
-  stack = stack_default;
-  stack_len_capacity = KD_STACK_INIT;
-
-  root = &nodes[tree->root];
+  const uint root_index = tree->nodes_len / 2;
+  root = &nodes[root_index];
   min_node = root;
   min_dist = len_squared_vnvn(root->co, co);
 
   if (co[root->d] < root->co[root->d]) {
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
+    kdtree_stack_push(stack, &cur, root_index + 1, tree->nodes_len);
+    kdtree_stack_push(stack, &cur, 0, root_index);
   }
   else {
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
+    kdtree_stack_push(stack, &cur, 0, root_index);
+    kdtree_stack_push(stack, &cur, root_index + 1, tree->nodes_len);
   }
 
   while (cur--) {
-    const KDTreeNode *node = &nodes[stack[cur]];
+    const KDTreeRange range = stack[cur];
+    const uint node_index = kdtree_range_root(&range);
+    const KDTreeNode *node = &nodes[node_index];
 
     cur_dist = node->co[node->d] - co[node->d];
 
@@ -289,13 +363,9 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
           min_dist = cur_dist;
           min_node = node;
         }
-        if (node->left != KD_NODE_UNSET) {
-          stack[cur++] = node->left;
-        }
-      }
-      if (node->right != KD_NODE_UNSET) {
-        stack[cur++] = node->right;
+        kdtree_stack_push(stack, &cur, range.begin, node_index);
       }
+      kdtree_stack_push(stack, &cur, node_index + 1, range.end);
     }
     else {
       cur_dist = cur_dist * cur_dist;
@@ -306,16 +376,9 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
           min_dist = cur_dist;
           min_node = node;
         }
-        if (node->right != KD_NODE_UNSET) {
-          stack[cur++] = node->right;
-        }
+        kdtree_stack_push(stack, &cur, node_index + 1, range.end);
       }
-      if (node->left != KD_NODE_UNSET) {
-        stack[cur++] = node->left;
-      }
-    }
-    if (UNLIKELY(cur + KD_DIMS > stack_len_capacity)) {
-      stack = realloc_nodes(stack, &stack_len_capacity, stack_default != stack);
+      kdtree_stack_push(stack, &cur, range.begin, node_index);
     }
   }
 
@@ -325,10 +388,6 @@ int BLI_kdtree_nd_(find_nearest)(const KDTree *tree,
     copy_vn_vn(r_nearest->co, min_node->co);
   }
 
-  if (stack != stack_default) {
-    MEM_freeN(stack);
-  }
-
   return min_node->index;
 }
 
@@ -349,21 +408,18 @@ int BLI_kdtree_nd_(find_nearest_cb)(
   const KDTreeNode *nodes = tree->nodes;
   const KDTreeNode *min_node = NULL;
 
-  uint *stack, stack_default[KD_STACK_INIT];
+  KDTreeRange stack[KD_STACK_SIZE];
   float min_dist = FLT_MAX, cur_dist;
-  uint stack_len_capacity, cur = 0;
+  uint cur = 0;
 
 #ifdef DEBUG
   BLI_assert(tree->is_balanced == true);
 #endif
 
-  if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
+  if (UNLIKELY(tree->nodes_len == 0)) {
     return -1;
   }
 
-  stack = stack_default;
-  stack_len_capacity = ARRAY_SIZE(stack_default);
-
 #define NODE_TEST_NEAREST(node) \
   { \
     const float dist_sq = len_squared_vnvn((node)->co, co); \
@@ -384,10 +440,12 @@ int BLI_kdtree_nd_(find_nearest_cb)(
   } \
   ((void)0)
 
-  stack[cur++] = tree->root;
+  kdtree_stack_push(stack, &cur, 0, tree->nodes_len);
 
   while (cur--) {
-    const KDTreeNode *node = &nodes[stack[cur]];
+    const KDTreeRange range = stack[cur];
+    const uint node_index = kdtree_range_root(&range);
+    const KDTreeNode *node = &nodes[node_index];
 
     cur_dist = node->co[node->d] - co[node->d];
 
@@ -397,13 +455,9 @@ int BLI_kdtree_nd_(find_nearest_cb)(
       if (-cur_dist < min_dist) {
         NODE_TEST_NEAREST(node);
 
-        if (node->left != KD_NODE_UNSET) {
-          stack[cur++] = node->left;
-        }
-      }
-      if (node->right != KD_NODE_UNSET) {
-        stack[cur++] = node->right;
+        kdtree_stack_push(stack, &cur, range.begin, node_index);
       }
+      kdtree_stack_push(stack, &cur, node_index + 1, range.end);
     }
     else {
       cur_dist = cur_dist * cur_dist;
@@ -411,26 +465,15 @@ int BLI_kdtree_nd_(find_nearest_cb)(
       if (cur_dist < min_dist) {
         NODE_TEST_NEAREST(node);
 
-        if (node->right != KD_NODE_UNSET) {
-          stack[cur++] = node->right;
-        }
-      }
-      if (node->left != KD_NODE_UNSET) {
-        stack[cur++] = node->left;
+        kdtree_stack_push(stack, &cur, node_index + 1, range.end);
       }
-    }
-    if (UNLIKELY(cur + KD_DIMS > stack_len_capacity)) {
-      stack = realloc_nodes(stack, &stack_len_capacity, stack_default != stack);
+      kdtree_stack_push(stack, &cur, range.begin, node_index);
     }
   }
 
 #undef NODE_TEST_NEAREST
 
 finally:
-  if (stack != stack_default) {
-    MEM_freeN(stack);
-  }
-
   if (min_node) {
     if (r_nearest) {
       r_nearest->index = min_node->index;
@@ -489,16 +532,16 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
 {
   const KDTreeNode *nodes = tree->nodes;
   const KDTreeNode *root;
-  uint *stack, stack_default[KD_STACK_INIT];
+  KDTreeRange stack[KD_STACK_SIZE];
   float cur_dist;
-  uint stack_len_capacity, cur = 0;
+  uint cur = 0;
   uint i, nearest_len = 0;
 
 #ifdef DEBUG
   BLI_assert(tree->is_balanced == true);
 #endif
 
-  if (UNLIKELY((tree->root == KD_NODE_UNSET) || nearest_len_capacity == 0)) {
+  if (UNLIKELY((tree->nodes_len == 0) || nearest_len_capacity == 0)) {
     return 0;
   }
 
@@ -507,34 +550,26 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
     BLI_assert(user_data == NULL);
   }
 
-  stack = stack_default;
-  stack_len_capacity = ARRAY_SIZE(stack_default);
-
-  root = &nodes[tree->root];
+  const uint root_index = tree->nodes_len / 2;
+  root = &nodes[root_index];
 
   cur_dist = len_sq_fn(co, root->co, user_data);
   nearest_ordered_insert(
       r_nearest, &nearest_len, nearest_len_capacity, root->index, cur_dist, root->co);
 
   if (co[root->d] < root->co[root->d]) {
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
+    kdtree_stack_push(stack, &cur, root_index + 1, tree->nodes_len);
+    kdtree_stack_push(stack, &cur, 0, root_index);
   }
   else {
-    if (root->left != KD_NODE_UNSET) {
-      stack[cur++] = root->left;
-    }
-    if (root->right != KD_NODE_UNSET) {
-      stack[cur++] = root->right;
-    }
+    kdtree_stack_push(stack, &cur, 0, root_index);
+    kdtree_stack_push(stack, &cur, root_index + 1, tree->nodes_len);
   }
 
   while (cur--) {
-    const KDTreeNode *node = &nodes[stack[cur]];
+    const KDTreeRange range = stack[cur];
+    const uint node_index = kdtree_range_root(&range);
+    const KDTreeNode *node = &nodes[node_index];
 
     cur_dist = node->co[node->d] - co[node->d];
 
@@ -549,13 +584,9 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
               r_nearest, &nearest_len, nearest_len_capacity, node->index, cur_dist, node->co);
         }
 
-        if (node->left != KD_NODE_UNSET) {
-          stack[cur++] = node->left;
-        }
-      }
-      if (node->right != KD_NODE_UNSET) {
-        stack[cur++] = node->right;
+        kdtree_stack_push(stack, &cur, range.begin, node_index);
       }
+      kdtree_stack_push(stack, &cur, node_index + 1, range.end);
     }
     else {
       cur_dist = cur_dist * cur_dist;
@@ -567,16 +598,9 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
               r_nearest, &nearest_len, nearest_len_capacity, node->index, cur_dist, node->co);
         }
 
-        if (node->right != KD_NODE_UNSET) {
-          stack[cur++] = node->right;
-        }
+        kdtree_stack_push(stack, &cur, node_index + 1, range.end);
       }
-      if (node->left != KD_NODE_UNSET) {
-        stack[cur++] = node->left;
-      }
-    }
-    if (UNLIKELY(cur + KD_DIMS > stack_len_capacity)) {
-      stack = realloc_nodes(stack, &stack_len_capacity, stack_default != stack);
+      kdtree_stack_push(stack, &cur, range.begin, node_index);
     }
   }
 
@@ -584,10 +608,6 @@ int BLI_kdtree_nd_(find_nearest_n_with_len_squared_cb)(
     r_nearest[i].dist = sqrtf(r_nearest[i].dist);
   }
 
-  if (stack != stack_default) {
-    MEM_freeN(stack);
-  }
-
   return (int)nearest_len;
 }
 
@@ -615,6 +635,28 @@ static int nearest_cmp_dist(const void *a, const void *b)
     return 0;
   }
 }
+
+/**
+ * Sort by distance, range searches mostly find a few points, sort those without #qsort.
+ */
+static void nearest_sort_by_dist(KDTreeNearest *nearest, const uint nearest_len)
+{
+  if (nearest_len > KD_SORT_INSERTION_MAX) {
+    qsort(nearest, nearest_len, sizeof(KDTreeNearest), nearest_cmp_dist);
+    return;
+  }
+
+  for (uint i = 1; i < nearest_len; i++) {
+    const KDTreeNearest nearest_test = nearest[i];
+    uint j = i;
+    while (j > 0 && nearest[j - 1].dist > nearest_test.dist) {
+      nearest[j] = nearest[j - 1];
+      j--;
+    }
+    nearest[j] = nearest_test;
+  }
+}
+
 static void nearest_add_in_range(KDTreeNearest **r_nearest,
                                  uint nearest_index,
                                  uint *nearest_len_capacity,
@@ -626,7 +668,7 @@ static void nearest_add_in_range(KDTreeNearest **r_nearest,
 
   if (UNLIKELY(nearest_index >= *nearest_len_capacity)) {
     *r_nearest = MEM_reallocN_id(
-        *r_nearest, (*nearest_len_capacity += KD_FOUND_ALLOC_INC) * sizeof(KDTreeNode), __func__);
+        *r_nearest, (*nearest_len_capacity += KD_FOUND_ALLOC_INC) * sizeof(KDTreeNearest), __func__);
   }
 
   to = (*r_nearest) + nearest_index;
@@ -652,18 +694,19 @@ int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
     const void *user_data)
 {
   const KDTreeNode *nodes = tree->nodes;
-  uint *stack, stack_default[KD_STACK_INIT];
+  KDTreeRange stack[KD_STACK_SIZE];
   KDTreeNearest *nearest = NULL;
   const float range_sq = range * range;
   float dist_sq;
-  uint stack_len_capacity, cur = 0;
+  uint cur = 0;
   uint nearest_len = 0, nearest_len_capacity = 0;
 
 #ifdef DEBUG
   BLI_assert(tree->is_balanced == true);
 #endif
 
-  if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
+  if (UNLIKELY(tree->nodes_len == 0)) {
+    *r_nearest = NULL;
     return 0;
   }
 
@@ -672,23 +715,18 @@ int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
     BLI_assert(user_data == NULL);
   }
 
-  stack = stack_default;
-  stack_len_capacity = ARRAY_SIZE(stack_default);
-
-  stack[cur++] = tree->root;
+  kdtree_stack_push(stack, &cur, 0, tree->nodes_len);
 
   while (cur--) {
-    const KDTreeNode *node = &nodes[stack[cur]];
+    const KDTreeRange node_range = stack[cur];
+    const uint node_index = kdtree_range_root(&node_range);
+    const KDTreeNode *node = &nodes[node_index];
 
     if (co[node->d] + range < node->co[node->d]) {
-      if (node->left != KD_NODE_UNSET) {
-        stack[cur++] = node->left;
-      }
+      kdtree_stack_push(stack, &cur, node_range.begin, node_index);
     }
     else if (co[node->d] - range > node->co[node->d]) {
-      if (node->right != KD_NODE_UNSET) {
-        stack[cur++] = node->right;
-      }
+      kdtree_stack_push(stack, &cur, node_index + 1, node_range.end);
     }
     else {
       dist_sq = len_sq_fn(co, node->co, user_data);
@@ -697,25 +735,13 @@ int BLI_kdtree_nd_(range_search_with_len_squared_cb)(
             &nearest, nearest_len++, &nearest_len_capacity, node->index, dist_sq, node->co);
       }
 
-      if (node->left != KD_NODE_UNSET) {
-        stack[cur++] = node->left;
-      }
-      if (node->right != KD_NODE_UNSET) {
-        stack[cur++] = node->right;
-      }
-    }
-
-    if (UNLIKELY(cur + KD_DIMS > stack_len_capacity)) {
-      stack = realloc_nodes(stack, &stack_len_capacity, stack_default != stack);
+      kdtree_stack_push(stack, &cur, node_range.begin, node_index);
+      kdtree_stack_push(stack, &cur, node_index + 1, node_range.end);
     }
   }
 
-  if (stack != stack_default) {
-    MEM_freeN(stack);
-  }
-
   if (nearest_len) {
-    qsort(nearest, nearest_len, sizeof(KDTreeNearest), nearest_cmp_dist);
+    nearest_sort_by_dist(nearest, nearest_len);
   }
 
   *r_nearest = nearest;
@@ -749,63 +775,178 @@ void BLI_kdtree_nd_(range_search_cb)(
 {
   const KDTreeNode *nodes = tree->nodes;
 
-  uint *stack, stack_default[KD_STACK_INIT];
+  KDTreeRange stack[KD_STACK_SIZE];
   float range_sq = range * range, dist_sq;
-  uint stack_len_capacity, cur = 0;
+  uint cur = 0;
 
 #ifdef DEBUG
   BLI_assert(tree->is_balanced == true);
 #endif
 
-  if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
+  if (UNLIKELY(tree->nodes_len == 0)) {
     return;
   }
 
-  stack = stack_default;
-  stack_len_capacity = ARRAY_SIZE(stack_default);
-
-  stack[cur++] = tree->root;
+  kdtree_stack_push(stack, &cur, 0, tree->nodes_len);
 
   while (cur--) {
-    const KDTreeNode *node = &nodes[stack[cur]];
+    const KDTreeRange node_range = stack[cur];
+    const uint node_index = kdtree_range_root(&node_range);
+    const KDTreeNode *node = &nodes[node_index];
 
     if (co[node->d] + range < node->co[node->d]) {
-      if (node->left != KD_NODE_UNSET) {
-        stack[cur++] = node->left;
-      }
+      kdtree_stack_push(stack, &cur, node_range.begin, node_index);
     }
     else if (co[node->d] - range > node->co[node->d]) {
-      if (node->right != KD_NODE_UNSET) {
-        stack[cur++] = node->right;
-      }
+      kdtree_stack_push(stack, &cur, node_index + 1, node_range.end);
     }
     else {
       dist_sq = len_squared_vnvn(node->co, co);
       if (dist_sq <= range_sq) {
         if (search_cb(user_data, node->index, node->co, dist_sq) == false) {
-          goto finally;
+          return;
         }
       }
 
-      if (node->left != KD_NODE_UNSET) {
-        stack[cur++] = node->left;
-      }
-      if (node->right != KD_NODE_UNSET) {
-        stack[cur++] = node->right;
-      }
-    }
-
-    if (UNLIKELY(cur + KD_DIMS > stack_len_capacity)) {
-      stack = realloc_nodes(stack, &stack_len_capacity, stack_default != stack);
+      kdtree_stack_push(stack, &cur, node_range.begin, node_index);
+      kdtree_stack_push(stack, &cur, node_index + 1, node_range.end);
     }
   }
+}
 
-finally:
-  if (stack != stack_default) {
-    MEM_freeN(stack);
+/* -------------------------------------------------------------------- */
+/** \name Batched Queries
+ *
+ * Run many queries over threads,
+ * results are the same as calling the single query for each coordinate.
+ * \{ */
+
+typedef struct KDTreeBatchData {
+  const KDTree *tree;
+  const float (*co)[KD_DIMS];
+  KDTreeNearest *r_nearest;
+  KDTreeNearest **r_nearest_range;
+  int *r_nearest_len;
+  uint nearest_len_capacity;
+  float range;
+} KDTreeBatchData;
+
+static void kdtree_batch_settings(TaskParallelSettings *settings, const uint co_len)
+{
+  BLI_parallel_range_settings_defaults(settings);
+  settings->use_threading = (co_len > KD_BATCH_CHUNK_SIZE);
+  settings->min_iter_per_thread = KD_BATCH_CHUNK_SIZE;
+}
+
+static void kdtree_find_nearest_batch_task_cb(void *__restrict userdata,
+                                              const int i,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchData *data = userdata;
+  KDTreeNearest *nearest = &data->r_nearest[i];
+  if (BLI_kdtree_nd_(find_nearest)(data->tree, data->co[i], nearest) == -1) {
+    nearest->index = -1;
   }
 }
 
+/**
+ * Find the nearest point for each of \a co, in parallel.
+ *
+ * \param r_nearest: An array of \a co_len results, the index is -1 when none is found.
+ */
+void BLI_kdtree_nd_(find_nearest_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        KDTreeNearest *r_nearest)
+{
+  KDTreeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .r_nearest = r_nearest,
+  };
+
+  TaskParallelSettings settings;
+  kdtree_batch_settings(&settings, co_len);
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_find_nearest_batch_task_cb, &settings);
+}
+
+static void kdtree_find_nearest_n_batch_task_cb(void *__restrict userdata,
+                                                const int i,
+                                                const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchData *data = userdata;
+  data->r_nearest_len[i] = BLI_kdtree_nd_(find_nearest_n)(
+      data->tree,
+      data->co[i],
+      &data->r_nearest[(uint)i * data->nearest_len_capacity],
+      data->nearest_len_capacity);
+}
+
+/**
+ * Find the \a nearest_len_capacity nearest points for each of \a co, in parallel.
+ *
+ * \param r_nearest: An array of (\a co_len * \a nearest_len_capacity) results,
+ * the results of each coordinate are sorted by distance.
+ * \param r_nearest_len: The number of points found for each coordinate.
+ */
+void BLI_kdtree_nd_(find_nearest_n_batch)(const KDTree *tree,
+                                          const float (*co)[KD_DIMS],
+                                          const uint co_len,
+                                          KDTreeNearest *r_nearest,
+                                          const uint nearest_len_capacity,
+                                          int *r_nearest_len)
+{
+  KDTreeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .r_nearest = r_nearest,
+      .r_nearest_len = r_nearest_len,
+      .nearest_len_capacity = nearest_len_capacity,
+  };
+
+  TaskParallelSettings settings;
+  kdtree_batch_settings(&settings, co_len);
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_find_nearest_n_batch_task_cb, &settings);
+}
+
+static void kdtree_range_search_batch_task_cb(void *__restrict userdata,
+                                              const int i,
+                                              const TaskParallelTLS *__restrict UNUSED(tls))
+{
+  const KDTreeBatchData *data = userdata;
+  data->r_nearest_len[i] = BLI_kdtree_nd_(range_search)(
+      data->tree, data->co[i], &data->r_nearest_range[i], data->range);
+}
+
+/**
+ * Range search for each of \a co, in parallel.
+ *
+ * \param r_nearest: An array of \a co_len allocated arrays, sorted by distance
+ * (NULL when nothing is found, caller is responsible for freeing).
+ * \param r_nearest_len: The number of points found for each coordinate.
+ */
+void BLI_kdtree_nd_(range_search_batch)(const KDTree *tree,
+                                        const float (*co)[KD_DIMS],
+                                        const uint co_len,
+                                        const float range,
+                                        KDTreeNearest **r_nearest,
+                                        int *r_nearest_len)
+{
+  KDTreeBatchData data = {
+      .tree = tree,
+      .co = co,
+      .r_nearest_range = r_nearest,
+      .r_nearest_len = r_nearest_len,
+      .range = range,
+  };
+
+  TaskParallelSettings settings;
+  kdtree_batch_settings(&settings, co_len);
+  BLI_task_parallel_range(0, (int)co_len, &data, kdtree_range_search_batch_task_cb, &settings);
+}
+
+/** \} */
+
 /**
  * Use when we want to loop over nodes ordered by index.
  * Requires indices to be aligned with nodes.
@@ -837,18 +978,18 @@ struct DeDuplicateParams {
   int search;
 };
 
-static void deduplicate_recursive(const struct DeDuplicateParams *p, uint i)
+static void deduplicate_recursive(const struct DeDuplicateParams *p, uint begin, uint end)
 {
+  if (begin == end) {
+    return;
+  }
+  const uint i = begin + (end - begin) / 2;
   const KDTreeNode *node = &p->nodes[i];
   if (p->search_co[node->d] + p->range <= node->co[node->d]) {
-    if (node->left != KD_NODE_UNSET) {
-      deduplicate_recursive(p, node->left);
-    }
+    deduplicate_recursive(p, begin, i);
   }
   else if (p->search_co[node->d] - p->range >= node->co[node->d]) {
-    if (node->right != KD_NODE_UNSET) {
-      deduplicate_recursive(p, node->right);
-    }
+    deduplicate_recursive(p, i + 1, end);
   }
   else {
     if ((p->search != node->index) && (p->duplicates[node->index] == -1)) {
@@ -857,12 +998,8 @@ static void deduplicate_recursive(const struct DeDuplicateParams *p, uint i)
         *p->duplicates_found += 1;
       }
     }
-    if (node->left != KD_NODE_UNSET) {
-      deduplicate_recursive(p, node->left);
-    }
-    if (node->right != KD_NODE_UNSET) {
-      deduplicate_recursive(p, node->right);
-    }
+    deduplicate_recursive(p, begin, i);
+    deduplicate_recursive(p, i + 1, end);
   }
 }
 
@@ -907,7 +1044,7 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
         p.search = index;
         copy_vn_vn(p.search_co, tree->nodes[node_index].co);
         int found_prev = found;
-        deduplicate_recursive(&p, tree->root);
+        deduplicate_recursive(&p, 0, tree->nodes_len);
         if (found != found_prev) {
           /* Prevent chains of doubles. */
           duplicates[index] = index;
@@ -924,7 +1061,7 @@ int BLI_kdtree_nd_(calc_duplicates_fast)(const KDTree *tree,
         p.search = index;
         copy_vn_vn(p.search_co, tree->nodes[node_index].co);
         int found_prev = found;
-        deduplicate_recursive(&p, tree->root);
+        deduplicate_recursive(&p, 0, tree->nodes_len);
         if (found != found_prev) {
           /* Prevent chains of doubles. */
           duplicates[index] = index;
@@ -2034,6 +2034,15 @@ void add_weighted_dq_dq(DualQuat *dqsum, const DualQuat *dq, float weight)
   }
 
   /* interpolate rotation and translation */
+#ifdef __SSE2__
+  {
+    const __m128 w = _mm_set1_ps(weight);
+    _mm_storeu_ps(dqsum->quat,
+                  _mm_add_ps(_mm_loadu_ps(dqsum->quat), _mm_mul_ps(w, _mm_loadu_ps(dq->quat))));
+    _mm_storeu_ps(dqsum->trans,
+                  _mm_add_ps(_mm_loadu_ps(dqsum->trans), _mm_mul_ps(w, _mm_loadu_ps(dq->trans))));
+  }
+#else
   dqsum->quat[0] += weight * dq->quat[0];
   dqsum->quat[1] += weight * dq->quat[1];
   dqsum->quat[2] += weight * dq->quat[2];
@@ -2043,21 +2052,31 @@ void add_weighted_dq_dq(DualQuat *dqsum, const DualQuat *dq, float weight)
   dqsum->trans[1] += weight * dq->trans[1];
   dqsum->trans[2] += weight * dq->trans[2];
   dqsum->trans[3] += weight * dq->trans[3];
+#endif
 
   /* Interpolate scale - but only if there is scale present. If any dual
    * quaternions without scale are added, they will be compensated for in
    * normalize_dq. */
   if (dq->scale_weight) {
-    float wmat[4][4];
-
     if (flipped) {
       /* we don't want negative weights for scaling */
       weight = -weight;
     }
 
+#ifdef __SSE2__
+    const __m128 w = _mm_set1_ps(weight);
+    for (int i = 0; i < 4; i++) {
+      _mm_storeu_ps(dqsum->scale[i],
+                    _mm_add_ps(_mm_loadu_ps(dqsum->scale[i]),
+                               _mm_mul_ps(_mm_loadu_ps(dq->scale[i]), w)));
+    }
+#else
+    float wmat[4][4];
+
     copy_m4_m4(wmat, (float(*)[4])dq->scale);
     mul_m4_fl(wmat, weight);
     add_m4_m4m4(dqsum->scale, dqsum->scale, wmat);
+#endif
     dqsum->scale_weight += weight;
   }
 }
@@ -3542,6 +3542,7 @@ static void direct_link_animdata(FileData *fd, AnimData *adt)
   link_list(fd, &adt->drivers);
   direct_link_fcurves(fd, &adt->drivers);
   adt->driver_array = NULL;
+  adt->action_eval_cache = NULL;
 
   /* link overrides */
   // TODO...
@@ -4257,6 +4258,7 @@ static void direct_link_key(BlendDataReader *reader, Key *key)
   direct_link_animdata(reader->fd, key->adt);
 
   BLO_read_data_address(reader, &key->refkey);
+  key->eval_cache = NULL;
 
   for (kb = key->block.first; kb; kb = kb->next) {
     BLO_read_data_address(reader, &kb->data);
@@ -5082,6 +5084,7 @@ static void direct_link_customdata(FileData *fd, CustomData *data, int count)
     }
 
     layer->flag &= ~CD_FLAG_NOFREE;
+    layer->sharing_info = NULL;
 
     if (CustomData_verify_versions(data, i)) {
       layer->data = newdataadr(fd, layer->data);
@@ -768,6 +768,10 @@ void BLO_version_defaults_userpref_blend(Main *bmain, UserDef *userdef)
     if (userdef->collection_instance_empty_size == 0) {
       userdef->collection_instance_empty_size = 1.0f;
     }
+
+    if (userdef->image_decode_cache_size_limit == 0) {
+      userdef->image_decode_cache_size_limit = 100;
+    }
   }
 
   if (userdef->pixelsize == 0.0f) {
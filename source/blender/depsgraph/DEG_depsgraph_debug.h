@@ -33,6 +33,7 @@ extern "C" {
 #endif
 
 struct Depsgraph;
+struct ID;
 struct Scene;
 struct ViewLayer;
 
@@ -53,6 +54,35 @@ void DEG_stats_simple(const struct Depsgraph *graph,
                       size_t *r_operations,
                       size_t *r_relations);
 
+/* ------------------------------------------------ */
+/* Profiling of the last graph evaluation. */
+
+typedef struct DEGOperationProfile {
+  /* Original ID the operation belongs to. */
+  struct ID *id;
+  char component[64];
+  char operation[128];
+  /* Full identifier of the dependency which finished last before this operation became ready,
+   * empty when the operation did not wait for anything. */
+  char blocked_by[256];
+  /* Index of the thread which evaluated the operation, the main thread has index 0. */
+  int thread_id;
+  /* Time in seconds since the beginning of the graph evaluation, when all dependencies of the
+   * operation were evaluated, and when evaluation of the operation began and ended. */
+  double ready_time;
+  double start_time;
+  double end_time;
+} DEGOperationProfile;
+
+/* Operations evaluated during the last graph evaluation, as opaque pointers which stay valid
+ * until the graph is evaluated or rebuilt again. */
+void **DEG_debug_profile_operations(const struct Depsgraph *depsgraph, int *r_len);
+void DEG_debug_profile_operation_info(const void *operation, DEGOperationProfile *r_profile);
+
+/* Write timing of the last graph evaluation in the Chrome trace event format, which can be
+ * viewed in chrome://tracing or similar tools. */
+void DEG_debug_profile_chrome_trace(const struct Depsgraph *depsgraph, FILE *stream);
+
 /* ************************************************ */
 /* Diagram-Based Graph Debugging */
 
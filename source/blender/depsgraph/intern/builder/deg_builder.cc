@@ -203,11 +203,56 @@ void deg_graph_build_flush_visibility(Depsgraph *graph)
 
 }  // namespace
 
+void deg_graph_build_calculate_priorities(Depsgraph *graph)
+{
+  /* Priority of an operation is the cost of the longest path from it to any of the sinks of the
+   * graph. Operations are visited in reverse topological order, so that priorities of all the
+   * children are known by the time their parent is visited. */
+  BLI_Stack *stack = BLI_stack_new(sizeof(OperationNode *), "DEG priorities stack");
+  for (OperationNode *op_node : graph->operations) {
+    op_node->num_links_pending = 0;
+    op_node->priority = 0.0f;
+    for (Relation *rel : op_node->outlinks) {
+      if ((rel->to->type == NodeType::OPERATION) && (rel->flag & RELATION_FLAG_CYCLIC) == 0) {
+        ++op_node->num_links_pending;
+      }
+    }
+    if (op_node->num_links_pending == 0) {
+      BLI_stack_push(stack, &op_node);
+    }
+  }
+  while (!BLI_stack_is_empty(stack)) {
+    OperationNode *op_node;
+    BLI_stack_pop(stack, &op_node);
+    float children_priority = 0.0f;
+    for (Relation *rel : op_node->outlinks) {
+      if ((rel->to->type == NodeType::OPERATION) && (rel->flag & RELATION_FLAG_CYCLIC) == 0) {
+        OperationNode *op_to = (OperationNode *)rel->to;
+        children_priority = max(children_priority, op_to->priority);
+      }
+    }
+    op_node->priority = children_priority + (op_node->is_noop() ? 0.0f : op_node->cost);
+    for (Relation *rel : op_node->inlinks) {
+      if ((rel->from->type == NodeType::OPERATION) && (rel->flag & RELATION_FLAG_CYCLIC) == 0) {
+        OperationNode *op_from = (OperationNode *)rel->from;
+        BLI_assert(op_from->num_links_pending > 0);
+        if (--op_from->num_links_pending == 0) {
+          BLI_stack_push(stack, &op_from);
+        }
+      }
+    }
+  }
+  BLI_stack_free(stack);
+}
+
 void deg_graph_build_finalize(Main *bmain, Depsgraph *graph)
 {
   /* Make sure dependencies of visible ID datablocks are visible. */
   deg_graph_build_flush_visibility(graph);
   deg_graph_remove_unused_noops(graph);
+  deg_graph_build_calculate_priorities(graph);
+  /* Operations from the previous evaluation might have been freed. */
+  graph->profile.clear();
 
   /* Re-tag IDs for update if it was tagged before the relations
    * update tag. */
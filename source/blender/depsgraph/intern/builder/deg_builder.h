@@ -58,4 +58,7 @@ bool deg_check_id_in_depsgraph(const Depsgraph *graph, ID *id_orig);
 bool deg_check_base_in_depsgraph(const Depsgraph *graph, Base *base);
 void deg_graph_build_finalize(Main *bmain, Depsgraph *graph);
 
+/* Calculate scheduling priorities of all operations from their current cost estimates. */
+void deg_graph_build_calculate_priorities(Depsgraph *graph);
+
 }  // namespace DEG
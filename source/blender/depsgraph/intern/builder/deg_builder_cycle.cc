@@ -179,6 +179,10 @@ void solve_cycles(CyclesSolverState *state)
     const int num_visited = get_node_num_visited_children(node);
     for (int i = num_visited; i < node->outlinks.size(); i++) {
       Relation *rel = node->outlinks[i];
+      if (rel->flag & RELATION_FLAG_CYCLIC) {
+        /* Relation was already sacrificed to solve another cycle. */
+        continue;
+      }
       if (rel->to->type == NodeType::OPERATION) {
         OperationNode *to = (OperationNode *)rel->to;
         eCyclicCheckVisitedState to_state = get_node_visited_state(to);
@@ -234,4 +238,20 @@ void deg_graph_detect_cycles(Depsgraph *graph)
   }
 }
 
+void deg_graph_detect_cycles_from(Depsgraph *graph, const vector<OperationNode *> &operations)
+{
+  CyclesSolverState state(graph);
+  for (OperationNode *node : graph->operations) {
+    node->custom_flags = 0;
+  }
+  /* Any new cycle goes through one of the operations, so it is enough to only traverse what is
+   * reachable from them. */
+  for (OperationNode *node : operations) {
+    if (get_node_visited_state(node) == NODE_NOT_VISITED) {
+      schedule_node_to_stack(&state, node);
+      solve_cycles(&state);
+    }
+  }
+}
+
 }  // namespace DEG
@@ -23,11 +23,18 @@
 
 #pragma once
 
+#include "intern/depsgraph_type.h"
+
 namespace DEG {
 
 struct Depsgraph;
+struct OperationNode;
 
 /* Detect and solve dependency cycles. */
 void deg_graph_detect_cycles(Depsgraph *graph);
 
+/* Detect and solve dependency cycles which go through any of the given operations. Used after an
+ * incremental update of the graph, where all new relations are connected to those operations. */
+void deg_graph_detect_cycles_from(Depsgraph *graph, const vector<OperationNode *> &operations);
+
 }  // namespace DEG
@@ -0,0 +1,411 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Incremental update of relations of a few IDs.
+ *
+ * Nodes and relations of the tagged IDs are removed from the graph and built again, with all the
+ * other IDs considered built already. Relations between the rebuilt IDs and the rest of the graph
+ * are partially created by builders of other IDs (collections, parents, constraint targets...),
+ * those are stored before the removal and restored afterwards, using keys which survive the
+ * rebuild.
+ *
+ * This is only valid for changes which do not remove relations of the ID, such as adding a
+ * modifier or a constraint. Cases where the rest of the graph depends on state of the ID in ways
+ * which can not be restored this way are handled by a full rebuild.
+ */
+
+#include "intern/builder/deg_builder_incremental.h"
+
+#include "BLI_listbase.h"
+#include "BLI_utildefines.h"
+
+#include "DNA_layer_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_force_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_modifier.h"
+
+#include "intern/builder/deg_builder_cache.h"
+#include "intern/builder/deg_builder_cycle.h"
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+#include "intern/debug/deg_debug.h"
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_relation.h"
+#include "intern/node/deg_node.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace DEG {
+
+namespace {
+
+/* Identifies an operation of a rebuilt ID. Node pointers can not be used since nodes are
+ * re-created by the rebuild. */
+struct SavedOperationKey {
+  ID *id_orig;
+  NodeType component_type;
+  string component_name;
+  OperationCode opcode;
+  string name;
+  int name_tag;
+};
+
+/* Relation between a rebuilt ID and the rest of the graph. Nodes which are not rebuilt are stored
+ * as-is, with a nullptr pointer the corresponding key is used. */
+struct SavedRelation {
+  Node *from;
+  SavedOperationKey from_key;
+  Node *to;
+  SavedOperationKey to_key;
+  const char *name;
+  int flag;
+};
+
+/* State of a rebuilt ID node which is accumulated by builders of other IDs. */
+struct RebuildIDState {
+  IDNode *id_node;
+  Base *base;
+  int base_index;
+  eDepsNode_LinkedState_Type linked_state;
+  bool is_directly_visible;
+};
+
+/* Name the component is registered with in its ID node, which is not necessarily the name of
+ * the component node. */
+const char *component_key_name(ComponentNode *comp_node)
+{
+  for (auto item : comp_node->owner->components.items()) {
+    if (item.value == comp_node) {
+      return item.key.name;
+    }
+  }
+  BLI_assert(!"Component is not registered in its ID node");
+  return "";
+}
+
+SavedOperationKey operation_key(OperationNode *op_node)
+{
+  ComponentNode *comp_node = op_node->owner;
+  SavedOperationKey key;
+  key.id_orig = comp_node->owner->id_orig;
+  key.component_type = comp_node->type;
+  key.component_name = component_key_name(comp_node);
+  key.opcode = op_node->opcode;
+  key.name = op_node->name;
+  key.name_tag = op_node->name_tag;
+  return key;
+}
+
+OperationNode *find_operation(Depsgraph *graph, const SavedOperationKey &key)
+{
+  IDNode *id_node = graph->find_id_node(key.id_orig);
+  if (id_node == nullptr) {
+    return nullptr;
+  }
+  ComponentNode *comp_node = id_node->find_component(key.component_type,
+                                                     key.component_name.c_str());
+  if (comp_node == nullptr) {
+    return nullptr;
+  }
+  return comp_node->find_operation(key.opcode, key.name.c_str(), key.name_tag);
+}
+
+/* Returns the ID node which owns the given node, when it is rebuilt. */
+IDNode *rebuilt_owner(Node *node, const Set<IDNode *> &rebuild_id_nodes)
+{
+  if (node->type != NodeType::OPERATION) {
+    return nullptr;
+  }
+  IDNode *id_node = static_cast<OperationNode *>(node)->owner->owner;
+  return rebuild_id_nodes.contains(id_node) ? id_node : nullptr;
+}
+
+/* Objects which are used by the rest of the graph in ways which are not expressed by relations
+ * to their own nodes: physics caches, proxies, rigid body world. */
+bool object_supports_incremental_build(Object *object)
+{
+  if (object->proxy != nullptr || object->proxy_from != nullptr ||
+      object->proxy_group != nullptr) {
+    return false;
+  }
+  if (object->pd != nullptr && (object->pd->forcefield != 0 || object->pd->deflect != 0)) {
+    return false;
+  }
+  if (object->rigidbody_object != nullptr || object->rigidbody_constraint != nullptr) {
+    return false;
+  }
+  if (!BLI_listbase_is_empty(&object->particlesystem)) {
+    return false;
+  }
+  if (BKE_modifiers_findby_type(object, eModifierType_Collision) != nullptr ||
+      BKE_modifiers_findby_type(object, eModifierType_Fluid) != nullptr ||
+      BKE_modifiers_findby_type(object, eModifierType_DynamicPaint) != nullptr) {
+    return false;
+  }
+  return true;
+}
+
+bool graph_supports_incremental_build(Depsgraph *graph)
+{
+  if (graph->is_render_pipeline_depsgraph || graph->time_source == nullptr) {
+    return false;
+  }
+  for (ID *id : graph->relations_update_ids) {
+    /* Lookup before accessing the ID: removal of an ID tags the whole graph for rebuild, so a
+     * tagged ID which is in the graph is still valid. */
+    IDNode *id_node = graph->find_id_node(id);
+    if (id_node == nullptr || id_node->id_type != ID_OB) {
+      return false;
+    }
+    if (id_node->linked_state == DEG_ID_LINKED_VIA_SET) {
+      return false;
+    }
+    if (!object_supports_incremental_build(reinterpret_cast<Object *>(id))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Store relations which connect rebuilt IDs with other IDs, and keys of all the operations of the
+ * rebuilt IDs. */
+bool save_rebuilt_ids_state(const Set<IDNode *> &rebuild_id_nodes,
+                            vector<SavedRelation> *r_relations,
+                            vector<SavedOperationKey> *r_operations)
+{
+  for (IDNode *id_node : rebuild_id_nodes) {
+    for (ComponentNode *comp_node : id_node->components.values()) {
+      /* Relations are expected to be between operations, anything else is not restored. */
+      if (!comp_node->inlinks.is_empty() || !comp_node->outlinks.is_empty()) {
+        return false;
+      }
+      for (OperationNode *op_node : comp_node->operations) {
+        r_operations->push_back(operation_key(op_node));
+        for (Relation *rel : op_node->inlinks) {
+          IDNode *from_id_node = rebuilt_owner(rel->from, rebuild_id_nodes);
+          if (from_id_node == id_node) {
+            continue;
+          }
+          SavedRelation saved_relation;
+          saved_relation.from = (from_id_node == nullptr) ? rel->from : nullptr;
+          if (from_id_node != nullptr) {
+            saved_relation.from_key = operation_key(static_cast<OperationNode *>(rel->from));
+          }
+          saved_relation.to = nullptr;
+          saved_relation.to_key = operation_key(op_node);
+          saved_relation.name = rel->name;
+          saved_relation.flag = rel->flag;
+          r_relations->push_back(saved_relation);
+        }
+        for (Relation *rel : op_node->outlinks) {
+          /* Relations between rebuilt IDs are stored from the inlinks side. */
+          if (rebuilt_owner(rel->to, rebuild_id_nodes) != nullptr) {
+            continue;
+          }
+          SavedRelation saved_relation;
+          saved_relation.from = nullptr;
+          saved_relation.from_key = operation_key(op_node);
+          saved_relation.to = rel->to;
+          saved_relation.name = rel->name;
+          saved_relation.flag = rel->flag;
+          r_relations->push_back(saved_relation);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/* Animated properties of IDs which are not rebuilt might point to operations of rebuilt IDs, which
+ * are freed. Such IDs flush frame changes to all animated properties until the next full build. */
+void clear_rebuilt_animated_property_targets(Depsgraph *graph,
+                                              const Set<IDNode *> &rebuild_id_nodes)
+{
+  for (IDNode *id_node : graph->id_nodes) {
+    if (rebuild_id_nodes.contains(id_node)) {
+      continue;
+    }
+    for (OperationNode *op_node : id_node->animated_property_targets) {
+      if (op_node != nullptr && rebuilt_owner(op_node, rebuild_id_nodes) != nullptr) {
+        id_node->animated_property_targets.clear();
+        break;
+      }
+    }
+  }
+}
+
+bool restore_relations(Depsgraph *graph, const vector<SavedRelation> &saved_relations)
+{
+  /* Resolve all nodes first: relations which were created again by the builder are not restored,
+   * but those which were stored multiple times are. */
+  vector<pair<Node *, Node *>> nodes;
+  vector<bool> is_built;
+  for (const SavedRelation &saved_relation : saved_relations) {
+    Node *from = saved_relation.from;
+    if (from == nullptr) {
+      from = find_operation(graph, saved_relation.from_key);
+    }
+    Node *to = saved_relation.to;
+    if (to == nullptr) {
+      to = find_operation(graph, saved_relation.to_key);
+    }
+    if (from == nullptr || to == nullptr) {
+      return false;
+    }
+    nodes.push_back(make_pair(from, to));
+    is_built.push_back(graph->check_nodes_connected(from, to, saved_relation.name) != nullptr);
+  }
+  for (size_t i = 0; i < saved_relations.size(); i++) {
+    if (!is_built[i]) {
+      graph->add_new_relation(
+          nodes[i].first, nodes[i].second, saved_relations[i].name, saved_relations[i].flag);
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool deg_graph_build_incremental(Main *bmain,
+                                 Depsgraph *graph,
+                                 Scene *scene,
+                                 ViewLayer *view_layer)
+{
+  if (!graph_supports_incremental_build(graph)) {
+    return false;
+  }
+
+  DepsgraphBuilderCache builder_cache;
+  DepsgraphNodeBuilder node_builder(bmain, graph, &builder_cache);
+
+  Set<IDNode *> rebuild_id_nodes;
+  vector<RebuildIDState> rebuild_states;
+  for (ID *id : graph->relations_update_ids) {
+    IDNode *id_node = graph->find_id_node(id);
+    if (!rebuild_id_nodes.add(id_node)) {
+      continue;
+    }
+    RebuildIDState state;
+    state.id_node = id_node;
+    state.base = nullptr;
+    state.base_index = -1;
+    state.linked_state = id_node->linked_state;
+    state.is_directly_visible = id_node->is_directly_visible;
+    rebuild_states.push_back(state);
+  }
+
+  /* Base index must match the one used when building the whole view layer. */
+  int base_index = 0;
+  LISTBASE_FOREACH (Base *, base, &view_layer->object_bases) {
+    if (!node_builder.need_pull_base_into_graph(base)) {
+      continue;
+    }
+    for (RebuildIDState &state : rebuild_states) {
+      if (state.id_node->id_orig == &base->object->id) {
+        state.base = base;
+        state.base_index = base_index;
+      }
+    }
+    base_index++;
+  }
+
+  vector<SavedRelation> saved_relations;
+  vector<SavedOperationKey> saved_operations;
+  if (!save_rebuilt_ids_state(rebuild_id_nodes, &saved_relations, &saved_operations)) {
+    return false;
+  }
+
+  /* From now on the graph is modified, and on failure it is left in a state which is only good
+   * enough for a full rebuild. */
+  clear_rebuilt_animated_property_targets(graph, rebuild_id_nodes);
+  const size_t num_id_nodes = graph->id_nodes.size();
+  node_builder.begin_build_incremental(scene, view_layer, rebuild_id_nodes);
+  const size_t num_operations = graph->operations.size();
+  for (const RebuildIDState &state : rebuild_states) {
+    node_builder.build_object(state.base_index,
+                              reinterpret_cast<Object *>(state.id_node->id_orig),
+                              state.linked_state,
+                              state.is_directly_visible);
+  }
+  node_builder.end_build();
+
+  /* Visibility and linked state of the rebuilt IDs might have been accumulated from other IDs. */
+  for (const RebuildIDState &state : rebuild_states) {
+    IDNode *id_node = state.id_node;
+    id_node->linked_state = max(id_node->linked_state, state.linked_state);
+    id_node->is_directly_visible |= state.is_directly_visible;
+  }
+
+  /* IDs which are new to the graph get all their relations built as well. */
+  Set<IDNode *> build_id_nodes = rebuild_id_nodes;
+  for (size_t i = num_id_nodes; i < graph->id_nodes.size(); i++) {
+    build_id_nodes.add(graph->id_nodes[i]);
+  }
+  /* Builders might add operations to IDs which are not rebuilt (properties used by drivers, for
+   * example). Those would miss copy-on-write relations. */
+  vector<OperationNode *> new_operations(graph->operations.begin() + num_operations,
+                                         graph->operations.end());
+  for (OperationNode *op_node : new_operations) {
+    if (!build_id_nodes.contains(op_node->owner->owner)) {
+      return false;
+    }
+  }
+  /* Operations which existed before are needed for the stored relations and entry tags. */
+  for (const SavedOperationKey &key : saved_operations) {
+    if (find_operation(graph, key) == nullptr) {
+      return false;
+    }
+  }
+
+  DepsgraphRelationBuilder relation_builder(bmain, graph, &builder_cache);
+  relation_builder.begin_build_incremental(scene, build_id_nodes);
+  for (const RebuildIDState &state : rebuild_states) {
+    relation_builder.build_object(state.base, reinterpret_cast<Object *>(state.id_node->id_orig));
+  }
+  for (IDNode *id_node : build_id_nodes) {
+    relation_builder.build_copy_on_write_relations(id_node);
+    relation_builder.build_driver_relations(id_node);
+  }
+  /* Restore relations last, so they are not duplicated by the builder. They do not affect the
+   * copy-on-write relations, which only depend on relations within the same component. */
+  if (!restore_relations(graph, saved_relations)) {
+    return false;
+  }
+
+  /* All new relations are connected to the new operations. */
+  deg_graph_detect_cycles_from(graph, new_operations);
+
+  DEG_DEBUG_PRINTF((::Depsgraph *)graph,
+                   BUILD,
+                   "Incremental update of %d IDs, %d new IDs, %d restored relations\n",
+                   (int)rebuild_id_nodes.size(),
+                   (int)(build_id_nodes.size() - rebuild_id_nodes.size()),
+                   (int)saved_relations.size());
+
+  return true;
+}
+
+}  // namespace DEG
@@ -0,0 +1,45 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+struct Main;
+struct Scene;
+struct ViewLayer;
+
+namespace DEG {
+
+struct Depsgraph;
+
+/* Rebuild nodes and relations of the IDs from graph->relations_update_ids only, keeping the rest
+ * of the graph as-is. Cycles going through the rebuilt IDs are solved, but the graph still needs
+ * to be finalized.
+ *
+ * Returns false when the update can not be done incrementally, in which case the graph is to be
+ * rebuilt from scratch. */
+bool deg_graph_build_incremental(Main *bmain,
+                                 Depsgraph *graph,
+                                 Scene *scene,
+                                 ViewLayer *view_layer);
+
+}  // namespace DEG
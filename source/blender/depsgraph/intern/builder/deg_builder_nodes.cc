@@ -112,6 +112,7 @@
 
 #include "intern/builder/deg_builder.h"
 #include "intern/depsgraph.h"
+#include "intern/depsgraph_relation.h"
 #include "intern/depsgraph_type.h"
 #include "intern/eval/deg_eval_copy_on_write.h"
 #include "intern/node/deg_node.h"
@@ -378,6 +379,72 @@ void DepsgraphNodeBuilder::end_build()
   }
 }
 
+void DepsgraphNodeBuilder::begin_build_incremental(Scene *scene,
+                                                   ViewLayer *view_layer,
+                                                   const Set<IDNode *> &rebuild_id_nodes)
+{
+  /* Setup context which is otherwise set while building the view layer. */
+  view_layer_index_ = 0;
+  scene_ = scene;
+  view_layer_ = view_layer;
+
+  for (IDNode *id_node : graph_->id_nodes) {
+    /* Nodes which are kept are only tagged for update when their state changes. */
+    id_node->previously_visible_components_mask = id_node->visible_components_mask;
+    id_node->previous_eval_flags = id_node->eval_flags;
+    id_node->previous_customdata_masks = id_node->customdata_masks;
+    if (!rebuild_id_nodes.contains(id_node)) {
+      built_map_.tagBuild(id_node->id_orig);
+    }
+  }
+
+  Set<OperationNode *> removed_operations;
+  for (IDNode *id_node : rebuild_id_nodes) {
+    /* The ID node itself is kept, together with its copy-on-write datablock. Only store the
+     * previous state, so it is not reset by add_id_node(). */
+    IDInfo *id_info = (IDInfo *)MEM_mallocN(sizeof(IDInfo), "depsgraph id info");
+    id_info->id_cow = nullptr;
+    id_info->previously_visible_components_mask = id_node->visible_components_mask;
+    id_info->previous_eval_flags = id_node->eval_flags;
+    id_info->previous_customdata_masks = id_node->customdata_masks;
+    id_info_hash_.add_new(id_node->id_orig, id_info);
+
+    for (ComponentNode *comp_node : id_node->components.values()) {
+      for (OperationNode *op_node : comp_node->operations) {
+        if (graph_->entry_tags.contains(op_node)) {
+          SavedEntryTag entry_tag;
+          entry_tag.id_orig = id_node->id_orig;
+          entry_tag.component_type = comp_node->type;
+          entry_tag.opcode = op_node->opcode;
+          entry_tag.name = op_node->name;
+          entry_tag.name_tag = op_node->name_tag;
+          saved_entry_tags_.push_back(entry_tag);
+          graph_->entry_tags.remove(op_node);
+        }
+        while (!op_node->inlinks.is_empty()) {
+          Relation *rel = op_node->inlinks[0];
+          rel->unlink();
+          OBJECT_GUARDED_DELETE(rel, Relation);
+        }
+        while (!op_node->outlinks.is_empty()) {
+          Relation *rel = op_node->outlinks[0];
+          rel->unlink();
+          OBJECT_GUARDED_DELETE(rel, Relation);
+        }
+        removed_operations.add(op_node);
+      }
+    }
+    id_node->clear_components();
+  }
+
+  graph_->operations.erase(std::remove_if(graph_->operations.begin(),
+                                          graph_->operations.end(),
+                                          [&](OperationNode *op_node) {
+                                            return removed_operations.contains(op_node);
+                                          }),
+                           graph_->operations.end());
+}
+
 void DepsgraphNodeBuilder::build_id(ID *id)
 {
   if (id == nullptr) {
@@ -99,6 +99,13 @@ class DepsgraphNodeBuilder : public DepsgraphBuilder {
   virtual void begin_build();
   virtual void end_build();
 
+  /* Prepare incremental update of an already built graph: nodes and relations of the given IDs
+   * are removed (keeping their copy-on-write datablocks and update tags), all other IDs are
+   * considered built, so only the given IDs and datablocks new to the graph are built. */
+  virtual void begin_build_incremental(Scene *scene,
+                                       ViewLayer *view_layer,
+                                       const Set<IDNode *> &rebuild_id_nodes);
+
   IDNode *add_id_node(ID *id);
   IDNode *find_id_node(ID *id);
   TimeSourceNode *add_time_source();
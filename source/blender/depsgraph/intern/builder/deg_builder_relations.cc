@@ -477,6 +477,18 @@ void DepsgraphRelationBuilder::begin_build()
 {
 }
 
+void DepsgraphRelationBuilder::begin_build_incremental(Scene *scene,
+                                                       const Set<IDNode *> &build_id_nodes)
+{
+  /* Setup context which is otherwise set while building the view layer. */
+  scene_ = scene;
+  for (IDNode *id_node : graph_->id_nodes) {
+    if (!build_id_nodes.contains(id_node)) {
+      built_map_.tagBuild(id_node->id_orig);
+    }
+  }
+}
+
 void DepsgraphRelationBuilder::build_id(ID *id)
 {
   if (id == nullptr) {
@@ -1276,7 +1288,16 @@ void DepsgraphRelationBuilder::build_animdata_curves(ID *id)
   BLI_assert(operation_from != nullptr);
   /* Build relations from animation operation to properties it changes. */
   if (adt->action != nullptr) {
-    build_animdata_curves_targets(id, adt_key, operation_from, &adt->action->curves);
+    /* Without NLA the values of the active action are written as-is, so it is known which
+     * properties an F-Curve changes. */
+    Vector<OperationNode *> *animated_property_targets = nullptr;
+    if (BLI_listbase_is_empty(&adt->nla_tracks)) {
+      IDNode *id_node = graph_->find_id_node(id);
+      animated_property_targets = &id_node->animated_property_targets;
+      animated_property_targets->clear();
+    }
+    build_animdata_curves_targets(
+        id, adt_key, operation_from, &adt->action->curves, animated_property_targets);
   }
   LISTBASE_FOREACH (NlaTrack *, nlt, &adt->nla_tracks) {
     build_animdata_nlastrip_targets(id, adt_key, operation_from, &nlt->strips);
@@ -1286,7 +1307,8 @@ void DepsgraphRelationBuilder::build_animdata_curves(ID *id)
 void DepsgraphRelationBuilder::build_animdata_curves_targets(ID *id,
                                                              ComponentKey &adt_key,
                                                              OperationNode *operation_from,
-                                                             ListBase *curves)
+                                                             ListBase *curves,
+                                                             Vector<OperationNode *> *r_targets)
 {
   /* Iterate over all curves and build relations. */
   PointerRNA id_ptr;
@@ -1295,6 +1317,9 @@ void DepsgraphRelationBuilder::build_animdata_curves_targets(ID *id,
     PointerRNA ptr;
     PropertyRNA *prop;
     int index;
+    if (r_targets != nullptr) {
+      r_targets->append(nullptr);
+    }
     if (!RNA_path_resolve_full(&id_ptr, fcu->rna_path, &ptr, &prop, &index)) {
       continue;
     }
@@ -1308,11 +1333,22 @@ void DepsgraphRelationBuilder::build_animdata_curves_targets(ID *id,
      * init anyway. */
     if (operation_to->opcode == OperationCode::BONE_LOCAL) {
       OperationKey pose_init_key(id, NodeType::EVAL_POSE, OperationCode::POSE_INIT);
-      add_relation(adt_key, pose_init_key, "Animation -> Prop", RELATION_CHECK_BEFORE_ADD);
+      Relation *rel = add_relation(adt_key,
+                                   pose_init_key,
+                                   "Animation -> Prop",
+                                   RELATION_CHECK_BEFORE_ADD | RELATION_FLAG_ANIMATED_PROPERTY);
+      if (r_targets != nullptr && rel != nullptr) {
+        r_targets->last() = static_cast<OperationNode *>(rel->to);
+      }
       continue;
     }
-    graph_->add_new_relation(
-        operation_from, operation_to, "Animation -> Prop", RELATION_CHECK_BEFORE_ADD);
+    graph_->add_new_relation(operation_from,
+                             operation_to,
+                             "Animation -> Prop",
+                             RELATION_CHECK_BEFORE_ADD | RELATION_FLAG_ANIMATED_PROPERTY);
+    if (r_targets != nullptr) {
+      r_targets->last() = operation_to;
+    }
     /* It is possible that animation is writing to a nested ID data-block,
      * need to make sure animation is evaluated after target ID is copied. */
     const IDNode *id_node_from = operation_from->owner->owner;
@@ -1339,7 +1375,7 @@ void DepsgraphRelationBuilder::build_animdata_nlastrip_targets(ID *id,
       ComponentKey action_key(&strip->act->id, NodeType::ANIMATION);
       add_relation(action_key, adt_key, "Action -> Animation");
 
-      build_animdata_curves_targets(id, adt_key, operation_from, &strip->act->curves);
+      build_animdata_curves_targets(id, adt_key, operation_from, &strip->act->curves, nullptr);
     }
     else if (strip->strips.first != nullptr) {
       build_animdata_nlastrip_targets(id, adt_key, operation_from, &strip->strips);
@@ -162,6 +162,9 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   DepsgraphRelationBuilder(Main *bmain, Depsgraph *graph, DepsgraphBuilderCache *cache);
 
   void begin_build();
+  /* Relations are only built for IDs from the given set, all other IDs of the graph are
+   * considered built. */
+  void begin_build_incremental(Scene *scene, const Set<IDNode *> &build_id_nodes);
 
   template<typename KeyFrom, typename KeyTo>
   Relation *add_relation(const KeyFrom &key_from,
@@ -233,7 +236,8 @@ class DepsgraphRelationBuilder : public DepsgraphBuilder {
   virtual void build_animdata_curves_targets(ID *id,
                                              ComponentKey &adt_key,
                                              OperationNode *operation_from,
-                                             ListBase *curves);
+                                             ListBase *curves,
+                                             Vector<OperationNode *> *r_targets);
   virtual void build_animdata_nlastrip_targets(ID *id,
                                                ComponentKey &adt_key,
                                                OperationNode *operation_from,
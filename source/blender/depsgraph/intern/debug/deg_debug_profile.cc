@@ -0,0 +1,253 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/debug/deg_debug_profile.h"
+
+#include <cstdarg>
+
+#include "BLI_compiler_attrs.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "PIL_time.h"
+
+#include "DNA_ID.h"
+
+#include "DEG_depsgraph_debug.h"
+
+#include "atomic_ops.h"
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_relation.h"
+#include "intern/node/deg_node.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_factory.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace DEG {
+
+DepsgraphProfile::DepsgraphProfile() : evaluation_start_time(0.0), evaluation_end_time(0.0)
+{
+}
+
+void DepsgraphProfile::begin_evaluation()
+{
+  evaluation_start_time = PIL_check_seconds_timer();
+  operations.clear();
+}
+
+void DepsgraphProfile::end_evaluation()
+{
+  evaluation_end_time = PIL_check_seconds_timer();
+}
+
+void DepsgraphProfile::clear()
+{
+  operations.clear();
+}
+
+double DepsgraphProfile::time_since_evaluation_begin() const
+{
+  return PIL_check_seconds_timer() - evaluation_start_time;
+}
+
+int deg_profile_thread_id()
+{
+  static int32_t num_threads = 1;
+  static thread_local int thread_id = -1;
+  if (thread_id == -1) {
+    thread_id = BLI_thread_is_main() ? 0 : atomic_fetch_and_add_int32(&num_threads, 1);
+  }
+  return thread_id;
+}
+
+namespace {
+
+/* Convert seconds to microseconds, which are used by the trace event format. */
+BLI_INLINE double seconds_to_us(const double seconds)
+{
+  return seconds * 1e6;
+}
+
+string json_escape(const string &str)
+{
+  string result;
+  result.reserve(str.length());
+  for (const char ch : str) {
+    if (ch == '"' || ch == '\\') {
+      result += '\\';
+      result += ch;
+    }
+    else if ((unsigned char)ch < 0x20) {
+      char buffer[8];
+      BLI_snprintf(buffer, sizeof(buffer), "\\u%04x", ch);
+      result += buffer;
+    }
+    else {
+      result += ch;
+    }
+  }
+  return result;
+}
+
+/* Components which are not named explicitly (like bones are) use name of their type. */
+string component_label(const ComponentNode *comp_node)
+{
+  const char *type_name = type_get_factory(comp_node->type)->type_name();
+  if (comp_node->name == type_name) {
+    return comp_node->name;
+  }
+  return string(type_name) + "/" + comp_node->name;
+}
+
+/* Among the dependencies of the operation, find the one which finished last. This is the one
+ * which kept the operation from being evaluated earlier. */
+const OperationNode *find_blocking_dependency(const OperationNode *op_node)
+{
+  const OperationNode *blocking_node = nullptr;
+  for (const Relation *rel : op_node->inlinks) {
+    if (rel->from->type != NodeType::OPERATION || (rel->flag & RELATION_FLAG_CYCLIC)) {
+      continue;
+    }
+    const OperationNode *op_from = (const OperationNode *)rel->from;
+    if (op_from->thread_id == -1) {
+      continue;
+    }
+    if (blocking_node == nullptr || op_from->end_time > blocking_node->end_time) {
+      blocking_node = op_from;
+    }
+  }
+  return blocking_node;
+}
+
+struct TraceContext {
+  FILE *file;
+  bool is_first_event;
+};
+
+void deg_trace_fprintf(TraceContext &ctx, const char *fmt, ...) ATTR_PRINTF_FORMAT(2, 3);
+void deg_trace_fprintf(TraceContext &ctx, const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  vfprintf(ctx.file, fmt, args);
+  va_end(args);
+}
+
+void deg_trace_begin_event(TraceContext &ctx)
+{
+  deg_trace_fprintf(ctx, ctx.is_first_event ? "\n" : ",\n");
+  ctx.is_first_event = false;
+}
+
+void deg_profile_write_chrome_trace(TraceContext &ctx, const Depsgraph *graph)
+{
+  const DepsgraphProfile &profile = graph->profile;
+  int max_thread_id = 0;
+  deg_trace_fprintf(ctx, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+  /* Whole graph evaluation. */
+  deg_trace_begin_event(ctx);
+  deg_trace_fprintf(ctx,
+                    "{\"name\": \"%s\", \"cat\": \"Depsgraph\", \"ph\": \"X\", \"pid\": 0, "
+                    "\"tid\": 0, \"ts\": 0, \"dur\": %.3f}",
+                    json_escape(graph->debug.name.empty() ? "Depsgraph" : graph->debug.name)
+                        .c_str(),
+                    seconds_to_us(profile.evaluation_end_time - profile.evaluation_start_time));
+  /* Operations. */
+  for (const OperationNode *op_node : profile.operations) {
+    const ComponentNode *comp_node = op_node->owner;
+    const IDNode *id_node = comp_node->owner;
+    const OperationNode *blocking_node = find_blocking_dependency(op_node);
+    max_thread_id = max(max_thread_id, op_node->thread_id);
+    deg_trace_begin_event(ctx);
+    deg_trace_fprintf(ctx,
+                      "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 0, "
+                      "\"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {"
+                      "\"id\": \"%s\", \"component\": \"%s\", "
+                      "\"ready\": %.3f, \"wait\": %.3f, \"blocked_by\": \"%s\"}}",
+                      json_escape(op_node->identifier()).c_str(),
+                      nodeTypeAsString(comp_node->type),
+                      op_node->thread_id,
+                      seconds_to_us(op_node->start_time),
+                      seconds_to_us(op_node->end_time - op_node->start_time),
+                      json_escape(id_node->id_orig->name).c_str(),
+                      json_escape(component_label(comp_node)).c_str(),
+                      seconds_to_us(op_node->ready_time),
+                      seconds_to_us(op_node->start_time - op_node->ready_time),
+                      blocking_node ? json_escape(blocking_node->full_identifier()).c_str() :
+                                      "");
+  }
+  /* Human readable names of the threads. */
+  for (int thread_id = 0; thread_id <= max_thread_id; thread_id++) {
+    deg_trace_begin_event(ctx);
+    deg_trace_fprintf(ctx,
+                      "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, "
+                      "\"args\": {\"name\": \"%s %d\"}}",
+                      thread_id,
+                      thread_id == 0 ? "Main Thread" : "Worker Thread",
+                      thread_id);
+  }
+  deg_trace_fprintf(ctx, "\n]}\n");
+}
+
+}  // namespace
+}  // namespace DEG
+
+void DEG_debug_profile_chrome_trace(const Depsgraph *depsgraph, FILE *stream)
+{
+  if (depsgraph == nullptr) {
+    return;
+  }
+  DEG::TraceContext ctx;
+  ctx.file = stream;
+  ctx.is_first_event = true;
+  DEG::deg_profile_write_chrome_trace(ctx, (const DEG::Depsgraph *)depsgraph);
+}
+
+void **DEG_debug_profile_operations(const Depsgraph *depsgraph, int *r_len)
+{
+  const DEG::Depsgraph *deg_graph = (const DEG::Depsgraph *)depsgraph;
+  *r_len = deg_graph->profile.operations.size();
+  return (void **)deg_graph->profile.operations.begin();
+}
+
+void DEG_debug_profile_operation_info(const void *operation, DEGOperationProfile *r_profile)
+{
+  const DEG::OperationNode *op_node = (const DEG::OperationNode *)operation;
+  const DEG::ComponentNode *comp_node = op_node->owner;
+  const DEG::OperationNode *blocking_node = DEG::find_blocking_dependency(op_node);
+  r_profile->id = comp_node->owner->id_orig;
+  BLI_strncpy(r_profile->component,
+              DEG::component_label(comp_node).c_str(),
+              sizeof(r_profile->component));
+  BLI_strncpy(r_profile->operation, op_node->identifier().c_str(), sizeof(r_profile->operation));
+  BLI_strncpy(r_profile->blocked_by,
+              blocking_node ? blocking_node->full_identifier().c_str() : "",
+              sizeof(r_profile->blocked_by));
+  r_profile->thread_id = op_node->thread_id;
+  r_profile->ready_time = op_node->ready_time;
+  r_profile->start_time = op_node->start_time;
+  r_profile->end_time = op_node->end_time;
+}
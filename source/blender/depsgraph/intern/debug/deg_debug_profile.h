@@ -0,0 +1,62 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+#include "intern/depsgraph_type.h"
+
+namespace DEG {
+
+struct OperationNode;
+
+/* Timing of operations evaluated during the last evaluation of the dependency graph.
+ *
+ * The timings themselves are stored in the operation nodes, so that threads do not need any
+ * synchronization to record them. The list of evaluated operations is gathered once the
+ * evaluation is finished. */
+class DepsgraphProfile {
+ public:
+  DepsgraphProfile();
+
+  void begin_evaluation();
+  void end_evaluation();
+
+  /* Forget all operations, is to be called when operation nodes are being freed. */
+  void clear();
+
+  /* Seconds since the beginning of the current graph evaluation. */
+  double time_since_evaluation_begin() const;
+
+  /* Point in time when the last graph evaluation began and ended. */
+  double evaluation_start_time;
+  double evaluation_end_time;
+
+  /* Operations which were evaluated during the last graph evaluation. */
+  Vector<OperationNode *> operations;
+};
+
+/* Small index of the current thread, stable for the life time of the thread. The main thread
+ * always has index 0. */
+int deg_profile_thread_id();
+
+}  // namespace DEG
@@ -41,6 +41,7 @@
 #include "DEG_depsgraph_physics.h"
 
 #include "intern/debug/deg_debug.h"
+#include "intern/debug/deg_debug_profile.h"
 #include "intern/depsgraph_type.h"
 
 struct ID;
@@ -108,6 +109,10 @@ struct Depsgraph {
   /* Indicates whether relations needs to be updated. */
   bool need_update;
 
+  /* IDs which relations are to be updated. When it is empty and need_update is set, the whole
+   * graph is to be rebuilt, otherwise only the nodes and relations of these IDs. */
+  Set<ID *> relations_update_ids;
+
   /* Indicates which ID types were updated. */
   char id_type_updated[MAX_LIBARRAY];
 
@@ -157,6 +162,9 @@ struct Depsgraph {
 
   DepsgraphDebug debug;
 
+  /* Timing of operations from the last graph evaluation. */
+  DepsgraphProfile profile;
+
   bool is_evaluating;
 
   /* Is set to truth for dependency graph which are used for post-processing (compositor and
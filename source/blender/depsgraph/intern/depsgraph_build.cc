@@ -46,6 +46,7 @@
 #include "builder/deg_builder.h"
 #include "builder/deg_builder_cache.h"
 #include "builder/deg_builder_cycle.h"
+#include "builder/deg_builder_incremental.h"
 #include "builder/deg_builder_nodes.h"
 #include "builder/deg_builder_relations.h"
 #include "builder/deg_builder_transitive.h"
@@ -59,6 +60,7 @@
 
 #include "intern/depsgraph_registry.h"
 #include "intern/depsgraph_relation.h"
+#include "intern/depsgraph_tag.h"
 #include "intern/depsgraph_type.h"
 
 /* ****************** */
@@ -231,6 +233,25 @@ static void graph_build_finalize_common(DEG::Depsgraph *deg_graph, Main *bmain)
 #endif
   /* Relations are up to date. */
   deg_graph->need_update = false;
+  deg_graph->relations_update_ids.clear();
+}
+
+static void graph_build_finalize_incremental(DEG::Depsgraph *deg_graph, Main *bmain)
+{
+  /* Cycles are solved by the incremental builder, only for the rebuilt part of the graph. */
+  DEG::deg_graph_build_finalize(bmain, deg_graph);
+  /* Rebuilt IDs are handled similar to IDs which are new to the graph. */
+  for (ID *id : deg_graph->relations_update_ids) {
+    DEG::graph_id_tag_update(bmain,
+                             deg_graph,
+                             id,
+                             ID_RECALC_COPY_ON_WRITE | ID_RECALC_TRANSFORM | ID_RECALC_GEOMETRY,
+                             DEG::DEG_UPDATE_SOURCE_RELATIONS);
+  }
+  DEG_graph_on_visible_update(bmain, reinterpret_cast<::Depsgraph *>(deg_graph), false);
+  /* Relations are up to date. */
+  deg_graph->need_update = false;
+  deg_graph->relations_update_ids.clear();
 }
 
 /* Build depsgraph for the given scene layer, and dump results in given graph container. */
@@ -484,6 +505,7 @@ void DEG_graph_tag_relations_update(Depsgraph *graph)
   DEG_DEBUG_PRINTF(graph, TAG, "%s: Tagging relations for update.\n", __func__);
   DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
   deg_graph->need_update = true;
+  deg_graph->relations_update_ids.clear();
   /* NOTE: When relations are updated, it's quite possible that
    * we've got new bases in the scene. This means, we need to
    * re-create flat array of bases in view layer.
@@ -504,9 +526,36 @@ void DEG_graph_relations_update(Depsgraph *graph, Main *bmain, Scene *scene, Vie
     /* Graph is up to date, nothing to do. */
     return;
   }
+  if (!deg_graph->relations_update_ids.is_empty()) {
+    double start_time = 0.0;
+    if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+      start_time = PIL_check_seconds_timer();
+    }
+    if (DEG::deg_graph_build_incremental(bmain, deg_graph, scene, view_layer)) {
+      graph_build_finalize_incremental(deg_graph, bmain);
+      if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+        printf("Depsgraph updated incrementally in %f seconds.\n",
+               PIL_check_seconds_timer() - start_time);
+      }
+      return;
+    }
+  }
   DEG_graph_build_from_view_layer(graph, bmain, scene, view_layer);
 }
 
+/* Tag relations of the given ID for update. */
+void DEG_graph_id_tag_relations_update(Depsgraph *graph, ID *id)
+{
+  DEG_DEBUG_PRINTF(graph, TAG, "%s: Tagging relations of %s for update.\n", __func__, id->name);
+  DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+  if (deg_graph->need_update && deg_graph->relations_update_ids.is_empty()) {
+    /* The whole graph is to be rebuilt already. */
+    return;
+  }
+  deg_graph->need_update = true;
+  deg_graph->relations_update_ids.add(id);
+}
+
 /* Tag all relations for update. */
 void DEG_relations_tag_update(Main *bmain)
 {
@@ -515,3 +564,12 @@ void DEG_relations_tag_update(Main *bmain)
     DEG_graph_tag_relations_update(reinterpret_cast<Depsgraph *>(depsgraph));
   }
 }
+
+/* Tag relations of the given ID for update in all dependency graphs. */
+void DEG_id_tag_relations_update(Main *bmain, ID *id)
+{
+  DEG_GLOBAL_DEBUG_PRINTF(TAG, "%s: Tagging relations of %s for update.\n", __func__, id->name);
+  for (DEG::Depsgraph *depsgraph : DEG::get_all_registered_graphs(bmain)) {
+    DEG_graph_id_tag_relations_update(reinterpret_cast<Depsgraph *>(depsgraph), id);
+  }
+}
@@ -42,6 +42,9 @@ enum RelationFlag {
   RELATION_FLAG_GODMODE = (1 << 4),
   /* Relation will check existence before being added. */
   RELATION_CHECK_BEFORE_ADD = (1 << 5),
+  /* Relation from animation to a property it animates. Frame change only flushes along the
+   * relation when the animated value changes, see IDNode::animated_property_targets. */
+  RELATION_FLAG_ANIMATED_PROPERTY = (1 << 6),
 };
 
 /* B depends on A (A -> B) */
@@ -25,7 +25,7 @@
 
 #include "intern/eval/deg_eval.h"
 
-#include "PIL_time.h"
+#include <algorithm>
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_gsqueue.h"
@@ -43,6 +43,7 @@
 
 #include "atomic_ops.h"
 
+#include "intern/builder/deg_builder.h"
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_relation.h"
 #include "intern/eval/deg_eval_copy_on_write.h"
@@ -60,18 +61,14 @@ namespace {
 
 struct DepsgraphEvalState;
 
+/* Operations which became ready for evaluation. */
+typedef Vector<OperationNode *, 16> ReadyOperations;
+
 void deg_task_run_func(TaskPool *pool, void *taskdata);
 
-template<typename ScheduleFunction, typename... ScheduleFunctionArgs>
 void schedule_children(DepsgraphEvalState *state,
                        OperationNode *node,
-                       ScheduleFunction *schedule_function,
-                       ScheduleFunctionArgs... schedule_function_args);
-
-void schedule_node_to_pool(OperationNode *node, const int UNUSED(thread_id), TaskPool *pool)
-{
-  BLI_task_pool_push(pool, deg_task_run_func, node, false, NULL);
-}
+                       ReadyOperations &r_ready_operations);
 
 /* Denotes which part of dependency graph is being evaluated. */
 enum class EvaluationStage {
@@ -103,15 +100,26 @@ void evaluate_node(const DepsgraphEvalState *state, OperationNode *operation_nod
 
   /* Sanity checks. */
   BLI_assert(!operation_node->is_noop() && "NOOP nodes should not actually be scheduled");
-  /* Perform operation. */
-  if (state->do_stats) {
-    const double start_time = PIL_check_seconds_timer();
-    operation_node->evaluate(depsgraph);
-    operation_node->stats.current_time += PIL_check_seconds_timer() - start_time;
-  }
-  else {
-    operation_node->evaluate(depsgraph);
-  }
+  /* Perform operation. Timing is always measured, it is used for profiling and to estimate cost
+   * of the operation for the scheduling priorities. */
+  const DepsgraphProfile &profile = state->graph->profile;
+  const double start_time = profile.time_since_evaluation_begin();
+  operation_node->evaluate(depsgraph);
+  const double end_time = profile.time_since_evaluation_begin();
+  operation_node->stats.current_time += end_time - start_time;
+  operation_node->start_time = start_time;
+  operation_node->end_time = end_time;
+  operation_node->thread_id = deg_profile_thread_id();
+}
+
+/* Order ready operations so that the ones on the most expensive paths come first. */
+void sort_by_priority(ReadyOperations &ready_operations)
+{
+  std::sort(ready_operations.begin(),
+            ready_operations.end(),
+            [](const OperationNode *a, const OperationNode *b) {
+              return a->priority > b->priority;
+            });
 }
 
 void deg_task_run_func(TaskPool *pool, void *taskdata)
@@ -119,12 +127,26 @@ void deg_task_run_func(TaskPool *pool, void *taskdata)
   void *userdata_v = BLI_task_pool_user_data(pool);
   DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
 
-  /* Evaluate node. */
   OperationNode *operation_node = reinterpret_cast<OperationNode *>(taskdata);
-  evaluate_node(state, operation_node);
+  ReadyOperations ready_operations;
+  while (true) {
+    /* Evaluate node. */
+    evaluate_node(state, operation_node);
 
-  /* Schedule children. */
-  schedule_children(state, operation_node, schedule_node_to_pool, pool);
+    /* Schedule children. */
+    ready_operations.clear();
+    schedule_children(state, operation_node, ready_operations);
+    if (ready_operations.is_empty()) {
+      break;
+    }
+    /* Continue the most critical path in this thread, avoiding the round trip through the pool,
+     * and hand the other children to the pool in the order of their priority. */
+    sort_by_priority(ready_operations);
+    for (uint i = 1; i < ready_operations.size(); i++) {
+      BLI_task_pool_push(pool, deg_task_run_func, ready_operations[i], false, NULL);
+    }
+    operation_node = ready_operations[0];
+  }
 }
 
 bool check_operation_node_visible(OperationNode *op_node)
@@ -177,15 +199,13 @@ void calculate_pending_parents(Depsgraph *graph)
   }
 }
 
-void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
+void initialize_execution(Depsgraph *graph)
 {
-  const bool do_stats = state->do_stats;
   calculate_pending_parents(graph);
   /* Clear tags and other things which needs to be clear. */
   for (OperationNode *node : graph->operations) {
-    if (do_stats) {
-      node->stats.reset_current();
-    }
+    node->stats.reset_current();
+    node->thread_id = -1;
   }
 }
 
@@ -226,16 +246,14 @@ bool need_evaluate_operation_at_stage(DepsgraphEvalState *state,
   return false;
 }
 
-/* Schedule a node if it needs evaluation.
+/* Schedule a node if it needs evaluation, adding it to the ready operations.
  *   dec_parents: Decrement pending parents count, true when child nodes are
  *                scheduled after a task has been completed.
  */
-template<typename ScheduleFunction, typename... ScheduleFunctionArgs>
 void schedule_node(DepsgraphEvalState *state,
                    OperationNode *node,
                    bool dec_parents,
-                   ScheduleFunction *schedule_function,
-                   ScheduleFunctionArgs... schedule_function_args)
+                   ReadyOperations &r_ready_operations)
 {
   /* No need to schedule nodes of invisible ID. */
   if (!check_operation_node_visible(node)) {
@@ -264,32 +282,44 @@ void schedule_node(DepsgraphEvalState *state,
   /* Actually schedule the node. */
   bool is_scheduled = atomic_fetch_and_or_uint8((uint8_t *)&node->scheduled, (uint8_t) true);
   if (!is_scheduled) {
+    node->ready_time = state->graph->profile.time_since_evaluation_begin();
     if (node->is_noop()) {
+      /* NOOP nodes are considered evaluated as soon as they are ready, this allows them to be
+       * reported as blocking dependencies when profiling. */
+      node->start_time = node->end_time = node->ready_time;
+      node->thread_id = deg_profile_thread_id();
       /* skip NOOP node, schedule children right away */
-      schedule_children(state, node, schedule_function, schedule_function_args...);
+      schedule_children(state, node, r_ready_operations);
     }
     else {
       /* children are scheduled once this task is completed */
-      schedule_function(node, 0, schedule_function_args...);
+      r_ready_operations.append(node);
     }
   }
 }
 
-template<typename ScheduleFunction, typename... ScheduleFunctionArgs>
-void schedule_graph(DepsgraphEvalState *state,
-                    ScheduleFunction *schedule_function,
-                    ScheduleFunctionArgs... schedule_function_args)
+/* Collect all operations which are ready for evaluation at the beginning of the stage, most
+ * critical ones first. */
+void schedule_graph(DepsgraphEvalState *state, ReadyOperations &r_ready_operations)
 {
   for (OperationNode *node : state->graph->operations) {
-    schedule_node(state, node, false, schedule_function, schedule_function_args...);
+    schedule_node(state, node, false, r_ready_operations);
+  }
+  sort_by_priority(r_ready_operations);
+}
+
+void schedule_graph_to_pool(DepsgraphEvalState *state, TaskPool *pool)
+{
+  ReadyOperations ready_operations;
+  schedule_graph(state, ready_operations);
+  for (OperationNode *node : ready_operations) {
+    BLI_task_pool_push(pool, deg_task_run_func, node, false, NULL);
   }
 }
 
-template<typename ScheduleFunction, typename... ScheduleFunctionArgs>
 void schedule_children(DepsgraphEvalState *state,
                        OperationNode *node,
-                       ScheduleFunction *schedule_function,
-                       ScheduleFunctionArgs... schedule_function_args)
+                       ReadyOperations &r_ready_operations)
 {
   for (Relation *rel : node->outlinks) {
     OperationNode *child = (OperationNode *)rel->to;
@@ -298,32 +328,29 @@ void schedule_children(DepsgraphEvalState *state,
       /* Happens when having cyclic dependencies. */
       continue;
     }
-    schedule_node(state,
-                  child,
-                  (rel->flag & RELATION_FLAG_CYCLIC) == 0,
-                  schedule_function,
-                  schedule_function_args...);
+    schedule_node(state, child, (rel->flag & RELATION_FLAG_CYCLIC) == 0, r_ready_operations);
   }
 }
 
-void schedule_node_to_queue(OperationNode *node,
-                            const int /*thread_id*/,
-                            GSQueue *evaluation_queue)
-{
-  BLI_gsqueue_push(evaluation_queue, &node);
-}
-
 void evaluate_graph_single_threaded(DepsgraphEvalState *state)
 {
   GSQueue *evaluation_queue = BLI_gsqueue_new(sizeof(OperationNode *));
-  schedule_graph(state, schedule_node_to_queue, evaluation_queue);
+  ReadyOperations ready_operations;
+  schedule_graph(state, ready_operations);
+  for (OperationNode *node : ready_operations) {
+    BLI_gsqueue_push(evaluation_queue, &node);
+  }
 
   while (!BLI_gsqueue_is_empty(evaluation_queue)) {
     OperationNode *operation_node;
     BLI_gsqueue_pop(evaluation_queue, &operation_node);
 
     evaluate_node(state, operation_node);
-    schedule_children(state, operation_node, schedule_node_to_queue, evaluation_queue);
+    ready_operations.clear();
+    schedule_children(state, operation_node, ready_operations);
+    for (OperationNode *node : ready_operations) {
+      BLI_gsqueue_push(evaluation_queue, &node);
+    }
   }
 
   BLI_gsqueue_free(evaluation_queue);
@@ -372,6 +399,7 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   }
 
   graph->debug.begin_graph_evaluation();
+  graph->profile.begin_evaluation();
 
   graph->is_evaluating = true;
   depsgraph_ensure_view_layer(graph);
@@ -381,20 +409,20 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   state.do_stats = graph->debug.do_time_debug();
   state.need_single_thread_pass = false;
   /* Prepare all nodes for evaluation. */
-  initialize_execution(&state, graph);
+  initialize_execution(graph);
 
   /* Do actual evaluation now. */
   /* First, process all Copy-On-Write nodes. */
   state.stage = EvaluationStage::COPY_ON_WRITE;
   TaskPool *task_pool = deg_evaluate_task_pool_create(&state);
-  schedule_graph(&state, schedule_node_to_pool, task_pool);
+  schedule_graph_to_pool(&state, task_pool);
   BLI_task_pool_work_and_wait(task_pool);
   BLI_task_pool_free(task_pool);
 
   /* After that, process all other nodes. */
   state.stage = EvaluationStage::THREADED_EVALUATION;
   task_pool = deg_evaluate_task_pool_create(&state);
-  schedule_graph(&state, schedule_node_to_pool, task_pool);
+  schedule_graph_to_pool(&state, task_pool);
   BLI_task_pool_work_and_wait(task_pool);
   BLI_task_pool_free(task_pool);
 
@@ -409,6 +437,12 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
   if (state.do_stats) {
     deg_eval_stats_aggregate(graph);
   }
+  graph->profile.end_evaluation();
+  /* Gather timings for profiling, and update cost estimates so that the next evaluation
+   * schedules the critical path according to the current state of the scene. */
+  if (deg_eval_stats_gather_timings(graph)) {
+    deg_graph_build_calculate_priorities(graph);
+  }
   /* Clear any uncleared tags - just in case. */
   deg_graph_clear_tags(graph);
   graph->is_evaluating = false;
@@ -27,11 +27,14 @@
 
 #include <cmath>
 
+#include "BLI_array.hh"
 #include "BLI_listbase.h"
 #include "BLI_math_vector.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 
+#include "BKE_anim_data.h"
+#include "BKE_animsys.h"
 #include "BKE_object.h"
 #include "BKE_scene.h"
 
@@ -160,25 +163,92 @@ BLI_INLINE void flush_handle_component_node(IDNode *id_node,
   }
 }
 
+/* Properties which will change when animation is evaluated at the new frame. */
+struct AnimatedPropertiesFilter {
+  /* Operations of animated properties which change value. */
+  Set<OperationNode *> changed_targets;
+  /* Whether any animated property changes value. */
+  bool any_changed;
+};
+
+/* Find animated properties which change value on frame change, when the given operation is the
+ * result of animation of an ID. Returns nullptr when all properties are to be flushed. */
+unique_ptr<AnimatedPropertiesFilter> flush_animated_properties_filter_create(
+    Depsgraph *graph, OperationNode *op_node)
+{
+  ComponentNode *comp_node = op_node->owner;
+  if (comp_node->type != NodeType::ANIMATION || op_node != comp_node->get_exit_operation()) {
+    return nullptr;
+  }
+  IDNode *id_node = comp_node->owner;
+  const Vector<OperationNode *> &targets = id_node->animated_property_targets;
+  if (targets.is_empty() || !deg_copy_on_write_is_expanded(id_node->id_cow)) {
+    return nullptr;
+  }
+  ID *id_cow = id_node->id_cow;
+  BLI::Array<bool> changed(targets.size(), false);
+  if (!BKE_animsys_action_eval_changed_channels(id_cow,
+                                                BKE_animdata_from_id(id_cow),
+                                                graph->ctime,
+                                                changed.begin(),
+                                                (int)targets.size())) {
+    return nullptr;
+  }
+  unique_ptr<AnimatedPropertiesFilter> filter(new AnimatedPropertiesFilter());
+  filter->any_changed = false;
+  for (uint i = 0; i < targets.size(); i++) {
+    if (!changed[i]) {
+      continue;
+    }
+    filter->any_changed = true;
+    if (targets[i] != nullptr) {
+      filter->changed_targets.add(targets[i]);
+    }
+  }
+  return filter;
+}
+
 /* Schedule children of the given operation node for traversal.
  *
  * One of the children will by-pass the queue and will be returned as a function
  * return value, so it can start being handled right away, without building too
  * much of a queue.
+ *
+ * On frame change without any other updates animation is only flushed to the
+ * properties which change value.
  */
-BLI_INLINE OperationNode *flush_schedule_children(OperationNode *op_node, FlushQueue *queue)
+BLI_INLINE OperationNode *flush_schedule_children(Depsgraph *graph,
+                                                  OperationNode *op_node,
+                                                  FlushQueue *queue,
+                                                  const bool is_time_update_only)
 {
   if (op_node->flag & DEPSOP_FLAG_USER_MODIFIED) {
     IDNode *id_node = op_node->owner->owner;
     id_node->is_user_modified = true;
   }
 
+  unique_ptr<AnimatedPropertiesFilter> animated_filter;
+  if (is_time_update_only) {
+    animated_filter = flush_animated_properties_filter_create(graph, op_node);
+  }
+
   OperationNode *result = nullptr;
   for (Relation *rel : op_node->outlinks) {
     /* Flush is forbidden, completely. */
     if (rel->flag & RELATION_FLAG_NO_FLUSH) {
       continue;
     }
+    /* Animation did not change the value of the property. */
+    if (animated_filter) {
+      if (rel->flag & RELATION_FLAG_ANIMATED_PROPERTY) {
+        if (!animated_filter->changed_targets.contains((OperationNode *)rel->to)) {
+          continue;
+        }
+      }
+      else if (!animated_filter->any_changed) {
+        continue;
+      }
+    }
     /* Relation only allows flushes on user changes, but the node was not
      * affected by user. */
     if ((rel->flag & RELATION_FLAG_FLUSH_USER_EDIT_ONLY) &&
@@ -333,6 +403,8 @@ void deg_graph_flush_updates(Main *bmain, Depsgraph *graph)
   /* Sanity checks. */
   BLI_assert(bmain != nullptr);
   BLI_assert(graph != nullptr);
+  /* Frame change without any other updates, see flush_schedule_children(). */
+  const bool is_time_update_only = graph->need_update_time && graph->entry_tags.is_empty();
   /* Nothing to update, early out. */
   if (graph->need_update_time) {
     const Scene *scene_orig = graph->scene;
@@ -368,7 +440,7 @@ void deg_graph_flush_updates(Main *bmain, Depsgraph *graph)
       flush_handle_id_node(id_node);
       flush_handle_component_node(id_node, comp_node, &queue);
       /* Flush to nodes along links. */
-      op_node = flush_schedule_children(op_node, &queue);
+      op_node = flush_schedule_children(graph, op_node, &queue, is_time_update_only);
     }
   }
   /* Inform editors about all changes. */
@@ -23,6 +23,8 @@
 
 #include "intern/eval/deg_eval_stats.h"
 
+#include <cmath>
+
 #include "BLI_utildefines.h"
 
 #include "intern/depsgraph.h"
@@ -54,4 +56,25 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
   }
 }
 
+bool deg_eval_stats_gather_timings(Depsgraph *graph)
+{
+  /* Changes of cost below this value (in seconds) are not worth re-calculating priorities. */
+  const float min_significant_change = 1e-4f;
+  bool need_update_priorities = false;
+  for (OperationNode *op_node : graph->operations) {
+    if (op_node->thread_id == -1 || op_node->is_noop()) {
+      continue;
+    }
+    graph->profile.operations.append(op_node);
+    const float delta = (float)op_node->stats.current_time - op_node->cost;
+    if (fabsf(delta) > max(min_significant_change, op_node->cost * 0.5f)) {
+      need_update_priorities = true;
+    }
+    /* Exponential moving average: follows changes in the scene within a few evaluations, while
+     * smoothing out noise of individual timings. */
+    op_node->cost += delta * 0.5f;
+  }
+  return need_update_priorities;
+}
+
 }  // namespace DEG
@@ -30,4 +30,9 @@ struct Depsgraph;
 /* Aggregate operation timings to overall component and ID nodes timing. */
 void deg_eval_stats_aggregate(Depsgraph *graph);
 
+/* Gather operations evaluated during the last graph evaluation into the graph profile, and blend
+ * their timings into the cost estimates. Returns true when the estimates changed enough for
+ * scheduling priorities to be re-calculated. */
+bool deg_eval_stats_gather_timings(Depsgraph *graph);
+
 }  // namespace DEG
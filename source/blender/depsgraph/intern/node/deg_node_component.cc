@@ -168,6 +168,18 @@ OperationNode *ComponentNode::add_operation(const DepsEvalOperationCb &op,
     DepsNodeFactory *factory = type_get_factory(NodeType::OPERATION);
     op_node = (OperationNode *)factory->create_node(this->owner->id_orig, "", name);
 
+    /* Component was already finalized, which happens when an incremental update of the graph
+     * adds operations to an ID which is not rebuilt. */
+    if (operations_map == nullptr) {
+      operations_map = new Map<ComponentNode::OperationIDKey, OperationNode *>();
+      for (OperationNode *existing_op_node : operations) {
+        OperationIDKey existing_key(
+            existing_op_node->opcode, existing_op_node->name.c_str(), existing_op_node->name_tag);
+        operations_map->add_new(existing_key, existing_op_node);
+      }
+      operations.clear();
+    }
+
     /* register opnode in this component's operation set */
     OperationIDKey key(opcode, name, name_tag);
     operations_map->add(key, op_node);
@@ -280,6 +292,10 @@ OperationNode *ComponentNode::get_exit_operation()
 
 void ComponentNode::finalize_build(Depsgraph * /*graph*/)
 {
+  if (operations_map == nullptr) {
+    /* Already finalized, not touched by an incremental update. */
+    return;
+  }
   operations.reserve(operations_map->size());
   for (OperationNode *op_node : operations_map->values()) {
     operations.push_back(op_node);
@@ -124,9 +124,7 @@ void IDNode::destroy()
     return;
   }
 
-  for (ComponentNode *comp_node : components.values()) {
-    OBJECT_GUARDED_DELETE(comp_node, ComponentNode);
-  }
+  clear_components();
 
   /* Free memory used by this CoW ID. */
   if (id_cow != id_orig && id_cow != nullptr) {
@@ -140,6 +138,15 @@ void IDNode::destroy()
   id_orig = nullptr;
 }
 
+void IDNode::clear_components()
+{
+  for (ComponentNode *comp_node : components.values()) {
+    OBJECT_GUARDED_DELETE(comp_node, ComponentNode);
+  }
+  components.clear();
+  animated_property_targets.clear();
+}
+
 string IDNode::identifier() const
 {
   char orig_ptr[24], cow_ptr[24];
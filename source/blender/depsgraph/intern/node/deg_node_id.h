@@ -31,6 +31,7 @@
 namespace DEG {
 
 struct ComponentNode;
+struct OperationNode;
 
 typedef uint64_t IDComponentsMask;
 
@@ -61,6 +62,9 @@ struct IDNode : public Node {
   ~IDNode();
   void destroy();
 
+  /* Free all components and their operations, keeping the copy-on-write datablock. */
+  void clear_components();
+
   virtual string identifier() const override;
 
   ComponentNode *find_component(NodeType type, const char *name = "") const;
@@ -111,6 +115,11 @@ struct IDNode : public Node {
   IDComponentsMask visible_components_mask;
   IDComponentsMask previously_visible_components_mask;
 
+  /* Operations which are affected by the F-Curves of the active action, in the order of the
+   * F-Curves (nullptr for F-Curves which do not affect any operation). Only filled in for
+   * animation without NLA, allows frame changes to only flush to properties which change. */
+  Vector<OperationNode *> animated_property_targets;
+
   DEG_DEPSNODE_DECLARE;
 };
 
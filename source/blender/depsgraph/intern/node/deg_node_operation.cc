@@ -203,7 +203,15 @@ const char *operationCodeAsString(OperationCode opcode)
   return "UNKNOWN";
 }
 
-OperationNode::OperationNode() : name_tag(-1), flag(0)
+OperationNode::OperationNode()
+    : cost(DEFAULT_COST),
+      priority(0.0f),
+      ready_time(0.0),
+      start_time(0.0),
+      end_time(0.0),
+      thread_id(-1),
+      name_tag(-1),
+      flag(0)
 {
 }
 
@@ -226,6 +226,9 @@ enum OperationFlag {
 
 /* Atomic Operation - Base type for all operations */
 struct OperationNode : public Node {
+  /* Cost which is used for operations which were never evaluated, in seconds. */
+  static const constexpr float DEFAULT_COST = 1e-6f;
+
   OperationNode();
   ~OperationNode();
 
@@ -262,6 +265,24 @@ struct OperationNode : public Node {
   uint32_t num_links_pending;
   bool scheduled;
 
+  /* Estimated evaluation time of this operation in seconds, averaged over previous evaluations.
+   * Operations which were never evaluated use DEFAULT_COST. */
+  float cost;
+  /* Cost of the most expensive chain of operations which starts at this one, including its own
+   * cost. Ready operations with higher priority are scheduled first, so that the critical path
+   * of the graph starts as early as possible. */
+  float priority;
+
+  /* Timing of the last evaluation, in seconds since the beginning of the graph evaluation: when
+   * all dependencies were evaluated, and when evaluation of this operation began and ended.
+   * Is used for profiling, see DepsgraphProfile. */
+  double ready_time;
+  double start_time;
+  double end_time;
+  /* Thread which evaluated the operation, -1 when it was not evaluated during the last graph
+   * evaluation. */
+  int thread_id;
+
   /* Identifier for the operation being performed. */
   OperationCode opcode;
   int name_tag;
@@ -279,21 +279,22 @@ static void mesh_render_data_update(MeshRenderData *mr,
     if (((data_flag & MR_DATA_LOOP_NOR) && is_auto_smooth) || (data_flag & MR_DATA_TAN_LOOP_NOR)) {
       mr->loop_normals = MEM_mallocN(sizeof(*mr->loop_normals) * mr->loop_len, __func__);
       short(*clnors)[2] = CustomData_get_layer(&mr->me->ldata, CD_CUSTOMLOOPNORMAL);
-      BKE_mesh_normals_loop_split(mr->me->mvert,
-                                  mr->vert_len,
-                                  mr->me->medge,
-                                  mr->edge_len,
-                                  mr->me->mloop,
-                                  mr->loop_normals,
-                                  mr->loop_len,
-                                  mr->me->mpoly,
-                                  mr->poly_normals,
-                                  mr->poly_len,
-                                  is_auto_smooth,
-                                  split_angle,
-                                  NULL,
-                                  clnors,
-                                  NULL);
+      BKE_mesh_normals_loop_split_ex(mr->me->mvert,
+                                     mr->vert_len,
+                                     mr->me->medge,
+                                     mr->edge_len,
+                                     mr->me->mloop,
+                                     mr->loop_normals,
+                                     mr->loop_len,
+                                     mr->me->mpoly,
+                                     mr->poly_normals,
+                                     mr->poly_len,
+                                     is_auto_smooth,
+                                     split_angle,
+                                     NULL,
+                                     clnors,
+                                     NULL,
+                                     mr->me);
     }
     if ((iter_type & MR_ITER_LOOPTRI) || (data_flag & MR_DATA_LOOPTRI)) {
       mr->mlooptri = MEM_mallocN(sizeof(*mr->mlooptri) * mr->tri_len, "MR_DATATYPE_LOOPTRI");
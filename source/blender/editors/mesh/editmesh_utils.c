@@ -1083,6 +1083,8 @@ void EDBM_verts_mirror_cache_begin_ex(BMEditMesh *em,
 
   /* one or the other is used depending if topo is enabled */
   KDTree_3d *tree = NULL;
+  KDTreeNearest_3d *tree_nearest = NULL;
+  int tree_nearest_index = 0;
   MirrTopoStore_t mesh_topo_store = {NULL, -1, -1, -1};
 
   BM_mesh_elem_table_ensure(bm, BM_VERT);
@@ -1114,6 +1116,21 @@ void EDBM_verts_mirror_cache_begin_ex(BMEditMesh *em,
       BLI_kdtree_3d_insert(tree, i, v->co);
     }
     BLI_kdtree_3d_balance(tree);
+
+    /* Look up all mirrored coordinates at once, in the same order they're used below. */
+    float(*co_mirr)[3] = MEM_mallocN(sizeof(*co_mirr) * (size_t)bm->totvert, __func__);
+    int co_mirr_len = 0;
+    BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+      if (use_select && !BM_elem_flag_test(v, BM_ELEM_SELECT)) {
+        continue;
+      }
+      copy_v3_v3(co_mirr[co_mirr_len], v->co);
+      co_mirr[co_mirr_len][axis] *= -1.0f;
+      co_mirr_len++;
+    }
+    tree_nearest = MEM_mallocN(sizeof(*tree_nearest) * (size_t)max_ii(co_mirr_len, 1), __func__);
+    BLI_kdtree_3d_find_nearest_batch(tree, co_mirr, (uint)co_mirr_len, tree_nearest);
+    MEM_freeN(co_mirr);
   }
 
 #define VERT_INTPTR(_v, _i) (r_index ? &r_index[_i] : BM_ELEM_CD_GET_VOID_P(_v, cd_vmirr_offset))
@@ -1133,17 +1150,12 @@ void EDBM_verts_mirror_cache_begin_ex(BMEditMesh *em,
         v_mirr = cache_mirr_intptr_as_bmvert(mesh_topo_store.index_lookup, i);
       }
       else {
-        int i_mirr;
-        float co[3];
-        copy_v3_v3(co, v->co);
-        co[axis] *= -1.0f;
+        const KDTreeNearest_3d *nearest = &tree_nearest[tree_nearest_index++];
 
         v_mirr = NULL;
-        i_mirr = BLI_kdtree_3d_find_nearest(tree, co, NULL);
-        if (i_mirr != -1) {
-          BMVert *v_test = BM_vert_at_index(bm, i_mirr);
-          if (len_squared_v3v3(co, v_test->co) < maxdist_sq) {
-            v_mirr = v_test;
+        if (nearest->index != -1) {
+          if (square_f(nearest->dist) < maxdist_sq) {
+            v_mirr = BM_vert_at_index(bm, nearest->index);
           }
         }
       }
@@ -1166,6 +1178,7 @@ void EDBM_verts_mirror_cache_begin_ex(BMEditMesh *em,
     ED_mesh_mirrtopo_free(&mesh_topo_store);
   }
   else {
+    MEM_freeN(tree_nearest);
     BLI_kdtree_3d_free(tree);
   }
 }
@@ -1986,8 +1986,9 @@ static int constraint_add_exec(
     BKE_pose_update_constraint_flags(ob->pose);
   }
 
-  /* force depsgraph to get recalculated since new relationships added */
-  DEG_relations_tag_update(bmain);
+  /* Force depsgraph to get recalculated since new relationships added. Only relations of the
+   * object itself are affected. */
+  DEG_id_tag_relations_update(bmain, &ob->id);
 
   if ((ob->type == OB_ARMATURE) && (pchan)) {
     BKE_pose_tag_recalc(bmain, ob->pose); /* sort pose channels */
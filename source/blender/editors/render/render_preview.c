@@ -1048,7 +1048,7 @@ static void icon_copy_rect(ImBuf *ibuf, uint w, uint h, uint *rect)
   dx = (w - ex) / 2;
   dy = (h - ey) / 2;
 
-  IMB_scalefastImBuf(ima, ex, ey);
+  IMB_scale_filter_ImBuf(ima, ex, ey, IMB_SCALE_FILTER_BILINEAR);
 
   /* if needed, convert to 32 bits */
   if (ima->rect == NULL) {
@@ -45,7 +45,6 @@
 #include "BLI_linklist.h"
 #include "BLI_math.h"
 #include "BLI_stack.h"
-#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -252,8 +251,7 @@ typedef struct FileListEntryCache {
   GHash *uuids;
 
   /* Previews handling. */
-  TaskPool *previews_pool;
-  ThreadQueue *previews_done;
+  ThumbBatch *previews_batch;
 } FileListEntryCache;
 
 /* FileListCache.flags */
@@ -262,19 +260,6 @@ enum {
   FLC_PREVIEWS_ACTIVE = 1 << 1,
 };
 
-typedef struct FileListEntryPreview {
-  char path[FILE_MAX];
-  uint flags;
-  int index;
-  ImBuf *img;
-} FileListEntryPreview;
-
-/* Dummy wrapper around FileListEntryPreview to ensure we do not access freed memory when freeing
- * tasks' data (see T74609). */
-typedef struct FileListEntryPreviewTaskData {
-  FileListEntryPreview *preview;
-} FileListEntryPreviewTaskData;
-
 typedef struct FileListFilter {
   uint64_t filter;
   uint64_t filter_id;
@@ -1268,108 +1253,38 @@ static void filelist_intern_free(FileListIntern *filelist_intern)
   MEM_SAFE_FREE(filelist_intern->filtered);
 }
 
-static void filelist_cache_preview_runf(TaskPool *__restrict pool, void *taskdata)
-{
-  FileListEntryCache *cache = BLI_task_pool_user_data(pool);
-  FileListEntryPreviewTaskData *preview_taskdata = taskdata;
-  FileListEntryPreview *preview = preview_taskdata->preview;
-
-  ThumbSource source = 0;
-
-  //  printf("%s: Start (%d)...\n", __func__, threadid);
-
-  //  printf("%s: %d - %s - %p\n", __func__, preview->index, preview->path, preview->img);
-  BLI_assert(preview->flags &
-             (FILE_TYPE_IMAGE | FILE_TYPE_MOVIE | FILE_TYPE_FTFONT | FILE_TYPE_BLENDER |
-              FILE_TYPE_BLENDER_BACKUP | FILE_TYPE_BLENDERLIB));
-
-  if (preview->flags & FILE_TYPE_IMAGE) {
-    source = THB_SOURCE_IMAGE;
-  }
-  else if (preview->flags &
-           (FILE_TYPE_BLENDER | FILE_TYPE_BLENDER_BACKUP | FILE_TYPE_BLENDERLIB)) {
-    source = THB_SOURCE_BLEND;
-  }
-  else if (preview->flags & FILE_TYPE_MOVIE) {
-    source = THB_SOURCE_MOVIE;
-  }
-  else if (preview->flags & FILE_TYPE_FTFONT) {
-    source = THB_SOURCE_FONT;
-  }
-
-  IMB_thumb_path_lock(preview->path);
-  preview->img = IMB_thumb_manage(preview->path, THB_LARGE, source);
-  IMB_thumb_path_unlock(preview->path);
-
-  /* That way task freeing function won't free th preview, since it does not own it anymore. */
-  atomic_cas_ptr((void **)&preview_taskdata->preview, preview, NULL);
-  BLI_thread_queue_push(cache->previews_done, preview);
-
-  //  printf("%s: End (%d)...\n", __func__, threadid);
-}
-
-static void filelist_cache_preview_freef(TaskPool *__restrict UNUSED(pool), void *taskdata)
-{
-  FileListEntryPreviewTaskData *preview_taskdata = taskdata;
-  FileListEntryPreview *preview = preview_taskdata->preview;
-
-  /* preview_taskdata->preview is atomically set to NULL once preview has been processed and sent
-   * to previews_done queue. */
-  if (preview != NULL) {
-    if (preview->img) {
-      IMB_freeImBuf(preview->img);
-    }
-    MEM_freeN(preview);
-  }
-  MEM_freeN(preview_taskdata);
-}
-
 static void filelist_cache_preview_ensure_running(FileListEntryCache *cache)
 {
-  if (!cache->previews_pool) {
-    cache->previews_pool = BLI_task_pool_create_background(cache, TASK_PRIORITY_LOW);
-    cache->previews_done = BLI_thread_queue_init();
-
-    IMB_thumb_locks_acquire();
+  if (!cache->previews_batch) {
+    cache->previews_batch = IMB_thumb_batch_create(THB_LARGE);
   }
 }
 
 static void filelist_cache_previews_clear(FileListEntryCache *cache)
 {
-  if (cache->previews_pool) {
-    BLI_task_pool_cancel(cache->previews_pool);
-
-    FileListEntryPreview *preview;
-    while ((preview = BLI_thread_queue_pop_timeout(cache->previews_done, 0))) {
-      // printf("%s: DONE %d - %s - %p\n", __func__, preview->index, preview->path,
-      // preview->img);
-      if (preview->img) {
-        IMB_freeImBuf(preview->img);
-      }
-      MEM_freeN(preview);
-    }
+  if (cache->previews_batch) {
+    IMB_thumb_batch_cancel(cache->previews_batch);
   }
 }
 
 static void filelist_cache_previews_free(FileListEntryCache *cache)
 {
-  if (cache->previews_pool) {
-    BLI_thread_queue_nowait(cache->previews_done);
-
-    filelist_cache_previews_clear(cache);
-
-    BLI_thread_queue_free(cache->previews_done);
-    BLI_task_pool_free(cache->previews_pool);
-    cache->previews_pool = NULL;
-    cache->previews_done = NULL;
-
-    IMB_thumb_locks_release();
+  if (cache->previews_batch) {
+    IMB_thumb_batch_free(cache->previews_batch);
+    cache->previews_batch = NULL;
   }
 
   cache->flags &= ~FLC_PREVIEWS_ACTIVE;
 }
 
-static void filelist_cache_previews_push(FileList *filelist, FileDirEntry *entry, const int index)
+/**
+ * \param priority: Previews with lower values are generated first,
+ * used to get the visible entries done before the rest of the cached block.
+ */
+static void filelist_cache_previews_push(FileList *filelist,
+                                         FileDirEntry *entry,
+                                         const int index,
+                                         const float priority)
 {
   FileListEntryCache *cache = &filelist->filelist_cache;
 
@@ -1378,31 +1293,32 @@ static void filelist_cache_previews_push(FileList *filelist, FileDirEntry *entry
   if (!entry->image && !(entry->flags & FILE_ENTRY_INVALID_PREVIEW) &&
       (entry->typeflag & (FILE_TYPE_IMAGE | FILE_TYPE_MOVIE | FILE_TYPE_FTFONT |
                           FILE_TYPE_BLENDER | FILE_TYPE_BLENDER_BACKUP | FILE_TYPE_BLENDERLIB))) {
-    FileListEntryPreview *preview = MEM_mallocN(sizeof(*preview), __func__);
+    char path[FILE_MAX_LIBEXTRA];
+    ThumbSource source = 0;
 
     if (entry->redirection_path) {
-      BLI_strncpy(preview->path, entry->redirection_path, FILE_MAXDIR);
+      BLI_strncpy(path, entry->redirection_path, FILE_MAXDIR);
     }
     else {
-      BLI_join_dirfile(
-          preview->path, sizeof(preview->path), filelist->filelist.root, entry->relpath);
+      BLI_join_dirfile(path, sizeof(path), filelist->filelist.root, entry->relpath);
     }
 
-    preview->index = index;
-    preview->flags = entry->typeflag;
-    preview->img = NULL;
-    //      printf("%s: %d - %s - %p\n", __func__, preview->index, preview->path, preview->img);
+    if (entry->typeflag & FILE_TYPE_IMAGE) {
+      source = THB_SOURCE_IMAGE;
+    }
+    else if (entry->typeflag &
+             (FILE_TYPE_BLENDER | FILE_TYPE_BLENDER_BACKUP | FILE_TYPE_BLENDERLIB)) {
+      source = THB_SOURCE_BLEND;
+    }
+    else if (entry->typeflag & FILE_TYPE_MOVIE) {
+      source = THB_SOURCE_MOVIE;
+    }
+    else if (entry->typeflag & FILE_TYPE_FTFONT) {
+      source = THB_SOURCE_FONT;
+    }
 
     filelist_cache_preview_ensure_running(cache);
-
-    FileListEntryPreviewTaskData *preview_taskdata = MEM_mallocN(sizeof(*preview_taskdata),
-                                                                 __func__);
-    preview_taskdata->preview = preview;
-    BLI_task_pool_push(cache->previews_pool,
-                       filelist_cache_preview_runf,
-                       preview_taskdata,
-                       true,
-                       filelist_cache_preview_freef);
+    IMB_thumb_batch_push(cache->previews_batch, path, source, index, priority);
   }
 }
 
@@ -1755,8 +1671,8 @@ static FileDirEntry *filelist_file_ex(struct FileList *filelist,
   cache->misc_cursor = (cache->misc_cursor + 1) % cache_size;
 
 #if 0 /* Actually no, only block cached entries should have preview imho. */
-  if (cache->previews_pool) {
-    filelist_cache_previews_push(filelist, ret, index);
+  if (cache->previews_batch) {
+    filelist_cache_previews_push(filelist, ret, index, 0.0f);
   }
 #endif
 
@@ -2082,11 +1998,11 @@ bool filelist_file_cache_block(struct FileList *filelist, const int index)
     for (i = 0; ((index + i) < end_index) || ((index - i) >= start_index); i++) {
       if ((index - i) >= start_index) {
         const int idx = (cache->block_cursor + (index - start_index) - i) % cache_size;
-        filelist_cache_previews_push(filelist, cache->block_entries[idx], index - i);
+        filelist_cache_previews_push(filelist, cache->block_entries[idx], index - i, (float)i);
       }
       if ((index + i) < end_index) {
         const int idx = (cache->block_cursor + (index - start_index) + i) % cache_size;
-        filelist_cache_previews_push(filelist, cache->block_entries[idx], index + i);
+        filelist_cache_previews_push(filelist, cache->block_entries[idx], index + i, (float)i);
       }
     }
   }
@@ -2109,7 +2025,7 @@ void filelist_cache_previews_set(FileList *filelist, const bool use_previews)
   else if (use_previews && (filelist->flags & FL_IS_READY)) {
     cache->flags |= FLC_PREVIEWS_ACTIVE;
 
-    BLI_assert((cache->previews_pool == NULL) && (cache->previews_done == NULL));
+    BLI_assert(cache->previews_batch == NULL);
 
     //      printf("%s: Init Previews...\n", __func__);
 
@@ -2125,39 +2041,31 @@ void filelist_cache_previews_set(FileList *filelist, const bool use_previews)
 bool filelist_cache_previews_update(FileList *filelist)
 {
   FileListEntryCache *cache = &filelist->filelist_cache;
-  TaskPool *pool = cache->previews_pool;
+  ThumbBatch *batch = cache->previews_batch;
   bool changed = false;
+  int index;
+  ImBuf *img;
 
-  if (!pool) {
+  if (!batch) {
     return changed;
   }
 
   //  printf("%s: Update Previews...\n", __func__);
 
-  while (!BLI_thread_queue_is_empty(cache->previews_done)) {
-    FileListEntryPreview *preview = BLI_thread_queue_pop(cache->previews_done);
-    FileDirEntry *entry;
-
-    /* Paranoid (should never happen currently
-     * since we consume this queue from a single thread), but... */
-    if (!preview) {
-      continue;
-    }
+  while (IMB_thumb_batch_pop_done(batch, &index, &img)) {
     /* entry might have been removed from cache in the mean time,
      * we do not want to cache it again here. */
-    entry = filelist_file_ex(filelist, preview->index, false);
+    FileDirEntry *entry = filelist_file_ex(filelist, index, false);
 
-    //      printf("%s: %d - %s - %p\n", __func__, preview->index, preview->path, preview->img);
-
-    if (preview->img) {
+    if (img) {
       /* Due to asynchronous process, a preview for a given image may be generated several times,
        * i.e. entry->image may already be set at this point. */
       if (entry && !entry->image) {
-        entry->image = preview->img;
+        entry->image = img;
         changed = true;
       }
       else {
-        IMB_freeImBuf(preview->img);
+        IMB_freeImBuf(img);
       }
     }
     else if (entry) {
@@ -2166,8 +2074,6 @@ bool filelist_cache_previews_update(FileList *filelist)
        * preview will be retried quite often anyway. */
       entry->flags |= FILE_ENTRY_INVALID_PREVIEW;
     }
-
-    MEM_freeN(preview);
   }
 
   return changed;
@@ -2177,7 +2083,9 @@ bool filelist_cache_previews_running(FileList *filelist)
 {
   FileListEntryCache *cache = &filelist->filelist_cache;
 
-  return (cache->previews_pool != NULL);
+  /* Finished once every pushed preview has been generated and handled,
+   * avoids redrawing on a timer while there is nothing left to do. */
+  return (cache->previews_batch != NULL) && !IMB_thumb_batch_is_done(cache->previews_batch);
 }
 
 /* would recognize .blend as well */
@@ -117,6 +117,13 @@ struct ImBuf *IMB_testiffname(const char *filepath, int flags);
  */
 struct ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_SPACE]);
 
+/**
+ *
+ * \attention Defined in decodecache.c
+ */
+void IMB_decode_cache_set_options(const char *dir, size_t size_limit);
+void IMB_decode_cache_clear(void);
+
 /**
  *
  * \attention Defined in allocimbuf.c
@@ -444,6 +451,25 @@ struct ImBuf *IMB_onehalf(struct ImBuf *ibuf1);
  */
 bool IMB_scaleImBuf(struct ImBuf *ibuf, unsigned int newx, unsigned int newy);
 
+typedef enum eIMBScaleFilter {
+  /** Area average, only useful for scaling down. */
+  IMB_SCALE_FILTER_BOX = 0,
+  IMB_SCALE_FILTER_BILINEAR = 1,
+  /** Mitchell-Netravali cubic, good default for photographic content. */
+  IMB_SCALE_FILTER_MITCHELL = 2,
+  /** Three lobe Lanczos, sharpest result but may ring on hard edges. */
+  IMB_SCALE_FILTER_LANCZOS = 3,
+} eIMBScaleFilter;
+
+/**
+ *
+ * \attention Defined in scaling.c
+ */
+bool IMB_scale_filter_ImBuf(struct ImBuf *ibuf,
+                            unsigned int newx,
+                            unsigned int newy,
+                            eIMBScaleFilter filter);
+
 /**
  *
  * \attention Defined in scaling.c
@@ -493,6 +519,10 @@ bool IMB_alpha_affects_rgb(const struct ImBuf *ibuf);
 
 /* create char buffer, color corrected if necessary, for ImBufs that lack one */
 void IMB_rect_from_float(struct ImBuf *ibuf);
+void IMB_rect_from_float_rows(const struct ImBuf *ibuf,
+                              unsigned char *rect_to,
+                              int start_y,
+                              int num_rows);
 void IMB_float_from_rect(struct ImBuf *ibuf);
 void IMB_color_to_bw(struct ImBuf *ibuf);
 void IMB_saturation(struct ImBuf *ibuf, float sat);
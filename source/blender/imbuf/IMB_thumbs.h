@@ -95,6 +95,17 @@ void IMB_thumb_locks_release(void);
 void IMB_thumb_path_lock(const char *path);
 void IMB_thumb_path_unlock(const char *path);
 
+/* Batched, threaded generation, see thumbs_batch.c */
+typedef struct ThumbBatch ThumbBatch;
+
+ThumbBatch *IMB_thumb_batch_create(ThumbSize size);
+void IMB_thumb_batch_free(ThumbBatch *batch);
+void IMB_thumb_batch_push(
+    ThumbBatch *batch, const char *path, ThumbSource source, int id, float priority);
+bool IMB_thumb_batch_pop_done(ThumbBatch *batch, int *r_id, struct ImBuf **r_img);
+void IMB_thumb_batch_cancel(ThumbBatch *batch);
+bool IMB_thumb_batch_is_done(ThumbBatch *batch);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -28,6 +28,11 @@
 struct ImBuf;
 
 #define IM_FTYPE_FLOAT 1
+/* Writer converts float buffers to 8 bit itself, a band of rows at a time,
+ * so no byte buffer has to be created before saving. */
+#define IM_FTYPE_BYTE_FROM_FLOAT 2
+/* Decoding is slow enough for loaded images to be kept in the decode cache. */
+#define IM_FTYPE_SLOW_DECODE 4
 
 typedef struct ImFileType {
   void (*init)(void);
@@ -64,6 +69,16 @@ void imb_tile_cache_init(void);
 void imb_tile_cache_exit(void);
 
 void imb_loadtile(struct ImBuf *ibuf, int tx, int ty, unsigned int *rect);
+
+bool imb_decode_cache_is_enabled(void);
+struct ImBuf *imb_decode_cache_load(const char *filepath,
+                                    int flags,
+                                    char colorspace[IM_MAX_SPACE]);
+void imb_decode_cache_store(const char *filepath,
+                            int flags,
+                            const char *colorspace_in,
+                            const char *colorspace,
+                            struct ImBuf *ibuf);
 void imb_tile_cache_tile_free(struct ImBuf *ibuf, int tx, int ty);
 
 /* Type Specific Functions */
@@ -0,0 +1,561 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup imbuf
+ *
+ * Disk cache of decoded images.
+ *
+ * Formats which are slow to decode (flagged #IM_FTYPE_SLOW_DECODE) are stored uncompressed
+ * after loading, so reading the same file again is a plain read of the pixels.
+ *
+ * Cache files are named after the MD5 of a key made of the file path, its modification time
+ * and size, the requested color space and the load flags which affect the result. The key is
+ * stored in the file as well, to detect hash collisions. Files are written to a temporary
+ * name and renamed, so other Blender instances sharing the directory never see partial files.
+ *
+ * File layout: a #DecodeCacheHeader, the key, the metadata as pairs of zero terminated
+ * strings, then the byte and float pixels starting at a page aligned offset, so the file can
+ * be memory mapped as well.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_fileops.h"
+#include "BLI_fileops_types.h"
+#include "BLI_hash_md5.h"
+#include "BLI_math_vector.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_allocimbuf.h"
+#include "IMB_colormanagement.h"
+#include "IMB_colormanagement_intern.h"
+#include "IMB_filetype.h"
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "IMB_metadata.h"
+#include "imbuf.h"
+
+#define DCACHE_MAGIC "IMBDCACH"
+#define DCACHE_CURRENT_VERSION 1
+#define DCACHE_EXTENSION ".ibc"
+#define DCACHE_PIXELS_ALIGN 4096
+/* Load flags which change the decoded result. */
+#define DCACHE_KEY_FLAGS \
+  (IB_rect | IB_metadata | IB_alphamode_premul | IB_alphamode_channel_packed | \
+   IB_alphamode_ignore | IB_alphamode_detect)
+/* Alpha flags set on the ImBuf while loading. */
+#define DCACHE_IBUF_FLAGS \
+  (IB_alphamode_premul | IB_alphamode_channel_packed | IB_alphamode_ignore)
+
+typedef struct DecodeCacheHeader {
+  char magic[8];
+  int version;
+  int x, y;
+  int planes;
+  int channels;
+  /* IB_rect and/or IB_rectfloat. */
+  int buffers;
+  int flags;
+  int colormanage_flag;
+  int ftype;
+  ImbFormatOptions foptions;
+  double ppm[2];
+  /* Color space of the byte buffer and the effective color space of the file. */
+  char rect_colorspace[IM_MAX_SPACE];
+  char colorspace[IM_MAX_SPACE];
+  int key_len;
+  int metadata_len;
+  uint64_t pixels_offset;
+} DecodeCacheHeader;
+
+static struct {
+  char dir[FILE_MAX];
+  size_t size_limit;
+  /* Total size of the cache directory, -1 when not known yet. */
+  int64_t size_total;
+  /* Same as a non-empty `dir`, readable without locking. */
+  bool enabled;
+} g_decode_cache = {"", 0, -1, false};
+
+static ThreadMutex g_decode_cache_mutex = BLI_MUTEX_INITIALIZER;
+
+/**
+ * Enable the cache, storing files in \a dir, or disable it when \a dir is empty.
+ * The oldest files are removed once the directory grows over \a size_limit bytes,
+ * zero means no limit.
+ */
+void IMB_decode_cache_set_options(const char *dir, size_t size_limit)
+{
+  BLI_mutex_lock(&g_decode_cache_mutex);
+  if (!STREQ(g_decode_cache.dir, dir)) {
+    BLI_strncpy(g_decode_cache.dir, dir, sizeof(g_decode_cache.dir));
+    if (g_decode_cache.dir[0] != '\0') {
+      BLI_path_slash_ensure(g_decode_cache.dir);
+    }
+    g_decode_cache.size_total = -1;
+  }
+  g_decode_cache.size_limit = size_limit;
+  g_decode_cache.enabled = (g_decode_cache.dir[0] != '\0');
+  BLI_mutex_unlock(&g_decode_cache_mutex);
+}
+
+/**
+ * Quick test done for every image load, so that a disabled cache costs nothing: no lock,
+ * no stat of the file and no hashing of the key. A stale result is harmless, the cache
+ * directory is checked again under the lock before it's used.
+ */
+bool imb_decode_cache_is_enabled(void)
+{
+  return g_decode_cache.enabled;
+}
+
+static bool imb_decode_cache_get_dir(char dir[FILE_MAX])
+{
+  BLI_mutex_lock(&g_decode_cache_mutex);
+  BLI_strncpy(dir, g_decode_cache.dir, FILE_MAX);
+  BLI_mutex_unlock(&g_decode_cache_mutex);
+
+  return dir[0] != '\0';
+}
+
+static bool imb_decode_cache_is_cache_file(const struct direntry *file)
+{
+  return S_ISREG(file->s.st_mode) && BLI_path_extension_check(file->relname, DCACHE_EXTENSION);
+}
+
+/* Remove all cache files. */
+void IMB_decode_cache_clear(void)
+{
+  struct direntry *files;
+  uint files_len;
+
+  BLI_mutex_lock(&g_decode_cache_mutex);
+  if (g_decode_cache.dir[0] != '\0' && BLI_is_dir(g_decode_cache.dir)) {
+    files_len = BLI_filelist_dir_contents(g_decode_cache.dir, &files);
+    for (uint i = 0; i < files_len; i++) {
+      if (imb_decode_cache_is_cache_file(&files[i])) {
+        BLI_delete(files[i].path, false, false);
+      }
+    }
+    BLI_filelist_free(files, files_len);
+  }
+  g_decode_cache.size_total = -1;
+  BLI_mutex_unlock(&g_decode_cache_mutex);
+}
+
+/* Build the cache key of \a filepath, false when the file can't be found. */
+static bool imb_decode_cache_key(const char *filepath,
+                                 int flags,
+                                 const char *colorspace,
+                                 char *key,
+                                 size_t key_maxlen)
+{
+  BLI_stat_t st;
+
+  if (BLI_stat(filepath, &st) == -1) {
+    return false;
+  }
+
+  /* The scene linear role is included since float buffers are converted to it. */
+  BLI_snprintf(key,
+               key_maxlen,
+               "%s\n%lld\n%lld\n%s\n%s\n%d",
+               filepath,
+               (long long)st.st_mtime,
+               (long long)st.st_size,
+               colorspace ? colorspace : "",
+               IMB_colormanagement_role_colorspace_name_get(COLOR_ROLE_SCENE_LINEAR),
+               flags & DCACHE_KEY_FLAGS);
+
+  return true;
+}
+
+static void imb_decode_cache_file_path(const char *dir, const char *key, char path[FILE_MAX])
+{
+  char digest[16], hex[33];
+
+  BLI_hash_md5_buffer(key, strlen(key), digest);
+  BLI_hash_md5_to_hexdigest(digest, hex);
+  BLI_join_dirfile(path, FILE_MAX, dir, hex);
+  BLI_path_extension_ensure(path, FILE_MAX, DCACHE_EXTENSION);
+}
+
+static bool imb_decode_cache_read_all(int file, void *data, size_t size)
+{
+  char *p = data;
+
+  while (size > 0) {
+    const int chunk = (int)MIN2(size, (size_t)1 << 30);
+    const int len = read(file, p, chunk);
+    if (len <= 0) {
+      return false;
+    }
+    p += len;
+    size -= (size_t)len;
+  }
+
+  return true;
+}
+
+static bool imb_decode_cache_write_all(int file, const void *data, size_t size)
+{
+  const char *p = data;
+
+  while (size > 0) {
+    const int chunk = (int)MIN2(size, (size_t)1 << 30);
+    const int len = write(file, p, chunk);
+    if (len <= 0) {
+      return false;
+    }
+    p += len;
+    size -= (size_t)len;
+  }
+
+  return true;
+}
+
+static size_t imb_decode_cache_rect_size(const DecodeCacheHeader *header)
+{
+  return (header->buffers & IB_rect) ? (size_t)header->x * header->y * 4 : 0;
+}
+
+static size_t imb_decode_cache_rect_float_size(const DecodeCacheHeader *header)
+{
+  return (header->buffers & IB_rectfloat) ?
+             (size_t)header->x * header->y * header->channels * sizeof(float) :
+             0;
+}
+
+static bool imb_decode_cache_read_file(int file,
+                                       const char *key,
+                                       ImBuf **r_ibuf,
+                                       DecodeCacheHeader *header)
+{
+  const int key_len = (int)strlen(key);
+  ImBuf *ibuf;
+  char *buf;
+  bool ok;
+
+  if (!imb_decode_cache_read_all(file, header, sizeof(*header)) ||
+      memcmp(header->magic, DCACHE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != DCACHE_CURRENT_VERSION || header->key_len != key_len ||
+      header->metadata_len < 0 || header->x <= 0 || header->y <= 0) {
+    return false;
+  }
+
+  /* Key and metadata. */
+  buf = MEM_mallocN((size_t)key_len + header->metadata_len + 1, __func__);
+  ok = imb_decode_cache_read_all(file, buf, (size_t)key_len + header->metadata_len) &&
+       memcmp(buf, key, key_len) == 0;
+  buf[key_len + header->metadata_len] = '\0';
+
+  if (!ok || lseek(file, (off_t)header->pixels_offset, SEEK_SET) == -1) {
+    MEM_freeN(buf);
+    return false;
+  }
+
+  ibuf = IMB_allocImBuf(header->x, header->y, header->planes, 0);
+  ok = ibuf != NULL;
+  if (ok) {
+    ibuf->channels = header->channels;
+  }
+  if (ok && (header->buffers & IB_rect)) {
+    ok = imb_addrectImBuf(ibuf) &&
+         imb_decode_cache_read_all(file, ibuf->rect, imb_decode_cache_rect_size(header));
+  }
+  if (ok && (header->buffers & IB_rectfloat)) {
+    ok = imb_addrectfloatImBuf(ibuf) &&
+         imb_decode_cache_read_all(
+             file, ibuf->rect_float, imb_decode_cache_rect_float_size(header));
+  }
+
+  if (ok && header->metadata_len) {
+    const char *field = buf + key_len;
+    const char *end = field + header->metadata_len;
+
+    IMB_metadata_ensure(&ibuf->metadata);
+    while (field < end) {
+      const char *value = field + strlen(field) + 1;
+      if (value >= end) {
+        break;
+      }
+      IMB_metadata_set_field(ibuf->metadata, field, value);
+      field = value + strlen(value) + 1;
+    }
+  }
+
+  MEM_freeN(buf);
+
+  if (!ok) {
+    if (ibuf) {
+      IMB_freeImBuf(ibuf);
+    }
+    return false;
+  }
+
+  ibuf->flags |= header->flags & DCACHE_IBUF_FLAGS;
+  ibuf->colormanage_flag = header->colormanage_flag;
+  ibuf->ftype = header->ftype;
+  ibuf->foptions = header->foptions;
+  copy_v2_v2_db(ibuf->ppm, header->ppm);
+  if (header->rect_colorspace[0]) {
+    ibuf->rect_colorspace = colormanage_colorspace_get_named(header->rect_colorspace);
+  }
+
+  *r_ibuf = ibuf;
+  return true;
+}
+
+/**
+ * Load \a filepath from the cache, NULL when not cached.
+ * \a colorspace has the same meaning as for #IMB_loadiffname.
+ */
+ImBuf *imb_decode_cache_load(const char *filepath, int flags, char colorspace[IM_MAX_SPACE])
+{
+  char dir[FILE_MAX], path[FILE_MAX], key[FILE_MAX + 256];
+  DecodeCacheHeader header;
+  ImBuf *ibuf = NULL;
+  int file;
+
+  if (!imb_decode_cache_get_dir(dir) ||
+      !imb_decode_cache_key(filepath, flags, colorspace, key, sizeof(key))) {
+    return NULL;
+  }
+
+  imb_decode_cache_file_path(dir, key, path);
+
+  file = BLI_open(path, O_BINARY | O_RDONLY, 0);
+  if (file == -1) {
+    return NULL;
+  }
+
+  if (!imb_decode_cache_read_file(file, key, &ibuf, &header)) {
+    ibuf = NULL;
+  }
+  close(file);
+
+  if (ibuf == NULL) {
+    return NULL;
+  }
+
+  if (colorspace) {
+    BLI_strncpy(colorspace, header.colorspace, IM_MAX_SPACE);
+  }
+
+  /* Keep recently used files when enforcing the size limit. */
+  BLI_file_touch(path);
+
+  return ibuf;
+}
+
+typedef struct MetadataWriteData {
+  char *buf;
+  int len, maxlen;
+} MetadataWriteData;
+
+static void imb_decode_cache_metadata_append(const char *field, const char *value, void *userdata)
+{
+  MetadataWriteData *data = userdata;
+  const int field_len = (int)strlen(field) + 1;
+  const int value_len = (int)strlen(value) + 1;
+
+  if (data->len + field_len + value_len > data->maxlen) {
+    data->maxlen = (data->len + field_len + value_len) * 2;
+    data->buf = MEM_reallocN(data->buf, data->maxlen);
+  }
+  memcpy(data->buf + data->len, field, field_len);
+  memcpy(data->buf + data->len + field_len, value, value_len);
+  data->len += field_len + value_len;
+}
+
+static int imb_decode_cache_compare_mtime(const void *a_v, const void *b_v)
+{
+  const struct direntry *a = a_v, *b = b_v;
+
+  if (a->s.st_mtime != b->s.st_mtime) {
+    return (a->s.st_mtime < b->s.st_mtime) ? -1 : 1;
+  }
+  return 0;
+}
+
+/* Remove the least recently used files once the limit is exceeded. */
+static void imb_decode_cache_enforce_limit(size_t file_size)
+{
+  struct direntry *files;
+  uint files_len;
+
+  BLI_mutex_lock(&g_decode_cache_mutex);
+
+  if (g_decode_cache.size_limit == 0) {
+    BLI_mutex_unlock(&g_decode_cache_mutex);
+    return;
+  }
+
+  if (g_decode_cache.size_total != -1) {
+    g_decode_cache.size_total += (int64_t)file_size;
+  }
+
+  if (g_decode_cache.size_total == -1 ||
+      g_decode_cache.size_total > (int64_t)g_decode_cache.size_limit) {
+    /* Other instances may share the directory, so always start from what is on disk. */
+    files_len = BLI_filelist_dir_contents(g_decode_cache.dir, &files);
+    qsort(files, files_len, sizeof(*files), imb_decode_cache_compare_mtime);
+
+    g_decode_cache.size_total = 0;
+    for (uint i = 0; i < files_len; i++) {
+      if (imb_decode_cache_is_cache_file(&files[i])) {
+        g_decode_cache.size_total += files[i].s.st_size;
+      }
+    }
+
+    /* Remove down to 90% of the limit, so this doesn't happen on every write. */
+    for (uint i = 0; i < files_len &&
+                     g_decode_cache.size_total > (int64_t)(g_decode_cache.size_limit / 10 * 9);
+         i++) {
+      if (imb_decode_cache_is_cache_file(&files[i]) &&
+          BLI_delete(files[i].path, false, false) == 0) {
+        g_decode_cache.size_total -= files[i].s.st_size;
+      }
+    }
+
+    BLI_filelist_free(files, files_len);
+  }
+
+  BLI_mutex_unlock(&g_decode_cache_mutex);
+}
+
+static bool imb_decode_cache_is_slow_format(const ImBuf *ibuf)
+{
+  const ImFileType *type;
+
+  for (type = IMB_FILE_TYPES; type < IMB_FILE_TYPES_LAST; type++) {
+    if (type->ftype(type, ibuf)) {
+      return (type->flag & IM_FTYPE_SLOW_DECODE) != 0;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Store a freshly loaded \a ibuf in the cache, if its format is slow to decode.
+ *
+ * \param colorspace_in: Color space passed to #IMB_loadiffname.
+ * \param colorspace: Effective color space returned by the loader.
+ */
+void imb_decode_cache_store(const char *filepath,
+                            int flags,
+                            const char *colorspace_in,
+                            const char *colorspace,
+                            ImBuf *ibuf)
+{
+  char dir[FILE_MAX], path[FILE_MAX], path_tmp[FILE_MAX], key[FILE_MAX + 256];
+  DecodeCacheHeader header = {{0}};
+  MetadataWriteData metadata = {NULL};
+  size_t header_size;
+  int file;
+  bool ok;
+
+  if ((ibuf->rect == NULL && ibuf->rect_float == NULL) || ibuf->miptot > 1 ||
+      !imb_decode_cache_is_slow_format(ibuf)) {
+    return;
+  }
+
+  if (!imb_decode_cache_get_dir(dir) ||
+      !imb_decode_cache_key(filepath, flags, colorspace_in, key, sizeof(key))) {
+    return;
+  }
+
+  if (!BLI_is_dir(dir) && !BLI_dir_create_recursive(dir)) {
+    return;
+  }
+
+  imb_decode_cache_file_path(dir, key, path);
+  BLI_snprintf(path_tmp, sizeof(path_tmp), "%s.tmp", path);
+
+  /* Another thread or instance is already writing this file. */
+  file = BLI_open(path_tmp, O_BINARY | O_WRONLY | O_CREAT | O_EXCL, 0666);
+  if (file == -1) {
+    return;
+  }
+
+  if (ibuf->metadata) {
+    IMB_metadata_foreach(ibuf, imb_decode_cache_metadata_append, &metadata);
+  }
+
+  memcpy(header.magic, DCACHE_MAGIC, sizeof(header.magic));
+  header.version = DCACHE_CURRENT_VERSION;
+  header.x = ibuf->x;
+  header.y = ibuf->y;
+  header.planes = ibuf->planes;
+  header.channels = ibuf->channels;
+  header.buffers = (ibuf->rect ? IB_rect : 0) | (ibuf->rect_float ? IB_rectfloat : 0);
+  header.flags = ibuf->flags & DCACHE_IBUF_FLAGS;
+  header.colormanage_flag = ibuf->colormanage_flag;
+  header.ftype = ibuf->ftype;
+  header.foptions = ibuf->foptions;
+  copy_v2_v2_db(header.ppm, ibuf->ppm);
+  if (ibuf->rect_colorspace) {
+    BLI_strncpy(header.rect_colorspace, ibuf->rect_colorspace->name, IM_MAX_SPACE);
+  }
+  BLI_strncpy(header.colorspace, colorspace, IM_MAX_SPACE);
+  header.key_len = (int)strlen(key);
+  header.metadata_len = metadata.len;
+
+  header_size = sizeof(header) + header.key_len + header.metadata_len;
+  header.pixels_offset = (header_size + DCACHE_PIXELS_ALIGN - 1) / DCACHE_PIXELS_ALIGN *
+                         DCACHE_PIXELS_ALIGN;
+
+  ok = imb_decode_cache_write_all(file, &header, sizeof(header)) &&
+       imb_decode_cache_write_all(file, key, header.key_len) &&
+       imb_decode_cache_write_all(file, metadata.buf, header.metadata_len) &&
+       lseek(file, (off_t)header.pixels_offset, SEEK_SET) != -1;
+  if (ok && ibuf->rect) {
+    ok = imb_decode_cache_write_all(file, ibuf->rect, imb_decode_cache_rect_size(&header));
+  }
+  if (ok && ibuf->rect_float) {
+    ok = imb_decode_cache_write_all(
+        file, ibuf->rect_float, imb_decode_cache_rect_float_size(&header));
+  }
+
+  MEM_SAFE_FREE(metadata.buf);
+
+  if (close(file) != 0) {
+    ok = false;
+  }
+
+  if (!ok || BLI_rename(path_tmp, path) != 0) {
+    BLI_delete(path_tmp, false, false);
+    return;
+  }
+
+  imb_decode_cache_enforce_limit(header.pixels_offset + imb_decode_cache_rect_size(&header) +
+                                 imb_decode_cache_rect_float_size(&header));
+}
@@ -35,6 +35,10 @@
 
 #include "MEM_guardedalloc.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 /************************* Floyd-Steinberg dithering *************************/
 
 typedef struct DitherContext {
@@ -96,30 +100,117 @@ MINLINE void float_to_byte_dither_v4(
   b[3] = unit_float_to_uchar_clamp(f[3]);
 }
 
+/* Row kernels for the common case of 4 channel buffers without color space conversion or
+ * dither. The SSE2 versions give exactly the same results as the scalar code. */
+
+#ifdef __SSE2__
+/* Same as #premul_to_straight_v4_v4. */
+MALWAYS_INLINE __m128 premul_to_straight_v4_simd(const __m128 premul)
+{
+  const __m128 alpha = _mm_shuffle_ps(premul, premul, _MM_SHUFFLE(3, 3, 3, 3));
+  const __m128 keep = _mm_or_ps(_mm_cmpeq_ps(alpha, _mm_setzero_ps()),
+                                _mm_cmpeq_ps(alpha, _mm_set1_ps(1.0f)));
+  const __m128 straight = _mm_mul_ps(premul, _mm_div_ps(_mm_set1_ps(1.0f), alpha));
+  /* Never touch the alpha channel itself. */
+  const __m128 mask_rgb = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  return _bli_math_blend_sse(_mm_andnot_ps(keep, mask_rgb), straight, premul);
+}
+
+/* Same as #unit_float_to_uchar_clamp, as 32 bit integers. */
+MALWAYS_INLINE __m128i unit_float_to_uchar_clamp_v4_simd(const __m128 f)
+{
+  const __m128 clamped = _mm_min_ps(_mm_max_ps(f, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+  return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)),
+                                     _mm_set1_ps(0.5f)));
+}
+#endif
+
+static void rgba_float_to_uchar_row(uchar *to, const float *from, int width, bool predivide)
+{
+  int x = 0;
+
+#ifdef __SSE2__
+  for (; x + 4 <= width; x += 4, from += 16, to += 16) {
+    __m128 px[4];
+    for (int i = 0; i < 4; i++) {
+      px[i] = _mm_loadu_ps(from + i * 4);
+      if (predivide) {
+        px[i] = premul_to_straight_v4_simd(px[i]);
+      }
+    }
+    const __m128i lo = _mm_packs_epi32(unit_float_to_uchar_clamp_v4_simd(px[0]),
+                                       unit_float_to_uchar_clamp_v4_simd(px[1]));
+    const __m128i hi = _mm_packs_epi32(unit_float_to_uchar_clamp_v4_simd(px[2]),
+                                       unit_float_to_uchar_clamp_v4_simd(px[3]));
+    _mm_storeu_si128((__m128i *)to, _mm_packus_epi16(lo, hi));
+  }
+#endif
+
+  for (; x < width; x++, from += 4, to += 4) {
+    if (predivide) {
+      float straight[4];
+      premul_to_straight_v4_v4(straight, from);
+      rgba_float_to_uchar(to, straight);
+    }
+    else {
+      rgba_float_to_uchar(to, from);
+    }
+  }
+}
+
+static void rgba_uchar_to_float_row(float *to, const uchar *from, int width)
+{
+  int x = 0;
+
+#ifdef __SSE2__
+  const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+  const __m128i zero = _mm_setzero_si128();
+
+  for (; x + 4 <= width; x += 4, from += 16, to += 16) {
+    const __m128i bytes = _mm_loadu_si128((const __m128i *)from);
+    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    _mm_storeu_ps(to, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+    _mm_storeu_ps(to + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+    _mm_storeu_ps(to + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+    _mm_storeu_ps(to + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+  }
+#endif
+
+  for (; x < width; x++, from += 4, to += 4) {
+    rgba_uchar_to_float(to, from);
+  }
+}
+
 /* Test if colorspace conversions of pixels in buffer need to take into account alpha. */
 bool IMB_alpha_affects_rgb(const ImBuf *ibuf)
 {
   return (ibuf->flags & IB_alphamode_channel_packed) == 0;
 }
 
-/* float to byte pixels, output 4-channel RGBA */
-void IMB_buffer_byte_from_float(uchar *rect_to,
-                                const float *rect_from,
-                                int channels_from,
-                                float dither,
-                                int profile_to,
-                                int profile_from,
-                                bool predivide,
-                                int width,
-                                int height,
-                                int stride_to,
-                                int stride_from)
+/* Float to byte pixels, output 4-channel RGBA.
+ *
+ * The buffers hold rows [start_y, start_y + height) of an image which is \a total_height rows
+ * high, so converting an image in bands gives the same dither pattern as doing it at once. */
+static void buffer_byte_from_float_rows(uchar *rect_to,
+                                        const float *rect_from,
+                                        int channels_from,
+                                        float dither,
+                                        int profile_to,
+                                        int profile_from,
+                                        bool predivide,
+                                        int width,
+                                        int height,
+                                        int stride_to,
+                                        int stride_from,
+                                        int start_y,
+                                        int total_height)
 {
   float tmp[4];
   int x, y;
   DitherContext *di = NULL;
   float inv_width = 1.0f / width;
-  float inv_height = 1.0f / height;
+  float inv_height = 1.0f / total_height;
 
   /* we need valid profiles */
   BLI_assert(profile_to != IB_PROFILE_NONE);
@@ -130,7 +221,7 @@ void IMB_buffer_byte_from_float(uchar *rect_to,
   }
 
   for (y = 0; y < height; y++) {
-    float t = y * inv_height;
+    float t = (y + start_y) * inv_height;
 
     if (channels_from == 1) {
       /* single channel input */
@@ -190,16 +281,8 @@ void IMB_buffer_byte_from_float(uchar *rect_to,
             float_to_byte_dither_v4(to, from, di, (float)x * inv_width, t);
           }
         }
-        else if (predivide) {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            premul_to_straight_v4_v4(straight, from);
-            rgba_float_to_uchar(to, straight);
-          }
-        }
         else {
-          for (x = 0; x < width; x++, from += 4, to += 4) {
-            rgba_float_to_uchar(to, from);
-          }
+          rgba_float_to_uchar_row(to, from, width, predivide);
         }
       }
       else if (profile_to == IB_PROFILE_SRGB) {
@@ -210,7 +293,7 @@ void IMB_buffer_byte_from_float(uchar *rect_to,
         if (dither && predivide) {
           for (x = 0; x < width; x++, from += 4, to += 4) {
             premul_to_straight_v4_v4(straight, from);
-            linearrgb_to_srgb_ushort4(us, from);
+            linearrgb_to_srgb_ushort4(us, straight);
             ushort_to_byte_dither_v4(to, us, di, (float)x * inv_width, t);
           }
         }
@@ -223,7 +306,7 @@ void IMB_buffer_byte_from_float(uchar *rect_to,
         else if (predivide) {
           for (x = 0; x < width; x++, from += 4, to += 4) {
             premul_to_straight_v4_v4(straight, from);
-            linearrgb_to_srgb_ushort4(us, from);
+            linearrgb_to_srgb_ushort4(us, straight);
             ushort_to_byte_v4(to, us);
           }
         }
@@ -269,6 +352,34 @@ void IMB_buffer_byte_from_float(uchar *rect_to,
   }
 }
 
+/* float to byte pixels, output 4-channel RGBA */
+void IMB_buffer_byte_from_float(uchar *rect_to,
+                                const float *rect_from,
+                                int channels_from,
+                                float dither,
+                                int profile_to,
+                                int profile_from,
+                                bool predivide,
+                                int width,
+                                int height,
+                                int stride_to,
+                                int stride_from)
+{
+  buffer_byte_from_float_rows(rect_to,
+                              rect_from,
+                              channels_from,
+                              dither,
+                              profile_to,
+                              profile_from,
+                              predivide,
+                              width,
+                              height,
+                              stride_to,
+                              stride_from,
+                              0,
+                              height);
+}
+
 /* float to byte pixels, output 4-channel RGBA */
 void IMB_buffer_byte_from_float_mask(uchar *rect_to,
                                      const float *rect_from,
@@ -385,9 +496,7 @@ void IMB_buffer_float_from_byte(float *rect_to,
 
     if (profile_to == profile_from) {
       /* no color space conversion */
-      for (x = 0; x < width; x++, from += 4, to += 4) {
-        rgba_uchar_to_float(to, from);
-      }
+      rgba_uchar_to_float_row(to, from, width);
     }
     else if (profile_to == IB_PROFILE_LINEAR_RGB) {
       /* convert sRGB to linear */
@@ -707,22 +816,20 @@ void IMB_buffer_byte_from_byte(uchar *rect_to,
 
 /****************************** ImBuf Conversion *****************************/
 
-void IMB_rect_from_float(ImBuf *ibuf)
+/**
+ * Convert rows [start_y, start_y + num_rows) of the float buffer into 4 channel byte rows
+ * in \a rect_to, in the color space of `ibuf->rect_colorspace`.
+ * Gives the same result as the matching rows of #IMB_rect_from_float, only needing a
+ * temporary copy of these rows, so image writers can convert images in bands.
+ */
+void IMB_rect_from_float_rows(const ImBuf *ibuf, uchar *rect_to, int start_y, int num_rows)
 {
-  float *buffer;
   const char *from_colorspace;
+  const size_t band_len = ((size_t)ibuf->x) * num_rows * ibuf->channels;
+  float *buffer;
 
-  /* verify we have a float buffer */
-  if (ibuf->rect_float == NULL) {
-    return;
-  }
-
-  /* create byte rect if it didn't exist yet */
-  if (ibuf->rect == NULL) {
-    if (imb_addrectImBuf(ibuf) == 0) {
-      return;
-    }
-  }
+  BLI_assert(ibuf->rect_float != NULL && ibuf->rect_colorspace != NULL);
+  BLI_assert(start_y >= 0 && start_y + num_rows <= ibuf->y);
 
   if (ibuf->float_colorspace == NULL) {
     from_colorspace = IMB_colormanagement_role_colorspace_name_get(COLOR_ROLE_SCENE_LINEAR);
@@ -731,40 +838,118 @@ void IMB_rect_from_float(ImBuf *ibuf)
     from_colorspace = ibuf->float_colorspace->name;
   }
 
-  buffer = MEM_dupallocN(ibuf->rect_float);
+  buffer = MEM_mallocN(sizeof(float) * band_len, __func__);
+  memcpy(buffer,
+         ibuf->rect_float + ((size_t)start_y) * ibuf->x * ibuf->channels,
+         sizeof(float) * band_len);
 
   /* first make float buffer in byte space */
   const bool predivide = IMB_alpha_affects_rgb(ibuf);
   IMB_colormanagement_transform(buffer,
                                 ibuf->x,
-                                ibuf->y,
+                                num_rows,
                                 ibuf->channels,
                                 from_colorspace,
                                 ibuf->rect_colorspace->name,
                                 predivide);
 
   /* convert from float's premul alpha to byte's straight alpha */
-  if (IMB_alpha_affects_rgb(ibuf)) {
-    IMB_unpremultiply_rect_float(buffer, ibuf->channels, ibuf->x, ibuf->y);
+  if (predivide) {
+    IMB_unpremultiply_rect_float(buffer, ibuf->channels, ibuf->x, num_rows);
   }
 
   /* convert float to byte */
-  IMB_buffer_byte_from_float((unsigned char *)ibuf->rect,
-                             buffer,
-                             ibuf->channels,
-                             ibuf->dither,
+  buffer_byte_from_float_rows(rect_to,
+                              buffer,
+                              ibuf->channels,
+                              ibuf->dither,
+                              IB_PROFILE_SRGB,
+                              IB_PROFILE_SRGB,
+                              false,
+                              ibuf->x,
+                              num_rows,
+                              ibuf->x,
+                              ibuf->x,
+                              start_y,
+                              ibuf->y);
+
+  MEM_freeN(buffer);
+}
+
+static void imb_rect_from_float_thread_do(void *data_v, int start_scanline, int num_scanlines)
+{
+  const ImBuf *ibuf = (const ImBuf *)data_v;
+  IMB_rect_from_float_rows(ibuf,
+                           (uchar *)ibuf->rect + ((size_t)start_scanline) * ibuf->x * 4,
+                           start_scanline,
+                           num_scanlines);
+}
+
+void IMB_rect_from_float(ImBuf *ibuf)
+{
+  /* verify we have a float buffer */
+  if (ibuf->rect_float == NULL) {
+    return;
+  }
+
+  /* create byte rect if it didn't exist yet */
+  if (ibuf->rect == NULL) {
+    if (imb_addrectImBuf(ibuf) == 0) {
+      return;
+    }
+  }
+
+  /* Convert in bands, avoids a temporary copy of the whole float buffer. */
+  if (((size_t)ibuf->x) * ibuf->y < 64 * 64) {
+    IMB_rect_from_float_rows(ibuf, (uchar *)ibuf->rect, 0, ibuf->y);
+  }
+  else {
+    IMB_processor_apply_threaded_scanlines(ibuf->y, imb_rect_from_float_thread_do, ibuf);
+  }
+
+  /* ensure user flag is reset */
+  ibuf->userflags &= ~IB_RECT_INVALID;
+}
+
+/* Byte to float conversion of rows [start_y, start_y + num_rows), see #IMB_float_from_rect. */
+static void imb_float_from_rect_rows(const ImBuf *ibuf,
+                                     float *rect_float,
+                                     int start_y,
+                                     int num_rows)
+{
+  const size_t offset = ((size_t)start_y) * ibuf->x * 4;
+  float *rect_to = rect_float + offset;
+
+  /* first, create float buffer in non-linear space */
+  IMB_buffer_float_from_byte(rect_to,
+                             (unsigned char *)ibuf->rect + offset,
                              IB_PROFILE_SRGB,
                              IB_PROFILE_SRGB,
                              false,
                              ibuf->x,
-                             ibuf->y,
+                             num_rows,
                              ibuf->x,
                              ibuf->x);
 
-  MEM_freeN(buffer);
+  /* then make float be in linear space */
+  IMB_colormanagement_colorspace_to_scene_linear(
+      rect_to, ibuf->x, num_rows, ibuf->channels, ibuf->rect_colorspace, false);
 
-  /* ensure user flag is reset */
-  ibuf->userflags &= ~IB_RECT_INVALID;
+  /* byte buffer is straight alpha, float should always be premul */
+  if (IMB_alpha_affects_rgb(ibuf)) {
+    IMB_premultiply_rect_float(rect_to, ibuf->channels, ibuf->x, num_rows);
+  }
+}
+
+typedef struct FloatFromRectThreadData {
+  const ImBuf *ibuf;
+  float *rect_float;
+} FloatFromRectThreadData;
+
+static void imb_float_from_rect_thread_do(void *data_v, int start_scanline, int num_scanlines)
+{
+  FloatFromRectThreadData *data = (FloatFromRectThreadData *)data_v;
+  imb_float_from_rect_rows(data->ibuf, data->rect_float, start_scanline, num_scanlines);
 }
 
 void IMB_float_from_rect(ImBuf *ibuf)
@@ -795,24 +980,14 @@ void IMB_float_from_rect(ImBuf *ibuf)
     }
   }
 
-  /* first, create float buffer in non-linear space */
-  IMB_buffer_float_from_byte(rect_float,
-                             (unsigned char *)ibuf->rect,
-                             IB_PROFILE_SRGB,
-                             IB_PROFILE_SRGB,
-                             false,
-                             ibuf->x,
-                             ibuf->y,
-                             ibuf->x,
-                             ibuf->x);
-
-  /* then make float be in linear space */
-  IMB_colormanagement_colorspace_to_scene_linear(
-      rect_float, ibuf->x, ibuf->y, ibuf->channels, ibuf->rect_colorspace, false);
-
-  /* byte buffer is straight alpha, float should always be premul */
-  if (IMB_alpha_affects_rgb(ibuf)) {
-    IMB_premultiply_rect_float(rect_float, ibuf->channels, ibuf->x, ibuf->y);
+  if (((size_t)ibuf->x) * ibuf->y < 64 * 64) {
+    imb_float_from_rect_rows(ibuf, rect_float, 0, ibuf->y);
+  }
+  else {
+    FloatFromRectThreadData data;
+    data.ibuf = ibuf;
+    data.rect_float = rect_float;
+    IMB_processor_apply_threaded_scanlines(ibuf->y, imb_float_from_rect_thread_do, &data);
   }
 
   if (ibuf->rect_float == NULL) {
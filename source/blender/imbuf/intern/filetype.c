@@ -72,7 +72,7 @@ const ImFileType IMB_FILE_TYPES[] = {
      NULL,
      imb_savepng,
      NULL,
-     0,
+     IM_FTYPE_BYTE_FROM_FLOAT,
      IMB_FTYPE_PNG,
      COLOR_ROLE_DEFAULT_BYTE},
     {NULL,
@@ -121,7 +121,7 @@ const ImFileType IMB_FILE_TYPES[] = {
      NULL,
      imb_save_dpx,
      NULL,
-     IM_FTYPE_FLOAT,
+     IM_FTYPE_FLOAT | IM_FTYPE_SLOW_DECODE,
      IMB_FTYPE_DPX,
      COLOR_ROLE_DEFAULT_FLOAT},
     {NULL,
@@ -133,7 +133,7 @@ const ImFileType IMB_FILE_TYPES[] = {
      NULL,
      imb_save_cineon,
      NULL,
-     IM_FTYPE_FLOAT,
+     IM_FTYPE_FLOAT | IM_FTYPE_SLOW_DECODE,
      IMB_FTYPE_CINEON,
      COLOR_ROLE_DEFAULT_FLOAT},
 #endif
@@ -147,7 +147,7 @@ const ImFileType IMB_FILE_TYPES[] = {
      NULL,
      imb_savetiff,
      imb_loadtiletiff,
-     0,
+     IM_FTYPE_SLOW_DECODE,
      IMB_FTYPE_TIF,
      COLOR_ROLE_DEFAULT_BYTE},
 #endif
@@ -189,7 +189,7 @@ const ImFileType IMB_FILE_TYPES[] = {
      NULL,
      imb_save_jp2,
      NULL,
-     IM_FTYPE_FLOAT,
+     IM_FTYPE_FLOAT | IM_FTYPE_SLOW_DECODE,
      IMB_FTYPE_JP2,
      COLOR_ROLE_DEFAULT_BYTE},
 #endif
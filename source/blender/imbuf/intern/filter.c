@@ -33,6 +33,10 @@
 
 #include "imbuf.h"
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 static void filtrow(unsigned char *point, int x)
 {
   unsigned int c1, c2, c3, error;
@@ -668,17 +672,26 @@ void IMB_premultiply_rect(unsigned int *rect, char planes, int w, int h)
 void IMB_premultiply_rect_float(float *rect_float, int channels, int w, int h)
 {
   float val, *cp;
-  int x, y;
+  size_t i = ((size_t)w) * h;
 
   if (channels == 4) {
     cp = rect_float;
-    for (y = 0; y < h; y++) {
-      for (x = 0; x < w; x++, cp += 4) {
-        val = cp[3];
-        cp[0] = cp[0] * val;
-        cp[1] = cp[1] * val;
-        cp[2] = cp[2] * val;
-      }
+#ifdef __SSE2__
+    const __m128 mask_rgb = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 one_alpha = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+    for (; i > 0; i--, cp += 4) {
+      const __m128 color = _mm_loadu_ps(cp);
+      const __m128 alpha = _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3));
+      /* Multiply by (alpha, alpha, alpha, 1). */
+      const __m128 fac = _mm_or_ps(_mm_and_ps(mask_rgb, alpha), one_alpha);
+      _mm_storeu_ps(cp, _mm_mul_ps(color, fac));
+    }
+#endif
+    for (; i > 0; i--, cp += 4) {
+      val = cp[3];
+      cp[0] = cp[0] * val;
+      cp[1] = cp[1] * val;
+      cp[2] = cp[2] * val;
     }
   }
 }
@@ -730,17 +743,28 @@ void IMB_unpremultiply_rect(unsigned int *rect, char planes, int w, int h)
 void IMB_unpremultiply_rect_float(float *rect_float, int channels, int w, int h)
 {
   float val, *fp;
-  int x, y;
+  size_t i = ((size_t)w) * h;
 
   if (channels == 4) {
     fp = rect_float;
-    for (y = 0; y < h; y++) {
-      for (x = 0; x < w; x++, fp += 4) {
-        val = fp[3] != 0.0f ? 1.0f / fp[3] : 1.0f;
-        fp[0] = fp[0] * val;
-        fp[1] = fp[1] * val;
-        fp[2] = fp[2] * val;
-      }
+#ifdef __SSE2__
+    const __m128 mask_rgb = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i > 0; i--, fp += 4) {
+      const __m128 color = _mm_loadu_ps(fp);
+      const __m128 alpha = _mm_shuffle_ps(color, color, _MM_SHUFFLE(3, 3, 3, 3));
+      /* Multiply by (1 / alpha, 1 / alpha, 1 / alpha, 1), leaving zero alpha untouched. */
+      const __m128 use_inv = _mm_andnot_ps(_mm_cmpeq_ps(alpha, _mm_setzero_ps()), mask_rgb);
+      const __m128 inv = _mm_div_ps(one, alpha);
+      const __m128 fac = _mm_or_ps(_mm_and_ps(use_inv, inv), _mm_andnot_ps(use_inv, one));
+      _mm_storeu_ps(fp, _mm_mul_ps(color, fac));
+    }
+#endif
+    for (; i > 0; i--, fp += 4) {
+      val = fp[3] != 0.0f ? 1.0f / fp[3] : 1.0f;
+      fp[0] = fp[0] * val;
+      fp[1] = fp[1] * val;
+      fp[2] = fp[2] * val;
     }
   }
 }
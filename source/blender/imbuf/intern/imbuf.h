@@ -62,4 +62,7 @@
 
 #define IMB_DPI_DEFAULT 72.0f
 
+/* Number of rows converted at once when converting or writing images in bands. */
+#define IMB_RECT_FROM_FLOAT_BAND_ROWS 64
+
 #endif /* __IMBUF_H__ */
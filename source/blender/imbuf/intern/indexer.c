@@ -1121,7 +1121,7 @@ static void index_rebuild_fallback(FallbackIndexBuilderContext *context,
 
         struct ImBuf *s_ibuf = IMB_dupImBuf(tmp_ibuf);
 
-        IMB_scalefastImBuf(s_ibuf, x, y);
+        IMB_scaleImBuf(s_ibuf, x, y);
 
         IMB_convert_rgba_to_abgr(s_ibuf);
 
@@ -27,6 +27,7 @@
 
 #include "BLI_fileops.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_global.h"
@@ -44,6 +45,8 @@
 #include "IMB_colormanagement.h"
 #include "IMB_colormanagement_intern.h"
 
+#include "imbuf.h"
+
 typedef struct PNGReadStruct {
   const unsigned char *data;
   unsigned int size;
@@ -119,120 +122,51 @@ BLI_INLINE unsigned short ftoshort(float val)
   return unit_float_to_ushort_clamp(val);
 }
 
-int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
-{
-  png_structp png_ptr;
-  png_infop info_ptr;
-
-  unsigned char *pixels = NULL;
-  unsigned char *from, *to;
-  unsigned short *pixels16 = NULL, *to16;
-  float *from_float, from_straight[4];
-  png_bytepp row_pointers = NULL;
-  int i, bytesperpixel, color_type = PNG_COLOR_TYPE_GRAY;
-  FILE *fp = NULL;
-
-  bool is_16bit = (ibuf->foptions.flag & PNG_16BIT) != 0;
-  bool has_float = (ibuf->rect_float != NULL);
-  int channels_in_float = ibuf->channels ? ibuf->channels : 4;
-
+/* Pixels are converted and handed to libpng in bands of rows, so no copy of the whole image
+ * has to be made. The next band is converted in a task while libpng compresses the current one.
+ */
+typedef struct PNGWriteBands {
+  const ImBuf *ibuf;
+  int bytesperpixel;
+  bool is_16bit;
+  int channels_in_float;
   float (*chanel_colormanage_cb)(float);
-  size_t num_bytes;
-
-  /* use the jpeg quality setting for compression */
-  int compression;
-  compression = (int)(((float)(ibuf->foptions.quality) / 11.1111f));
-  compression = compression < 0 ? 0 : (compression > 9 ? 9 : compression);
-
-  if (ibuf->float_colorspace || (ibuf->colormanage_flag & IMB_COLORMANAGE_IS_DATA)) {
-    /* float buffer was managed already, no need in color space conversion */
-    chanel_colormanage_cb = channel_colormanage_noop;
-  }
-  else {
-    /* standard linear-to-srgb conversion if float buffer wasn't managed */
-    chanel_colormanage_cb = linearrgb_to_srgb;
-  }
-
-  /* for prints */
-  if (flags & IB_mem) {
-    name = "<memory>";
-  }
-
-  bytesperpixel = (ibuf->planes + 7) >> 3;
-  if ((bytesperpixel > 4) || (bytesperpixel == 2)) {
-    printf("imb_savepng: Unsupported bytes per pixel: %d for file: '%s'\n", bytesperpixel, name);
-    return (0);
-  }
-
-  png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-  if (png_ptr == NULL) {
-    printf("imb_savepng: Cannot png_create_write_struct for file: '%s'\n", name);
-    return 0;
-  }
-
-  info_ptr = png_create_info_struct(png_ptr);
-  if (info_ptr == NULL) {
-    png_destroy_write_struct(&png_ptr, (png_infopp)NULL);
-    printf("imb_savepng: Cannot png_create_info_struct for file: '%s'\n", name);
-    return 0;
-  }
-
-  /* copy image data */
-  num_bytes = ((size_t)ibuf->x) * ibuf->y * bytesperpixel;
-  if (is_16bit) {
-    pixels16 = MEM_mallocN(num_bytes * sizeof(unsigned short), "png 16bit pixels");
-  }
-  else {
-    pixels = MEM_mallocN(num_bytes * sizeof(unsigned char), "png 8bit pixels");
-  }
-  if (pixels == NULL && pixels16 == NULL) {
-    printf(
-        "imb_savepng: Cannot allocate pixels array of %dx%d, %d bytes per pixel for file: "
-        "'%s'\n",
-        ibuf->x,
-        ibuf->y,
-        bytesperpixel,
-        name);
-  }
-
-  /* allocate memory for an array of row-pointers */
-  row_pointers = (png_bytepp)MEM_mallocN(ibuf->y * sizeof(png_bytep), "row_pointers");
-  if (row_pointers == NULL) {
-    printf("imb_savepng: Cannot allocate row-pointers array for file '%s'\n", name);
-  }
-
-  if ((pixels == NULL && pixels16 == NULL) || (row_pointers == NULL) ||
-      setjmp(png_jmpbuf(png_ptr))) {
-    /* On error jump here, and free any resources. */
-    png_destroy_write_struct(&png_ptr, &info_ptr);
-    if (pixels) {
-      MEM_freeN(pixels);
-    }
-    if (pixels16) {
-      MEM_freeN(pixels16);
-    }
-    if (row_pointers) {
-      MEM_freeN(row_pointers);
-    }
-    if (fp) {
-      fflush(fp);
-      fclose(fp);
-    }
-    return 0;
-  }
-
-  from = (unsigned char *)ibuf->rect;
-  to = pixels;
-  from_float = ibuf->rect_float;
-  to16 = pixels16;
 
-  switch (bytesperpixel) {
+  /* Rows per band and number of bands. */
+  int band_rows;
+  int tot_bands;
+  /* Size of one converted row in bytes. */
+  size_t row_size;
+
+  /* Two bands, one being converted while the other is written. */
+  unsigned char *pixels[2];
+  /* Byte rows for 8 bit output of images without byte buffer. */
+  unsigned char *rect_band[2];
+
+  /* Converts the next band while rows are written, NULL when not converting in bands. */
+  TaskPool *task_pool;
+} PNGWriteBands;
+
+/* Convert one row, either from \a from or \a from_float. */
+static void imb_savepng_convert_row(const PNGWriteBands *bands,
+                                    const unsigned char *from,
+                                    const float *from_float,
+                                    void *row)
+{
+  const ImBuf *ibuf = bands->ibuf;
+  const int channels_in_float = bands->channels_in_float;
+  float (*chanel_colormanage_cb)(float) = bands->chanel_colormanage_cb;
+  unsigned char *to = row;
+  unsigned short *to16 = row;
+  float from_straight[4];
+  int i;
+
+  switch (bands->bytesperpixel) {
     case 4:
-      color_type = PNG_COLOR_TYPE_RGBA;
-      if (is_16bit) {
-        if (has_float) {
+      if (bands->is_16bit) {
+        if (from_float) {
           if (channels_in_float == 4) {
-            for (i = ibuf->x * ibuf->y; i > 0; i--) {
+            for (i = ibuf->x; i > 0; i--) {
               premul_to_straight_v4_v4(from_straight, from_float);
               to16[0] = ftoshort(chanel_colormanage_cb(from_straight[0]));
               to16[1] = ftoshort(chanel_colormanage_cb(from_straight[1]));
@@ -243,7 +177,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
             }
           }
           else if (channels_in_float == 3) {
-            for (i = ibuf->x * ibuf->y; i > 0; i--) {
+            for (i = ibuf->x; i > 0; i--) {
               to16[0] = ftoshort(chanel_colormanage_cb(from_float[0]));
               to16[1] = ftoshort(chanel_colormanage_cb(from_float[1]));
               to16[2] = ftoshort(chanel_colormanage_cb(from_float[2]));
@@ -253,7 +187,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
             }
           }
           else {
-            for (i = ibuf->x * ibuf->y; i > 0; i--) {
+            for (i = ibuf->x; i > 0; i--) {
               to16[0] = ftoshort(chanel_colormanage_cb(from_float[0]));
               to16[2] = to16[1] = to16[0];
               to16[3] = 65535;
@@ -263,7 +197,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
           }
         }
         else {
-          for (i = ibuf->x * ibuf->y; i > 0; i--) {
+          for (i = ibuf->x; i > 0; i--) {
             to16[0] = UPSAMPLE_8_TO_16(from[0]);
             to16[1] = UPSAMPLE_8_TO_16(from[1]);
             to16[2] = UPSAMPLE_8_TO_16(from[2]);
@@ -274,22 +208,14 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
         }
       }
       else {
-        for (i = ibuf->x * ibuf->y; i > 0; i--) {
-          to[0] = from[0];
-          to[1] = from[1];
-          to[2] = from[2];
-          to[3] = from[3];
-          to += 4;
-          from += 4;
-        }
+        memcpy(to, from, sizeof(unsigned char) * 4 * ibuf->x);
       }
       break;
     case 3:
-      color_type = PNG_COLOR_TYPE_RGB;
-      if (is_16bit) {
-        if (has_float) {
+      if (bands->is_16bit) {
+        if (from_float) {
           if (channels_in_float == 4) {
-            for (i = ibuf->x * ibuf->y; i > 0; i--) {
+            for (i = ibuf->x; i > 0; i--) {
               premul_to_straight_v4_v4(from_straight, from_float);
               to16[0] = ftoshort(chanel_colormanage_cb(from_straight[0]));
               to16[1] = ftoshort(chanel_colormanage_cb(from_straight[1]));
@@ -299,7 +225,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
             }
           }
           else if (channels_in_float == 3) {
-            for (i = ibuf->x * ibuf->y; i > 0; i--) {
+            for (i = ibuf->x; i > 0; i--) {
               to16[0] = ftoshort(chanel_colormanage_cb(from_float[0]));
               to16[1] = ftoshort(chanel_colormanage_cb(from_float[1]));
               to16[2] = ftoshort(chanel_colormanage_cb(from_float[2]));
@@ -308,7 +234,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
             }
           }
           else {
-            for (i = ibuf->x * ibuf->y; i > 0; i--) {
+            for (i = ibuf->x; i > 0; i--) {
               to16[0] = ftoshort(chanel_colormanage_cb(from_float[0]));
               to16[2] = to16[1] = to16[0];
               to16 += 3;
@@ -317,7 +243,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
           }
         }
         else {
-          for (i = ibuf->x * ibuf->y; i > 0; i--) {
+          for (i = ibuf->x; i > 0; i--) {
             to16[0] = UPSAMPLE_8_TO_16(from[0]);
             to16[1] = UPSAMPLE_8_TO_16(from[1]);
             to16[2] = UPSAMPLE_8_TO_16(from[2]);
@@ -327,7 +253,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
         }
       }
       else {
-        for (i = ibuf->x * ibuf->y; i > 0; i--) {
+        for (i = ibuf->x; i > 0; i--) {
           to[0] = from[0];
           to[1] = from[1];
           to[2] = from[2];
@@ -337,12 +263,11 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
       }
       break;
     case 1:
-      color_type = PNG_COLOR_TYPE_GRAY;
-      if (is_16bit) {
-        if (has_float) {
+      if (bands->is_16bit) {
+        if (from_float) {
           float rgb[3];
           if (channels_in_float == 4) {
-            for (i = ibuf->x * ibuf->y; i > 0; i--) {
+            for (i = ibuf->x; i > 0; i--) {
               premul_to_straight_v4_v4(from_straight, from_float);
               rgb[0] = chanel_colormanage_cb(from_straight[0]);
               rgb[1] = chanel_colormanage_cb(from_straight[1]);
@@ -353,7 +278,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
             }
           }
           else if (channels_in_float == 3) {
-            for (i = ibuf->x * ibuf->y; i > 0; i--) {
+            for (i = ibuf->x; i > 0; i--) {
               rgb[0] = chanel_colormanage_cb(from_float[0]);
               rgb[1] = chanel_colormanage_cb(from_float[1]);
               rgb[2] = chanel_colormanage_cb(from_float[2]);
@@ -363,7 +288,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
             }
           }
           else {
-            for (i = ibuf->x * ibuf->y; i > 0; i--) {
+            for (i = ibuf->x; i > 0; i--) {
               to16[0] = ftoshort(chanel_colormanage_cb(from_float[0]));
               to16++;
               from_float++;
@@ -371,7 +296,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
           }
         }
         else {
-          for (i = ibuf->x * ibuf->y; i > 0; i--) {
+          for (i = ibuf->x; i > 0; i--) {
             to16[0] = UPSAMPLE_8_TO_16(from[0]);
             to16++;
             from += 4;
@@ -379,7 +304,7 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
         }
       }
       else {
-        for (i = ibuf->x * ibuf->y; i > 0; i--) {
+        for (i = ibuf->x; i > 0; i--) {
           to[0] = from[0];
           to++;
           from += 4;
@@ -387,6 +312,218 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
       }
       break;
   }
+}
+
+/* PNG rows are stored top to bottom, image buffer rows bottom to top. */
+static void imb_savepng_band_rows(const PNGWriteBands *bands, int band, int *r_y, int *r_num)
+{
+  const int png_start = band * bands->band_rows;
+  const int num = min_ii(bands->band_rows, bands->ibuf->y - png_start);
+
+  *r_y = bands->ibuf->y - png_start - num;
+  *r_num = num;
+}
+
+static void imb_savepng_convert_band(const PNGWriteBands *bands, int band)
+{
+  const ImBuf *ibuf = bands->ibuf;
+  const int slot = band & 1;
+  const bool from_float = bands->is_16bit && ibuf->rect_float != NULL;
+  unsigned char *rect_band = NULL;
+  int y, num;
+
+  imb_savepng_band_rows(bands, band, &y, &num);
+
+  if (!from_float && ibuf->rect == NULL) {
+    /* Color manage and dither these rows only. */
+    rect_band = bands->rect_band[slot];
+    IMB_rect_from_float_rows(ibuf, rect_band, y, num);
+  }
+
+  for (int i = 0; i < num; i++) {
+    const int row = y + num - 1 - i;
+    void *to = bands->pixels[slot] + bands->row_size * i;
+
+    if (from_float) {
+      imb_savepng_convert_row(
+          bands, NULL, ibuf->rect_float + ((size_t)row) * ibuf->x * bands->channels_in_float, to);
+    }
+    else if (rect_band) {
+      imb_savepng_convert_row(bands, rect_band + ((size_t)(row - y)) * ibuf->x * 4, NULL, to);
+    }
+    else {
+      imb_savepng_convert_row(
+          bands, (const unsigned char *)ibuf->rect + ((size_t)row) * ibuf->x * 4, NULL, to);
+    }
+  }
+}
+
+static void imb_savepng_convert_band_task(TaskPool *__restrict pool, void *taskdata)
+{
+  const PNGWriteBands *bands = BLI_task_pool_user_data(pool);
+  imb_savepng_convert_band(bands, POINTER_AS_INT(taskdata));
+}
+
+/* Zero copy case: byte buffer rows can be handed to libpng as they are. */
+static bool imb_savepng_use_rect_rows(const PNGWriteBands *bands)
+{
+  return !bands->is_16bit && bands->bytesperpixel == 4 && bands->ibuf->rect != NULL;
+}
+
+static void imb_savepng_write_rows(png_structp png_ptr, PNGWriteBands *bands)
+{
+  const ImBuf *ibuf = bands->ibuf;
+  png_bytep row_pointers[IMB_RECT_FROM_FLOAT_BAND_ROWS];
+  int y, num;
+
+  if (imb_savepng_use_rect_rows(bands)) {
+    for (int band = 0; band < bands->tot_bands; band++) {
+      imb_savepng_band_rows(bands, band, &y, &num);
+      for (int i = 0; i < num; i++) {
+        row_pointers[i] = (png_bytep)(ibuf->rect + ((size_t)(y + num - 1 - i)) * ibuf->x);
+      }
+      png_write_rows(png_ptr, row_pointers, num);
+    }
+    return;
+  }
+
+  /* Stored in the bands, so the error handler can wait for the conversion task on a libpng
+   * error longjmp out of png_write_rows(). */
+  TaskPool *task_pool = BLI_task_pool_create(bands, TASK_PRIORITY_HIGH);
+  bands->task_pool = task_pool;
+
+  imb_savepng_convert_band(bands, 0);
+
+  for (int band = 0; band < bands->tot_bands; band++) {
+    const int slot = band & 1;
+
+    if (band + 1 < bands->tot_bands) {
+      BLI_task_pool_push(
+          task_pool, imb_savepng_convert_band_task, POINTER_FROM_INT(band + 1), false, NULL);
+    }
+
+    imb_savepng_band_rows(bands, band, &y, &num);
+    for (int i = 0; i < num; i++) {
+      row_pointers[i] = (png_bytep)(bands->pixels[slot] + bands->row_size * i);
+    }
+    png_write_rows(png_ptr, row_pointers, num);
+
+    BLI_task_pool_work_and_wait(task_pool);
+  }
+
+  BLI_task_pool_free(task_pool);
+  bands->task_pool = NULL;
+}
+
+int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
+{
+  png_structp png_ptr;
+  png_infop info_ptr;
+
+  PNGWriteBands bands = {NULL};
+  int bytesperpixel, color_type = PNG_COLOR_TYPE_GRAY;
+  FILE *fp = NULL;
+
+  bool is_16bit = (ibuf->foptions.flag & PNG_16BIT) != 0;
+  int channels_in_float = ibuf->channels ? ibuf->channels : 4;
+
+  float (*chanel_colormanage_cb)(float);
+
+  /* use the jpeg quality setting for compression */
+  int compression;
+  compression = (int)(((float)(ibuf->foptions.quality) / 11.1111f));
+  compression = compression < 0 ? 0 : (compression > 9 ? 9 : compression);
+
+  if (ibuf->float_colorspace || (ibuf->colormanage_flag & IMB_COLORMANAGE_IS_DATA)) {
+    /* float buffer was managed already, no need in color space conversion */
+    chanel_colormanage_cb = channel_colormanage_noop;
+  }
+  else {
+    /* standard linear-to-srgb conversion if float buffer wasn't managed */
+    chanel_colormanage_cb = linearrgb_to_srgb;
+  }
+
+  /* for prints */
+  if (flags & IB_mem) {
+    name = "<memory>";
+  }
+
+  bytesperpixel = (ibuf->planes + 7) >> 3;
+  if ((bytesperpixel > 4) || (bytesperpixel == 2)) {
+    printf("imb_savepng: Unsupported bytes per pixel: %d for file: '%s'\n", bytesperpixel, name);
+    return (0);
+  }
+
+  if (ibuf->rect == NULL &&
+      (ibuf->rect_float == NULL || (!is_16bit && ibuf->rect_colorspace == NULL))) {
+    printf("imb_savepng: No pixels to write for file: '%s'\n", name);
+    return (0);
+  }
+
+  switch (bytesperpixel) {
+    case 4:
+      color_type = PNG_COLOR_TYPE_RGBA;
+      break;
+    case 3:
+      color_type = PNG_COLOR_TYPE_RGB;
+      break;
+    case 1:
+      color_type = PNG_COLOR_TYPE_GRAY;
+      break;
+  }
+
+  png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+  if (png_ptr == NULL) {
+    printf("imb_savepng: Cannot png_create_write_struct for file: '%s'\n", name);
+    return 0;
+  }
+
+  info_ptr = png_create_info_struct(png_ptr);
+  if (info_ptr == NULL) {
+    png_destroy_write_struct(&png_ptr, (png_infopp)NULL);
+    printf("imb_savepng: Cannot png_create_info_struct for file: '%s'\n", name);
+    return 0;
+  }
+
+  /* allocate band buffers */
+  bands.ibuf = ibuf;
+  bands.bytesperpixel = bytesperpixel;
+  bands.is_16bit = is_16bit;
+  bands.channels_in_float = channels_in_float;
+  bands.chanel_colormanage_cb = chanel_colormanage_cb;
+  bands.band_rows = IMB_RECT_FROM_FLOAT_BAND_ROWS;
+  bands.tot_bands = (ibuf->y + bands.band_rows - 1) / bands.band_rows;
+  bands.row_size = ((size_t)ibuf->x) * bytesperpixel *
+                   (is_16bit ? sizeof(unsigned short) : sizeof(unsigned char));
+
+  if (!imb_savepng_use_rect_rows(&bands)) {
+    for (int i = 0; i < 2; i++) {
+      bands.pixels[i] = MEM_mallocN(bands.row_size * bands.band_rows, "png band pixels");
+      if (!(is_16bit && ibuf->rect_float) && ibuf->rect == NULL) {
+        bands.rect_band[i] = MEM_mallocN(((size_t)ibuf->x) * bands.band_rows * 4,
+                                         "png band rect");
+      }
+    }
+  }
+
+  if (setjmp(png_jmpbuf(png_ptr))) {
+    /* On error jump here, and free any resources. */
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    if (bands.task_pool) {
+      /* A band may still be converted into the buffers freed below. */
+      BLI_task_pool_work_and_wait(bands.task_pool);
+      BLI_task_pool_free(bands.task_pool);
+    }
+    for (int i = 0; i < 2; i++) {
+      MEM_SAFE_FREE(bands.pixels[i]);
+      MEM_SAFE_FREE(bands.rect_band[i]);
+    }
+    if (fp) {
+      fflush(fp);
+      fclose(fp);
+    }
+    return 0;
+  }
 
   if (flags & IB_mem) {
     /* create image in memory */
@@ -399,11 +536,9 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
     fp = BLI_fopen(name, "wb");
     if (!fp) {
       png_destroy_write_struct(&png_ptr, &info_ptr);
-      if (pixels) {
-        MEM_freeN(pixels);
-      }
-      if (pixels16) {
-        MEM_freeN(pixels16);
+      for (int i = 0; i < 2; i++) {
+        MEM_SAFE_FREE(bands.pixels[i]);
+        MEM_SAFE_FREE(bands.rect_band[i]);
       }
       printf("imb_savepng: Cannot open file for writing: '%s'\n", name);
       return 0;
@@ -475,35 +610,17 @@ int imb_savepng(struct ImBuf *ibuf, const char *name, int flags)
   png_set_swap(png_ptr);
 #endif
 
-  /* set the individual row-pointers to point at the correct offsets */
-  if (is_16bit) {
-    for (i = 0; i < ibuf->y; i++) {
-      row_pointers[ibuf->y - 1 - i] = (png_bytep)((unsigned short *)pixels16 +
-                                                  (((size_t)i) * ibuf->x) * bytesperpixel);
-    }
-  }
-  else {
-    for (i = 0; i < ibuf->y; i++) {
-      row_pointers[ibuf->y - 1 - i] = (png_bytep)((unsigned char *)pixels +
-                                                  (((size_t)i) * ibuf->x) * bytesperpixel *
-                                                      sizeof(unsigned char));
-    }
-  }
-
-  /* write out the entire image data in one call */
-  png_write_image(png_ptr, row_pointers);
+  /* write out the image data in bands */
+  imb_savepng_write_rows(png_ptr, &bands);
 
   /* write the additional chunks to the PNG file (not really needed) */
   png_write_end(png_ptr, info_ptr);
 
   /* clean up */
-  if (pixels) {
-    MEM_freeN(pixels);
-  }
-  if (pixels16) {
-    MEM_freeN(pixels16);
+  for (int i = 0; i < 2; i++) {
+    MEM_SAFE_FREE(bands.pixels[i]);
+    MEM_SAFE_FREE(bands.rect_band[i]);
   }
-  MEM_freeN(row_pointers);
   png_destroy_write_struct(&png_ptr, &info_ptr);
 
   if (fp) {
@@ -222,16 +222,37 @@ static void imb_cache_filename(char *filename, const char *name, int flags)
   BLI_strncpy(filename, name, IMB_FILENAME_SIZE);
 }
 
+/* Loads which can use the decode cache, tiles and thumbnails are read differently. */
+static bool imb_use_decode_cache(int flags)
+{
+  return (flags & (IB_test | IB_tilecache | IB_thumbnail | IB_multiview)) == 0;
+}
+
 ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_SPACE])
 {
   ImBuf *ibuf;
   int file, a;
   char filepath_tx[IMB_FILENAME_SIZE];
+  char colorspace_in[IM_MAX_SPACE] = "";
+  const bool use_decode_cache = imb_use_decode_cache(flags) && imb_decode_cache_is_enabled();
 
   BLI_assert(!BLI_path_is_rel(filepath));
 
   imb_cache_filename(filepath_tx, filepath, flags);
 
+  if (use_decode_cache) {
+    if (colorspace) {
+      BLI_strncpy(colorspace_in, colorspace, sizeof(colorspace_in));
+    }
+
+    ibuf = imb_decode_cache_load(filepath_tx, flags, colorspace);
+    if (ibuf) {
+      BLI_strncpy(ibuf->name, filepath, sizeof(ibuf->name));
+      BLI_strncpy(ibuf->cachename, filepath_tx, sizeof(ibuf->cachename));
+      return ibuf;
+    }
+  }
+
   file = BLI_open(filepath_tx, O_BINARY | O_RDONLY, 0);
   if (file == -1) {
     return NULL;
@@ -239,6 +260,11 @@ ImBuf *IMB_loadiffname(const char *filepath, int flags, char colorspace[IM_MAX_S
 
   ibuf = IMB_loadifffile(file, filepath, flags, colorspace, filepath_tx);
 
+  if (ibuf && use_decode_cache) {
+    imb_decode_cache_store(
+        filepath_tx, flags, colorspace_in, colorspace ? colorspace : colorspace_in, ibuf);
+  }
+
   if (ibuf) {
     BLI_strncpy(ibuf->name, filepath, sizeof(ibuf->name));
     BLI_strncpy(ibuf->cachename, filepath_tx, sizeof(ibuf->cachename));
@@ -0,0 +1,217 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup imbuf
+ *
+ * Batched thumbnail generation.
+ *
+ * Requests are kept in a heap ordered by priority. Every request pushes one task into a
+ * background task pool, but a task does not process 'its' request: it takes the one with the
+ * lowest priority value still pending. That way requests pushed late with a low value (e.g.
+ * the items currently visible in the file browser) are handled before older ones, while
+ * decoding and scaling still runs on as many threads as the pool provides.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_heap_simple.h"
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+#include "IMB_thumbs.h"
+
+typedef struct ThumbBatchRequest {
+  char *path;
+  ThumbSource source;
+  int id;
+  struct ImBuf *img;
+} ThumbBatchRequest;
+
+struct ThumbBatch {
+  TaskPool *pool;
+  ThumbSize size;
+
+  /* Pending requests, protected by `mutex`. */
+  HeapSimple *pending;
+  /* Processed requests, ready to be popped by the owner. */
+  ThreadQueue *done;
+
+  ThreadMutex mutex;
+  /* Counts since the last cancel, protected by `mutex`. */
+  int tot_requested;
+  int tot_processed;
+};
+
+static void thumb_batch_request_free(void *request_v)
+{
+  ThumbBatchRequest *request = request_v;
+
+  if (request->img) {
+    IMB_freeImBuf(request->img);
+  }
+  MEM_freeN(request->path);
+  MEM_freeN(request);
+}
+
+static void thumb_batch_task_run(TaskPool *__restrict pool, void *UNUSED(taskdata))
+{
+  ThumbBatch *batch = BLI_task_pool_user_data(pool);
+  ThumbBatchRequest *request = NULL;
+
+  BLI_mutex_lock(&batch->mutex);
+  if (!BLI_heapsimple_is_empty(batch->pending)) {
+    request = BLI_heapsimple_pop_min(batch->pending);
+  }
+  BLI_mutex_unlock(&batch->mutex);
+
+  if (request == NULL) {
+    return;
+  }
+
+  if (BLI_task_pool_canceled(pool)) {
+    thumb_batch_request_free(request);
+    return;
+  }
+
+  IMB_thumb_path_lock(request->path);
+  request->img = IMB_thumb_manage(request->path, batch->size, request->source);
+  IMB_thumb_path_unlock(request->path);
+
+  /* Push before counting, see #IMB_thumb_batch_is_done. */
+  BLI_thread_queue_push(batch->done, request);
+
+  BLI_mutex_lock(&batch->mutex);
+  batch->tot_processed++;
+  BLI_mutex_unlock(&batch->mutex);
+}
+
+ThumbBatch *IMB_thumb_batch_create(ThumbSize size)
+{
+  ThumbBatch *batch = MEM_callocN(sizeof(*batch), __func__);
+
+  batch->size = size;
+  batch->pending = BLI_heapsimple_new();
+  batch->done = BLI_thread_queue_init();
+  BLI_mutex_init(&batch->mutex);
+  batch->pool = BLI_task_pool_create_background(batch, TASK_PRIORITY_LOW);
+
+  IMB_thumb_locks_acquire();
+
+  return batch;
+}
+
+void IMB_thumb_batch_free(ThumbBatch *batch)
+{
+  BLI_thread_queue_nowait(batch->done);
+  IMB_thumb_batch_cancel(batch);
+
+  BLI_task_pool_free(batch->pool);
+  BLI_heapsimple_free(batch->pending, thumb_batch_request_free);
+  BLI_thread_queue_free(batch->done);
+  BLI_mutex_end(&batch->mutex);
+
+  IMB_thumb_locks_release();
+
+  MEM_freeN(batch);
+}
+
+/**
+ * Queue a thumbnail request. Requests with a lower \a priority value are processed first,
+ * \a id is returned along with the result by #IMB_thumb_batch_pop_done.
+ */
+void IMB_thumb_batch_push(
+    ThumbBatch *batch, const char *path, ThumbSource source, int id, float priority)
+{
+  ThumbBatchRequest *request = MEM_mallocN(sizeof(*request), __func__);
+
+  request->path = BLI_strdup(path);
+  request->source = source;
+  request->id = id;
+  request->img = NULL;
+
+  BLI_mutex_lock(&batch->mutex);
+  BLI_heapsimple_insert(batch->pending, priority, request);
+  batch->tot_requested++;
+  BLI_mutex_unlock(&batch->mutex);
+
+  BLI_task_pool_push(batch->pool, thumb_batch_task_run, NULL, false, NULL);
+}
+
+/**
+ * Get one processed request, without blocking.
+ *
+ * \param r_img: The thumbnail, owned by the caller. NULL when it could not be generated.
+ * \return false when no processed request is available.
+ */
+bool IMB_thumb_batch_pop_done(ThumbBatch *batch, int *r_id, struct ImBuf **r_img)
+{
+  ThumbBatchRequest *request = BLI_thread_queue_pop_timeout(batch->done, 0);
+
+  if (request == NULL) {
+    return false;
+  }
+
+  *r_id = request->id;
+  *r_img = request->img;
+  request->img = NULL;
+  thumb_batch_request_free(request);
+
+  return true;
+}
+
+/**
+ * Drop all pending requests and processed results, waits for running ones to finish.
+ * The batch can be reused afterwards.
+ */
+void IMB_thumb_batch_cancel(ThumbBatch *batch)
+{
+  ThumbBatchRequest *request;
+
+  BLI_task_pool_cancel(batch->pool);
+
+  BLI_mutex_lock(&batch->mutex);
+  BLI_heapsimple_clear(batch->pending, thumb_batch_request_free);
+  batch->tot_requested = 0;
+  batch->tot_processed = 0;
+  BLI_mutex_unlock(&batch->mutex);
+
+  while ((request = BLI_thread_queue_pop_timeout(batch->done, 0))) {
+    thumb_batch_request_free(request);
+  }
+}
+
+/**
+ * True once every request has been processed and all results were popped. Results are pushed
+ * before being counted, so none can arrive after this returned true.
+ */
+bool IMB_thumb_batch_is_done(ThumbBatch *batch)
+{
+  bool is_done;
+
+  BLI_mutex_lock(&batch->mutex);
+  is_done = (batch->tot_processed == batch->tot_requested) &&
+            BLI_thread_queue_is_empty(batch->done);
+  BLI_mutex_unlock(&batch->mutex);
+
+  return is_done;
+}
@@ -38,6 +38,12 @@
 
 static bool prepare_write_imbuf(const ImFileType *type, ImBuf *ibuf)
 {
+  if ((type->flag & IM_FTYPE_BYTE_FROM_FLOAT) && ibuf->rect == NULL && ibuf->rect_float) {
+    /* Converted while writing, avoids holding a full byte copy of the image. */
+    ibuf->rect_colorspace = colormanage_colorspace_get_roled(COLOR_ROLE_DEFAULT_BYTE);
+    return false;
+  }
+
   return IMB_prepare_write_ImBuf((type->flag & IM_FTYPE_FLOAT), ibuf);
 }
 
@@ -1079,6 +1079,8 @@ typedef struct AnimData {
 
   /** Runtime data, for depsgraph evaluation. */
   FCurve **driver_array;
+  /** Runtime data, active action channels with resolved RNA paths, see anim_sys.c. */
+  struct ActionEvalCache *action_eval_cache;
 
   /* settings for animation evaluation */
   /** User-defined settings. */
@@ -54,6 +54,11 @@ typedef struct CustomDataLayer {
   char name[64];
   /** Layer data. */
   void *data;
+  /**
+   * Runtime only: reference count of the data when it is shared with other layers,
+   * see #CD_SHARE. NULL when the layer is the only owner of its data.
+   */
+  void *sharing_info;
 } CustomDataLayer;
 
 #define MAX_CUSTOMDATA_LAYER_NAME 64
@@ -76,8 +81,7 @@ typedef struct CustomData {
    * MUST be >= CD_NUMTYPES, but we cant use a define here.
    * Correct size is ensured in CustomData_update_typemap assert().
    */
-  int typemap[48];
-  char _pad[4];
+  int typemap[51];
   /** Number of layers, size of layers array. */
   int totlayer, maxlayer;
   /** In editmode, total size of all data layers. */
@@ -155,8 +159,12 @@ typedef enum CustomDataType {
   CD_HAIRMAPPING = 46,
 
   CD_PROP_COLOR = 47,
+  CD_PROP_FLOAT3 = 48,
+  /* Numbered like upstream so files from either keep their layer types. */
+  CD_PROP_FLOAT2 = 49,
+  CD_PROP_BOOL = 50,
 
-  CD_NUMTYPES = 48,
+  CD_NUMTYPES = 51,
 } CustomDataType;
 
 /* Bits for CustomDataMask */
@@ -206,9 +214,14 @@ typedef enum CustomDataType {
 #define CD_MASK_CUSTOMLOOPNORMAL (1LL << CD_CUSTOMLOOPNORMAL)
 #define CD_MASK_SCULPT_FACE_SETS (1LL << CD_SCULPT_FACE_SETS)
 #define CD_MASK_PROP_COLOR (1LL << CD_PROP_COLOR)
+#define CD_MASK_PROP_FLOAT3 (1LL << CD_PROP_FLOAT3)
+#define CD_MASK_PROP_FLOAT2 (1LL << CD_PROP_FLOAT2)
+#define CD_MASK_PROP_BOOL (1LL << CD_PROP_BOOL)
 
 /** Data types that may be defined for all mesh elements types. */
-#define CD_MASK_GENERIC_DATA (CD_MASK_PROP_FLT | CD_MASK_PROP_INT | CD_MASK_PROP_STR)
+#define CD_MASK_GENERIC_DATA \
+  (CD_MASK_PROP_FLT | CD_MASK_PROP_INT | CD_MASK_PROP_STR | CD_MASK_PROP_FLOAT3 | \
+   CD_MASK_PROP_FLOAT2 | CD_MASK_PROP_BOOL)
 
 /** Multires loop data. */
 #define CD_MASK_MULTIRES_GRIDS (CD_MASK_MDISPS | CD_GRID_PAINT_MASK)
@@ -33,6 +33,7 @@
 
 struct AnimData;
 struct Ipo;
+struct KeyEvalCache;
 
 typedef struct KeyBlock {
   struct KeyBlock *next, *prev;
@@ -116,6 +117,9 @@ typedef struct Key {
    * current free uid for keyblocks
    */
   int uidgen;
+
+  /** Runtime data, sparse offsets of the blocks for evaluated keys, see key.c. */
+  struct KeyEvalCache *eval_cache;
 } Key;
 
 /* **************** KEY ********************* */
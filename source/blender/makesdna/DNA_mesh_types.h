@@ -89,7 +89,8 @@ typedef struct Mesh_Runtime {
   void *batch_cache;
 
   struct SubdivCCG *subdiv_ccg;
-  void *_pad1;
+  /** `MeshTopologyCache` defined in 'mesh_runtime.c', shared with copies of the topology. */
+  struct MeshTopologyCache *topology_cache;
   int subdiv_ccg_tot_level;
   char _pad2[4];
 
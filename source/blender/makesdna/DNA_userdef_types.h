@@ -875,6 +875,11 @@ typedef struct UserDef {
   short sequencer_disk_cache_flag;
   char _pad5[2];
 
+  char image_decode_cache_dir[1024];
+  int image_decode_cache_size_limit;
+  short image_decode_cache_flag; /* eUserpref_ImageDecodeCacheFlag */
+  char _pad14[2];
+
   float collection_instance_empty_size;
   char _pad10[4];
 
@@ -1306,6 +1311,10 @@ typedef enum eUserpref_DiskCacheCompression {
   USER_SEQ_DISK_CACHE_COMPRESSION_HIGH = 2,
 } eUserpref_DiskCacheCompression;
 
+typedef enum eUserpref_ImageDecodeCacheFlag {
+  USER_IMAGE_DECODE_CACHE_ENABLE = (1 << 0),
+} eUserpref_ImageDecodeCacheFlag;
+
 /* Locale Ids. Auto will try to get local from OS. Our default is English though. */
 /** #UserDef.language */
 enum {
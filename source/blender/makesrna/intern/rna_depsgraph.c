@@ -226,6 +226,85 @@ static bool rna_DepsgraphUpdate_is_updated_geometry_get(PointerRNA *ptr)
   return ((data->recalc & ID_RECALC_ALL) != 0);
 }
 
+/* **************** Depsgraph Operation Profile **************** */
+
+static PointerRNA rna_DepsgraphOperationProfile_id_get(PointerRNA *ptr)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  return rna_pointer_inherit_refine(ptr, &RNA_ID, profile.id);
+}
+
+static void rna_DepsgraphOperationProfile_component_get(PointerRNA *ptr, char *value)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  strcpy(value, profile.component);
+}
+
+static int rna_DepsgraphOperationProfile_component_length(PointerRNA *ptr)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  return strlen(profile.component);
+}
+
+static void rna_DepsgraphOperationProfile_operation_get(PointerRNA *ptr, char *value)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  strcpy(value, profile.operation);
+}
+
+static int rna_DepsgraphOperationProfile_operation_length(PointerRNA *ptr)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  return strlen(profile.operation);
+}
+
+static void rna_DepsgraphOperationProfile_blocked_by_get(PointerRNA *ptr, char *value)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  strcpy(value, profile.blocked_by);
+}
+
+static int rna_DepsgraphOperationProfile_blocked_by_length(PointerRNA *ptr)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  return strlen(profile.blocked_by);
+}
+
+static int rna_DepsgraphOperationProfile_thread_get(PointerRNA *ptr)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  return profile.thread_id;
+}
+
+static float rna_DepsgraphOperationProfile_ready_time_get(PointerRNA *ptr)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  return (float)profile.ready_time;
+}
+
+static float rna_DepsgraphOperationProfile_start_time_get(PointerRNA *ptr)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  return (float)profile.start_time;
+}
+
+static float rna_DepsgraphOperationProfile_end_time_get(PointerRNA *ptr)
+{
+  DEGOperationProfile profile;
+  DEG_debug_profile_operation_info(ptr->data, &profile);
+  return (float)profile.end_time;
+}
+
 /* **************** Depsgraph **************** */
 
 static void rna_Depsgraph_debug_relations_graphviz(Depsgraph *depsgraph, const char *filename)
@@ -250,6 +329,16 @@ static void rna_Depsgraph_debug_stats_gnuplot(Depsgraph *depsgraph,
   fclose(f);
 }
 
+static void rna_Depsgraph_debug_profile_chrome_trace(Depsgraph *depsgraph, const char *filename)
+{
+  FILE *f = fopen(filename, "w");
+  if (f == NULL) {
+    return;
+  }
+  DEG_debug_profile_chrome_trace(depsgraph, f);
+  fclose(f);
+}
+
 static void rna_Depsgraph_debug_tag_update(Depsgraph *depsgraph)
 {
   DEG_graph_tag_relations_update(depsgraph);
@@ -447,6 +536,15 @@ static PointerRNA rna_Depsgraph_updates_get(CollectionPropertyIterator *iter)
   return rna_pointer_inherit_refine(&iter->parent, &RNA_DepsgraphUpdate, id);
 }
 
+static void rna_Depsgraph_debug_profile_operations_begin(CollectionPropertyIterator *iter,
+                                                        PointerRNA *ptr)
+{
+  Depsgraph *depsgraph = (Depsgraph *)ptr->data;
+  int len;
+  void **operations = DEG_debug_profile_operations(depsgraph, &len);
+  rna_iterator_array_begin(iter, operations, sizeof(void *), len, false, NULL);
+}
+
 static ID *rna_Depsgraph_id_eval_get(Depsgraph *depsgraph, ID *id_orig)
 {
   return DEG_get_evaluated_id(depsgraph, id_orig);
@@ -614,6 +712,81 @@ static void rna_def_depsgraph_update(BlenderRNA *brna)
   RNA_def_property_boolean_funcs(prop, "rna_DepsgraphUpdate_is_updated_shading_get", NULL);
 }
 
+static void rna_def_depsgraph_operation_profile(BlenderRNA *brna)
+{
+  StructRNA *srna;
+  PropertyRNA *prop;
+
+  srna = RNA_def_struct(brna, "DepsgraphOperationProfile", NULL);
+  RNA_def_struct_ui_text(srna,
+                         "Dependency Graph Operation Profile",
+                         "Timing of an operation evaluated during the last evaluation of the "
+                         "dependency graph");
+
+  prop = RNA_def_property(srna, "id", PROP_POINTER, PROP_NONE);
+  RNA_def_property_struct_type(prop, "ID");
+  RNA_def_property_ui_text(prop, "ID", "Original datablock the operation belongs to");
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE | PROP_EDITABLE);
+  RNA_def_property_pointer_funcs(prop, "rna_DepsgraphOperationProfile_id_get", NULL, NULL, NULL);
+
+  prop = RNA_def_property(srna, "component", PROP_STRING, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE | PROP_EDITABLE);
+  RNA_def_property_ui_text(prop, "Component", "Component of the datablock the operation is in");
+  RNA_def_property_string_funcs(prop,
+                                "rna_DepsgraphOperationProfile_component_get",
+                                "rna_DepsgraphOperationProfile_component_length",
+                                NULL);
+
+  prop = RNA_def_property(srna, "operation", PROP_STRING, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE | PROP_EDITABLE);
+  RNA_def_property_ui_text(prop, "Operation", "Identifier of the operation");
+  RNA_def_property_string_funcs(prop,
+                                "rna_DepsgraphOperationProfile_operation_get",
+                                "rna_DepsgraphOperationProfile_operation_length",
+                                NULL);
+
+  prop = RNA_def_property(srna, "blocked_by", PROP_STRING, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE | PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop,
+      "Blocked By",
+      "Dependency which finished last before the operation could be evaluated");
+  RNA_def_property_string_funcs(prop,
+                                "rna_DepsgraphOperationProfile_blocked_by_get",
+                                "rna_DepsgraphOperationProfile_blocked_by_length",
+                                NULL);
+
+  prop = RNA_def_property(srna, "thread", PROP_INT, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE | PROP_EDITABLE);
+  RNA_def_property_ui_text(
+      prop, "Thread", "Index of the thread which evaluated the operation, 0 is the main thread");
+  RNA_def_property_int_funcs(prop, "rna_DepsgraphOperationProfile_thread_get", NULL, NULL);
+
+  prop = RNA_def_property(srna, "ready_time", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE | PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Ready Time",
+                           "Time in seconds since the beginning of the evaluation when all "
+                           "dependencies of the operation were evaluated");
+  RNA_def_property_float_funcs(prop, "rna_DepsgraphOperationProfile_ready_time_get", NULL, NULL);
+
+  prop = RNA_def_property(srna, "start_time", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE | PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "Start Time",
+                           "Time in seconds since the beginning of the evaluation when the "
+                           "operation started to be evaluated");
+  RNA_def_property_float_funcs(prop, "rna_DepsgraphOperationProfile_start_time_get", NULL, NULL);
+
+  prop = RNA_def_property(srna, "end_time", PROP_FLOAT, PROP_NONE);
+  RNA_def_property_clear_flag(prop, PROP_ANIMATABLE | PROP_EDITABLE);
+  RNA_def_property_ui_text(prop,
+                           "End Time",
+                           "Time in seconds since the beginning of the evaluation when the "
+                           "operation was evaluated");
+  RNA_def_property_float_funcs(prop, "rna_DepsgraphOperationProfile_end_time_get", NULL, NULL);
+}
+
 static void rna_def_depsgraph(BlenderRNA *brna)
 {
   StructRNA *srna;
@@ -654,6 +827,14 @@ static void rna_def_depsgraph(BlenderRNA *brna)
                                   "File name where gnuplot script will save the result");
   RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
 
+  func = RNA_def_function(
+      srna, "debug_profile_chrome_trace", "rna_Depsgraph_debug_profile_chrome_trace");
+  RNA_def_function_ui_description(
+      func, "Write timing of the last evaluation in the Chrome trace event format");
+  parm = RNA_def_string_file_path(
+      func, "filename", NULL, FILE_MAX, "File Name", "Output path for the trace file");
+  RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+
   func = RNA_def_function(srna, "debug_tag_update", "rna_Depsgraph_debug_tag_update");
 
   func = RNA_def_function(srna, "debug_stats", "rna_Depsgraph_debug_stats");
@@ -776,12 +957,30 @@ static void rna_def_depsgraph(BlenderRNA *brna)
                                     NULL,
                                     NULL);
   RNA_def_property_ui_text(prop, "Updates", "Updates to datablocks");
+
+  prop = RNA_def_property(srna, "debug_profile_operations", PROP_COLLECTION, PROP_NONE);
+  RNA_def_property_struct_type(prop, "DepsgraphOperationProfile");
+  RNA_def_property_collection_funcs(prop,
+                                    "rna_Depsgraph_debug_profile_operations_begin",
+                                    "rna_iterator_array_next",
+                                    "rna_iterator_array_end",
+                                    "rna_iterator_array_dereference_get",
+                                    NULL,
+                                    NULL,
+                                    NULL,
+                                    NULL);
+  RNA_def_property_ui_text(prop,
+                           "Profile Operations",
+                           "Timing of operations evaluated during the last evaluation "
+                           "(WARNING: do not keep any references to its items, they are invalid "
+                           "after the next evaluation)");
 }
 
 void RNA_def_depsgraph(BlenderRNA *brna)
 {
   rna_def_depsgraph_instance(brna);
   rna_def_depsgraph_update(brna);
+  rna_def_depsgraph_operation_profile(brna);
   rna_def_depsgraph(brna);
 }
 
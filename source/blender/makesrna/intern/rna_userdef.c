@@ -564,6 +564,27 @@ static void rna_Userdef_disk_cache_dir_update(Main *UNUSED(bmain),
   USERDEF_TAG_DIRTY;
 }
 
+static void rna_Userdef_image_decode_cache_update(Main *UNUSED(bmain),
+                                                  Scene *UNUSED(scene),
+                                                  PointerRNA *UNUSED(ptr))
+{
+  WM_init_image_decode_cache();
+  USERDEF_TAG_DIRTY;
+}
+
+static void rna_Userdef_image_decode_cache_dir_update(Main *bmain,
+                                                      Scene *scene,
+                                                      PointerRNA *ptr)
+{
+  if (U.image_decode_cache_dir[0] != '\0') {
+    BLI_path_abs(U.image_decode_cache_dir, BKE_main_blendfile_path_from_global());
+    BLI_path_slash_ensure(U.image_decode_cache_dir);
+    BLI_path_make_safe(U.image_decode_cache_dir);
+  }
+
+  rna_Userdef_image_decode_cache_update(bmain, scene, ptr);
+}
+
 static void rna_UserDef_weight_color_update(Main *bmain, Scene *scene, PointerRNA *ptr)
 {
   Object *ob;
@@ -5288,6 +5309,30 @@ static void rna_def_userdef_system(BlenderRNA *brna)
       "Disk Cache Compression Level",
       "Smaller compression will result in larger files, but less decoding overhead");
 
+  /* Image decode cache */
+
+  prop = RNA_def_property(srna, "use_image_decode_cache", PROP_BOOLEAN, PROP_NONE);
+  RNA_def_property_boolean_sdna(
+      prop, NULL, "image_decode_cache_flag", USER_IMAGE_DECODE_CACHE_ENABLE);
+  RNA_def_property_ui_text(prop,
+                           "Use Image Decode Cache",
+                           "Store decoded JPEG 2000, Cineon, DPX and TIFF images on disk, "
+                           "so loading them again skips decoding");
+  RNA_def_property_update(prop, 0, "rna_Userdef_image_decode_cache_update");
+
+  prop = RNA_def_property(srna, "image_decode_cache_dir", PROP_STRING, PROP_DIRPATH);
+  RNA_def_property_string_sdna(prop, NULL, "image_decode_cache_dir");
+  RNA_def_property_ui_text(
+      prop, "Image Decode Cache Directory", "Directory to store decoded images in");
+  RNA_def_property_update(prop, 0, "rna_Userdef_image_decode_cache_dir_update");
+
+  prop = RNA_def_property(srna, "image_decode_cache_size_limit", PROP_INT, PROP_NONE);
+  RNA_def_property_int_sdna(prop, NULL, "image_decode_cache_size_limit");
+  RNA_def_property_range(prop, 1, INT_MAX);
+  RNA_def_property_ui_text(
+      prop, "Image Decode Cache Limit", "Image decode cache limit (in gigabytes)");
+  RNA_def_property_update(prop, 0, "rna_Userdef_image_decode_cache_update");
+
   prop = RNA_def_property(srna, "scrollback", PROP_INT, PROP_UNSIGNED);
   RNA_def_property_int_sdna(prop, NULL, "scrollback");
   RNA_def_property_range(prop, 32, 32768);
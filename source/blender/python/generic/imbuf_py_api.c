@@ -111,6 +111,8 @@ static PyObject *py_imbuf_resize(Py_ImBuf *self, PyObject *args, PyObject *kw)
     return NULL;
   }
   if (method.value_found == FAST) {
+    /* Nearest neighbor is what scripts ask for here, e.g. to keep pixel art or masks sharp,
+     * so this is not routed through the filtered scaling. */
     IMB_scalefastImBuf(self->ibuf, UNPACK2(size));
   }
   else if (method.value_found == BILINEAR) {
@@ -123,6 +123,10 @@ struct Render {
   Depsgraph *pipeline_depsgraph;
   Scene *pipeline_scene_eval;
 
+  /* Dependency graphs of the render engine which are kept between frames of an animation render
+   * with persistent data, one per view layer (LinkData). */
+  ListBase persistent_depsgraphs;
+
   /* callbacks */
   void (*display_init)(void *handle, RenderResult *rr);
   void *dih;
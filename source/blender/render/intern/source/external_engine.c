@@ -591,11 +591,44 @@ RenderData *RE_engine_get_render_data(Render *re)
 }
 
 /* Depsgraph */
+
+/* The scene structure usually does not change between frames of an animation, so with persistent
+ * data the dependency graph and its evaluated copies are kept for the next frame. Relations are
+ * still rebuilt when tagged for update, and only data changed by the new frame is evaluated. */
+static bool engine_keep_depsgraph(const RenderEngine *engine)
+{
+  const Render *re = engine->re;
+  return (re->flag & R_ANIMATION) && (re->r.mode & R_PERSISTENT_DATA) &&
+         !(re->r.scemode & R_BUTS_PREVIEW);
+}
+
+static Depsgraph *engine_depsgraph_pop_persistent(RenderEngine *engine, ViewLayer *view_layer)
+{
+  Render *re = engine->re;
+  LISTBASE_FOREACH (LinkData *, link, &re->persistent_depsgraphs) {
+    Depsgraph *depsgraph = link->data;
+    if (DEG_get_input_scene(depsgraph) == re->scene &&
+        DEG_get_input_view_layer(depsgraph) == view_layer) {
+      BLI_freelinkN(&re->persistent_depsgraphs, link);
+      return depsgraph;
+    }
+  }
+  return NULL;
+}
+
 static void engine_depsgraph_init(RenderEngine *engine, ViewLayer *view_layer)
 {
   Main *bmain = engine->re->main;
   Scene *scene = engine->re->scene;
 
+  if (engine_keep_depsgraph(engine)) {
+    engine->depsgraph = engine_depsgraph_pop_persistent(engine, view_layer);
+    if (engine->depsgraph != NULL) {
+      BKE_scene_graph_update_for_newframe(engine->depsgraph, bmain);
+      return;
+    }
+  }
+
   engine->depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_RENDER);
   DEG_debug_name_set(engine->depsgraph, "RENDER");
 
@@ -613,7 +646,12 @@ static void engine_depsgraph_init(RenderEngine *engine, ViewLayer *view_layer)
 
 static void engine_depsgraph_free(RenderEngine *engine)
 {
-  DEG_graph_free(engine->depsgraph);
+  if (engine->depsgraph != NULL && engine_keep_depsgraph(engine)) {
+    BLI_addtail(&engine->re->persistent_depsgraphs, BLI_genericNodeN(engine->depsgraph));
+  }
+  else {
+    DEG_graph_free(engine->depsgraph);
+  }
 
   engine->depsgraph = NULL;
 }
@@ -976,6 +1014,10 @@ void RE_engine_free_blender_memory(RenderEngine *engine)
   if (DRW_render_check_grease_pencil(engine->depsgraph)) {
     return;
   }
+  /* The dependency graph is kept for the next frame. */
+  if (engine_keep_depsgraph(engine)) {
+    return;
+  }
   DEG_graph_free(engine->depsgraph);
   engine->depsgraph = NULL;
 }
@@ -2695,6 +2695,11 @@ void RE_CleanAfterRender(Render *re)
   }
   re->pipeline_depsgraph = NULL;
   re->pipeline_scene_eval = NULL;
+
+  LISTBASE_FOREACH (LinkData *, link, &re->persistent_depsgraphs) {
+    DEG_graph_free(link->data);
+  }
+  BLI_freelistN(&re->persistent_depsgraphs);
 }
 
 /* note; repeated win/disprect calc... solve that nicer, also in compo */
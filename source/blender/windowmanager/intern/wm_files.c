@@ -387,6 +387,15 @@ static void wm_window_match_do(bContext *C,
 /** \name Preferences Initialization & Versioning
  * \{ */
 
+/* Pass the decode cache preferences on to imbuf. */
+void WM_init_image_decode_cache(void)
+{
+  const bool use_cache = (U.image_decode_cache_flag & USER_IMAGE_DECODE_CACHE_ENABLE) != 0;
+
+  IMB_decode_cache_set_options(use_cache ? U.image_decode_cache_dir : "",
+                               (size_t)U.image_decode_cache_size_limit * 1024 * 1024 * 1024);
+}
+
 /* in case UserDef was read, we re-initialize all, and do versioning */
 static void wm_init_userdef(Main *bmain)
 {
@@ -403,6 +412,7 @@ static void wm_init_userdef(Main *bmain)
   }
 
   MEM_CacheLimiter_set_maximum(((size_t)U.memcachelimit) * 1024 * 1024);
+  WM_init_image_decode_cache();
   BKE_sound_init(bmain);
 
   /* update tempdir from user preferences */
@@ -18,11 +18,21 @@
  */
 
 #include "BKE_armature.h"
+#include "BKE_lattice.h"
 
+#include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_string.h"
+
+#include "DNA_armature_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"
 
 #include "testing/testing.h"
 
+#include <vector>
+
 static const float FLOAT_EPSILON = 1.2e-7;
 
 TEST(mat3_vec_to_roll, UnitMatrix)
@@ -87,3 +97,213 @@ TEST(mat3_vec_to_roll, Rotationmatrix)
     EXPECT_NEAR(0.57158958f, roll, FLOAT_EPSILON);
   }
 }
+
+/* Scalar version of add_weighted_dq_dq(), which may be vectorized. */
+static void add_weighted_dq_dq_scalar(DualQuat *dqsum, const DualQuat *dq, float weight)
+{
+  bool flipped = false;
+
+  if (dot_qtqt(dq->quat, dqsum->quat) < 0) {
+    flipped = true;
+    weight = -weight;
+  }
+
+  for (int i = 0; i < 4; i++) {
+    dqsum->quat[i] += weight * dq->quat[i];
+  }
+  for (int i = 0; i < 4; i++) {
+    dqsum->trans[i] += weight * dq->trans[i];
+  }
+
+  if (dq->scale_weight) {
+    if (flipped) {
+      weight = -weight;
+    }
+
+    float wmat[4][4];
+    copy_m4_m4(wmat, (float(*)[4])dq->scale);
+    mul_m4_fl(wmat, weight);
+    add_m4_m4m4(dqsum->scale, dqsum->scale, wmat);
+    dqsum->scale_weight += weight;
+  }
+}
+
+static void expect_dq_eq(const DualQuat &a, const DualQuat &b)
+{
+  for (int i = 0; i < 4; i++) {
+    EXPECT_EQ(a.quat[i], b.quat[i]);
+    EXPECT_EQ(a.trans[i], b.trans[i]);
+    for (int j = 0; j < 4; j++) {
+      EXPECT_EQ(a.scale[i][j], b.scale[i][j]);
+    }
+  }
+  EXPECT_EQ(a.scale_weight, b.scale_weight);
+}
+
+/* Bone matrix with rotation, translation and, for odd bones, scale. */
+static void test_bone_matrix(float r_mat[4][4], int bone)
+{
+  const float eul[3] = {0.3f * (float)bone, 1.1f - 0.7f * (float)bone, 0.2f + (float)bone};
+  eul_to_mat4(r_mat, eul);
+  if (bone % 2) {
+    const float scale[3] = {1.5f, 0.75f, 1.25f};
+    rescale_m4(r_mat, scale);
+  }
+  r_mat[3][0] = (float)bone;
+  r_mat[3][1] = 0.5f;
+  r_mat[3][2] = -0.25f * (float)bone;
+}
+
+TEST(armature_deform, WeightedDualQuatMatchesScalar)
+{
+  float base[4][4];
+  unit_m4(base);
+  translate_m4(base, 0.1f, 0.2f, 0.3f);
+
+  DualQuat sum = {{0}}, sum_scalar = {{0}};
+  for (int bone = 0; bone < 8; bone++) {
+    float mat[4][4];
+    test_bone_matrix(mat, bone);
+    DualQuat dq;
+    mat4_to_dquat(&dq, base, mat);
+    if (bone == 5) {
+      /* Opposite rotation direction, the weight is flipped for it. */
+      negate_v4(dq.quat);
+      negate_v4(dq.trans);
+    }
+
+    const float weight = 0.1f + 0.13f * (float)bone;
+    add_weighted_dq_dq(&sum, &dq, weight);
+    add_weighted_dq_dq_scalar(&sum_scalar, &dq, weight);
+    expect_dq_eq(sum, sum_scalar);
+  }
+}
+
+/* Deform vertices by four bones with varying weights, both through the armature deform and
+ * through scalar code doing the same steps. The results have to be bit-identical. */
+static void test_armature_deform(const bool use_quaternion)
+{
+  const int bones_num = 4;
+  const int verts_num = 257;
+
+  bArmature arm = {};
+  bPose pose = {};
+  Bone bones[bones_num] = {};
+  bPoseChannel pchans[bones_num] = {};
+  bDeformGroup groups[bones_num] = {};
+
+  Object ob_arm = {};
+  ob_arm.data = &arm;
+  ob_arm.pose = &pose;
+  unit_m4(ob_arm.obmat);
+  translate_m4(ob_arm.obmat, 0.5f, -1.0f, 2.0f);
+
+  Mesh mesh = {};
+  Object ob_target = {};
+  ob_target.type = OB_MESH;
+  ob_target.data = &mesh;
+  unit_m4(ob_target.obmat);
+
+  for (int i = 0; i < bones_num; i++) {
+    BLI_snprintf(pchans[i].name, sizeof(pchans[i].name), "Bone%d", i);
+    STRNCPY(groups[i].name, pchans[i].name);
+    bones[i].segments = 1;
+    unit_m4(bones[i].arm_mat);
+    bones[i].arm_mat[3][1] = (float)i;
+    pchans[i].bone = &bones[i];
+    test_bone_matrix(pchans[i].chan_mat, i);
+    mat4_to_dquat(&pchans[i].runtime.deform_dual_quat, bones[i].arm_mat, pchans[i].chan_mat);
+    BLI_addtail(&pose.chanbase, &pchans[i]);
+    BLI_addtail(&ob_target.defbase, &groups[i]);
+  }
+
+  /* Up to four influences per vertex, some of them zero. */
+  std::vector<MDeformVert> dverts(verts_num);
+  std::vector<MDeformWeight> weights;
+  weights.reserve(verts_num * bones_num);
+  std::vector<float> coords(verts_num * 3);
+  for (int i = 0; i < verts_num; i++) {
+    dverts[i].dw = weights.data() + weights.size();
+    dverts[i].totweight = i % (bones_num + 1);
+    for (int j = 0; j < dverts[i].totweight; j++) {
+      MDeformWeight dw;
+      dw.def_nr = (i + j) % bones_num;
+      dw.weight = ((i * 7 + j * 3) % 5) * 0.25f;
+      weights.push_back(dw);
+    }
+    coords[i * 3 + 0] = sinf((float)i);
+    coords[i * 3 + 1] = cosf((float)i * 0.3f) * 2.0f;
+    coords[i * 3 + 2] = (float)i * 0.01f;
+  }
+  mesh.dvert = dverts.data();
+  mesh.totvert = verts_num;
+
+  /* Scalar reference. */
+  float obinv[4][4], premat[4][4], postmat[4][4];
+  invert_m4_m4(obinv, ob_target.obmat);
+  mul_m4_m4m4(postmat, obinv, ob_arm.obmat);
+  invert_m4_m4(premat, postmat);
+
+  std::vector<float> coords_expected = coords;
+  for (int i = 0; i < verts_num; i++) {
+    float *co = &coords_expected[i * 3];
+    DualQuat dq = {{0}};
+    float vec[3] = {0.0f, 0.0f, 0.0f};
+    float contrib = 0.0f;
+
+    mul_m4_v3(premat, co);
+    for (int j = 0; j < dverts[i].totweight; j++) {
+      const MDeformWeight *dw = &dverts[i].dw[j];
+      const bPoseChannel *pchan = &pchans[dw->def_nr];
+      if (dw->weight == 0.0f) {
+        continue;
+      }
+      if (use_quaternion) {
+        add_weighted_dq_dq_scalar(&dq, &pchan->runtime.deform_dual_quat, dw->weight);
+      }
+      else {
+        float tmp[3];
+        mul_v3_m4v3(tmp, pchan->chan_mat, co);
+        sub_v3_v3(tmp, co);
+        madd_v3_v3fl(vec, tmp, dw->weight);
+      }
+      contrib += dw->weight;
+    }
+    if (contrib > 0.0001f) {
+      if (use_quaternion) {
+        normalize_dq(&dq, contrib);
+        mul_v3m3_dq(co, NULL, &dq);
+      }
+      else {
+        mul_v3_fl(vec, 1.0f / contrib);
+        add_v3_v3v3(co, vec, co);
+      }
+    }
+    mul_m4_v3(postmat, co);
+  }
+
+  armature_deform_verts(&ob_arm,
+                        &ob_target,
+                        NULL,
+                        (float(*)[3])coords.data(),
+                        NULL,
+                        verts_num,
+                        ARM_DEF_VGROUP | (use_quaternion ? ARM_DEF_QUATERNION : 0),
+                        NULL,
+                        NULL,
+                        NULL);
+
+  for (int i = 0; i < verts_num * 3; i++) {
+    EXPECT_EQ(coords[i], coords_expected[i]) << "index " << i;
+  }
+}
+
+TEST(armature_deform, LinearMatchesScalar)
+{
+  test_armature_deform(false);
+}
+
+TEST(armature_deform, DualQuatMatchesScalar)
+{
+  test_armature_deform(true);
+}
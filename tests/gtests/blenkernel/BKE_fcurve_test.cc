@@ -20,13 +20,28 @@
 #include "MEM_guardedalloc.h"
 
 extern "C" {
+#include "BKE_action.h"
+#include "BKE_anim_data.h"
+#include "BKE_animsys.h"
 #include "BKE_fcurve.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+
+#include "BLI_listbase.h"
+#include "BLI_rand.h"
+#include "BLI_string.h"
 
 #include "ED_keyframing.h"
 
 #include "DNA_anim_types.h"
+#include "DNA_object_types.h"
+
+#include "RNA_define.h"
 }
 
+#include <algorithm>
+#include <vector>
+
 // Epsilon for floating point comparisons.
 static const float EPSILON = 1e-7f;
 
@@ -209,3 +224,119 @@ TEST(evaluate_fcurve, ExtrapolationBezierKeys)
 
   BKE_fcurve_free(fcu);
 }
+
+/* Keys with irregular spacing and all kinds of interpolation. */
+static FCurve *segment_test_fcurve(int keys_num, int seed)
+{
+  const char ipos[] = {BEZT_IPO_BEZ, BEZT_IPO_LIN, BEZT_IPO_CONST, BEZT_IPO_BOUNCE, BEZT_IPO_SINE};
+  FCurve *fcu = BKE_fcurve_create();
+  RNG *rng = BLI_rng_new((unsigned int)seed);
+  float time = 1.0f;
+
+  for (int i = 0; i < keys_num; i++) {
+    insert_vert_fcurve(fcu,
+                       time,
+                       BLI_rng_get_float(rng) * 10.0f - 5.0f,
+                       BEZT_KEYTYPE_KEYFRAME,
+                       INSERTKEY_NO_USERPREF);
+    time += 0.5f + BLI_rng_get_float(rng) * 4.0f;
+  }
+  for (int i = 0; i < fcu->totvert; i++) {
+    fcu->bezt[i].ipo = ipos[(i + seed) % ARRAY_SIZE(ipos)];
+  }
+  calchandles_fcurve(fcu);
+
+  BLI_rng_free(rng);
+  return fcu;
+}
+
+/* Times in playback order, in reverse, and in random order. Includes times before the first and
+ * after the last key, on the keys and around them within and beyond the search threshold. */
+static std::vector<std::vector<float>> segment_test_times(const FCurve *fcu)
+{
+  const float start = fcu->bezt[0].vec[1][0] - 2.0f;
+  const float end = fcu->bezt[fcu->totvert - 1].vec[1][0] + 2.0f;
+
+  std::vector<float> sequential;
+  for (float time = start; time <= end; time += 0.25f) {
+    sequential.push_back(time);
+  }
+  for (int i = 0; i < fcu->totvert; i++) {
+    const float key = fcu->bezt[i].vec[1][0];
+    for (const float offset : {-0.0002f, -0.00005f, 0.0f, 0.00005f, 0.0002f}) {
+      sequential.push_back(key + offset);
+    }
+  }
+  std::sort(sequential.begin(), sequential.end());
+
+  std::vector<float> reverse(sequential.rbegin(), sequential.rend());
+
+  std::vector<float> random = sequential;
+  RNG *rng = BLI_rng_new(7);
+  BLI_rng_shuffle_array(rng, random.data(), sizeof(float), (unsigned int)random.size());
+  BLI_rng_free(rng);
+
+  return {sequential, reverse, random};
+}
+
+TEST(evaluate_fcurve, SegmentCacheMatchesSearch)
+{
+  FCurve *fcu = segment_test_fcurve(20, 0);
+
+  /* One cache for all orders, as when scrubbing back and forth. */
+  int segment_cache = 0;
+  for (const std::vector<float> &times : segment_test_times(fcu)) {
+    for (const float time : times) {
+      EXPECT_EQ(evaluate_fcurve_segment_cached(fcu, time, &segment_cache),
+                evaluate_fcurve(fcu, time))
+          << "time " << time;
+    }
+  }
+
+  BKE_fcurve_free(fcu);
+}
+
+class animsys_action_eval_cache : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+    RNA_init();
+  }
+  static void TearDownTestCase()
+  {
+    RNA_exit();
+  }
+};
+
+TEST_F(animsys_action_eval_cache, MatchesFCurveEvaluation)
+{
+  Object *ob = (Object *)BKE_id_new_nomain(ID_OB, "OBTest");
+  bAction *act = (bAction *)BKE_id_new_nomain(ID_AC, "ACTest");
+  FCurve *fcurves[3];
+  for (int i = 0; i < 3; i++) {
+    fcurves[i] = segment_test_fcurve(12 + i, i);
+    fcurves[i]->rna_path = BLI_strdup("location");
+    fcurves[i]->array_index = i;
+    BLI_addtail(&act->curves, fcurves[i]);
+  }
+
+  /* The compiled action is only used for evaluated IDs. */
+  ob->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+  AnimData *adt = BKE_animdata_add_id(&ob->id);
+  adt->action = act;
+
+  for (const std::vector<float> &times : segment_test_times(fcurves[0])) {
+    for (const float time : times) {
+      BKE_animsys_evaluate_animdata(&ob->id, adt, time, ADT_RECALC_ANIM, false);
+      for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(ob->loc[i], evaluate_fcurve(fcurves[i], time)) << "time " << time;
+      }
+    }
+  }
+  EXPECT_NE(adt->action_eval_cache, nullptr);
+
+  adt->action = NULL;
+  BKE_id_free(NULL, ob);
+  BKE_id_free(NULL, act);
+}
@@ -0,0 +1,223 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation
+ * All rights reserved.
+ */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_idtype.h"
+#include "BKE_key.h"
+#include "BKE_lib_id.h"
+
+#include "BLI_listbase.h"
+#include "BLI_math.h"
+
+#include "DEG_depsgraph_query.h"
+
+#include "DNA_ipo_types.h"
+#include "DNA_key_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+
+#include <vector>
+
+/* More elements than blended by a single task, so several ranges are evaluated. */
+#define VERTS_NUM 10000
+
+class key_evaluate_relative : public testing::Test {
+ protected:
+  Object *ob;
+  Mesh *me;
+  Key *key;
+
+  static void SetUpTestCase()
+  {
+    BKE_idtype_init();
+  }
+
+  void SetUp() override
+  {
+    me = (Mesh *)BKE_id_new_nomain(ID_ME, "Mesh");
+    me->totvert = VERTS_NUM;
+    ob = (Object *)BKE_id_new_nomain(ID_OB, "Object");
+    ob->type = OB_MESH;
+    ob->data = me;
+
+    /* Same setup as #BKE_key_add() for meshes, without a main database. */
+    key = (Key *)BKE_id_new_nomain(ID_KE, "Key");
+    key->type = KEY_RELATIVE;
+    key->from = &me->id;
+    key->uidgen = 1;
+    key->elemstr[0] = KEYELEM_FLOAT_LEN_COORD;
+    key->elemstr[1] = IPO_FLOAT;
+    key->elemsize = sizeof(float[KEYELEM_FLOAT_LEN_COORD]);
+    me->key = key;
+  }
+
+  void TearDown() override
+  {
+    me->key = NULL;
+    BKE_id_free(NULL, key);
+    BKE_id_free(NULL, ob);
+    BKE_id_free(NULL, me);
+  }
+
+  KeyBlock *add_block(const int relative, const float curval)
+  {
+    KeyBlock *kb = BKE_keyblock_add(key, NULL);
+    kb->relative = relative;
+    kb->curval = curval;
+    kb->totelem = VERTS_NUM;
+    kb->data = MEM_calloc_arrayN(VERTS_NUM, sizeof(float[3]), __func__);
+    return kb;
+  }
+
+  /* Evaluate the object with the given key, which may be an evaluated copy of #key. */
+  std::vector<float> evaluate(Key *key_eval)
+  {
+    std::vector<float> result(VERTS_NUM * 3);
+    me->key = key_eval;
+    EXPECT_NE(BKE_key_evaluate_object_ex(
+                  ob, NULL, result.data(), sizeof(float[3]) * VERTS_NUM),
+              nullptr);
+    me->key = key;
+    return result;
+  }
+};
+
+/* Copy the key like the dependency graph does for evaluation, in place when given a copy. */
+static Key *key_copy_for_eval(Key *key, Key *key_eval)
+{
+  int flag = LIB_ID_COPY_LOCALIZE;
+  if (key_eval) {
+    BKE_libblock_free_datablock(&key_eval->id, 0);
+    flag |= LIB_ID_CREATE_NO_ALLOCATE;
+  }
+  BKE_id_copy_ex(NULL, &key->id, (ID **)&key_eval, flag);
+  key_eval->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+  return key_eval;
+}
+
+static void move_verts(KeyBlock *kb, const KeyBlock *refkb, const int step, const float offset)
+{
+  const float(*ref)[3] = (const float(*)[3])refkb->data;
+  float(*co)[3] = (float(*)[3])kb->data;
+  for (int i = 0; i < VERTS_NUM; i++) {
+    copy_v3_v3(co[i], ref[i]);
+    if (i % step == 0) {
+      co[i][i % 3] += offset * (float)(i % 7 + 1);
+    }
+  }
+}
+
+static void expect_bit_identical(const std::vector<float> &a, const std::vector<float> &b)
+{
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); i++) {
+    /* Compare the bits, the fast path promises the same result as blending densely. */
+    EXPECT_EQ(memcmp(&a[i], &b[i], sizeof(float)), 0) << "at element " << i / 3;
+  }
+}
+
+TEST_F(key_evaluate_relative, SparseMatchesDense)
+{
+  KeyBlock *basis = add_block(0, 0.0f);
+  float(*co)[3] = (float(*)[3])basis->data;
+  for (int i = 0; i < VERTS_NUM; i++) {
+    co[i][0] = (float)(i % 100) * 0.1f;
+    co[i][1] = (float)(i / 100) * 0.1f;
+    co[i][2] = sinf((float)i);
+  }
+
+  /* Sparse corrective shapes, one of them relative to another shape. */
+  KeyBlock *sparse = add_block(0, 0.7f);
+  move_verts(sparse, basis, 37, 0.25f);
+  KeyBlock *chained = add_block(1, 0.45f);
+  move_verts(chained, sparse, 101, -0.5f);
+  /* Moving all elements stays dense. */
+  KeyBlock *dense = add_block(0, 0.3f);
+  move_verts(dense, basis, 1, 0.125f);
+  /* Blocks which are skipped. */
+  KeyBlock *muted = add_block(0, 1.0f);
+  move_verts(muted, basis, 3, 1.0f);
+  muted->flag |= KEYBLOCK_MUTE;
+  KeyBlock *zero = add_block(0, 0.0f);
+  move_verts(zero, basis, 5, 1.0f);
+  /* Moving nothing. */
+  add_block(0, 1.0f);
+  move_verts((KeyBlock *)key->block.last, basis, 1, 0.0f);
+  /* Last element only. */
+  KeyBlock *last = add_block(0, 0.9f);
+  move_verts(last, basis, 1, 0.0f);
+  ((float(*)[3])last->data)[VERTS_NUM - 1][1] += 2.0f;
+
+  ASSERT_FALSE(DEG_is_evaluated_id(&key->id));
+  const std::vector<float> expected = evaluate(key);
+
+  Key *key_eval = key_copy_for_eval(key, NULL);
+  ASSERT_TRUE(DEG_is_evaluated_id(&key_eval->id));
+
+  /* The first evaluation creates the sparse offsets, the second one uses them. */
+  expect_bit_identical(evaluate(key_eval), expected);
+  EXPECT_NE(key_eval->eval_cache, nullptr);
+  expect_bit_identical(evaluate(key_eval), expected);
+
+  /* Influence changes only come from animation, without copying the key again. */
+  LISTBASE_FOREACH (KeyBlock *, kb, &key->block) {
+    kb->curval *= 0.5f;
+  }
+  LISTBASE_FOREACH (KeyBlock *, kb, &key_eval->block) {
+    kb->curval *= 0.5f;
+  }
+  expect_bit_identical(evaluate(key_eval), evaluate(key));
+
+  BKE_id_free(NULL, key_eval);
+}
+
+TEST_F(key_evaluate_relative, DataChangedInPlace)
+{
+  KeyBlock *basis = add_block(0, 0.0f);
+  float(*co)[3] = (float(*)[3])basis->data;
+  for (int i = 0; i < VERTS_NUM; i++) {
+    co[i][0] = (float)i;
+  }
+  KeyBlock *shape = add_block(0, 0.6f);
+  move_verts(shape, basis, 50, 1.0f);
+
+  Key *key_eval = key_copy_for_eval(key, NULL);
+  expect_bit_identical(evaluate(key_eval), evaluate(key));
+
+  /* Edit the shape without reallocating its data, like sculpting or Python do. Other vertices
+   * move, so offsets of the previous data would give a different result. */
+  const void *data = shape->data;
+  move_verts(shape, basis, 13, -2.0f);
+  ASSERT_EQ(shape->data, data);
+
+  /* Evaluating the original key does not cache anything. */
+  const std::vector<float> expected = evaluate(key);
+  EXPECT_EQ(key->eval_cache, nullptr);
+
+  /* The evaluated key is copied again in place, its data may get the same address as before. */
+  Key *key_eval_updated = key_copy_for_eval(key, key_eval);
+  ASSERT_EQ(key_eval_updated, key_eval);
+  EXPECT_EQ(key_eval->eval_cache, nullptr);
+  expect_bit_identical(evaluate(key_eval), expected);
+
+  BKE_id_free(NULL, key_eval);
+}
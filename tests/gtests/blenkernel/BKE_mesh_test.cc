@@ -0,0 +1,546 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 Blender Foundation
+ * All rights reserved.
+ */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BKE_bvhutils.h"
+#include "BKE_customdata.h"
+#include "BKE_idtype.h"
+#include "BKE_lib_id.h"
+#include "BKE_mesh.h"
+#include "BKE_mesh_mapping.h"
+#include "BKE_mesh_runtime.h"
+
+#include "BLI_math.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
+#include <algorithm>
+#include <vector>
+
+/* Regular polygons with 3 to 8 sides, placed next to each other. */
+struct PolygonSoup {
+  std::vector<MVert> verts;
+  std::vector<MLoop> loops;
+  std::vector<MPoly> polys;
+  std::vector<float> areas;
+
+  PolygonSoup(int polys_num)
+  {
+    for (int i = 0; i < polys_num; i++) {
+      const int sides = 3 + (i % 6);
+      MPoly mp = {0};
+      mp.loopstart = (int)loops.size();
+      mp.totloop = sides;
+      polys.push_back(mp);
+      for (int j = 0; j < sides; j++) {
+        MVert mv = {{0}};
+        const float angle = (float)(2.0 * M_PI) * (float)j / (float)sides;
+        mv.co[0] = (float)(i * 3) + cosf(angle);
+        mv.co[1] = sinf(angle);
+        MLoop ml = {0};
+        ml.v = (unsigned int)verts.size();
+        verts.push_back(mv);
+        loops.push_back(ml);
+      }
+      areas.push_back(0.5f * (float)sides * sinf((float)(2.0 * M_PI) / (float)sides));
+    }
+  }
+
+  std::vector<MLoopTri> looptris(int polys_num) const
+  {
+    const int totloop = polys[polys_num - 1].loopstart + polys[polys_num - 1].totloop;
+    std::vector<MLoopTri> looptris((size_t)poly_to_tri_count(polys_num, totloop));
+    BKE_mesh_recalc_looptri(
+        loops.data(), polys.data(), verts.data(), totloop, polys_num, looptris.data());
+    return looptris;
+  }
+};
+
+/* Grid of quads with a wavy surface, so vertex normals all differ. */
+struct QuadGrid {
+  std::vector<MVert> verts;
+  std::vector<MLoop> loops;
+  std::vector<MPoly> polys;
+
+  QuadGrid(int size)
+  {
+    for (int y = 0; y <= size; y++) {
+      for (int x = 0; x <= size; x++) {
+        MVert mv = {{0}};
+        mv.co[0] = (float)x;
+        mv.co[1] = (float)y;
+        mv.co[2] = sinf((float)x * 0.7f) * cosf((float)y * 0.3f);
+        verts.push_back(mv);
+      }
+    }
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        const unsigned int v = (unsigned int)(y * (size + 1) + x);
+        const unsigned int row = (unsigned int)(size + 1);
+        const unsigned int quad[4] = {v, v + 1, v + 1 + row, v + row};
+        MPoly mp = {0};
+        mp.loopstart = (int)loops.size();
+        mp.totloop = 4;
+        polys.push_back(mp);
+        for (int j = 0; j < 4; j++) {
+          MLoop ml = {0};
+          ml.v = quad[j];
+          loops.push_back(ml);
+        }
+      }
+    }
+  }
+};
+
+TEST(mesh_normals, GatherMatchesScatter)
+{
+  QuadGrid grid(100);
+  const int totvert = (int)grid.verts.size();
+  const int totloop = (int)grid.loops.size();
+  const int totpoly = (int)grid.polys.size();
+
+  std::vector<float> vnors(grid.verts.size() * 3), vnors_gather(grid.verts.size() * 3);
+  std::vector<float> pnors(grid.polys.size() * 3), pnors_gather(grid.polys.size() * 3);
+
+  BKE_mesh_calc_normals_poly(grid.verts.data(),
+                             (float(*)[3])vnors.data(),
+                             totvert,
+                             grid.loops.data(),
+                             grid.polys.data(),
+                             totloop,
+                             totpoly,
+                             (float(*)[3])pnors.data(),
+                             false);
+  std::vector<MVert> verts_scatter = grid.verts;
+
+  MeshElemMap *vert_loop_map;
+  int *vert_loop_map_mem;
+  BKE_mesh_vert_loop_map_create(&vert_loop_map,
+                                &vert_loop_map_mem,
+                                grid.polys.data(),
+                                grid.loops.data(),
+                                totvert,
+                                totpoly,
+                                totloop);
+  BKE_mesh_calc_normals_poly_ex(grid.verts.data(),
+                                (float(*)[3])vnors_gather.data(),
+                                totvert,
+                                grid.loops.data(),
+                                grid.polys.data(),
+                                totloop,
+                                totpoly,
+                                (float(*)[3])pnors_gather.data(),
+                                false,
+                                vert_loop_map);
+  MEM_freeN(vert_loop_map);
+  MEM_freeN(vert_loop_map_mem);
+
+  for (size_t i = 0; i < vnors.size(); i++) {
+    EXPECT_NEAR(vnors[i], vnors_gather[i], 1e-6f);
+  }
+  for (size_t i = 0; i < pnors.size(); i++) {
+    EXPECT_EQ(pnors[i], pnors_gather[i]);
+  }
+  for (int i = 0; i < totvert; i++) {
+    for (int j = 0; j < 3; j++) {
+      EXPECT_NEAR(verts_scatter[i].no[j], grid.verts[i].no[j], 1);
+    }
+  }
+}
+
+/* Copy-on-write mesh of a grid, with its first half of edges tagged sharp. */
+static Mesh *quad_grid_mesh_cow(const QuadGrid &grid)
+{
+  Mesh *mesh = BKE_mesh_new_nomain(
+      (int)grid.verts.size(), 0, 0, (int)grid.loops.size(), (int)grid.polys.size());
+  std::copy(grid.verts.begin(), grid.verts.end(), mesh->mvert);
+  std::copy(grid.loops.begin(), grid.loops.end(), mesh->mloop);
+  std::copy(grid.polys.begin(), grid.polys.end(), mesh->mpoly);
+  for (int i = 0; i < mesh->totpoly; i++) {
+    mesh->mpoly[i].flag |= ME_SMOOTH;
+  }
+  BKE_mesh_calc_edges(mesh, false, false);
+  for (int i = 0; i < mesh->totedge / 2; i += 7) {
+    mesh->medge[i].flag |= ME_SHARP;
+  }
+  mesh->flag |= ME_AUTOSMOOTH;
+  mesh->smoothresh = DEG2RADF(20.0f);
+  mesh->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+  return mesh;
+}
+
+static std::vector<float> mesh_split_normals(Mesh *mesh, Mesh *mesh_cache)
+{
+  std::vector<float> pnors((size_t)mesh->totpoly * 3), lnors((size_t)mesh->totloop * 3);
+  MLoopNorSpaceArray lnors_spacearr = {NULL};
+
+  BKE_mesh_calc_normals_poly(mesh->mvert,
+                             NULL,
+                             mesh->totvert,
+                             mesh->mloop,
+                             mesh->mpoly,
+                             mesh->totloop,
+                             mesh->totpoly,
+                             (float(*)[3])pnors.data(),
+                             false);
+  BKE_mesh_normals_loop_split_ex(mesh->mvert,
+                                 mesh->totvert,
+                                 mesh->medge,
+                                 mesh->totedge,
+                                 mesh->mloop,
+                                 (float(*)[3])lnors.data(),
+                                 mesh->totloop,
+                                 mesh->mpoly,
+                                 (const float(*)[3])pnors.data(),
+                                 mesh->totpoly,
+                                 true,
+                                 mesh->smoothresh,
+                                 &lnors_spacearr,
+                                 NULL,
+                                 NULL,
+                                 mesh_cache);
+
+  /* Append the lnor space of each loop, spaces of a same fan are shared. */
+  EXPECT_EQ(lnors_spacearr.data_type, MLNOR_SPACEARR_LOOP_INDEX);
+  for (int i = 0; i < mesh->totloop; i++) {
+    const MLoopNorSpace *lnor_space = lnors_spacearr.lspacearr[i];
+    lnors.push_back(lnor_space->ref_alpha);
+    lnors.push_back(lnor_space->ref_beta);
+    lnors.push_back((lnor_space->flags & MLNOR_SPACE_IS_SINGLE) ? 1.0f : 0.0f);
+  }
+  BKE_lnor_spacearr_free(&lnors_spacearr);
+  return lnors;
+}
+
+TEST(mesh_normals, SplitNormalsCachedTopology)
+{
+  BKE_idtype_init();
+
+  QuadGrid grid(60);
+  Mesh *mesh = quad_grid_mesh_cow(grid);
+
+  for (int deform = 0; deform < 2; deform++) {
+    if (deform) {
+      /* Change which edges are sharp from angle, the cached fans have to be rebuilt. */
+      for (int i = 0; i < mesh->totvert; i++) {
+        mesh->mvert[i].co[2] *= 3.0f;
+      }
+    }
+    const std::vector<float> lnors = mesh_split_normals(mesh, NULL);
+
+    /* Only the second evaluation caches the fans, the third one reuses them. */
+    for (int i = 0; i < 3; i++) {
+      Mesh *mesh_eval = BKE_mesh_copy_for_eval(mesh, true);
+      EXPECT_NE(mesh_eval->runtime.topology_cache, nullptr);
+      EXPECT_EQ(mesh_split_normals(mesh_eval, mesh_eval), lnors);
+      BKE_id_free(NULL, mesh_eval);
+    }
+  }
+
+  BKE_id_free(NULL, mesh);
+}
+
+TEST(mesh_customdata, PackedFloat3AndBoolLayers)
+{
+  BKE_idtype_init();
+
+  QuadGrid grid(8);
+  Mesh *mesh = quad_grid_mesh_cow(grid);
+
+  float(*positions)[3] = (float(*)[3])CustomData_add_layer_named(
+      &mesh->vdata, CD_PROP_FLOAT3, CD_CALLOC, NULL, mesh->totvert, "positions");
+  bool *selection = (bool *)CustomData_add_layer_named(
+      &mesh->vdata, CD_PROP_BOOL, CD_CALLOC, NULL, mesh->totvert, "selection");
+  EXPECT_EQ((uintptr_t)positions % 64, 0);
+  EXPECT_EQ((uintptr_t)selection % 64, 0);
+
+  for (int i = 0; i < mesh->totvert; i++) {
+    copy_v3_v3(positions[i], mesh->mvert[i].co);
+    selection[i] = (i % 2) == 0;
+  }
+
+  /* Interpolate between an unselected and a selected vertex. */
+  const int src_indices[2] = {1, 2};
+  const float weights[2] = {0.25f, 0.75f};
+  CustomData_interp(&mesh->vdata, &mesh->vdata, src_indices, weights, NULL, 2, 0);
+  float expected[3];
+  interp_v3_v3v3(expected, mesh->mvert[1].co, mesh->mvert[2].co, 0.75f);
+  EXPECT_V3_NEAR(positions[0], expected, 1e-6f);
+  EXPECT_TRUE(selection[0]);
+
+  /* Evaluated copies share the layers until they are written to. */
+  Mesh *mesh_eval = BKE_mesh_copy_for_eval(mesh, true);
+  float(*positions_eval)[3] = (float(*)[3])CustomData_duplicate_referenced_layer_named(
+      &mesh_eval->vdata, CD_PROP_FLOAT3, "positions", mesh_eval->totvert);
+  EXPECT_NE(positions_eval, positions);
+  EXPECT_EQ((uintptr_t)positions_eval % 64, 0);
+  for (int i = 0; i < mesh->totvert; i++) {
+    EXPECT_V3_NEAR(positions_eval[i], positions[i], 0.0f);
+  }
+  BKE_id_free(NULL, mesh_eval);
+
+  BKE_id_free(NULL, mesh);
+}
+
+TEST(mesh_customdata, Float2LayerKept)
+{
+  BKE_idtype_init();
+
+  QuadGrid grid(8);
+  Mesh *mesh = quad_grid_mesh_cow(grid);
+
+  float(*offsets)[2] = (float(*)[2])CustomData_add_layer_named(
+      &mesh->vdata, CD_PROP_FLOAT2, CD_CALLOC, NULL, mesh->totvert, "offsets");
+  for (int i = 0; i < mesh->totvert; i++) {
+    copy_v2_v2(offsets[i], mesh->mvert[i].co);
+  }
+
+  const int src_indices[2] = {1, 2};
+  const float weights[2] = {0.25f, 0.75f};
+  CustomData_interp(&mesh->vdata, &mesh->vdata, src_indices, weights, NULL, 2, 0);
+  float expected[2];
+  interp_v2_v2v2(expected, mesh->mvert[1].co, mesh->mvert[2].co, 0.75f);
+  EXPECT_NEAR(offsets[0][0], expected[0], 1e-6f);
+  EXPECT_NEAR(offsets[0][1], expected[1], 1e-6f);
+
+  /* Copies masked with the mesh data types keep the layer. */
+  Mesh *mesh_eval = BKE_mesh_copy_for_eval(mesh, false);
+  const float(*offsets_eval)[2] = (const float(*)[2])CustomData_get_layer_named(
+      &mesh_eval->vdata, CD_PROP_FLOAT2, "offsets");
+  ASSERT_NE(offsets_eval, nullptr);
+  for (int i = 0; i < mesh->totvert; i++) {
+    EXPECT_EQ(offsets_eval[i][0], offsets[i][0]);
+    EXPECT_EQ(offsets_eval[i][1], offsets[i][1]);
+  }
+  BKE_id_free(NULL, mesh_eval);
+
+  BKE_id_free(NULL, mesh);
+}
+
+TEST(mesh_customdata, SharedLayerOwnership)
+{
+  const int totelem = 100;
+  const size_t blocks_in_use = MEM_get_memory_blocks_in_use();
+
+  CustomData src;
+  CustomData_reset(&src);
+  float *src_data = (float *)CustomData_add_layer(&src, CD_PROP_FLT, CD_CALLOC, NULL, totelem);
+  for (int i = 0; i < totelem; i++) {
+    src_data[i] = (float)i;
+  }
+  EXPECT_FALSE(CustomData_is_referenced_layer(&src, CD_PROP_FLT));
+
+  /* Both copies use the source data, which now has three users. */
+  CustomData a, b;
+  CustomData_copy(&src, &a, CD_MASK_PROP_FLT, CD_SHARE, totelem);
+  CustomData_copy(&src, &b, CD_MASK_PROP_FLT, CD_SHARE, totelem);
+  EXPECT_EQ(CustomData_get_layer(&a, CD_PROP_FLT), src_data);
+  EXPECT_EQ(CustomData_get_layer(&b, CD_PROP_FLT), src_data);
+  EXPECT_TRUE(CustomData_is_referenced_layer(&src, CD_PROP_FLT));
+  EXPECT_TRUE(CustomData_is_referenced_layer(&a, CD_PROP_FLT));
+
+  /* Writing to a copy duplicates the data, without changing the other users. */
+  float *a_data = (float *)CustomData_duplicate_referenced_layer(&a, CD_PROP_FLT, totelem);
+  EXPECT_NE(a_data, src_data);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&a, CD_PROP_FLT));
+  EXPECT_TRUE(CustomData_is_referenced_layer(&src, CD_PROP_FLT));
+  a_data[0] = -1.0f;
+  EXPECT_EQ(src_data[0], 0.0f);
+  EXPECT_EQ(a_data[totelem - 1], (float)(totelem - 1));
+
+  /* Freeing the source keeps the data alive for the remaining user. */
+  CustomData_free(&src, totelem);
+  float *b_data = (float *)CustomData_get_layer(&b, CD_PROP_FLT);
+  EXPECT_EQ(b_data, src_data);
+  EXPECT_EQ(b_data[totelem - 1], (float)(totelem - 1));
+
+  /* The last user takes ownership of the data without copying it. */
+  EXPECT_EQ(CustomData_duplicate_referenced_layer(&b, CD_PROP_FLT, totelem), b_data);
+  EXPECT_FALSE(CustomData_is_referenced_layer(&b, CD_PROP_FLT));
+
+  /* The last layer sharing data frees it as well. */
+  CustomData c;
+  CustomData_copy(&a, &c, CD_MASK_PROP_FLT, CD_SHARE, totelem);
+  CustomData_free(&a, totelem);
+  CustomData_free(&b, totelem);
+  EXPECT_EQ(CustomData_get_layer(&c, CD_PROP_FLT), a_data);
+  CustomData_free(&c, totelem);
+
+  EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_in_use);
+}
+
+TEST(mesh_normals, SharedVertsKeepOriginalNormals)
+{
+  BKE_idtype_init();
+
+  QuadGrid grid(20);
+  Mesh *mesh = quad_grid_mesh_cow(grid);
+  mesh->id.tag &= ~LIB_TAG_COPIED_ON_WRITE;
+  for (int i = 0; i < mesh->totvert; i++) {
+    memset(mesh->mvert[i].no, 0, sizeof(mesh->mvert[i].no));
+  }
+
+  /* Copy the way the depsgraph does, the vertices of all three meshes are the same. */
+  Mesh *mesh_cow;
+  BKE_id_copy_ex(NULL,
+                 &mesh->id,
+                 (ID **)&mesh_cow,
+                 LIB_ID_CREATE_NO_MAIN | LIB_ID_CREATE_NO_USER_REFCOUNT |
+                     LIB_ID_CREATE_NO_DEG_TAG | LIB_ID_COPY_CD_SHARE);
+  mesh_cow->id.tag |= LIB_TAG_COPIED_ON_WRITE;
+  EXPECT_EQ(mesh_cow->mvert, mesh->mvert);
+
+  for (int split = 0; split < 2; split++) {
+    Mesh *mesh_eval = BKE_mesh_copy_for_eval(mesh_cow, true);
+    EXPECT_EQ(mesh_eval->mvert, mesh->mvert);
+    if (split) {
+      BKE_mesh_calc_normals_split(mesh_eval);
+    }
+    else {
+      BKE_mesh_calc_normals(mesh_eval);
+    }
+    EXPECT_NE(mesh_eval->mvert, mesh->mvert);
+    EXPECT_NE(mesh_eval->mvert[0].no[2], 0);
+    BKE_id_free(NULL, mesh_eval);
+  }
+
+  EXPECT_EQ(mesh_cow->mvert, mesh->mvert);
+  for (int i = 0; i < mesh->totvert; i++) {
+    EXPECT_EQ(mesh->mvert[i].no[0], 0);
+    EXPECT_EQ(mesh->mvert[i].no[1], 0);
+    EXPECT_EQ(mesh->mvert[i].no[2], 0);
+  }
+
+  BKE_id_free(NULL, mesh_cow);
+  BKE_id_free(NULL, mesh);
+}
+
+TEST(mesh_bvhtree, RefitMatchesRebuild)
+{
+  BKE_idtype_init();
+
+  QuadGrid grid(40);
+  Mesh *mesh = quad_grid_mesh_cow(grid);
+
+  /* The tree of the first evaluated mesh is kept when it's freed. */
+  Mesh *mesh_eval = BKE_mesh_copy_for_eval(mesh, true);
+  BVHTreeFromMesh treedata;
+  BVHTree *tree = BKE_bvhtree_from_mesh_get(&treedata, mesh_eval, BVHTREE_FROM_LOOPTRI, 2);
+  ASSERT_NE(tree, nullptr);
+  free_bvhtree_from_mesh(&treedata);
+  BKE_id_free(NULL, mesh_eval);
+
+  /* The next one deforms the same topology, its tree is refitted instead of built. */
+  mesh_eval = BKE_mesh_copy_for_eval(mesh, true);
+  CustomData_duplicate_referenced_layer(&mesh_eval->vdata, CD_MVERT, mesh_eval->totvert);
+  BKE_mesh_update_customdata_pointers(mesh_eval, false);
+  for (int i = 0; i < mesh_eval->totvert; i++) {
+    float *co = mesh_eval->mvert[i].co;
+    co[2] = sinf(co[0] * 0.3f) * 4.0f + co[1] * 0.5f;
+  }
+  tree = BKE_bvhtree_from_mesh_get(&treedata, mesh_eval, BVHTREE_FROM_LOOPTRI, 2);
+
+  BVHTreeFromMesh treedata_rebuilt;
+  bvhtree_from_mesh_looptri_ex(&treedata_rebuilt,
+                               mesh_eval->mvert,
+                               false,
+                               mesh_eval->mloop,
+                               false,
+                               BKE_mesh_runtime_looptri_ensure(mesh_eval),
+                               BKE_mesh_runtime_looptri_len(mesh_eval),
+                               false,
+                               NULL,
+                               -1,
+                               0.0f,
+                               2,
+                               6,
+                               BVHTREE_FROM_LOOPTRI,
+                               NULL,
+                               NULL);
+
+  for (int i = 0; i < 200; i++) {
+    const float co[3] = {(float)(i % 20) * 2.1f, (float)(i / 20) * 4.3f, (float)(i % 7) - 3.0f};
+    BVHTreeNearest nearest = {-1, {0.0f}, {0.0f}, FLT_MAX, 0};
+    BVHTreeNearest nearest_rebuilt = nearest;
+    BLI_bvhtree_find_nearest(treedata.tree, co, &nearest, treedata.nearest_callback, &treedata);
+    BLI_bvhtree_find_nearest(treedata_rebuilt.tree,
+                             co,
+                             &nearest_rebuilt,
+                             treedata_rebuilt.nearest_callback,
+                             &treedata_rebuilt);
+    EXPECT_FLOAT_EQ(nearest.dist_sq, nearest_rebuilt.dist_sq);
+  }
+
+  free_bvhtree_from_mesh(&treedata_rebuilt);
+  free_bvhtree_from_mesh(&treedata);
+  BKE_id_free(NULL, mesh_eval);
+
+  /* The tree kept for the next evaluation is the refitted one. */
+  mesh_eval = BKE_mesh_copy_for_eval(mesh, true);
+  int refit_count;
+  BVHTree *tree_kept = BKE_mesh_runtime_bvh_tree_take(
+      mesh_eval, BVHTREE_FROM_LOOPTRI, &refit_count);
+  EXPECT_EQ(tree_kept, tree);
+  EXPECT_EQ(refit_count, 1);
+  BLI_bvhtree_free(tree_kept);
+  BKE_id_free(NULL, mesh_eval);
+
+  BKE_id_free(NULL, mesh);
+}
+
+TEST(mesh_looptri, AreaMatchesPolygons)
+{
+  /* Enough loops to tessellate in parallel. */
+  const PolygonSoup soup(4000);
+  const std::vector<MLoopTri> looptris = soup.looptris((int)soup.polys.size());
+
+  std::vector<float> areas(soup.polys.size(), 0.0f);
+  for (const MLoopTri &lt : looptris) {
+    const MPoly &mp = soup.polys[lt.poly];
+    for (int j = 0; j < 3; j++) {
+      EXPECT_GE(lt.tri[j], (unsigned int)mp.loopstart);
+      EXPECT_LT(lt.tri[j], (unsigned int)(mp.loopstart + mp.totloop));
+    }
+    areas[lt.poly] += area_tri_v3(soup.verts[soup.loops[lt.tri[0]].v].co,
+                                  soup.verts[soup.loops[lt.tri[1]].v].co,
+                                  soup.verts[soup.loops[lt.tri[2]].v].co);
+  }
+  for (size_t i = 0; i < areas.size(); i++) {
+    EXPECT_NEAR(areas[i], soup.areas[i], 1e-3f);
+  }
+}
+
+TEST(mesh_looptri, ThreadedMatchesSingleThreaded)
+{
+  const PolygonSoup soup(4000);
+  const std::vector<MLoopTri> looptris = soup.looptris((int)soup.polys.size());
+  /* Few enough loops to tessellate on a single thread. */
+  const std::vector<MLoopTri> looptris_small = soup.looptris(100);
+
+  for (size_t i = 0; i < looptris_small.size(); i++) {
+    EXPECT_EQ(looptris_small[i].poly, looptris[i].poly);
+    for (int j = 0; j < 3; j++) {
+      EXPECT_EQ(looptris_small[i].tri[j], looptris[i].tri[j]);
+    }
+  }
+}
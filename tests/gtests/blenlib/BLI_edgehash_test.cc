@@ -234,6 +234,24 @@ TEST(edgehash, ClearSetsLengthToZero)
   BLI_edgehash_free(eh, nullptr);
 }
 
+TEST(edgehash, ClearThenInsert)
+{
+  EdgeHash *eh = BLI_edgehash_new(__func__);
+
+  for (int i = 0; i < 1000; i++) {
+    BLI_edgehash_insert(eh, i, i + 1, VALUE_1);
+  }
+  BLI_edgehash_clear(eh, nullptr);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_FALSE(BLI_edgehash_haskey(eh, i, i + 1));
+  }
+  BLI_edgehash_insert(eh, 1, 2, VALUE_2);
+  ASSERT_EQ(BLI_edgehash_lookup(eh, 1, 2), VALUE_2);
+  ASSERT_EQ(BLI_edgehash_len(eh), 1);
+
+  BLI_edgehash_free(eh, nullptr);
+}
+
 TEST(edgehash, IteratorFindsAllValues)
 {
   EdgeHash *eh = BLI_edgehash_new(__func__);
@@ -405,3 +423,23 @@ TEST(edgeset, HasKeyExisting)
 
   BLI_edgeset_free(es);
 }
+
+TEST(edgeset, SharedVertexFan)
+{
+  /* Many edges using the same vertex start probing at the same slots. */
+  EdgeSet *es = BLI_edgeset_new(__func__);
+
+  const int amount = 10000;
+  for (int i = 1; i < amount; i++) {
+    ASSERT_TRUE(BLI_edgeset_add(es, 0, i));
+    ASSERT_TRUE(BLI_edgeset_add(es, i, i + amount));
+  }
+  ASSERT_EQ(BLI_edgeset_len(es), (amount - 1) * 2);
+  for (int i = 1; i < amount; i++) {
+    ASSERT_TRUE(BLI_edgeset_haskey(es, i, 0));
+    ASSERT_TRUE(BLI_edgeset_haskey(es, i + amount, i));
+    ASSERT_FALSE(BLI_edgeset_haskey(es, i, i + 1));
+  }
+
+  BLI_edgeset_free(es);
+}
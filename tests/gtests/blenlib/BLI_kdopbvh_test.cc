@@ -2,13 +2,14 @@
 
 #include "testing/testing.h"
 
-/* TODO: ray intersection, overlap ... etc.*/
+/* TODO: overlap ... etc.*/
 
 #include "MEM_guardedalloc.h"
 
 extern "C" {
 #include "BLI_compiler_attrs.h"
 #include "BLI_kdopbvh.h"
+#include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
 #include "BLI_rand.h"
 }
@@ -51,6 +52,42 @@ TEST(kdopbvh, Single)
   BLI_bvhtree_free(tree);
 }
 
+/* Leafs with infinite bounds must not break balancing of the other leafs. */
+TEST(kdopbvh, BalanceSAHInfinite)
+{
+  const int points_len = 500;
+  struct RNG *rng = BLI_rng_new(1234);
+  BVHTree *tree = BLI_bvhtree_new(points_len + 2, 0.0, 8, 8);
+
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  {
+    /* Infinite centroid, and a centroid which is NaN. */
+    float co_inf[3] = {INFINITY, 0.0f, 0.0f};
+    float co_span[2][3] = {{-INFINITY, 0.0f, 0.0f}, {INFINITY, 0.5f, 0.5f}};
+    BLI_bvhtree_insert(tree, points_len, co_inf, 1);
+    BLI_bvhtree_insert(tree, points_len + 1, co_span[0], 2);
+  }
+  BLI_bvhtree_balance_ex(tree, BVH_BALANCE_SAH);
+
+  for (int i = 0; i < points_len; i++) {
+    const int j = BLI_bvhtree_find_nearest(tree, points[i], NULL, NULL, NULL);
+    EXPECT_GE(j, 0);
+    if (j != i) {
+      EXPECT_LT(j, points_len);
+      if (j >= 0 && j < points_len) {
+        EXPECT_EQ_ARRAY(points[i], points[j], 3);
+      }
+    }
+  }
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+}
+
 static void optimal_check_callback(void *userdata,
                                    int index,
                                    const float co[3],
@@ -70,8 +107,12 @@ static void optimal_check_callback(void *userdata,
  * Note that a small epsilon is added to the BVH nodes bounds, even if we pass in zero.
  * Use rounding to ensure very close nodes don't cause the wrong node to be found as nearest.
  */
-static void find_nearest_points_test(
-    int points_len, float scale, int round, int random_seed, bool optimal = false)
+static void find_nearest_points_test(int points_len,
+                                     float scale,
+                                     int round,
+                                     int random_seed,
+                                     bool optimal = false,
+                                     int balance_flag = 0)
 {
   struct RNG *rng = BLI_rng_new(random_seed);
   BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 8, 8);
@@ -83,7 +124,7 @@ static void find_nearest_points_test(
     rng_v3_round(points[i], 3, rng, round, scale);
     BLI_bvhtree_insert(tree, i, points[i], 1);
   }
-  BLI_bvhtree_balance(tree);
+  BLI_bvhtree_balance_ex(tree, balance_flag);
 
   /* first find each point */
   BVHTree_NearestPointCallback callback = optimal ? optimal_check_callback : NULL;
@@ -136,3 +177,205 @@ TEST(kdopbvh, OptimalFindNearest_500)
 {
   find_nearest_points_test(500, 1.0, 1000, 12, true);
 }
+
+TEST(kdopbvh, FindNearestSAH_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, false, BVH_BALANCE_SAH);
+}
+TEST(kdopbvh, OptimalFindNearestSAH_500)
+{
+  find_nearest_points_test(500, 1.0, 1000, 12, true, BVH_BALANCE_SAH);
+}
+
+/**
+ * Move all points after balancing, the tree must still find them once updated.
+ */
+static void update_tree_test(int points_len, int tree_type, int balance_flag, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, tree_type, 6);
+
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance_ex(tree, balance_flag);
+
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    BLI_bvhtree_update_node(tree, i, points[i], NULL, 1);
+  }
+  BLI_bvhtree_update_tree(tree);
+
+  for (int i = 0; i < points_len; i++) {
+    const int j = BLI_bvhtree_find_nearest_ex(tree, points[i], NULL, NULL, NULL, 0);
+    if (j != i) {
+      EXPECT_GE(j, 0);
+      EXPECT_LT(j, points_len);
+      EXPECT_EQ_ARRAY(points[i], points[j], 3);
+    }
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+}
+
+TEST(kdopbvh, UpdateTree_Quad_5000)
+{
+  update_tree_test(5000, 4, 0, 12);
+}
+TEST(kdopbvh, UpdateTreeSAH_Binary_5000)
+{
+  update_tree_test(5000, 2, BVH_BALANCE_SAH, 123);
+}
+TEST(kdopbvh, UpdateTreeSAH_Oct_5000)
+{
+  update_tree_test(5000, 8, BVH_BALANCE_SAH, 1234);
+}
+
+static void find_nearest_batch_test(int points_len, float scale, int round, int random_seed)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 4, 6);
+
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  float(*queries)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  BVHTreeNearest *nearest = (BVHTreeNearest *)MEM_mallocN(sizeof(*nearest) * points_len,
+                                                          __func__);
+
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(points[i], 3, rng, round, scale);
+    BLI_bvhtree_insert(tree, i, points[i], 1);
+  }
+  BLI_bvhtree_balance(tree);
+
+  for (int i = 0; i < points_len; i++) {
+    rng_v3_round(queries[i], 3, rng, round, scale);
+  }
+  BLI_bvhtree_find_nearest_batch(
+      tree, queries, points_len, FLT_MAX, nearest, NULL, NULL, BVH_NEAREST_OPTIMAL_ORDER);
+
+  for (int i = 0; i < points_len; i++) {
+    BVHTreeNearest nearest_single;
+    nearest_single.index = -1;
+    nearest_single.dist_sq = FLT_MAX;
+    BLI_bvhtree_find_nearest(tree, queries[i], &nearest_single, NULL, NULL);
+    EXPECT_GE(nearest[i].index, 0);
+    EXPECT_FLOAT_EQ(nearest[i].dist_sq, nearest_single.dist_sq);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+  MEM_freeN(nearest);
+}
+
+TEST(kdopbvh, FindNearestBatch_500)
+{
+  find_nearest_batch_test(500, 1.0, 1000, 12);
+}
+
+#define RAY_CAST_BOX_SIZE 0.01f
+
+static void ray_cast_box_callback(void *userdata,
+                                  int index,
+                                  const BVHTreeRay *ray,
+                                  BVHTreeRayHit *hit)
+{
+  float(*points)[3] = (float(*)[3])userdata;
+  float min[3], max[3], tmin, tmax;
+  copy_v3_v3(min, points[index]);
+  copy_v3_v3(max, points[index]);
+  add_v3_fl(min, -RAY_CAST_BOX_SIZE);
+  add_v3_fl(max, RAY_CAST_BOX_SIZE);
+  if (isect_ray_aabb_v3_simple(ray->origin, ray->direction, min, max, &tmin, &tmax) &&
+      tmin >= 0.0f && tmin < hit->dist) {
+    hit->index = index;
+    hit->dist = tmin;
+  }
+}
+
+static void ray_cast_batch_test(int points_len,
+                                int tree_type,
+                                int random_seed,
+                                int balance_flag = 0)
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, tree_type, 6);
+
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  float(*origins)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  float(*dirs)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * points_len, __func__);
+
+  for (int i = 0; i < points_len; i++) {
+    float box[2][3];
+    rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+    copy_v3_v3(box[0], points[i]);
+    copy_v3_v3(box[1], points[i]);
+    add_v3_fl(box[0], -RAY_CAST_BOX_SIZE);
+    add_v3_fl(box[1], RAY_CAST_BOX_SIZE);
+    BLI_bvhtree_insert(tree, i, box[0], 2);
+  }
+  BLI_bvhtree_balance_ex(tree, balance_flag);
+
+  /* Rays from a common origin towards all points, so some are occluded by other points. */
+  for (int i = 0; i < points_len; i++) {
+    copy_v3_fl3(origins[i], 2.0f, 0.5f, -1.5f);
+    sub_v3_v3v3(dirs[i], points[i], origins[i]);
+    normalize_v3(dirs[i]);
+  }
+  BLI_bvhtree_ray_cast_batch(tree,
+                             origins,
+                             dirs,
+                             points_len,
+                             0.0f,
+                             BVH_RAYCAST_DIST_MAX,
+                             hits,
+                             ray_cast_box_callback,
+                             points,
+                             BVH_RAYCAST_DEFAULT);
+
+  for (int i = 0; i < points_len; i++) {
+    BVHTreeRayHit hit_brute_force;
+    hit_brute_force.index = -1;
+    hit_brute_force.dist = BVH_RAYCAST_DIST_MAX;
+    for (int j = 0; j < points_len; j++) {
+      BVHTreeRay ray;
+      copy_v3_v3(ray.origin, origins[i]);
+      copy_v3_v3(ray.direction, dirs[i]);
+      ray.radius = 0.0f;
+      ray_cast_box_callback(points, j, &ray, &hit_brute_force);
+    }
+    EXPECT_NE(hits[i].index, -1);
+    EXPECT_FLOAT_EQ(hits[i].dist, hit_brute_force.dist);
+  }
+
+  BLI_bvhtree_free(tree);
+  BLI_rng_free(rng);
+  MEM_freeN(points);
+  MEM_freeN(origins);
+  MEM_freeN(dirs);
+  MEM_freeN(hits);
+}
+
+TEST(kdopbvh, RayCastBatch_Binary_500)
+{
+  ray_cast_batch_test(500, 2, 123);
+}
+TEST(kdopbvh, RayCastBatch_Quad_500)
+{
+  ray_cast_batch_test(500, 4, 1234);
+}
+TEST(kdopbvh, RayCastBatch_Oct_500)
+{
+  ray_cast_batch_test(500, 8, 12);
+}
+TEST(kdopbvh, RayCastBatchSAH_Quad_500)
+{
+  ray_cast_batch_test(500, 4, 1234, BVH_BALANCE_SAH);
+}
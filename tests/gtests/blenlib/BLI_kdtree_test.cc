@@ -0,0 +1,254 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+}
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static float (*points_random(int points_len, int random_seed))[3]
+{
+  struct RNG *rng = BLI_rng_new(random_seed);
+  float(*points)[3] = (float(*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+  for (int i = 0; i < points_len; i++) {
+    BLI_rng_get_float_unit_v3(rng, points[i]);
+    mul_v3_fl(points[i], BLI_rng_get_float(rng));
+  }
+  BLI_rng_free(rng);
+  return points;
+}
+
+static KDTree_3d *tree_from_points(const float (*points)[3], int points_len)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new((uint)points_len);
+  for (int i = 0; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  return tree;
+}
+
+static float nearest_brute_force(const float (*points)[3], int points_len, const float co[3])
+{
+  float dist_sq_min = FLT_MAX;
+  for (int i = 0; i < points_len; i++) {
+    dist_sq_min = min_ff(dist_sq_min, len_squared_v3v3(points[i], co));
+  }
+  return sqrtf(dist_sq_min);
+}
+
+static int range_brute_force(const float (*points)[3],
+                             int points_len,
+                             const float co[3],
+                             float range)
+{
+  int found = 0;
+  for (int i = 0; i < points_len; i++) {
+    if (len_squared_v3v3(points[i], co) <= range * range) {
+      found++;
+    }
+  }
+  return found;
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(kdtree, Empty)
+{
+  KDTree_3d *tree = BLI_kdtree_3d_new(0);
+  BLI_kdtree_3d_balance(tree);
+  const float co[3] = {0.0f, 0.0f, 0.0f};
+  EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, co, NULL), -1);
+  KDTreeNearest_3d *nearest = NULL;
+  EXPECT_EQ(BLI_kdtree_3d_range_search(tree, co, &nearest, 1.0f), 0);
+  EXPECT_EQ(nearest, nullptr);
+  BLI_kdtree_3d_free(tree);
+}
+
+static void find_nearest_test(int points_len, int random_seed)
+{
+  float(*points)[3] = points_random(points_len, random_seed);
+  float(*queries)[3] = points_random(points_len, random_seed + 1);
+  KDTree_3d *tree = tree_from_points(points, points_len);
+
+  /* Every point finds itself. */
+  for (int i = 0; i < points_len; i++) {
+    KDTreeNearest_3d nearest;
+    EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, points[i], &nearest), i);
+    EXPECT_EQ(nearest.dist, 0.0f);
+  }
+
+  for (int i = 0; i < points_len; i++) {
+    KDTreeNearest_3d nearest;
+    BLI_kdtree_3d_find_nearest(tree, queries[i], &nearest);
+    EXPECT_FLOAT_EQ(nearest.dist, nearest_brute_force(points, points_len, queries[i]));
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+}
+
+TEST(kdtree, FindNearest_10)
+{
+  find_nearest_test(10, 12);
+}
+TEST(kdtree, FindNearest_5000)
+{
+  find_nearest_test(5000, 123);
+}
+
+TEST(kdtree, FindNearestN_5000)
+{
+  const int points_len = 5000, nearest_len = 8;
+  float(*points)[3] = points_random(points_len, 1234);
+  float(*queries)[3] = points_random(points_len, 12);
+  KDTree_3d *tree = tree_from_points(points, points_len);
+
+  for (int i = 0; i < points_len; i++) {
+    KDTreeNearest_3d nearest[nearest_len];
+    EXPECT_EQ(BLI_kdtree_3d_find_nearest_n(tree, queries[i], nearest, nearest_len), nearest_len);
+    for (int j = 1; j < nearest_len; j++) {
+      EXPECT_LE(nearest[j - 1].dist, nearest[j].dist);
+    }
+    /* No other point may be closer than the furthest of the nearest points. */
+    const float dist_max = nearest[nearest_len - 1].dist;
+    EXPECT_GE(range_brute_force(points, points_len, queries[i], dist_max * 1.0001f), nearest_len);
+    EXPECT_LT(range_brute_force(points, points_len, queries[i], dist_max * 0.9999f), nearest_len);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+}
+
+TEST(kdtree, RangeSearch_5000)
+{
+  const int points_len = 5000;
+  const float range = 0.1f;
+  float(*points)[3] = points_random(points_len, 12);
+  float(*queries)[3] = points_random(points_len, 123);
+  KDTree_3d *tree = tree_from_points(points, points_len);
+
+  for (int i = 0; i < points_len; i++) {
+    KDTreeNearest_3d *nearest = NULL;
+    const int found = BLI_kdtree_3d_range_search(tree, queries[i], &nearest, range);
+    EXPECT_EQ(found, range_brute_force(points, points_len, queries[i], range));
+    for (int j = 1; j < found; j++) {
+      EXPECT_LE(nearest[j - 1].dist, nearest[j].dist);
+    }
+    MEM_SAFE_FREE(nearest);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+}
+
+TEST(kdtree, Batch_5000)
+{
+  const int points_len = 5000, nearest_len = 4;
+  const float range = 0.1f;
+  float(*points)[3] = points_random(points_len, 123);
+  float(*queries)[3] = points_random(points_len, 1234);
+  KDTree_3d *tree = tree_from_points(points, points_len);
+
+  KDTreeNearest_3d *nearest = (KDTreeNearest_3d *)MEM_mallocN(sizeof(*nearest) * points_len,
+                                                             __func__);
+  KDTreeNearest_3d *nearest_n = (KDTreeNearest_3d *)MEM_mallocN(
+      sizeof(*nearest_n) * points_len * nearest_len, __func__);
+  KDTreeNearest_3d **nearest_range = (KDTreeNearest_3d **)MEM_mallocN(
+      sizeof(*nearest_range) * points_len, __func__);
+  int *nearest_n_len = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  int *nearest_range_len = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+
+  BLI_kdtree_3d_find_nearest_batch(tree, queries, points_len, nearest);
+  BLI_kdtree_3d_find_nearest_n_batch(
+      tree, queries, points_len, nearest_n, nearest_len, nearest_n_len);
+  BLI_kdtree_3d_range_search_batch(
+      tree, queries, points_len, range, nearest_range, nearest_range_len);
+
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(nearest[i].index, BLI_kdtree_3d_find_nearest(tree, queries[i], NULL));
+
+    KDTreeNearest_3d nearest_n_single[nearest_len];
+    EXPECT_EQ(nearest_n_len[i],
+              BLI_kdtree_3d_find_nearest_n(tree, queries[i], nearest_n_single, nearest_len));
+    for (int j = 0; j < nearest_n_len[i]; j++) {
+      EXPECT_EQ(nearest_n[i * nearest_len + j].index, nearest_n_single[j].index);
+    }
+
+    KDTreeNearest_3d *nearest_range_single = NULL;
+    EXPECT_EQ(nearest_range_len[i],
+              BLI_kdtree_3d_range_search(tree, queries[i], &nearest_range_single, range));
+    for (int j = 0; j < nearest_range_len[i]; j++) {
+      EXPECT_EQ(nearest_range[i][j].dist, nearest_range_single[j].dist);
+    }
+    MEM_SAFE_FREE(nearest_range_single);
+    MEM_SAFE_FREE(nearest_range[i]);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(queries);
+  MEM_freeN(nearest);
+  MEM_freeN(nearest_n);
+  MEM_freeN(nearest_range);
+  MEM_freeN(nearest_n_len);
+  MEM_freeN(nearest_range_len);
+}
+
+TEST(kdtree, Rebalance)
+{
+  const int points_len = 3000;
+  float(*points)[3] = points_random(points_len, 12);
+  KDTree_3d *tree = BLI_kdtree_3d_new(points_len);
+
+  /* Balance, insert more points and balance again. */
+  for (int i = 0; i < points_len / 2; i++) {
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+  for (int i = points_len / 2; i < points_len; i++) {
+    BLI_kdtree_3d_insert(tree, i, points[i]);
+  }
+  BLI_kdtree_3d_balance(tree);
+
+  for (int i = 0; i < points_len; i++) {
+    EXPECT_EQ(BLI_kdtree_3d_find_nearest(tree, points[i], NULL), i);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+}
+
+TEST(kdtree, CalcDuplicatesFast)
+{
+  const int points_len = 2000;
+  float(*points)[3] = points_random(points_len, 123);
+  /* Every odd point duplicates the point before it. */
+  for (int i = 1; i < points_len; i += 2) {
+    copy_v3_v3(points[i], points[i - 1]);
+  }
+  KDTree_3d *tree = tree_from_points(points, points_len);
+
+  int *duplicates = (int *)MEM_mallocN(sizeof(int) * points_len, __func__);
+  copy_vn_i(duplicates, points_len, -1);
+  EXPECT_EQ(BLI_kdtree_3d_calc_duplicates_fast(tree, 1e-6f, true, duplicates), points_len / 2);
+  for (int i = 1; i < points_len; i += 2) {
+    EXPECT_EQ(duplicates[i], i - 1);
+  }
+
+  BLI_kdtree_3d_free(tree);
+  MEM_freeN(points);
+  MEM_freeN(duplicates);
+}
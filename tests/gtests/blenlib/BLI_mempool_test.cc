@@ -0,0 +1,147 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+extern "C" {
+#include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+}
+
+#define ELEM_NUM 10000
+
+typedef struct MempoolTestElem {
+  int value;
+  int pad;
+} MempoolTestElem;
+
+typedef struct MempoolTestChunk {
+  BLI_mempool_tls pool_tls;
+} MempoolTestChunk;
+
+static void mempool_tls_alloc_cb(void *__restrict userdata,
+                                 const int i,
+                                 const TaskParallelTLS *__restrict tls)
+{
+  MempoolTestElem **elems = (MempoolTestElem **)userdata;
+  MempoolTestChunk *chunk = (MempoolTestChunk *)tls->userdata_chunk;
+  MempoolTestElem *elem = (MempoolTestElem *)BLI_mempool_tls_alloc(&chunk->pool_tls);
+  elem->value = i;
+  /* Free some elements again, these get reused by the same thread. */
+  if (i % 3 == 0) {
+    BLI_mempool_tls_free(&chunk->pool_tls, elem);
+    elem = NULL;
+  }
+  elems[i] = elem;
+}
+
+static void mempool_tls_reduce(const void *__restrict UNUSED(userdata),
+                               void *__restrict chunk_join,
+                               void *__restrict chunk)
+{
+  BLI_mempool_tls_join(&((MempoolTestChunk *)chunk_join)->pool_tls,
+                       &((MempoolTestChunk *)chunk)->pool_tls);
+}
+
+static void mempool_tls_alloc_parallel(BLI_mempool *pool, MempoolTestElem **elems)
+{
+  MempoolTestChunk chunk;
+  BLI_mempool_tls_init(pool, &chunk.pool_tls);
+
+  TaskParallelSettings settings;
+  BLI_parallel_range_settings_defaults(&settings);
+  settings.min_iter_per_thread = 64;
+  settings.userdata_chunk = &chunk;
+  settings.userdata_chunk_size = sizeof(chunk);
+  settings.func_reduce = mempool_tls_reduce;
+  BLI_task_parallel_range(0, ELEM_NUM, elems, mempool_tls_alloc_cb, &settings);
+
+  BLI_mempool_tls_finalize(&chunk.pool_tls);
+}
+
+TEST(mempool, ThreadLocalAlloc)
+{
+  BLI_mempool *pool = BLI_mempool_create(
+      sizeof(MempoolTestElem), 0, 512, BLI_MEMPOOL_ALLOW_ITER);
+  MempoolTestElem **elems = (MempoolTestElem **)MEM_mallocN(sizeof(*elems) * ELEM_NUM,
+                                                            __func__);
+
+  /* Elements allocated from the pool its self must be kept. */
+  MempoolTestElem *elem_first = (MempoolTestElem *)BLI_mempool_alloc(pool);
+  elem_first->value = -1;
+
+  mempool_tls_alloc_parallel(pool, elems);
+
+  const int elems_used = ELEM_NUM - ((ELEM_NUM + 2) / 3);
+  EXPECT_EQ(BLI_mempool_len(pool), elems_used + 1);
+
+  /* Iteration visits the existing element first, then all new ones. */
+  bool *found = (bool *)MEM_callocN(sizeof(bool) * ELEM_NUM, __func__);
+  BLI_mempool_iter iter;
+  BLI_mempool_iternew(pool, &iter);
+  MempoolTestElem *elem = (MempoolTestElem *)BLI_mempool_iterstep(&iter);
+  EXPECT_EQ(elem, elem_first);
+  int iter_len = 0;
+  while ((elem = (MempoolTestElem *)BLI_mempool_iterstep(&iter))) {
+    EXPECT_NE(elem->value % 3, 0);
+    EXPECT_FALSE(found[elem->value]);
+    EXPECT_EQ(elems[elem->value], elem);
+    found[elem->value] = true;
+    iter_len++;
+  }
+  EXPECT_EQ(iter_len, elems_used);
+
+  /* Free elements from the pool are used again by regular allocation. */
+  for (int i = 0; i < ELEM_NUM; i++) {
+    if (elems[i]) {
+      BLI_mempool_free(pool, elems[i]);
+    }
+  }
+  EXPECT_EQ(BLI_mempool_len(pool), 1);
+  elem = (MempoolTestElem *)BLI_mempool_alloc(pool);
+  EXPECT_NE(elem, nullptr);
+  EXPECT_EQ(BLI_mempool_len(pool), 2);
+
+  MEM_freeN(found);
+  MEM_freeN(elems);
+  BLI_mempool_destroy(pool);
+}
+
+TEST(mempool, ThreadLocalFreeExisting)
+{
+  BLI_mempool *pool = BLI_mempool_create(
+      sizeof(MempoolTestElem), 0, 512, BLI_MEMPOOL_ALLOW_ITER);
+  MempoolTestElem **elems = (MempoolTestElem **)MEM_mallocN(sizeof(*elems) * ELEM_NUM,
+                                                            __func__);
+  for (int i = 0; i < ELEM_NUM; i++) {
+    elems[i] = (MempoolTestElem *)BLI_mempool_alloc(pool);
+    elems[i]->value = i;
+  }
+
+  /* Free existing elements through a thread allocator, then reuse them. */
+  BLI_mempool_tls tls;
+  BLI_mempool_tls_init(pool, &tls);
+  for (int i = 0; i < ELEM_NUM; i += 2) {
+    BLI_mempool_tls_free(&tls, elems[i]);
+  }
+  for (int i = 0; i < ELEM_NUM / 4; i++) {
+    MempoolTestElem *elem = (MempoolTestElem *)BLI_mempool_tls_calloc(&tls);
+    EXPECT_EQ(elem->value, 0);
+  }
+  EXPECT_EQ(tls.chunks, nullptr);
+  BLI_mempool_tls_finalize(&tls);
+  EXPECT_EQ(BLI_mempool_len(pool), ELEM_NUM - (ELEM_NUM / 2) + (ELEM_NUM / 4));
+
+  BLI_mempool_iter iter;
+  BLI_mempool_iternew(pool, &iter);
+  int iter_len = 0;
+  while (BLI_mempool_iterstep(&iter)) {
+    iter_len++;
+  }
+  EXPECT_EQ(iter_len, BLI_mempool_len(pool));
+
+  MEM_freeN(elems);
+  BLI_mempool_destroy(pool);
+}
@@ -0,0 +1,232 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "depsgraph_test_base.h"
+
+#include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_incremental.h"
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_relation.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+#include "intern/node/deg_node_time.h"
+
+extern "C" {
+#include "BKE_constraint.h"
+#include "BKE_modifier.h"
+#include "BKE_object.h"
+
+#include "BLI_listbase.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+
+#include "DNA_constraint_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+}
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/* Nodes and relations of a graph in a form which does not depend on the order in which they were
+ * built. */
+struct GraphDescription {
+  std::vector<std::string> id_nodes;
+  std::vector<std::string> operations;
+  std::vector<std::string> relations;
+  int num_cyclic_relations = 0;
+};
+
+static std::string node_description(const DEG::Node *node)
+{
+  if (node->type != DEG::NodeType::OPERATION) {
+    return node->identifier();
+  }
+  const DEG::OperationNode *op_node = static_cast<const DEG::OperationNode *>(node);
+  const DEG::ComponentNode *comp_node = op_node->owner;
+  return comp_node->owner->name + "/" + DEG::nodeTypeAsString(comp_node->type) + "[" +
+         comp_node->name + "]/" + op_node->identifier() + "#" +
+         std::to_string(op_node->name_tag);
+}
+
+static void relations_description_add(const DEG::Node *node, GraphDescription *r_description)
+{
+  for (const DEG::Relation *rel : node->outlinks) {
+    /* Which relation of a cycle gets disabled depends on the order of traversal. */
+    const int flag = rel->flag & ~DEG::RELATION_FLAG_CYCLIC;
+    r_description->relations.push_back(node_description(rel->from) + " -> " +
+                                       node_description(rel->to) + " (" + rel->name + ", " +
+                                       std::to_string(flag) + ")");
+    if (rel->flag & DEG::RELATION_FLAG_CYCLIC) {
+      r_description->num_cyclic_relations++;
+    }
+  }
+}
+
+static GraphDescription graph_description(::Depsgraph *depsgraph)
+{
+  DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
+  GraphDescription description;
+  for (const DEG::IDNode *id_node : deg_graph->id_nodes) {
+    description.id_nodes.push_back(id_node->name + ", linked state " +
+                                   std::to_string(id_node->linked_state) + ", visible " +
+                                   std::to_string(id_node->is_directly_visible));
+    for (const DEG::ComponentNode *comp_node : id_node->components.values()) {
+      /* Relations are between operations, but make sure none were missed. */
+      relations_description_add(comp_node, &description);
+    }
+  }
+  for (const DEG::OperationNode *op_node : deg_graph->operations) {
+    description.operations.push_back(node_description(op_node));
+    relations_description_add(op_node, &description);
+  }
+  relations_description_add(deg_graph->find_time_source(), &description);
+  std::sort(description.id_nodes.begin(), description.id_nodes.end());
+  std::sort(description.operations.begin(), description.operations.end());
+  std::sort(description.relations.begin(), description.relations.end());
+  return description;
+}
+
+/* Compare sorted descriptions, only reporting the differences. */
+static void expect_same_descriptions(const std::vector<std::string> &incremental,
+                                     const std::vector<std::string> &full)
+{
+  std::vector<std::string> missing, extra;
+  std::set_difference(full.begin(),
+                      full.end(),
+                      incremental.begin(),
+                      incremental.end(),
+                      std::back_inserter(missing));
+  std::set_difference(incremental.begin(),
+                      incremental.end(),
+                      full.begin(),
+                      full.end(),
+                      std::back_inserter(extra));
+  for (const std::string &description : missing) {
+    ADD_FAILURE() << "Missing after incremental update: " << description;
+  }
+  for (const std::string &description : extra) {
+    ADD_FAILURE() << "Not in full build: " << description;
+  }
+}
+
+class depsgraph_build_incremental : public DepsgraphTestBase {
+ protected:
+  Object *ob_a = nullptr;
+  Object *ob_b = nullptr;
+
+  void SetUp() override
+  {
+    DepsgraphTestBase::SetUp();
+
+    ob_a = add_mesh_object("A");
+    ob_b = add_mesh_object("B");
+  }
+
+  /* Update relations of the depsgraph after changing the given object, and check the result is
+   * the same as building a new depsgraph. */
+  void expect_incremental_matches_full_build(Object *ob)
+  {
+    DEG_graph_id_tag_relations_update(depsgraph, &ob->id);
+    DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
+    ASSERT_TRUE(DEG::deg_graph_build_incremental(bmain, deg_graph, scene, view_layer));
+    /* Same as after a full build, which removes relations to unused no-op operations. The rest
+     * of finalizing an incremental update only tags the rebuilt IDs. */
+    DEG::deg_graph_build_finalize(bmain, deg_graph);
+    const GraphDescription incremental = graph_description(depsgraph);
+
+    ::Depsgraph *depsgraph_full = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+    DEG_graph_build_from_view_layer(depsgraph_full, bmain, scene, view_layer);
+    const GraphDescription full = graph_description(depsgraph_full);
+    DEG_graph_free(depsgraph_full);
+
+    expect_same_descriptions(incremental.id_nodes, full.id_nodes);
+    expect_same_descriptions(incremental.operations, full.operations);
+    expect_same_descriptions(incremental.relations, full.relations);
+    EXPECT_EQ(incremental.num_cyclic_relations > 0, full.num_cyclic_relations > 0);
+  }
+
+  void add_copy_location(Object *ob, Object *target)
+  {
+    bConstraint *con = BKE_constraint_add_for_object(ob, "Copy Location", CONSTRAINT_TYPE_LOCLIKE);
+    reinterpret_cast<bLocateLikeConstraint *>(con->data)->tar = target;
+  }
+};
+
+TEST_F(depsgraph_build_incremental, AddModifier)
+{
+  depsgraph_create_and_evaluate();
+
+  ModifierData *md = BKE_modifier_new(eModifierType_Array);
+  BLI_addtail(&ob_a->modifiers, md);
+  BKE_modifier_unique_name(&ob_a->modifiers, md);
+  ArrayModifierData *amd = reinterpret_cast<ArrayModifierData *>(md);
+  amd->offset_type |= MOD_ARR_OFF_OBJ;
+  amd->offset_ob = ob_b;
+
+  expect_incremental_matches_full_build(ob_a);
+}
+
+TEST_F(depsgraph_build_incremental, AddConstraint)
+{
+  add_copy_location(ob_b, ob_a);
+  depsgraph_create_and_evaluate();
+
+  /* An object which is not in the scene is pulled into the graph through the constraint. */
+  Object *ob_c = BKE_object_add_only_object(bmain, OB_EMPTY, "C");
+  add_copy_location(ob_a, ob_c);
+
+  expect_incremental_matches_full_build(ob_a);
+}
+
+TEST_F(depsgraph_build_incremental, AddConstraintCycle)
+{
+  add_copy_location(ob_b, ob_a);
+  depsgraph_create_and_evaluate();
+
+  add_copy_location(ob_a, ob_b);
+
+  expect_incremental_matches_full_build(ob_a);
+  EXPECT_GT(graph_description(depsgraph).num_cyclic_relations, 0);
+}
+
+TEST_F(depsgraph_build_incremental, UnsupportedFallsBackToFullBuild)
+{
+  depsgraph_create_and_evaluate();
+
+  /* Only objects are rebuilt incrementally. */
+  DEG_graph_id_tag_relations_update(depsgraph, static_cast<ID *>(ob_a->data));
+  DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
+  EXPECT_FALSE(DEG::deg_graph_build_incremental(bmain, deg_graph, scene, view_layer));
+
+  /* The graph is left untouched and then rebuilt from scratch. */
+  DEG_graph_relations_update(depsgraph, bmain, scene, view_layer);
+  EXPECT_FALSE(deg_graph->need_update);
+  EXPECT_TRUE(deg_graph->relations_update_ids.is_empty());
+
+  ::Depsgraph *depsgraph_full = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+  DEG_graph_build_from_view_layer(depsgraph_full, bmain, scene, view_layer);
+  const GraphDescription full = graph_description(depsgraph_full);
+  DEG_graph_free(depsgraph_full);
+  const GraphDescription rebuilt = graph_description(depsgraph);
+  expect_same_descriptions(rebuilt.operations, full.operations);
+  expect_same_descriptions(rebuilt.relations, full.relations);
+}
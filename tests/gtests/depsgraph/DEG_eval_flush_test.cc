@@ -0,0 +1,177 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "depsgraph_test_base.h"
+
+#include "intern/depsgraph.h"
+#include "intern/eval/deg_eval.h"
+#include "intern/eval/deg_eval_flush.h"
+#include "intern/node/deg_node_operation.h"
+#include "intern/node/deg_node_time.h"
+
+extern "C" {
+#include "BKE_action.h"
+#include "BKE_anim_data.h"
+#include "BKE_fcurve.h"
+#include "BKE_lib_id.h"
+#include "BKE_modifier.h"
+
+#include "BLI_listbase.h"
+#include "BLI_string.h"
+
+#include "DEG_depsgraph_query.h"
+
+#include "DNA_anim_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "ED_keyframing.h"
+}
+
+/* Frame changes of an object with keyframed transform and modifier. */
+class depsgraph_flush_animation : public DepsgraphTestBase {
+ protected:
+  Object *ob = nullptr;
+  bAction *action = nullptr;
+
+  void SetUp() override
+  {
+    DepsgraphTestBase::SetUp();
+
+    ob = add_mesh_object("Object");
+    ModifierData *md = BKE_modifier_new(eModifierType_Displace);
+    BLI_addtail(&ob->modifiers, md);
+    BKE_modifier_unique_name(&ob->modifiers, md);
+
+    action = BKE_action_add(bmain, "Action");
+    AnimData *adt = BKE_animdata_add_id(&ob->id);
+    adt->action = action;
+    id_us_plus(&action->id);
+  }
+
+  /* Add an F-Curve with a key at frame 1 and 10. */
+  FCurve *add_fcurve(const char *rna_path, int array_index, float value_1, float value_10)
+  {
+    FCurve *fcu = BKE_fcurve_create();
+    fcu->rna_path = BLI_strdup(rna_path);
+    fcu->array_index = array_index;
+    insert_vert_fcurve(fcu, 1.0f, value_1, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+    insert_vert_fcurve(fcu, 10.0f, value_10, BEZT_KEYTYPE_KEYFRAME, INSERTKEY_NO_USERPREF);
+    BLI_addtail(&action->curves, fcu);
+    return fcu;
+  }
+
+  /* Change frame and flush it, without evaluating the depsgraph yet. */
+  void frame_change_flush(int frame)
+  {
+    DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
+    scene->r.cfra = frame;
+    deg_graph->find_time_source()->cfra = (float)frame;
+    deg_graph->need_update_time = true;
+    DEG::deg_graph_flush_updates(bmain, deg_graph);
+  }
+
+  /* Evaluate the operations tagged by frame_change_flush(). */
+  void frame_change_evaluate()
+  {
+    DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
+    DEG::deg_evaluate_on_refresh(deg_graph);
+    deg_graph->need_update_time = false;
+  }
+
+  /* Evaluate the depsgraph and change frame once. The compiled action then has the values written
+   * on the previous frame to compare with, before that all animated properties are flushed. */
+  void evaluate_first_frames()
+  {
+    depsgraph_create_and_evaluate();
+    frame_change_flush(2);
+    EXPECT_TRUE(geometry_needs_update());
+    EXPECT_TRUE(transform_needs_update());
+    frame_change_evaluate();
+  }
+
+  bool needs_update(DEG::NodeType component_type, DEG::OperationCode opcode)
+  {
+    DEG::OperationNode *op_node = find_operation(&ob->id, component_type, opcode);
+    EXPECT_NE(op_node, nullptr);
+    return op_node != nullptr && (op_node->flag & DEG::DEPSOP_FLAG_NEEDS_UPDATE);
+  }
+
+  bool geometry_needs_update()
+  {
+    return needs_update(DEG::NodeType::GEOMETRY, DEG::OperationCode::GEOMETRY_EVAL);
+  }
+
+  bool transform_needs_update()
+  {
+    return needs_update(DEG::NodeType::TRANSFORM, DEG::OperationCode::TRANSFORM_LOCAL);
+  }
+
+  DisplaceModifierData *modifier_eval()
+  {
+    Object *ob_eval = DEG_get_evaluated_object(depsgraph, ob);
+    return reinterpret_cast<DisplaceModifierData *>(ob_eval->modifiers.first);
+  }
+};
+
+TEST_F(depsgraph_flush_animation, HeldModifierChannelSkipsGeometry)
+{
+  add_fcurve("modifiers[\"Displace\"].strength", 0, 0.5f, 0.5f);
+  FCurve *fcu_loc = add_fcurve("location", 0, 0.0f, 9.0f);
+  evaluate_first_frames();
+
+  frame_change_flush(3);
+  EXPECT_FALSE(geometry_needs_update());
+  EXPECT_TRUE(transform_needs_update());
+  frame_change_evaluate();
+
+  Object *ob_eval = DEG_get_evaluated_object(depsgraph, ob);
+  EXPECT_FLOAT_EQ(ob_eval->loc[0], evaluate_fcurve(fcu_loc, 3.0f));
+  EXPECT_FLOAT_EQ(modifier_eval()->strength, 0.5f);
+}
+
+TEST_F(depsgraph_flush_animation, ChangingModifierChannelUpdatesGeometry)
+{
+  FCurve *fcu_strength = add_fcurve("modifiers[\"Displace\"].strength", 0, 0.5f, 5.0f);
+  add_fcurve("location", 0, 3.0f, 3.0f);
+  evaluate_first_frames();
+
+  frame_change_flush(3);
+  EXPECT_TRUE(geometry_needs_update());
+  EXPECT_FALSE(transform_needs_update());
+  frame_change_evaluate();
+
+  EXPECT_FLOAT_EQ(modifier_eval()->strength, evaluate_fcurve(fcu_strength, 3.0f));
+  EXPECT_FLOAT_EQ(DEG_get_evaluated_object(depsgraph, ob)->loc[0], 3.0f);
+}
+
+TEST_F(depsgraph_flush_animation, HeldChannelsSkipEverything)
+{
+  add_fcurve("modifiers[\"Displace\"].strength", 0, 0.5f, 0.5f);
+  add_fcurve("location", 0, 3.0f, 3.0f);
+  evaluate_first_frames();
+
+  frame_change_flush(3);
+  EXPECT_FALSE(geometry_needs_update());
+  EXPECT_FALSE(transform_needs_update());
+  frame_change_evaluate();
+
+  /* Held values are kept from the previous evaluation. */
+  EXPECT_FLOAT_EQ(modifier_eval()->strength, 0.5f);
+  EXPECT_FLOAT_EQ(DEG_get_evaluated_object(depsgraph, ob)->loc[0], 3.0f);
+}
@@ -0,0 +1,87 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#include "depsgraph_test_base.h"
+
+#include "intern/depsgraph.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+
+extern "C" {
+#include "BKE_collection.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+#include "BKE_scene.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+}
+
+void DepsgraphTestBase::SetUp()
+{
+  BlendfileLoadingBaseTest::SetUp();
+
+  bmain = BKE_main_new();
+  scene = BKE_scene_add(bmain, "Scene");
+  view_layer = static_cast<ViewLayer *>(scene->view_layers.first);
+}
+
+void DepsgraphTestBase::TearDown()
+{
+  BlendfileLoadingBaseTest::TearDown();
+
+  BKE_main_free(bmain);
+  bmain = nullptr;
+  scene = nullptr;
+  view_layer = nullptr;
+}
+
+Object *DepsgraphTestBase::add_mesh_object(const char *name)
+{
+  Object *ob = BKE_object_add_only_object(bmain, OB_MESH, name);
+  ob->data = BKE_mesh_add(bmain, name);
+  BKE_collection_object_add(bmain, scene->master_collection, ob);
+  return ob;
+}
+
+void DepsgraphTestBase::depsgraph_create_and_evaluate()
+{
+  depsgraph = DEG_graph_new(bmain, scene, view_layer, DAG_EVAL_VIEWPORT);
+  DEG_graph_build_from_view_layer(depsgraph, bmain, scene, view_layer);
+  BKE_scene_graph_update_tagged(depsgraph, bmain);
+}
+
+DEG::OperationNode *DepsgraphTestBase::find_operation(ID *id,
+                                                      DEG::NodeType component_type,
+                                                      DEG::OperationCode opcode)
+{
+  DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
+  DEG::IDNode *id_node = deg_graph->find_id_node(id);
+  if (id_node == nullptr) {
+    return nullptr;
+  }
+  DEG::ComponentNode *comp_node = id_node->find_component(component_type);
+  if (comp_node == nullptr) {
+    return nullptr;
+  }
+  return comp_node->find_operation(opcode, "", -1);
+}
@@ -0,0 +1,59 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2020 by Blender Foundation.
+ */
+#ifndef __DEPSGRAPH_TEST_BASE_H__
+#define __DEPSGRAPH_TEST_BASE_H__
+
+#include "blenloader/blendfile_loading_base_test.h"
+
+struct Main;
+struct Object;
+struct Scene;
+struct ViewLayer;
+
+namespace DEG {
+struct OperationNode;
+enum class NodeType;
+enum class OperationCode;
+}  // namespace DEG
+
+/* Builds scenes in code instead of loading them, with Blender set up the same way as for
+ * loading blend files. */
+class DepsgraphTestBase : public BlendfileLoadingBaseTest {
+ protected:
+  struct Main *bmain = nullptr;
+  struct Scene *scene = nullptr;
+  struct ViewLayer *view_layer = nullptr;
+
+  /* Creates an empty scene in a new main database. */
+  virtual void SetUp();
+  /* Frees the depsgraph and the main database. */
+  virtual void TearDown();
+
+  /* Add an object with an empty mesh to the scene. */
+  struct Object *add_mesh_object(const char *name);
+
+  /* Create a depsgraph for the scene and evaluate it. */
+  void depsgraph_create_and_evaluate();
+
+  /* Operation of the depsgraph, nullptr when it does not exist. */
+  DEG::OperationNode *find_operation(struct ID *id,
+                                     DEG::NodeType component_type,
+                                     DEG::OperationCode opcode);
+};
+
+#endif /* __DEPSGRAPH_TEST_BASE_H__ */
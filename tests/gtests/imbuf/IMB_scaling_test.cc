@@ -0,0 +1,160 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_math.h"
+#include "BLI_utildefines.h"
+
+#include "IMB_imbuf.h"
+#include "IMB_imbuf_types.h"
+
+class imbuf_scaling : public testing::Test {
+ protected:
+  static void SetUpTestCase()
+  {
+    IMB_init();
+  }
+  static void TearDownTestCase()
+  {
+    IMB_exit();
+  }
+};
+
+static ImBuf *create_float_ibuf(int x, int y, int channels, const float *pixels)
+{
+  ImBuf *ibuf = IMB_allocImBuf(x, y, 32, IB_rectfloat);
+  ibuf->channels = channels;
+  if (channels != 4) {
+    MEM_freeN(ibuf->rect_float);
+    ibuf->rect_float = (float *)MEM_mallocN(sizeof(float) * x * y * channels, __func__);
+  }
+  memcpy(ibuf->rect_float, pixels, sizeof(float) * x * y * channels);
+  return ibuf;
+}
+
+static ImBuf *create_byte_ibuf(int x, int y, const unsigned char *pixels)
+{
+  ImBuf *ibuf = IMB_allocImBuf(x, y, 32, IB_rect);
+  memcpy(ibuf->rect, pixels, sizeof(int) * x * y);
+  return ibuf;
+}
+
+TEST_F(imbuf_scaling, DownscaleBoxAverages)
+{
+  /* Columns of 0 and 1, rows of 0 and 0.5. */
+  float pixels[4 * 2];
+  for (int y = 0; y < 2; y++) {
+    for (int x = 0; x < 4; x++) {
+      pixels[y * 4 + x] = (float)(x % 2) + (float)y * 0.5f;
+    }
+  }
+  ImBuf *ibuf = create_float_ibuf(4, 2, 1, pixels);
+
+  EXPECT_TRUE(IMB_scale_filter_ImBuf(ibuf, 2, 1, IMB_SCALE_FILTER_BOX));
+  EXPECT_EQ(ibuf->x, 2);
+  EXPECT_EQ(ibuf->y, 1);
+  EXPECT_FLOAT_EQ(ibuf->rect_float[0], 0.75f);
+  EXPECT_FLOAT_EQ(ibuf->rect_float[1], 0.75f);
+
+  IMB_freeImBuf(ibuf);
+}
+
+TEST_F(imbuf_scaling, DownscaleByte)
+{
+  const unsigned char pixels[4][4] = {
+      {0, 10, 20, 255}, {200, 30, 40, 255}, {0, 50, 60, 255}, {200, 70, 80, 255}};
+  ImBuf *ibuf = create_byte_ibuf(4, 1, &pixels[0][0]);
+
+  EXPECT_TRUE(IMB_scaleImBuf(ibuf, 2, 1));
+  const unsigned char *rect = (unsigned char *)ibuf->rect;
+  const unsigned char expected[2][4] = {{100, 20, 30, 255}, {100, 60, 70, 255}};
+  for (int i = 0; i < 8; i++) {
+    EXPECT_EQ(rect[i], (&expected[0][0])[i]);
+  }
+
+  IMB_freeImBuf(ibuf);
+}
+
+TEST_F(imbuf_scaling, UpscaleBilinear)
+{
+  const float pixels[2] = {0.0f, 1.0f};
+  ImBuf *ibuf = create_float_ibuf(2, 1, 1, pixels);
+
+  EXPECT_TRUE(IMB_scale_filter_ImBuf(ibuf, 4, 1, IMB_SCALE_FILTER_BILINEAR));
+  /* Destination pixel centers fall at a quarter and three quarters between source pixels,
+   * the outer ones are clamped to the edge. */
+  const float expected[4] = {0.0f, 0.25f, 0.75f, 1.0f};
+  for (int i = 0; i < 4; i++) {
+    EXPECT_FLOAT_EQ(ibuf->rect_float[i], expected[i]);
+  }
+
+  IMB_freeImBuf(ibuf);
+}
+
+TEST_F(imbuf_scaling, ConstantImageAllFilters)
+{
+  const eIMBScaleFilter filters[] = {IMB_SCALE_FILTER_BOX,
+                                     IMB_SCALE_FILTER_BILINEAR,
+                                     IMB_SCALE_FILTER_MITCHELL,
+                                     IMB_SCALE_FILTER_LANCZOS};
+  const int sizes[][2] = {{3, 2}, {17, 13}, {40, 40}};
+  const float color[4] = {0.25f, 0.5f, 0.75f, 1.0f};
+  float pixels[9 * 7 * 4];
+  for (int i = 0; i < 9 * 7; i++) {
+    copy_v4_v4(&pixels[i * 4], color);
+  }
+
+  /* Weights are normalized, so a flat image stays flat whatever the filter and scale. */
+  for (const eIMBScaleFilter filter : filters) {
+    for (const auto &size : sizes) {
+      ImBuf *ibuf = create_float_ibuf(9, 7, 4, pixels);
+      EXPECT_TRUE(IMB_scale_filter_ImBuf(ibuf, size[0], size[1], filter));
+      for (int i = 0; i < size[0] * size[1]; i++) {
+        EXPECT_V4_NEAR((ibuf->rect_float + i * 4), color, 1e-5f);
+      }
+      IMB_freeImBuf(ibuf);
+    }
+  }
+}
+
+TEST_F(imbuf_scaling, SinglePixel)
+{
+  const float color[3] = {0.1f, 0.2f, 0.3f};
+
+  /* Enlarging a single pixel repeats it. */
+  ImBuf *ibuf = create_float_ibuf(1, 1, 3, color);
+  EXPECT_TRUE(IMB_scale_filter_ImBuf(ibuf, 5, 3, IMB_SCALE_FILTER_LANCZOS));
+  for (int i = 0; i < 5 * 3; i++) {
+    EXPECT_V3_NEAR((ibuf->rect_float + i * 3), color, 1e-6f);
+  }
+  IMB_freeImBuf(ibuf);
+
+  /* Shrinking to a single pixel gives the average. */
+  float pixels[7 * 5];
+  float sum = 0.0f;
+  for (int i = 0; i < 7 * 5; i++) {
+    pixels[i] = (float)i;
+    sum += pixels[i];
+  }
+  ibuf = create_float_ibuf(7, 5, 1, pixels);
+  EXPECT_TRUE(IMB_scale_filter_ImBuf(ibuf, 1, 1, IMB_SCALE_FILTER_BOX));
+  EXPECT_NEAR(ibuf->rect_float[0], sum / (7 * 5), 1e-4f);
+  IMB_freeImBuf(ibuf);
+
+  /* A single column only scales along one axis. */
+  ibuf = create_float_ibuf(1, 5, 1, pixels);
+  EXPECT_TRUE(IMB_scale_filter_ImBuf(ibuf, 1, 10, IMB_SCALE_FILTER_BOX));
+  for (int i = 0; i < 10; i++) {
+    EXPECT_FLOAT_EQ(ibuf->rect_float[i], pixels[i / 2]);
+  }
+  IMB_freeImBuf(ibuf);
+
+  /* Unchanged size and zero size are rejected. */
+  ibuf = create_float_ibuf(1, 1, 3, color);
+  EXPECT_FALSE(IMB_scale_filter_ImBuf(ibuf, 1, 1, IMB_SCALE_FILTER_BOX));
+  EXPECT_FALSE(IMB_scale_filter_ImBuf(ibuf, 0, 4, IMB_SCALE_FILTER_BOX));
+  EXPECT_EQ(ibuf->x, 1);
+  IMB_freeImBuf(ibuf);
+}